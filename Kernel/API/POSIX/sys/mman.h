@@ -24,6 +24,7 @@ extern "C" {
 #define MAP_RANDOMIZED 0x100
 #define MAP_PURGEABLE 0x200
 #define MAP_FIXED_NOREPLACE 0x400
+#define MAP_HUGEPAGE 0x800
 
 #define PROT_READ 0x1
 #define PROT_WRITE 0x2
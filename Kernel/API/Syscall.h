@@ -13,6 +13,7 @@
 constexpr int syscall_vector = 0x82;
 
 extern "C" {
+struct epoll_event;
 struct pollfd;
 struct timeval;
 struct timespec;
@@ -64,6 +65,9 @@ enum class NeedsBigProcessLock {
     S(dump_backtrace, NeedsBigProcessLock::No)              \
     S(dup2, NeedsBigProcessLock::No)                        \
     S(emuctl, NeedsBigProcessLock::No)                      \
+    S(epoll_create1, NeedsBigProcessLock::Yes)              \
+    S(epoll_ctl, NeedsBigProcessLock::Yes)                  \
+    S(epoll_wait, NeedsBigProcessLock::Yes)                 \
     S(execve, NeedsBigProcessLock::Yes)                     \
     S(exit, NeedsBigProcessLock::Yes)                       \
     S(exit_thread, NeedsBigProcessLock::Yes)                \
@@ -147,6 +151,7 @@ enum class NeedsBigProcessLock {
     S(sched_getparam, NeedsBigProcessLock::No)              \
     S(sched_setparam, NeedsBigProcessLock::No)              \
     S(sendfd, NeedsBigProcessLock::No)                      \
+    S(sendfile, NeedsBigProcessLock::Yes)                   \
     S(sendmsg, NeedsBigProcessLock::Yes)                    \
     S(set_coredump_metadata, NeedsBigProcessLock::Yes)      \
     S(set_mmap_name, NeedsBigProcessLock::Yes)              \
@@ -174,6 +179,7 @@ enum class NeedsBigProcessLock {
     S(sigtimedwait, NeedsBigProcessLock::Yes)               \
     S(socket, NeedsBigProcessLock::Yes)                     \
     S(socketpair, NeedsBigProcessLock::Yes)                 \
+    S(splice, NeedsBigProcessLock::Yes)                     \
     S(stat, NeedsBigProcessLock::No)                        \
     S(statvfs, NeedsBigProcessLock::Yes)                    \
     S(symlink, NeedsBigProcessLock::Yes)                    \
@@ -473,6 +479,37 @@ struct SC_statvfs_params {
     struct statvfs* buf;
 };
 
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    off_t* offset;
+    size_t count;
+};
+
+struct SC_splice_params {
+    int fd_in;
+    off_t* off_in;
+    int fd_out;
+    off_t* off_out;
+    size_t count;
+    unsigned flags;
+};
+
+struct SC_epoll_ctl_params {
+    int epfd;
+    int op;
+    int fd;
+    struct epoll_event* event;
+};
+
+struct SC_epoll_wait_params {
+    int epfd;
+    struct epoll_event* events;
+    int maxevents;
+    const struct timespec* timeout;
+    u32 const* sigmask;
+};
+
 struct SC_chmod_params {
     int dirfd;
     StringArgument path;
@@ -18,13 +18,49 @@ namespace Kernel {
 
 inline bool time_page_supports(clockid_t clock_id)
 {
-    return clock_id == CLOCK_REALTIME_COARSE || clock_id == CLOCK_MONOTONIC_COARSE;
+    switch (clock_id) {
+    case CLOCK_REALTIME:
+    case CLOCK_MONOTONIC:
+    case CLOCK_MONOTONIC_RAW:
+    case CLOCK_REALTIME_COARSE:
+    case CLOCK_MONOTONIC_COARSE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The coarse clocks can be handed out as-is, but the precise ones have to be
+// advanced by the time that has passed since the page was last updated.
+inline bool time_page_clock_needs_interpolation(clockid_t clock_id)
+{
+    return clock_id != CLOCK_REALTIME_COARSE && clock_id != CLOCK_MONOTONIC_COARSE;
 }
 
 struct TimePage {
     volatile u32 update1;
     struct timespec clocks[CLOCK_ID_COUNT];
+    // If tsc_to_ns_multiplier is zero, the TSC can't be used for timekeeping,
+    // and the precise clocks have to be read through a syscall instead.
+    u64 tsc_at_update;
+    u64 tsc_to_ns_multiplier; // 32.32 fixed point
+    u64 max_interpolation_ns;
     volatile u32 update2;
 };
 
+// Both the kernel and userspace use this to compute how far the precise clocks
+// have advanced since the last update. The result is capped to the update
+// interval, so a clock never runs ahead of the value the next update publishes.
+inline u64 time_page_interpolate_ns(TimePage const& page, u64 tsc)
+{
+    if (tsc <= page.tsc_at_update)
+        return 0;
+    // Anything this large is way past max_interpolation_ns anyway, and capping it keeps the multiplication from overflowing.
+    u64 delta = tsc - page.tsc_at_update;
+    if (delta > 0xffffffff)
+        delta = 0xffffffff;
+    u64 ns = delta * (page.tsc_to_ns_multiplier >> 32) + ((delta * (page.tsc_to_ns_multiplier & 0xffffffff)) >> 32);
+    return ns < page.max_interpolation_ns ? ns : page.max_interpolation_ns;
+}
+
 }
@@ -24,6 +24,14 @@ public:
         m_raw |= PhysicalAddress::physical_page_base(value);
     }
 
+    // NOTE: A huge entry maps a 2 MiB page directly, so bits 12-20 don't belong to its base address.
+    PhysicalPtr huge_page_base() const { return m_raw & huge_page_base_mask; }
+    void set_huge_page_base(PhysicalPtr value)
+    {
+        m_raw &= ~huge_page_base_mask;
+        m_raw |= value & huge_page_base_mask;
+    }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
@@ -66,6 +74,8 @@ public:
     void set_execute_disabled(bool b) { set_bit(NoExecute, b); }
 
 private:
+    static constexpr u64 huge_page_base_mask = 0x000fffffffe00000ULL;
+
     void set_bit(u64 bit, bool value)
     {
         if (value)
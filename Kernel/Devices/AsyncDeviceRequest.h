@@ -63,7 +63,8 @@ public:
 
     void do_start(SpinlockLocker<Spinlock>&& requests_lock)
     {
-        if (is_completed_result(m_result))
+        // NOTE: A sub-request may be started by its device and by its parent request, but it must only run once.
+        if (m_result != Pending)
             return;
         m_result = Started;
         requests_lock.unlock();
@@ -155,6 +155,18 @@ void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceR
 {
     SpinlockLocker lock(m_requests_lock);
     VERIFY(!m_requests.is_empty());
+    if (can_start_requests_concurrently()) {
+        // Every request has already been started, so they may complete in any order.
+        for (auto it = m_requests.begin(); it != m_requests.end(); ++it) {
+            if (it->ptr() == &completed_request) {
+                m_requests.remove(it);
+                break;
+            }
+        }
+        lock.unlock();
+        evaluate_block_conditions();
+        return;
+    }
     VERIFY(m_requests.first().ptr() == &completed_request);
     m_requests.remove(m_requests.begin());
     if (!m_requests.is_empty()) {
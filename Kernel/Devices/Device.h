@@ -57,13 +57,17 @@ public:
         SpinlockLocker lock(m_requests_lock);
         bool was_empty = m_requests.is_empty();
         m_requests.append(request);
-        if (was_empty)
+        if (was_empty || can_start_requests_concurrently())
             request->do_start(move(lock));
         return request;
     }
 
 protected:
     Device(MajorNumber major, MinorNumber minor);
+
+    // Devices that can keep track of many requests at once return true here, so every
+    // request is started as soon as it's made instead of waiting for the previous one.
+    virtual bool can_start_requests_concurrently() const { return false; }
     void set_uid(UserID uid) { m_uid = uid; }
     void set_gid(GroupID gid) { m_gid = gid; }
 
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Arch/RegisterState.h>
+#include <Kernel/Arch/x86/InterruptDisabler.h>
+#include <Kernel/Devices/DeviceManagement.h>
+#include <Kernel/Devices/PerformanceEventStreamDevice.h>
+#include <Kernel/KBufferBuilder.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+PerformanceEventStreamDevice* PerformanceEventStreamDevice::s_the;
+
+// Don't hand out more than this much JSON per refill, so a busy system can't
+// make a single read() allocate unbounded amounts of memory.
+static constexpr size_t max_pending_output_size = 256 * KiB;
+
+UNMAP_AFTER_INIT NonnullRefPtr<PerformanceEventStreamDevice> PerformanceEventStreamDevice::must_create()
+{
+    auto device_or_error = DeviceManagement::try_create_device<PerformanceEventStreamDevice>();
+    // FIXME: Find a way to propagate errors
+    VERIFY(!device_or_error.is_error());
+    auto device = device_or_error.release_value();
+    s_the = device.ptr();
+    return device;
+}
+
+UNMAP_AFTER_INIT PerformanceEventStreamDevice::PerformanceEventStreamDevice()
+    : CharacterDevice(1, 10)
+{
+}
+
+UNMAP_AFTER_INIT PerformanceEventStreamDevice::~PerformanceEventStreamDevice() = default;
+
+ErrorOr<void> PerformanceEventStreamDevice::attach(OpenFileDescription& description)
+{
+    if (!Process::current().is_superuser())
+        return EPERM;
+
+    MutexLocker locker(m_read_lock);
+    if (m_is_streaming)
+        return EBUSY;
+
+    // The rings are allocated the first time someone starts streaming and are
+    // kept around afterwards, so that recording never has to worry about them
+    // going away underneath it.
+    if (m_rings.is_empty()) {
+        Vector<NonnullOwnPtr<Ring>> rings;
+        for (u32 i = 0; i < Processor::count(); ++i) {
+            auto buffer = TRY(KBuffer::try_create_with_size(events_per_ring * sizeof(PerformanceEvent), Memory::Region::Access::ReadWrite, "Performance event stream", AllocationStrategy::AllocateNow));
+            auto ring = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Ring { move(buffer) }));
+            TRY(rings.try_append(move(ring)));
+        }
+        m_rings = move(rings);
+    }
+
+    for (auto& ring : m_rings) {
+        ring->tail = ring->head.load();
+        ring->dropped_events = 0;
+    }
+    m_pending_output = nullptr;
+    m_pending_output_offset = 0;
+
+    TRY(CharacterDevice::attach(description));
+    m_is_streaming = true;
+    return {};
+}
+
+void PerformanceEventStreamDevice::detach(OpenFileDescription& description)
+{
+    {
+        MutexLocker locker(m_read_lock);
+        m_is_streaming = false;
+        m_pending_output = nullptr;
+    }
+    CharacterDevice::detach(description);
+}
+
+void PerformanceEventStreamDevice::append(Thread& thread, FlatPtr ip, FlatPtr bp, int type, FlatPtr arg1, FlatPtr arg2)
+{
+    InterruptDisabler disabler;
+    auto processor = Processor::current_id();
+    if (processor >= m_rings.size())
+        return;
+    auto& ring = *m_rings[processor];
+
+    // We're the only one who ever moves the head of this ring, and the reader
+    // only moves the tail, so a plain load/store pair is all we need here.
+    auto head = ring.head.load(AK::MemoryOrder::memory_order_relaxed);
+    auto tail = ring.tail.load(AK::MemoryOrder::memory_order_acquire);
+    if (head - tail >= events_per_ring) {
+        ring.dropped_events.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        return;
+    }
+
+    auto& event = ring.at(head);
+    auto dropped_events = ring.dropped_events.exchange(0, AK::MemoryOrder::memory_order_relaxed);
+    if (PerformanceEventBuffer::build_event(event, thread.pid(), thread.tid(), ip, bp, type, dropped_events, arg1, arg2, {}).is_error())
+        return;
+
+    ring.head.store(head + 1, AK::MemoryOrder::memory_order_release);
+    m_reader_needs_wakeup.store(true, AK::MemoryOrder::memory_order_relaxed);
+}
+
+void PerformanceEventStreamDevice::append_cpu_sample(Thread& thread, RegisterState const& regs)
+{
+    if (!is_streaming() || thread.is_profiling_suppressed())
+        return;
+    s_the->append(thread, regs.ip(), regs.bp(), PERF_EVENT_SAMPLE, 0, 0);
+}
+
+void PerformanceEventStreamDevice::append_context_switch(Thread& from_thread, Thread& to_thread)
+{
+    if (!is_streaming() || from_thread.is_profiling_suppressed())
+        return;
+    s_the->append(from_thread, 0, bit_cast<FlatPtr>(__builtin_frame_address(0)), PERF_EVENT_CONTEXT_SWITCH, to_thread.pid().value(), to_thread.tid().value());
+}
+
+void PerformanceEventStreamDevice::notify_reader_if_needed()
+{
+    if (!is_streaming())
+        return;
+    if (s_the->m_reader_needs_wakeup.exchange(false, AK::MemoryOrder::memory_order_relaxed))
+        s_the->evaluate_block_conditions();
+}
+
+bool PerformanceEventStreamDevice::has_unread_events() const
+{
+    for (auto& ring : m_rings) {
+        if (ring->tail.load(AK::MemoryOrder::memory_order_relaxed) != ring->head.load(AK::MemoryOrder::memory_order_acquire))
+            return true;
+    }
+    return false;
+}
+
+bool PerformanceEventStreamDevice::can_read(OpenFileDescription const&, u64) const
+{
+    if (m_pending_output && m_pending_output_offset < m_pending_output->size())
+        return true;
+    return has_unread_events();
+}
+
+ErrorOr<void> PerformanceEventStreamDevice::fill_pending_output()
+{
+    VERIFY(m_read_lock.is_exclusively_locked_by_current_thread());
+
+    auto builder = TRY(KBufferBuilder::try_create());
+    for (size_t processor = 0; processor < m_rings.size(); ++processor) {
+        auto& ring = *m_rings[processor];
+        auto head = ring.head.load(AK::MemoryOrder::memory_order_acquire);
+        auto tail = ring.tail.load(AK::MemoryOrder::memory_order_relaxed);
+        for (; tail != head && builder.length() < max_pending_output_size; ++tail) {
+            TRY(PerformanceEventBuffer::event_to_json(builder, ring.at(tail), true, processor));
+            TRY(builder.append('\n'));
+        }
+        // Only now the producer may reuse the slots we just serialized.
+        ring.tail.store(tail, AK::MemoryOrder::memory_order_release);
+    }
+
+    m_pending_output = builder.build();
+    m_pending_output_offset = 0;
+    return {};
+}
+
+ErrorOr<size_t> PerformanceEventStreamDevice::read(OpenFileDescription&, u64, UserOrKernelBuffer& buffer, size_t size)
+{
+    MutexLocker locker(m_read_lock);
+    if (!m_pending_output || m_pending_output_offset >= m_pending_output->size())
+        TRY(fill_pending_output());
+    if (!m_pending_output || m_pending_output->size() == 0)
+        return EAGAIN;
+
+    auto nread = min(size, m_pending_output->size() - m_pending_output_offset);
+    TRY(buffer.write(m_pending_output->data() + m_pending_output_offset, nread));
+    m_pending_output_offset += nread;
+    return nread;
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <Kernel/Devices/CharacterDevice.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/PerformanceEventBuffer.h>
+
+namespace Kernel {
+
+// /dev/perf streams CPU samples and context switches from every processor, for
+// as long as someone has it open. Each processor records into its own ring,
+// which only that processor writes to and only the reader consumes from, so
+// recording never takes a lock. Events are handed out as one JSON object per
+// line, in the same format as the events in /proc/<pid>/perf_events.
+// Only one (superuser) reader can have the device open at a time.
+class PerformanceEventStreamDevice final : public CharacterDevice {
+    friend class DeviceManagement;
+
+public:
+    static NonnullRefPtr<PerformanceEventStreamDevice> must_create();
+    virtual ~PerformanceEventStreamDevice() override;
+
+    static bool is_streaming()
+    {
+        return s_the && s_the->m_is_streaming.load(AK::MemoryOrder::memory_order_relaxed);
+    }
+
+    static void append_cpu_sample(Thread&, RegisterState const&);
+    static void append_context_switch(Thread& from_thread, Thread& to_thread);
+
+    // Wakes up a reader waiting for events; called from the timer tick.
+    static void notify_reader_if_needed();
+
+private:
+    PerformanceEventStreamDevice();
+
+    static constexpr size_t events_per_ring = 256;
+
+    struct Ring {
+        NonnullOwnPtr<KBuffer> buffer;
+        Atomic<size_t> head { 0 };
+        Atomic<size_t> tail { 0 };
+        Atomic<u32> dropped_events { 0 };
+
+        PerformanceEvent& at(size_t index)
+        {
+            return reinterpret_cast<PerformanceEvent*>(buffer->data())[index % events_per_ring];
+        }
+    };
+
+    void append(Thread&, FlatPtr ip, FlatPtr bp, int type, FlatPtr arg1, FlatPtr arg2);
+    bool has_unread_events() const;
+    ErrorOr<void> fill_pending_output();
+
+    // ^File
+    virtual ErrorOr<void> attach(OpenFileDescription&) override;
+    virtual void detach(OpenFileDescription&) override;
+
+    // ^CharacterDevice
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override;
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual StringView class_name() const override { return "PerformanceEventStreamDevice"sv; }
+
+    static PerformanceEventStreamDevice* s_the;
+
+    Vector<NonnullOwnPtr<Ring>> m_rings;
+    Atomic<bool> m_is_streaming { false };
+    Atomic<bool> m_reader_needs_wakeup { false };
+
+    Mutex m_read_lock { "PerformanceEventStreamDevice"sv };
+    OwnPtr<KBuffer> m_pending_output;
+    size_t m_pending_output_offset { 0 };
+};
+
+}
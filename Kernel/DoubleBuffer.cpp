@@ -90,4 +90,14 @@ ErrorOr<size_t> DoubleBuffer::peek(UserOrKernelBuffer& data, size_t size)
     return read_impl(data, size, locker, false);
 }
 
+void DoubleBuffer::discard(size_t size)
+{
+    MutexLocker locker(m_lock);
+    VERIFY(m_read_buffer_index + size <= m_read_buffer->size);
+    m_read_buffer_index += size;
+    compute_lockfree_metadata();
+    if (m_unblock_callback && m_space_for_writing > 0)
+        m_unblock_callback();
+}
+
 }
@@ -34,9 +34,12 @@ public:
         auto buffer = UserOrKernelBuffer::for_kernel_buffer(data);
         return peek(buffer, size);
     }
+    // Drops data previously returned by peek().
+    void discard(size_t);
 
     bool is_empty() const { return m_empty; }
 
+    size_t capacity() const { return m_capacity; }
     size_t space_for_writing() const { return m_space_for_writing; }
     size_t immediately_readable() const
     {
@@ -4,18 +4,46 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/HashTable.h>
 #include <AK/IntrusiveList.h>
+#include <AK/NumericLimits.h>
+#include <AK/QuickSort.h>
+#include <AK/Singleton.h>
 #include <Kernel/Debug.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 #include <Kernel/Process.h>
+#include <Kernel/Tasks/WritebackTask.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
+// We never keep more than this much data per file system on its way into the cache.
+static constexpr size_t max_readahead_bytes_in_flight = 2 * MiB;
+
+// The writeback never writes more than this much data in one go, so that it doesn't hog the device.
+static constexpr size_t max_writeback_batch_bytes = 1 * MiB;
+
+// Writers between the background and the hard dirty limit are slowed down by up to this much per write.
+static constexpr i64 max_writer_pause_ms = 20;
+// Writers over the hard dirty limit wait for the writeback for at most this long per write.
+static constexpr i64 max_writer_wait_ms = 1000;
+
+static Singleton<SpinlockProtected<BlockBasedFileSystem::ReadaheadStatistics>> s_readahead_statistics;
+static Singleton<SpinlockProtected<BlockBasedFileSystem::WritebackStatistics>> s_writeback_statistics;
+static Singleton<SpinlockProtected<BlockBasedFileSystem::WritebackSettings>> s_writeback_settings;
+
 struct CacheEntry {
     IntrusiveListNode<CacheEntry> list_node;
     BlockBasedFileSystem::BlockIndex block_index { 0 };
     u8* data { nullptr };
+    Time dirty_since;
     bool has_data { false };
+    bool is_readahead { false };
+    bool is_under_writeback { false };
+    bool was_dirtied_during_writeback { false };
 };
 
 class DiskCache {
@@ -37,22 +65,50 @@ public:
     bool is_dirty() const { return !m_dirty_list.is_empty(); }
     bool entry_is_dirty(CacheEntry const& entry) const { return m_dirty_list.contains(entry); }
 
-    void mark_all_clean()
-    {
-        while (auto* entry = m_dirty_list.first())
-            m_clean_list.prepend(*entry);
-    }
-
     void mark_dirty(CacheEntry& entry)
     {
+        if (entry.is_under_writeback)
+            entry.was_dirtied_during_writeback = true;
+        if (!entry_is_dirty(entry)) {
+            entry.dirty_since = TimeManagement::the().monotonic_time(TimePrecision::Coarse);
+            m_fs.m_dirty_block_count.fetch_add(1);
+        }
         m_dirty_list.prepend(entry);
     }
 
-    void mark_clean(CacheEntry& entry)
+    void mark_clean(CacheEntry& entry) const
     {
+        if (entry_is_dirty(entry))
+            m_fs.m_dirty_block_count.fetch_sub(1);
         m_clean_list.prepend(entry);
     }
 
+    // Makes the entry the first one to be reused once we run out of clean entries.
+    void mark_reclaimable(CacheEntry& entry)
+    {
+        if (!entry_is_dirty(entry))
+            m_clean_list.append(entry);
+    }
+
+    void did_use_readahead_entry(CacheEntry& entry)
+    {
+        if (!entry.is_readahead)
+            return;
+        entry.is_readahead = false;
+        s_readahead_statistics->with([](auto& statistics) { ++statistics.hits; });
+    }
+
+    bool is_being_read_ahead(BlockBasedFileSystem::BlockIndex block_index) const { return m_readahead_blocks.contains(block_index); }
+    size_t readahead_block_count() const { return m_readahead_blocks.size(); }
+    ErrorOr<void> start_readahead(BlockBasedFileSystem::BlockIndex block_index)
+    {
+        TRY(m_readahead_blocks.try_set(block_index));
+        return {};
+    }
+    // Returns false if the readahead of this block has been cancelled in the meantime.
+    bool finish_readahead(BlockBasedFileSystem::BlockIndex block_index) { return m_readahead_blocks.remove(block_index); }
+    void cancel_readahead(BlockBasedFileSystem::BlockIndex block_index) { m_readahead_blocks.remove(block_index); }
+
     CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index) const
     {
         auto it = m_hash.find(block_index);
@@ -69,10 +125,10 @@ public:
             return entry;
 
         if (m_clean_list.is_empty()) {
-            // Not a single clean entry! Flush writes and try again.
-            // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
-            //       not some FileBackedFileSystem subclass flush!
-            m_fs.flush_writes_impl();
+            // Not a single clean entry! Write out the dirty ones and try again.
+            // NOTE: We can't wait for the writeback here, as it needs the cache lock that we're holding.
+            write_out_dirty_entries();
+            VERIFY(!m_clean_list.is_empty());
             return ensure(block_index);
         }
 
@@ -83,8 +139,12 @@ public:
         m_hash.remove(new_entry.block_index);
         TRY(m_hash.try_set(block_index, &new_entry));
 
+        if (new_entry.is_readahead)
+            s_readahead_statistics->with([](auto& statistics) { ++statistics.unused; });
+
         new_entry.block_index = block_index;
         new_entry.has_data = false;
+        new_entry.is_readahead = false;
 
         return &new_entry;
     }
@@ -92,18 +152,43 @@ public:
     CacheEntry const* entries() const { return (CacheEntry const*)m_entries->data(); }
     CacheEntry* entries() { return (CacheEntry*)m_entries->data(); }
 
+    // Iterates over the dirty entries, starting with the one that was least recently written to.
     template<typename Callback>
     void for_each_dirty_entry(Callback callback)
     {
-        for (auto& entry : m_dirty_list)
-            callback(entry);
+        for (auto it = m_dirty_list.rbegin(); it != m_dirty_list.rend(); ++it) {
+            if (callback(*it) == IterationDecision::Break)
+                break;
+        }
     }
 
 private:
+    void write_out_dirty_entries() const
+    {
+        size_t count = 0;
+        for (size_t i = m_fs.m_dirty_block_count.load(); i > 0; --i) {
+            auto* entry = m_dirty_list.last();
+            if (!entry)
+                break;
+            // Entries that are being written back can't be reused until the writeback is done anyway.
+            if (entry->is_under_writeback) {
+                m_dirty_list.prepend(*entry);
+                continue;
+            }
+            auto base_offset = entry->block_index.value() * m_fs.block_size();
+            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
+            [[maybe_unused]] auto rc = m_fs.file_description().write(base_offset, entry_data_buffer, m_fs.block_size());
+            mark_clean(*entry);
+            ++count;
+        }
+        dbgln_if(BBFS_DEBUG, "{}: Block cache full, wrote {} blocks to disk", m_fs.class_name(), count);
+    }
+
     BlockBasedFileSystem& m_fs;
     mutable HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
     mutable IntrusiveList<&CacheEntry::list_node> m_clean_list;
     mutable IntrusiveList<&CacheEntry::list_node> m_dirty_list;
+    HashTable<BlockBasedFileSystem::BlockIndex> m_readahead_blocks;
     NonnullOwnPtr<KBuffer> m_cached_block_data;
     NonnullOwnPtr<KBuffer> m_entries;
 };
@@ -123,6 +208,9 @@ ErrorOr<void> BlockBasedFileSystem::initialize()
     auto entries_data = TRY(KBuffer::try_create_with_size(DiskCache::EntryCount * sizeof(CacheEntry)));
     auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data))));
 
+    m_writeback_buffer = TRY(KBuffer::try_create_with_size(max_writeback_batch_bytes, Memory::Region::Access::ReadWrite, "BlockBasedFileSystem: Writeback"sv));
+    TRY(m_writeback_batch.try_ensure_capacity(max<size_t>(max_writeback_batch_bytes / block_size(), 1)));
+
     m_cache.with_exclusive([&](auto& cache) {
         cache = move(disk_cache);
     });
@@ -148,6 +236,15 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, UserOrKernelBu
             u64 base_offset = index.value() * block_size() + offset;
             auto nwritten = TRY(file_description().write(base_offset, data, count));
             VERIFY(nwritten == count);
+
+            // Make sure neither the cache nor a pending readahead of this block hold on to outdated data.
+            cache->cancel_readahead(index);
+            if (auto* entry = cache->get(index); entry && entry->has_data) {
+                memcpy(entry->data + offset, buffered_data.data(), count);
+                // An older version of the block might still be on its way to the disk, so make sure it'll be written again.
+                if (entry->is_under_writeback)
+                    cache->mark_dirty(*entry);
+            }
             return {};
         }
 
@@ -204,10 +301,31 @@ ErrorOr<void> BlockBasedFileSystem::write_blocks(BlockIndex index, unsigned coun
 {
     VERIFY(m_logical_block_size);
     dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::write_blocks {}, count={}", index, count);
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(write_block(BlockIndex { index.value() + i }, data.offset(i * block_size()), block_size(), 0, allow_cache));
+    if (allow_cache || count == 1) {
+        // NOTE: The writeback merges adjacent dirty blocks into larger requests for us.
+        for (unsigned i = 0; i < count; ++i) {
+            TRY(write_block(BlockIndex { index.value() + i }, data.offset(i * block_size()), block_size(), 0, allow_cache));
+        }
+        return {};
     }
-    return {};
+
+    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+        TRY(write_blocks_to_device(index, count, data));
+
+        // Make sure neither the cache nor a pending readahead of these blocks hold on to outdated data.
+        for (unsigned i = 0; i < count; ++i) {
+            BlockIndex block_index { index.value() + i };
+            cache->cancel_readahead(block_index);
+            auto* entry = cache->get(block_index);
+            if (!entry || !entry->has_data)
+                continue;
+            TRY(data.read(entry->data, i * block_size(), block_size()));
+            // An older version of the block might still be on its way to the disk, so make sure it'll be written again.
+            if (entry->is_under_writeback)
+                cache->mark_dirty(*entry);
+        }
+        return {};
+    });
 }
 
 ErrorOr<void> BlockBasedFileSystem::read_block(BlockIndex index, UserOrKernelBuffer* buffer, size_t count, u64 offset, bool allow_cache) const
@@ -218,6 +336,15 @@ ErrorOr<void> BlockBasedFileSystem::read_block(BlockIndex index, UserOrKernelBuf
 
     return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
         if (!allow_cache) {
+            // The block may have been read ahead for us. If so, hand it out and let it be
+            // the next one to go, as the caller wasn't interested in keeping it cached.
+            if (auto* entry = cache->get(index); entry && entry->has_data && entry->is_readahead) {
+                TRY(buffer->write(entry->data + offset, count));
+                cache->did_use_readahead_entry(*entry);
+                cache->mark_reclaimable(*entry);
+                return {};
+            }
+
             const_cast<BlockBasedFileSystem*>(this)->flush_specific_block_if_needed(index);
             u64 base_offset = index.value() * block_size() + offset;
             auto nread = TRY(file_description().read(*buffer, base_offset, count));
@@ -232,6 +359,8 @@ ErrorOr<void> BlockBasedFileSystem::read_block(BlockIndex index, UserOrKernelBuf
             auto nread = TRY(file_description().read(entry_data_buffer, base_offset, block_size()));
             VERIFY(nread == block_size());
             entry->has_data = true;
+        } else {
+            cache->did_use_readahead_entry(*entry);
         }
         if (buffer)
             TRY(buffer->write(entry->data + offset, count));
@@ -246,15 +375,209 @@ ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count
         return EINVAL;
     if (count == 1)
         return read_block(index, &buffer, block_size(), 0, allow_cache);
-    auto out = buffer;
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(read_block(BlockIndex { index.value() + i }, &out, block_size(), 0, allow_cache));
-        out = out.offset(block_size());
+
+    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+        bool all_blocks_cached = true;
+        for (unsigned i = 0; i < count && all_blocks_cached; ++i) {
+            auto* entry = cache->get(BlockIndex { index.value() + i });
+            all_blocks_cached = entry && entry->has_data;
+        }
+
+        // Userspace can modify its buffers at any point, so we can't fill the cache from them.
+        // Instead, read into a kernel buffer first and copy that out to the caller.
+        OwnPtr<KBuffer> bounce_buffer;
+        if (!all_blocks_cached && allow_cache && !buffer.is_kernel_buffer())
+            bounce_buffer = TRY(KBuffer::try_create_with_size(count * block_size(), Memory::Region::Access::ReadWrite, "BlockBasedFileSystem: Bounce"sv));
+        auto device_buffer = bounce_buffer ? UserOrKernelBuffer::for_kernel_buffer(bounce_buffer->data()) : buffer;
+
+        // Read the whole run in one go, then let whatever we have in the cache take precedence
+        // over what's on disk, as it may be more recent.
+        if (!all_blocks_cached)
+            TRY(read_blocks_from_device(index, count, device_buffer));
+
+        for (unsigned i = 0; i < count; ++i) {
+            BlockIndex block_index { index.value() + i };
+            auto* entry = cache->get(block_index);
+            if (entry && entry->has_data) {
+                TRY(buffer.write(entry->data, i * block_size(), block_size()));
+                bool was_read_ahead = entry->is_readahead;
+                cache->did_use_readahead_entry(*entry);
+                if (!allow_cache && was_read_ahead)
+                    cache->mark_reclaimable(*entry);
+                continue;
+            }
+            if (bounce_buffer)
+                TRY(buffer.write(bounce_buffer->data() + i * block_size(), i * block_size(), block_size()));
+            if (!allow_cache)
+                continue;
+            auto* new_entry = TRY(cache->ensure(block_index));
+            TRY(device_buffer.read(new_entry->data, i * block_size(), block_size()));
+            new_entry->has_data = true;
+        }
+        return {};
+    });
+}
+
+void BlockBasedFileSystem::read_ahead_blocks(BlockIndex index, size_t count)
+{
+    VERIFY(m_logical_block_size);
+    auto blocks_to_read = m_cache.with_exclusive([&](auto& cache) -> size_t {
+        // Skip over whatever we already have, and stop at the first block we have after that.
+        while (count > 0 && (cache->get(index) || cache->is_being_read_ahead(index))) {
+            index = index.value() + 1;
+            --count;
+        }
+
+        size_t max_blocks_in_flight = max<size_t>(max_readahead_bytes_in_flight / block_size(), 1);
+        if (cache->readahead_block_count() >= max_blocks_in_flight)
+            return 0;
+        count = min(count, max_blocks_in_flight - cache->readahead_block_count());
+
+        size_t blocks_to_read = 0;
+        for (; blocks_to_read < count; ++blocks_to_read) {
+            BlockIndex block_index { index.value() + blocks_to_read };
+            if (cache->get(block_index) || cache->is_being_read_ahead(block_index))
+                break;
+            if (cache->start_readahead(block_index).is_error())
+                break;
+        }
+        return blocks_to_read;
+    });
+    if (blocks_to_read == 0)
+        return;
+
+    dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_ahead_blocks {}, count={}", index, blocks_to_read);
+    g_readahead_work->queue([fs = NonnullRefPtr<BlockBasedFileSystem>(*this), index, blocks_to_read]() mutable {
+        if (auto result = fs->read_ahead(index, blocks_to_read); result.is_error())
+            dbgln("{}: Failed to read ahead {} blocks at {}: {}", fs->class_name(), blocks_to_read, index, result.error());
+    });
+}
+
+ErrorOr<void> BlockBasedFileSystem::read_ahead(BlockIndex index, size_t count)
+{
+    auto data_or_error = [&]() -> ErrorOr<NonnullOwnPtr<KBuffer>> {
+        auto data = TRY(KBuffer::try_create_with_size(count * block_size(), Memory::Region::Access::ReadWrite, "BlockBasedFileSystem: Readahead"sv));
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(data->data());
+        TRY(read_blocks_from_device(index, count, buffer));
+        return data;
+    }();
+
+    size_t cached_blocks = 0;
+    m_cache.with_exclusive([&](auto& cache) {
+        for (size_t i = 0; i < count; ++i) {
+            BlockIndex block_index { index.value() + i };
+            // NOTE: We always have to clear the readahead state of all blocks, even if we failed to read them.
+            if (!cache->finish_readahead(block_index) || data_or_error.is_error())
+                continue;
+            // Someone else might have brought the block into the cache while we were waiting for the device.
+            if (cache->get(block_index))
+                continue;
+            auto entry_or_error = cache->ensure(block_index);
+            if (entry_or_error.is_error())
+                continue;
+            auto* entry = entry_or_error.release_value();
+            memcpy(entry->data, data_or_error.value()->data() + i * block_size(), block_size());
+            entry->has_data = true;
+            entry->is_readahead = true;
+            ++cached_blocks;
+        }
+    });
+
+    s_readahead_statistics->with([&](auto& statistics) {
+        ++statistics.requests;
+        statistics.blocks += cached_blocks;
+    });
+
+    if (data_or_error.is_error())
+        return data_or_error.release_error();
+    return {};
+}
+
+// Submits all requests up front, so the device can work through them back-to-back.
+static ErrorOr<void> transfer_blocks(BlockDevice& device, AsyncBlockDeviceRequest::RequestType request_type, u64 base_offset, size_t size, UserOrKernelBuffer const& buffer)
+{
+    // NOTE: Some storage controllers can't transfer more than a page per request.
+    size_t request_size = max(static_cast<size_t>(PAGE_SIZE), device.block_size());
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>> requests;
+    TRY(requests.try_ensure_capacity(ceil_div(size, request_size)));
+
+    ErrorOr<void> result {};
+    for (size_t offset = 0; offset < size; offset += request_size) {
+        auto chunk_size = min(request_size, size - offset);
+        auto request_or_error = device.try_make_request<AsyncBlockDeviceRequest>(request_type,
+            (base_offset + offset) >> device.block_size_log(), chunk_size >> device.block_size_log(),
+            buffer.offset(offset), chunk_size);
+        if (request_or_error.is_error()) {
+            result = request_or_error.release_error();
+            break;
+        }
+        requests.unchecked_append(request_or_error.release_value());
     }
 
+    // NOTE: We have to wait for every request we submitted, as they're accessing our buffer.
+    for (auto& request : requests) {
+        auto wait_result = request->wait();
+        if (result.is_error())
+            continue;
+        if (wait_result.wait_result().was_interrupted())
+            result = Error::from_errno(EINTR);
+        else if (wait_result.request_result() == AsyncDeviceRequest::MemoryFault)
+            result = Error::from_errno(EFAULT);
+        else if (wait_result.request_result() != AsyncDeviceRequest::Success)
+            result = Error::from_errno(EIO);
+    }
+    return result;
+}
+
+BlockDevice* BlockBasedFileSystem::block_device_for_transfer(u64 base_offset, size_t size) const
+{
+    auto& file = file_description().file();
+    if (!file.is_block_device())
+        return nullptr;
+    auto& device = static_cast<BlockDevice&>(file);
+    if (base_offset % device.block_size() != 0 || size % device.block_size() != 0)
+        return nullptr;
+    return &device;
+}
+
+ErrorOr<void> BlockBasedFileSystem::read_blocks_from_device(BlockIndex index, size_t count, UserOrKernelBuffer& buffer) const
+{
+    u64 base_offset = index.value() * block_size();
+    size_t size = count * block_size();
+    if (auto* device = block_device_for_transfer(base_offset, size))
+        return transfer_blocks(*device, AsyncBlockDeviceRequest::Read, base_offset, size, buffer);
+
+    for (size_t nread = 0; nread < size;) {
+        auto buffer_offset = buffer.offset(nread);
+        auto nread_now = TRY(file_description().read(buffer_offset, base_offset + nread, size - nread));
+        if (nread_now == 0)
+            return EIO;
+        nread += nread_now;
+    }
+    return {};
+}
+
+ErrorOr<void> BlockBasedFileSystem::write_blocks_to_device(BlockIndex index, size_t count, UserOrKernelBuffer const& buffer)
+{
+    u64 base_offset = index.value() * block_size();
+    size_t size = count * block_size();
+    if (auto* device = block_device_for_transfer(base_offset, size))
+        return transfer_blocks(*device, AsyncBlockDeviceRequest::Write, base_offset, size, buffer);
+
+    for (size_t nwritten = 0; nwritten < size;) {
+        auto nwritten_now = TRY(file_description().write(base_offset + nwritten, buffer.offset(nwritten), size - nwritten));
+        if (nwritten_now == 0)
+            return EIO;
+        nwritten += nwritten_now;
+    }
     return {};
 }
 
+BlockBasedFileSystem::ReadaheadStatistics BlockBasedFileSystem::readahead_statistics()
+{
+    return s_readahead_statistics->with([](auto& statistics) { return statistics; });
+}
+
 void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
 {
     m_cache.with_exclusive([&](auto& cache) {
@@ -271,21 +594,165 @@ void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
     });
 }
 
-void BlockBasedFileSystem::flush_writes_impl()
+size_t BlockBasedFileSystem::write_back_dirty_blocks(size_t max_count, Optional<Time> dirtied_before)
 {
-    size_t count = 0;
+    MutexLocker writeback_locker(m_writeback_lock);
+    VERIFY(m_writeback_buffer);
+
+    max_count = min(max_count, max<size_t>(max_writeback_batch_bytes / block_size(), 1));
+    m_writeback_batch.clear_with_capacity();
+
     m_cache.with_exclusive([&](auto& cache) {
-        if (!cache->is_dirty())
-            return;
         cache->for_each_dirty_entry([&](CacheEntry& entry) {
-            auto base_offset = entry.block_index.value() * block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, block_size());
-            ++count;
+            if (m_writeback_batch.size() >= max_count)
+                return IterationDecision::Break;
+            if (entry.is_under_writeback)
+                return IterationDecision::Continue;
+            if (dirtied_before.has_value() && entry.dirty_since >= dirtied_before.value())
+                return IterationDecision::Continue;
+            m_writeback_batch.unchecked_append(&entry);
+            return IterationDecision::Continue;
         });
-        cache->mark_all_clean();
-        dbgln("{}: Flushed {} blocks to disk", class_name(), count);
+
+        // Write the blocks in ascending order, so neighboring blocks end up in a single request.
+        quick_sort(m_writeback_batch, [](auto* a, auto* b) { return a->block_index < b->block_index; });
+
+        // NOTE: We write out a copy of the data, so we don't have to hold on to the cache lock while the device is busy.
+        for (size_t i = 0; i < m_writeback_batch.size(); ++i) {
+            auto& entry = *m_writeback_batch[i];
+            memcpy(m_writeback_buffer->data() + i * block_size(), entry.data, block_size());
+            entry.is_under_writeback = true;
+            entry.was_dirtied_during_writeback = false;
+        }
+    });
+
+    if (m_writeback_batch.is_empty())
+        return 0;
+
+    size_t request_count = 0;
+    for (size_t run_start = 0; run_start < m_writeback_batch.size();) {
+        size_t run_length = 1;
+        auto first_block_index = m_writeback_batch[run_start]->block_index;
+        while (run_start + run_length < m_writeback_batch.size() && m_writeback_batch[run_start + run_length]->block_index.value() == first_block_index.value() + run_length)
+            ++run_length;
+
+        if (auto result = write_blocks_to_device(first_block_index, run_length, UserOrKernelBuffer::for_kernel_buffer(m_writeback_buffer->data() + run_start * block_size())); result.is_error())
+            dbgln("{}: Failed to write back {} blocks at {}: {}", class_name(), run_length, first_block_index, result.error());
+        run_start += run_length;
+        ++request_count;
+    }
+
+    m_cache.with_exclusive([&](auto& cache) {
+        for (auto* entry : m_writeback_batch) {
+            entry->is_under_writeback = false;
+            if (entry->was_dirtied_during_writeback)
+                entry->dirty_since = TimeManagement::the().monotonic_time(TimePrecision::Coarse);
+            else
+                cache->mark_clean(*entry);
+            entry->was_dirtied_during_writeback = false;
+        }
     });
+
+    s_writeback_statistics->with([&](auto& statistics) {
+        statistics.blocks += m_writeback_batch.size();
+        statistics.requests += request_count;
+    });
+    m_writeback_wait_queue.wake_all();
+    return m_writeback_batch.size();
+}
+
+void BlockBasedFileSystem::write_back_dirty_data()
+{
+    auto settings = writeback_settings();
+
+    // First, get back below the background limit.
+    size_t background_limit = DiskCache::EntryCount * settings.dirty_background_ratio / 100;
+    while (m_dirty_block_count.load() > background_limit) {
+        if (write_back_dirty_blocks(m_dirty_block_count.load() - background_limit, {}) == 0)
+            break;
+    }
+
+    // Then write back everything that has been dirty for too long.
+    auto dirtied_before = TimeManagement::the().monotonic_time(TimePrecision::Coarse) - Time::from_milliseconds(settings.dirty_expire_ms);
+    while (write_back_dirty_blocks(NumericLimits<size_t>::max(), dirtied_before) > 0)
+        ;
+}
+
+void BlockBasedFileSystem::throttle_writer()
+{
+    auto settings = writeback_settings();
+    size_t background_limit = DiskCache::EntryCount * settings.dirty_background_ratio / 100;
+    size_t dirty_limit = DiskCache::EntryCount * settings.dirty_ratio / 100;
+
+    size_t dirty_block_count = m_dirty_block_count.load();
+    if (dirty_block_count <= background_limit)
+        return;
+    WritebackTask::wake();
+
+    i64 throttled_ms = 0;
+    if (dirty_block_count < dirty_limit) {
+        // Slow the writer down a little more the closer we get to the hard limit, so the writeback can keep up
+        // before anyone has to wait for it.
+        throttled_ms = max_writer_pause_ms * static_cast<i64>(dirty_block_count - background_limit) / static_cast<i64>(dirty_limit - background_limit);
+        if (throttled_ms > 0)
+            (void)Thread::current()->sleep(Time::from_milliseconds(throttled_ms));
+    } else {
+        // We're over the hard limit, so wait for the writeback to catch up.
+        // NOTE: We give up after a while, as the writer might be holding locks that somebody else needs to make progress.
+        auto start = TimeManagement::the().monotonic_time(TimePrecision::Coarse);
+        auto deadline = start + Time::from_milliseconds(max_writer_wait_ms);
+        while (m_dirty_block_count.load() >= dirty_limit) {
+            auto now = TimeManagement::the().monotonic_time(TimePrecision::Coarse);
+            if (now >= deadline)
+                break;
+            auto timeout = deadline - now;
+            WritebackTask::wake();
+            if (m_writeback_wait_queue.wait_on(Thread::BlockTimeout(false, &timeout), "BlockBasedFileSystem"sv).was_interrupted())
+                break;
+        }
+        throttled_ms = (TimeManagement::the().monotonic_time(TimePrecision::Coarse) - start).to_milliseconds();
+    }
+
+    s_writeback_statistics->with([&](auto& statistics) {
+        ++statistics.throttled_writes;
+        statistics.throttled_ms += throttled_ms;
+    });
+}
+
+BlockBasedFileSystem::WritebackStatistics BlockBasedFileSystem::writeback_statistics()
+{
+    return s_writeback_statistics->with([](auto& statistics) { return statistics; });
+}
+
+BlockBasedFileSystem::WritebackSettings BlockBasedFileSystem::writeback_settings()
+{
+    return s_writeback_settings->with([](auto& settings) { return settings; });
+}
+
+ErrorOr<void> BlockBasedFileSystem::set_writeback_settings(WritebackSettings const& new_settings)
+{
+    if (new_settings.dirty_ratio == 0 || new_settings.dirty_ratio > 100)
+        return EINVAL;
+    if (new_settings.dirty_background_ratio == 0 || new_settings.dirty_background_ratio >= new_settings.dirty_ratio)
+        return EINVAL;
+    s_writeback_settings->with([&](auto& settings) { settings = new_settings; });
+    return {};
+}
+
+void BlockBasedFileSystem::flush_writes_impl()
+{
+    // NOTE: Don't try to chase writers that keep dirtying blocks, just write out what's dirty right now.
+    size_t count = 0;
+    size_t remaining = m_dirty_block_count.load();
+    while (remaining > 0) {
+        auto written = write_back_dirty_blocks(remaining, {});
+        if (written == 0)
+            break;
+        count += written;
+        remaining -= min(written, remaining);
+    }
+    if (count > 0)
+        dbgln("{}: Flushed {} blocks to disk", class_name(), count);
 }
 
 void BlockBasedFileSystem::flush_writes()
@@ -6,21 +6,59 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
+#include <AK/Time.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/Locking/MutexProtected.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
+struct CacheEntry;
+
 class BlockBasedFileSystem : public FileBackedFileSystem {
 public:
     TYPEDEF_DISTINCT_ORDERED_ID(u64, BlockIndex);
 
+    struct ReadaheadStatistics {
+        u64 requests { 0 };
+        u64 blocks { 0 };
+        u64 hits { 0 };
+        u64 unused { 0 };
+    };
+    static ReadaheadStatistics readahead_statistics();
+
+    struct WritebackStatistics {
+        u64 blocks { 0 };
+        u64 requests { 0 };
+        u64 throttled_writes { 0 };
+        u64 throttled_ms { 0 };
+    };
+    static WritebackStatistics writeback_statistics();
+
+    // These apply to the block cache of every block based file system.
+    struct WritebackSettings {
+        // Once this percentage of the cache is dirty, the writeback starts writing blocks back in the background...
+        u32 dirty_background_ratio { 10 };
+        // ...and once this percentage is dirty, writers have to wait for it.
+        u32 dirty_ratio { 30 };
+        // Blocks that have been dirty for longer than this are written back, regardless of how much is dirty.
+        u32 dirty_expire_ms { 3000 };
+    };
+    static WritebackSettings writeback_settings();
+    static ErrorOr<void> set_writeback_settings(WritebackSettings const&);
+
     virtual ~BlockBasedFileSystem() override;
     virtual ErrorOr<void> initialize() override;
 
     u64 logical_block_size() const { return m_logical_block_size; };
 
+    virtual bool supports_page_cache() const override { return true; }
+
     virtual void flush_writes() override;
+    virtual void flush_metadata_writes() override { }
+    virtual void write_back_dirty_data() override;
+    virtual void throttle_writer() override;
     void flush_writes_impl();
 
 protected:
@@ -38,13 +76,33 @@ protected:
     ErrorOr<void> write_block(BlockIndex, UserOrKernelBuffer const&, size_t count, u64 offset = 0, bool allow_cache = true);
     ErrorOr<void> write_blocks(BlockIndex, unsigned count, UserOrKernelBuffer const&, bool allow_cache = true);
 
+    // Starts reading the given blocks into the block cache in the background.
+    void read_ahead_blocks(BlockIndex, size_t count);
+
     u64 m_logical_block_size { 512 };
 
 private:
+    friend class DiskCache;
+
     DiskCache& cache() const;
     void flush_specific_block_if_needed(BlockIndex index);
 
+    ErrorOr<void> read_ahead(BlockIndex, size_t count);
+    size_t write_back_dirty_blocks(size_t max_count, Optional<Time> dirtied_before);
+
+    BlockDevice* block_device_for_transfer(u64 base_offset, size_t size) const;
+    ErrorOr<void> read_blocks_from_device(BlockIndex, size_t count, UserOrKernelBuffer&) const;
+    ErrorOr<void> write_blocks_to_device(BlockIndex, size_t count, UserOrKernelBuffer const&);
+
     mutable MutexProtected<OwnPtr<DiskCache>> m_cache;
+
+    // NOTE: This is only ever touched with the cache lock held, but we want to be able to peek at it without it.
+    Atomic<size_t> m_dirty_block_count { 0 };
+
+    Mutex m_writeback_lock;
+    OwnPtr<KBuffer> m_writeback_buffer;
+    Vector<CacheEntry*> m_writeback_batch;
+    WaitQueue m_writeback_wait_queue;
 };
 
 }
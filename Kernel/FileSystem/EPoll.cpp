@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/EPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KString.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+ErrorOr<NonnullOwnPtr<EPoll::Item>> EPoll::Item::try_create(EPoll& epoll, int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    auto weak_description = TRY(description.try_make_weak_ptr());
+    return adopt_nonnull_own_or_enomem(new (nothrow) Item(epoll, fd, move(weak_description), description.file(), description.blocker_set(), event));
+}
+
+EPoll::Item::Item(EPoll& epoll, int fd, WeakPtr<OpenFileDescription> description, NonnullRefPtr<File> file, FileBlockerSet& blocker_set, epoll_event const& event)
+    : m_epoll(epoll)
+    , m_fd(fd)
+    , m_description(move(description))
+    , m_file(move(file))
+    , m_blocker_set(blocker_set)
+    , m_events(event.events)
+    , m_data(event.data.u64)
+{
+    m_blocker_set.add_watcher(*this);
+}
+
+EPoll::Item::~Item()
+{
+    // Once we no longer watch the file, nobody else can put us back on the ready list.
+    m_blocker_set.remove_watcher(*this);
+    m_epoll.m_ready_items.with([&](auto&) {
+        if (m_ready_list_node.is_in_list())
+            m_ready_list_node.remove();
+    });
+}
+
+void EPoll::Item::set_event(epoll_event const& event)
+{
+    m_events = event.events;
+    m_data = event.data.u64;
+    m_disabled = false;
+}
+
+void EPoll::Item::file_state_may_have_changed()
+{
+    if (m_disabled)
+        return;
+    m_epoll.mark_ready(*this);
+}
+
+ErrorOr<NonnullRefPtr<EPoll>> EPoll::try_create()
+{
+    return adopt_nonnull_ref_or_enomem(new (nothrow) EPoll);
+}
+
+EPoll::~EPoll()
+{
+    (void)close();
+}
+
+bool EPoll::can_read(OpenFileDescription const&, u64) const
+{
+    return m_ready_items.with([](auto& ready_items) { return !ready_items.is_empty(); });
+}
+
+ErrorOr<void> EPoll::close()
+{
+    MutexLocker locker(m_lock);
+    // NOTE: Items have to stop watching their files before they go away, so they're destroyed one by one.
+    while (!m_items.is_empty())
+        remove_item(m_items.begin()->key);
+    return {};
+}
+
+ErrorOr<NonnullOwnPtr<KString>> EPoll::pseudo_path(OpenFileDescription const&) const
+{
+    MutexLocker locker(m_lock);
+    return KString::formatted("EPoll:({})", m_items.size());
+}
+
+void EPoll::mark_ready(Item& item)
+{
+    bool was_queued = m_ready_items.with([&](auto& ready_items) {
+        if (item.m_ready_list_node.is_in_list())
+            return false;
+        ready_items.append(item);
+        return true;
+    });
+    // Anyone waiting on us has already been woken up if the ready list wasn't empty.
+    if (was_queued)
+        evaluate_block_conditions();
+}
+
+void EPoll::remove_item(int fd)
+{
+    VERIFY(m_lock.is_locked());
+    bool removed = m_items.remove(fd);
+    VERIFY(removed);
+}
+
+ErrorOr<void> EPoll::add(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    // FIXME: Allow nesting these, once we can detect loops between them.
+    if (description.is_epoll())
+        return EINVAL;
+
+    MutexLocker locker(m_lock);
+    if (auto it = m_items.find(fd); it != m_items.end()) {
+        if (it->value->is_for(description))
+            return EEXIST;
+        // The fd has been closed (and possibly reused) since it was added, so the item is stale.
+        remove_item(fd);
+    }
+
+    auto item = TRY(Item::try_create(*this, fd, description, event));
+    auto& item_ref = *item;
+    TRY(m_items.try_set(fd, move(item)));
+    // Report whatever state the file is already in, the next epoll_wait() call will find out.
+    mark_ready(item_ref);
+    return {};
+}
+
+ErrorOr<void> EPoll::modify(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    MutexLocker locker(m_lock);
+    auto it = m_items.find(fd);
+    if (it == m_items.end() || !it->value->is_for(description))
+        return ENOENT;
+    it->value->set_event(event);
+    mark_ready(*it->value);
+    return {};
+}
+
+ErrorOr<void> EPoll::remove(int fd, OpenFileDescription& description)
+{
+    MutexLocker locker(m_lock);
+    auto it = m_items.find(fd);
+    if (it == m_items.end() || !it->value->is_for(description))
+        return ENOENT;
+    remove_item(fd);
+    return {};
+}
+
+size_t EPoll::collect_ready_events(Span<epoll_event> events)
+{
+    MutexLocker locker(m_lock);
+
+    Vector<int, 16> dead_fds;
+    size_t count = 0;
+    // NOTE: Level triggered items go back to the end of the list, so only look at the items that were there when we started.
+    auto candidates = m_ready_items.with([](auto& ready_items) { return ready_items.size_slow(); });
+    for (size_t i = 0; i < candidates && count < events.size(); ++i) {
+        auto* item = m_ready_items.with([](auto& ready_items) { return ready_items.take_first(); });
+        if (!item)
+            break;
+        if (item->is_disabled())
+            continue;
+
+        auto description = item->description();
+        if (!description) {
+            // The file description is gone, and with it any chance of this item becoming ready.
+            (void)dead_fds.try_append(item->fd());
+            continue;
+        }
+
+        auto block_flags = BlockFlags::None;
+        if (item->events() & EPOLLIN)
+            block_flags |= BlockFlags::Read;
+        if (item->events() & EPOLLOUT)
+            block_flags |= BlockFlags::Write;
+
+        // NOTE: We can't ask the file while holding the ready list lock, as that might block.
+        auto unblock_flags = description->should_unblock(block_flags);
+        u32 ready_events = 0;
+        if (has_flag(unblock_flags, BlockFlags::Read))
+            ready_events |= EPOLLIN;
+        if (has_flag(unblock_flags, BlockFlags::Write))
+            ready_events |= EPOLLOUT;
+        // Whatever happened to the file didn't concern us; it'll be put back on the list when something else happens.
+        if (ready_events == 0)
+            continue;
+
+        events[count++] = { .events = ready_events, .data = { .u64 = item->data() } };
+
+        if (item->events() & EPOLLONESHOT) {
+            item->set_disabled();
+            continue;
+        }
+        // An edge triggered item only comes back once the file tells us something changed.
+        // A level triggered one stays on the list for as long as the file is ready.
+        if (!(item->events() & EPOLLET)) {
+            m_ready_items.with([&](auto& ready_items) {
+                if (!item->m_ready_list_node.is_in_list())
+                    ready_items.append(*item);
+            });
+        }
+    }
+
+    for (auto fd : dead_fds) {
+        if (m_items.contains(fd))
+            remove_item(fd);
+    }
+    return count;
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/WeakPtr.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+// An EPoll keeps a persistent set of file descriptions a process is interested in.
+// Instead of registering (and unregistering) a blocker with every single one of them
+// on each call like poll() does, every item watches its file for state changes and
+// puts itself on a ready list, so epoll_wait() only has to look at what actually changed.
+class EPoll final : public File {
+public:
+    static ErrorOr<NonnullRefPtr<EPoll>> try_create();
+    virtual ~EPoll() override;
+
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual ErrorOr<void> close() override;
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "EPoll"sv; }
+    virtual bool is_epoll() const override { return true; }
+
+    ErrorOr<void> add(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> modify(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> remove(int fd, OpenFileDescription&);
+
+    // Fills `events` with as many ready items as it can hold, and returns how many that were.
+    size_t collect_ready_events(Span<epoll_event> events);
+
+private:
+    class Item final : public FileBlockerSet::Watcher {
+    public:
+        static ErrorOr<NonnullOwnPtr<Item>> try_create(EPoll&, int fd, OpenFileDescription&, epoll_event const&);
+        virtual ~Item() override;
+
+        virtual void file_state_may_have_changed() override;
+
+        int fd() const { return m_fd; }
+        RefPtr<OpenFileDescription> description() const { return m_description.strong_ref(); }
+        bool is_for(OpenFileDescription const& description) const { return m_description.unsafe_ptr() == &description; }
+
+        u32 events() const { return m_events; }
+        u64 data() const { return m_data; }
+        void set_event(epoll_event const&);
+
+        bool is_disabled() const { return m_disabled; }
+        void set_disabled() { m_disabled = true; }
+
+        IntrusiveListNode<Item> m_ready_list_node;
+
+    private:
+        Item(EPoll&, int fd, WeakPtr<OpenFileDescription>, NonnullRefPtr<File>, FileBlockerSet&, epoll_event const&);
+
+        EPoll& m_epoll;
+        int m_fd { -1 };
+        WeakPtr<OpenFileDescription> m_description;
+        // NOTE: We hold on to the file, so the blocker set we're watching stays alive
+        //       even if the description is closed while it's still in the set.
+        NonnullRefPtr<File> m_file;
+        FileBlockerSet& m_blocker_set;
+        u32 m_events { 0 };
+        u64 m_data { 0 };
+        bool m_disabled { false };
+    };
+
+    using ReadyList = IntrusiveList<&Item::m_ready_list_node>;
+
+    EPoll() = default;
+
+    void mark_ready(Item&);
+    void remove_item(int fd);
+
+    mutable Mutex m_lock { "EPoll"sv };
+    HashMap<int, NonnullOwnPtr<Item>> m_items;
+    SpinlockProtected<ReadyList> m_ready_items;
+};
+
+}
@@ -7,6 +7,7 @@
 
 #include <AK/HashMap.h>
 #include <AK/MemoryStream.h>
+#include <AK/QuickSort.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringView.h>
 #include <Kernel/API/POSIX/errno.h>
@@ -15,6 +16,7 @@
 #include <Kernel/FileSystem/Ext2FileSystem.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/FileSystem/ext2_fs.h>
+#include <Kernel/Memory/PageCache.h>
 #include <Kernel/Process.h>
 #include <Kernel/UnixTypes.h>
 
@@ -23,6 +25,14 @@ namespace Kernel {
 static constexpr size_t max_block_size = 4096;
 static constexpr size_t max_inline_symlink_length = 60;
 
+// Block reservations start out small and double every time a file fills one up.
+static constexpr size_t min_block_reservation_size = 8;
+static constexpr size_t max_block_reservation_bytes = 4 * MiB;
+static constexpr size_t max_block_reservations = 64;
+
+// Physically contiguous blocks of a file are transferred with a single request, up to this many bytes at a time.
+static constexpr size_t max_contiguous_transfer_bytes = 256 * KiB;
+
 struct Ext2FSDirectoryEntry {
     NonnullOwnPtr<KString> name;
     InodeIndex inode_index { 0 };
@@ -113,6 +123,8 @@ ErrorOr<void> Ext2FS::initialize()
 
     VERIFY(block_size() <= (int)max_block_size);
 
+    m_reservation_bitmap_buffer = TRY(KBuffer::try_create_with_size(block_size(), Memory::Region::Access::ReadWrite, "Ext2FS: Reservation bitmap"));
+
     m_block_group_count = ceil_div(super_block.s_blocks_count, super_block.s_blocks_per_group);
 
     if (m_block_group_count == 0) {
@@ -612,6 +624,8 @@ ErrorOr<void> Ext2FS::free_inode(Ext2FSInode& inode)
     VERIFY(inode.m_raw_inode.i_links_count == 0);
     dbgln_if(EXT2_DEBUG, "Ext2FS[{}]::free_inode(): Inode {} has no more links, time to delete!", fsid(), inode.index());
 
+    discard_block_reservation(inode.index());
+
     // Mark all blocks used by this inode as free.
     {
         auto blocks = TRY(inode.compute_block_list_with_meta_blocks());
@@ -652,6 +666,12 @@ void Ext2FS::flush_block_group_descriptor_table()
 }
 
 void Ext2FS::flush_writes()
+{
+    flush_metadata_writes();
+    BlockBasedFileSystem::flush_writes();
+}
+
+void Ext2FS::flush_metadata_writes()
 {
     {
         MutexLocker locker(m_lock);
@@ -696,8 +716,6 @@ void Ext2FS::flush_writes()
             return cached_inode->ref_count() == 1 && !cached_inode->has_watchers();
         });
     }
-
-    BlockBasedFileSystem::flush_writes();
 }
 
 Ext2FSInode::Ext2FSInode(Ext2FS& fs, InodeIndex index)
@@ -799,6 +817,56 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FS::get_inode(InodeIdentifier inode) const
 }
 
 ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description) const
+{
+    bool allow_cache = !description || !description->is_direct();
+    return read_bytes_impl(offset, count, buffer, allow_cache);
+}
+
+ErrorOr<size_t> Ext2FSInode::read_bytes_for_page_cache(off_t offset, size_t count, UserOrKernelBuffer& buffer) const
+{
+    // The page cache holds on to file contents itself, so don't keep a second copy in the block cache.
+    return read_bytes_impl(offset, count, buffer, false);
+}
+
+void Ext2FSInode::start_readahead(u64 offset, size_t size)
+{
+    MutexLocker inode_locker(m_inode_lock);
+    if (size == 0 || offset >= this->size())
+        return;
+
+    if (m_block_list.is_empty()) {
+        auto block_list_or_error = compute_block_list();
+        if (block_list_or_error.is_error())
+            return;
+        m_block_list = block_list_or_error.release_value();
+    }
+    if (m_block_list.is_empty())
+        return;
+
+    u64 const block_size = fs().block_size();
+    size_t first_block_logical_index = offset / block_size;
+    size_t last_block_logical_index = min((offset + size - 1) / block_size, static_cast<u64>(m_block_list.size() - 1));
+
+    // Coalesce physically contiguous blocks into runs, so they can be read with as few requests as possible.
+    BlockBasedFileSystem::BlockIndex run_start = 0;
+    size_t run_length = 0;
+    for (size_t i = first_block_logical_index; i <= last_block_logical_index; ++i) {
+        auto block_index = m_block_list[i];
+        if (run_length > 0 && block_index.value() == run_start.value() + run_length) {
+            ++run_length;
+            continue;
+        }
+        if (run_length > 0)
+            fs().read_ahead_blocks(run_start, run_length);
+        // Holes don't need to be read from anywhere.
+        run_start = block_index;
+        run_length = block_index.value() == 0 ? 0 : 1;
+    }
+    if (run_length > 0)
+        fs().read_ahead_blocks(run_start, run_length);
+}
+
+ErrorOr<size_t> Ext2FSInode::read_bytes_impl(off_t offset, size_t count, UserOrKernelBuffer& buffer, bool allow_cache) const
 {
     MutexLocker inode_locker(m_inode_lock);
     VERIFY(offset >= 0);
@@ -825,8 +893,6 @@ ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernel
         return EIO;
     }
 
-    bool allow_cache = !description || !description->is_direct();
-
     int const block_size = fs().block_size();
 
     BlockBasedFileSystem::BlockIndex first_block_logical_index = offset / block_size;
@@ -841,7 +907,7 @@ ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernel
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::read_bytes(): Reading up to {} bytes, {} bytes into inode to {}", identifier(), count, offset, buffer.user_or_kernel_ptr());
 
-    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
+    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index;) {
         auto block_index = m_block_list[bi.value()];
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
@@ -849,6 +915,16 @@ ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernel
         if (block_index.value() == 0) {
             // This is a hole, act as if it's filled with zeroes.
             TRY(buffer_offset.memset(0, num_bytes_to_copy));
+        } else if (num_bytes_to_copy == static_cast<size_t>(block_size)) {
+            auto run_length = contiguous_block_count(bi.value(), min(static_cast<size_t>(remaining_count / block_size), static_cast<size_t>(last_block_logical_index.value() - bi.value() + 1)));
+            if (auto result = fs().read_blocks(block_index, run_length, buffer_offset, allow_cache); result.is_error()) {
+                dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read {} blocks at {} (index {})", identifier(), run_length, block_index.value(), bi);
+                return result.release_error();
+            }
+            remaining_count -= run_length * block_size;
+            nread += run_length * block_size;
+            bi = bi.value() + run_length;
+            continue;
         } else {
             if (auto result = fs().read_block(block_index, &buffer_offset, num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
                 dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read block {} (index {})", identifier(), block_index.value(), bi);
@@ -857,11 +933,22 @@ ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernel
         }
         remaining_count -= num_bytes_to_copy;
         nread += num_bytes_to_copy;
+        bi = bi.value() + 1;
     }
 
     return nread;
 }
 
+size_t Ext2FSInode::contiguous_block_count(size_t first_block_logical_index, size_t max_count) const
+{
+    VERIFY(m_block_list[first_block_logical_index].value() != 0);
+    max_count = min(max_count, max<size_t>(max_contiguous_transfer_bytes / fs().block_size(), 1));
+    size_t count = 1;
+    while (count < max_count && m_block_list[first_block_logical_index + count].value() == m_block_list[first_block_logical_index].value() + count)
+        ++count;
+    return count;
+}
+
 ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 {
     auto old_size = size();
@@ -890,9 +977,14 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
         m_block_list = TRY(compute_block_list());
 
     if (blocks_needed_after > blocks_needed_before) {
-        auto blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before));
+        // Try to continue right where the file currently ends on disk.
+        Ext2FS::BlockIndex goal = 0;
+        if (!m_block_list.is_empty() && m_block_list.last().value() != 0)
+            goal = m_block_list.last().value() + 1;
+        auto blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before, index(), goal));
         TRY(m_block_list.try_extend(move(blocks)));
     } else if (blocks_needed_after < blocks_needed_before) {
+        fs().discard_block_reservation(index());
         if constexpr (EXT2_VERY_DEBUG) {
             dbgln("Ext2FSInode[{}]::resize(): Shrinking inode, old block list is {} entries:", identifier(), m_block_list.size());
             for (auto block_index : m_block_list) {
@@ -985,9 +1077,21 @@ ErrorOr<size_t> Ext2FSInode::write_bytes(off_t offset, size_t count, UserOrKerne
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing {} bytes, {} bytes into inode from {}", identifier(), count, offset, data.user_or_kernel_ptr());
 
-    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
+    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index;) {
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
+        if (num_bytes_to_copy == block_size) {
+            auto run_length = contiguous_block_count(bi.value(), min(static_cast<size_t>(remaining_count / block_size), static_cast<size_t>(last_block_logical_index.value() - bi.value() + 1)));
+            dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing {} blocks at {}", identifier(), run_length, m_block_list[bi.value()]);
+            if (auto result = fs().write_blocks(m_block_list[bi.value()], run_length, data.offset(nwritten), allow_cache); result.is_error()) {
+                dbgln("Ext2FSInode[{}]::write_bytes(): Failed to write {} blocks at {} (index {})", identifier(), run_length, m_block_list[bi.value()], bi);
+                return result.release_error();
+            }
+            remaining_count -= run_length * block_size;
+            nwritten += run_length * block_size;
+            bi = bi.value() + run_length;
+            continue;
+        }
         dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing block {} (offset_into_block: {})", identifier(), m_block_list[bi.value()], offset_into_block);
         if (auto result = fs().write_block(m_block_list[bi.value()], data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
             dbgln("Ext2FSInode[{}]::write_bytes(): Failed to write block {} (index {})", identifier(), m_block_list[bi.value()], bi);
@@ -995,6 +1099,7 @@ ErrorOr<size_t> Ext2FSInode::write_bytes(off_t offset, size_t count, UserOrKerne
         }
         remaining_count -= num_bytes_to_copy;
         nwritten += num_bytes_to_copy;
+        bi = bi.value() + 1;
     }
 
     did_modify_contents();
@@ -1025,6 +1130,11 @@ u8 Ext2FS::internal_file_type_to_directory_entry_type(DirectoryEntryView const&
     }
 }
 
+bool Ext2FS::supports_directory_index() const
+{
+    return m_super_block.s_feature_compat & EXT2_FEATURE_COMPAT_DIR_INDEX;
+}
+
 Ext2FS::FeaturesReadOnly Ext2FS::get_features_readonly() const
 {
     if (m_super_block.s_rev_level > 0)
@@ -1062,6 +1172,713 @@ ErrorOr<void> Ext2FSInode::traverse_as_directory(Function<ErrorOr<void>(FileSyst
     return {};
 }
 
+// Hashed directory indexes ("htree")
+//
+// Block 0 of an indexed directory holds the "." and ".." entries, with the record of ".."
+// covering the rest of the block. That's where the root of the index lives, so anyone
+// who doesn't know about indexes still sees a regular (if slightly odd) directory block.
+// The index maps name hashes to leaf blocks, which are regular directory blocks.
+// There may be one level of index nodes between the root and the leaves.
+
+static constexpr size_t directory_index_root_info_offset = 24;
+static constexpr size_t directory_index_node_entries_offset = 8;
+static constexpr u32 directory_index_block_mask = 0x0fffffff;
+static constexpr u8 directory_index_max_indirect_levels = 1;
+
+struct Ext2FSHashedDirectoryEntry {
+    u32 hash { 0 };
+    InodeIndex inode_index { 0 };
+    u8 file_type { 0 };
+    StringView name;
+};
+
+struct Ext2FSDirectoryIndexFrame {
+    ByteBuffer block;
+    size_t logical_block_index { 0 };
+    size_t entries_offset { 0 };
+    size_t position { 0 };
+
+    // NOTE: The count and limit of the entries are stored in place of the hash of the first entry.
+    ext2_dx_countlimit& count_and_limit() { return *reinterpret_cast<ext2_dx_countlimit*>(block.data() + entries_offset); }
+    ext2_dx_entry* entries() { return reinterpret_cast<ext2_dx_entry*>(block.data() + entries_offset); }
+    size_t count() { return count_and_limit().count; }
+    size_t limit() { return count_and_limit().limit; }
+    u32 block_at(size_t index) { return entries()[index].block & directory_index_block_mask; }
+
+    void insert_after_position(u32 hash, u32 block_index)
+    {
+        auto count = this->count();
+        VERIFY(count < limit());
+        auto* entries = this->entries();
+        memmove(&entries[position + 2], &entries[position + 1], (count - position - 1) * sizeof(ext2_dx_entry));
+        entries[position + 1] = { hash, block_index };
+        count_and_limit().count = count + 1;
+    }
+};
+
+struct Ext2FSDirectoryIndexPath {
+    Vector<Ext2FSDirectoryIndexFrame, directory_index_max_indirect_levels + 1> frames;
+    u8 hash_version { 0 };
+    u32 hash { 0 };
+
+    Ext2FSDirectoryIndexFrame& root() { return frames.first(); }
+    Ext2FSDirectoryIndexFrame& parent_of_leaf() { return frames.last(); }
+    size_t leaf_block_index() { return parent_of_leaf().block_at(parent_of_leaf().position); }
+    ext2_dx_root_info& root_info() { return *reinterpret_cast<ext2_dx_root_info*>(root().block.data() + directory_index_root_info_offset); }
+};
+
+static void str_to_hash_buffer(ReadonlyBytes name, bool is_unsigned, u32* buffer, size_t word_count)
+{
+    u32 padding = static_cast<u32>(name.size()) | (static_cast<u32>(name.size()) << 8);
+    padding |= padding << 16;
+
+    u32 value = padding;
+    size_t words_written = 0;
+    for (size_t i = 0; i < min(name.size(), word_count * 4); ++i) {
+        i32 character = is_unsigned ? static_cast<i32>(name[i]) : static_cast<i32>(static_cast<i8>(name[i]));
+        value = static_cast<u32>(character) + (value << 8);
+        if (i % 4 == 3) {
+            buffer[words_written++] = value;
+            value = padding;
+        }
+    }
+    if (words_written < word_count)
+        buffer[words_written++] = value;
+    while (words_written < word_count)
+        buffer[words_written++] = padding;
+}
+
+static u32 legacy_directory_hash(ReadonlyBytes name, bool is_unsigned)
+{
+    u32 hash0 = 0x12a3fe2d;
+    u32 hash1 = 0x37abe8f9;
+    for (auto byte : name) {
+        i32 character = is_unsigned ? static_cast<i32>(byte) : static_cast<i32>(static_cast<i8>(byte));
+        u32 hash = hash1 + (hash0 ^ static_cast<u32>(character * 7152373));
+        if (hash & 0x80000000)
+            hash -= 0x7fffffff;
+        hash1 = hash0;
+        hash0 = hash;
+    }
+    return hash0 << 1;
+}
+
+static void half_md4_transform(u32* buffer, u32 const* input)
+{
+    auto rotate = [](u32 value, u32 shift) { return (value << shift) | (value >> (32 - shift)); };
+    auto f = [](u32 x, u32 y, u32 z) { return z ^ (x & (y ^ z)); };
+    auto g = [](u32 x, u32 y, u32 z) { return (x & y) + ((x ^ y) & z); };
+    auto h = [](u32 x, u32 y, u32 z) { return x ^ y ^ z; };
+
+    u32 a = buffer[0], b = buffer[1], c = buffer[2], d = buffer[3];
+    auto round = [&](auto function, u32 k, Array<u8, 8> const& order, Array<u8, 4> const& shifts) {
+        for (size_t i = 0; i < 8; ++i) {
+            u32 shift = shifts[i % 4];
+            u32 x = input[order[i]] + k;
+            switch (i % 4) {
+            case 0:
+                a = rotate(a + function(b, c, d) + x, shift);
+                break;
+            case 1:
+                d = rotate(d + function(a, b, c) + x, shift);
+                break;
+            case 2:
+                c = rotate(c + function(d, a, b) + x, shift);
+                break;
+            case 3:
+                b = rotate(b + function(c, d, a) + x, shift);
+                break;
+            }
+        }
+    };
+    round(f, 0, { 0, 1, 2, 3, 4, 5, 6, 7 }, { 3, 7, 11, 19 });
+    round(g, 0x5a827999, { 1, 3, 5, 7, 0, 2, 4, 6 }, { 3, 5, 9, 13 });
+    round(h, 0x6ed9eba1, { 3, 7, 2, 6, 1, 5, 0, 4 }, { 3, 9, 11, 15 });
+
+    buffer[0] += a;
+    buffer[1] += b;
+    buffer[2] += c;
+    buffer[3] += d;
+}
+
+static void tea_transform(u32* buffer, u32 const* input)
+{
+    u32 sum = 0;
+    u32 b0 = buffer[0], b1 = buffer[1];
+    u32 a = input[0], b = input[1], c = input[2], d = input[3];
+    for (size_t i = 0; i < 16; ++i) {
+        sum += 0x9e3779b9;
+        b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+        b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+    }
+    buffer[0] += b0;
+    buffer[1] += b1;
+}
+
+static u32 directory_hash(ReadonlyBytes name, u8 hash_version, u32 const* seed)
+{
+    u32 buffer[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    if (seed[0] || seed[1] || seed[2] || seed[3])
+        memcpy(buffer, seed, sizeof(buffer));
+
+    u32 hash = 0;
+    switch (hash_version) {
+    case EXT2_HASH_LEGACY:
+    case EXT2_HASH_LEGACY_UNSIGNED:
+        hash = legacy_directory_hash(name, hash_version == EXT2_HASH_LEGACY_UNSIGNED);
+        break;
+    case EXT2_HASH_HALF_MD4:
+    case EXT2_HASH_HALF_MD4_UNSIGNED: {
+        u32 input[8];
+        for (size_t offset = 0; offset < name.size(); offset += 32) {
+            str_to_hash_buffer(name.slice(offset), hash_version == EXT2_HASH_HALF_MD4_UNSIGNED, input, 8);
+            half_md4_transform(buffer, input);
+        }
+        hash = buffer[1];
+        break;
+    }
+    case EXT2_HASH_TEA:
+    case EXT2_HASH_TEA_UNSIGNED: {
+        u32 input[4];
+        for (size_t offset = 0; offset < name.size(); offset += 16) {
+            str_to_hash_buffer(name.slice(offset), hash_version == EXT2_HASH_TEA_UNSIGNED, input, 4);
+            tea_transform(buffer, input);
+        }
+        hash = buffer[0];
+        break;
+    }
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+    // The lowest bit is used to mark hash collisions that continue in the next leaf,
+    // and the largest hash is reserved as an end-of-directory marker.
+    hash &= ~1u;
+    if (hash == (0x7fffffffu << 1))
+        hash = (0x7fffffffu - 1) << 1;
+    return hash;
+}
+
+u8 Ext2FS::directory_hash_version(u8 on_disk_hash_version) const
+{
+    // Whether characters are treated as signed or unsigned depends on whoever created the file system.
+    if (on_disk_hash_version <= EXT2_HASH_TEA && (m_super_block.s_flags & EXT2_FLAGS_UNSIGNED_HASH))
+        return on_disk_hash_version + EXT2_HASH_LEGACY_UNSIGNED;
+    return on_disk_hash_version;
+}
+
+u32 Ext2FS::hash_directory_entry_name(StringView name, u8 hash_version) const
+{
+    return directory_hash(name.bytes(), hash_version, m_super_block.s_hash_seed);
+}
+
+// Calls the callback with every entry in the block (including unused ones) and the one before it, if any.
+template<typename Callback>
+static ErrorOr<void> for_each_entry_in_directory_block(Bytes block, Callback callback)
+{
+    ext2_dir_entry_2* previous_entry = nullptr;
+    for (size_t offset = 0; offset < block.size();) {
+        auto* entry = reinterpret_cast<ext2_dir_entry_2*>(block.data() + offset);
+        if (entry->rec_len < 8 || entry->rec_len % 4 != 0 || offset + entry->rec_len > block.size() || entry->name_len + 8u > entry->rec_len) {
+            dbgln("Ext2FS: Corrupted directory entry at offset {} (rec_len: {}, name_len: {})", offset, entry->rec_len, entry->name_len);
+            return EIO;
+        }
+        if (callback(*entry, previous_entry) == IterationDecision::Break)
+            return {};
+        offset += entry->rec_len;
+        previous_entry = entry;
+    }
+    return {};
+}
+
+static ErrorOr<Optional<InodeIndex>> find_in_directory_block(Bytes block, StringView name)
+{
+    Optional<InodeIndex> inode_index;
+    TRY(for_each_entry_in_directory_block(block, [&](auto& entry, auto*) {
+        if (entry.inode == 0 || name != StringView { entry.name, entry.name_len })
+            return IterationDecision::Continue;
+        inode_index = entry.inode;
+        return IterationDecision::Break;
+    }));
+    return inode_index;
+}
+
+static ErrorOr<bool> insert_into_directory_block(Bytes block, StringView name, InodeIndex inode_index, u8 file_type)
+{
+    size_t const needed_length = EXT2_DIR_REC_LEN(name.length());
+    bool inserted = false;
+    TRY(for_each_entry_in_directory_block(block, [&](auto& entry, auto*) {
+        size_t used_length = entry.inode ? EXT2_DIR_REC_LEN(entry.name_len) : 0;
+        if (entry.rec_len - used_length < needed_length)
+            return IterationDecision::Continue;
+        auto* new_entry = &entry;
+        if (used_length) {
+            new_entry = reinterpret_cast<ext2_dir_entry_2*>(reinterpret_cast<u8*>(&entry) + used_length);
+            new_entry->rec_len = entry.rec_len - used_length;
+            entry.rec_len = used_length;
+        }
+        new_entry->inode = inode_index.value();
+        new_entry->name_len = name.length();
+        new_entry->file_type = file_type;
+        memcpy(new_entry->name, name.characters_without_null_termination(), name.length());
+        inserted = true;
+        return IterationDecision::Break;
+    }));
+    return inserted;
+}
+
+static ErrorOr<Optional<InodeIndex>> remove_from_directory_block(Bytes block, StringView name)
+{
+    Optional<InodeIndex> inode_index;
+    TRY(for_each_entry_in_directory_block(block, [&](auto& entry, auto* previous_entry) {
+        if (entry.inode == 0 || name != StringView { entry.name, entry.name_len })
+            return IterationDecision::Continue;
+        inode_index = entry.inode;
+        // Hand the space over to the previous entry, or mark the entry as unused if it's the first one in the block.
+        if (previous_entry)
+            previous_entry->rec_len += entry.rec_len;
+        else
+            entry.inode = 0;
+        return IterationDecision::Break;
+    }));
+    return inode_index;
+}
+
+static void lay_out_directory_block(Bytes block, Span<Ext2FSHashedDirectoryEntry const> entries)
+{
+    memset(block.data(), 0, block.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto& entry = entries[i];
+        auto* raw_entry = reinterpret_cast<ext2_dir_entry_2*>(block.data() + offset);
+        size_t record_length = (i + 1 < entries.size()) ? EXT2_DIR_REC_LEN(entry.name.length()) : block.size() - offset;
+        VERIFY(offset + record_length <= block.size());
+        raw_entry->inode = entry.inode_index.value();
+        raw_entry->rec_len = record_length;
+        raw_entry->name_len = entry.name.length();
+        raw_entry->file_type = entry.file_type;
+        memcpy(raw_entry->name, entry.name.characters_without_null_termination(), entry.name.length());
+        offset += record_length;
+    }
+    if (entries.is_empty())
+        reinterpret_cast<ext2_dir_entry_2*>(block.data())->rec_len = block.size();
+}
+
+// Splits the entries (sorted by hash) into two halves of about the same size, and returns the index of the first entry
+// of the upper half.
+static size_t directory_entries_split_point(Span<Ext2FSHashedDirectoryEntry const> entries)
+{
+    VERIFY(entries.size() >= 2);
+    size_t total_length = 0;
+    for (auto& entry : entries)
+        total_length += EXT2_DIR_REC_LEN(entry.name.length());
+
+    size_t lower_length = 0;
+    size_t split = 0;
+    while (split < entries.size() - 1 && lower_length < total_length / 2)
+        lower_length += EXT2_DIR_REC_LEN(entries[split++].name.length());
+    return max<size_t>(split, 1);
+}
+
+static u32 directory_index_split_hash(Span<Ext2FSHashedDirectoryEntry const> entries, size_t split)
+{
+    // If the split happens between entries with the same hash, the lookup has to continue into the next leaf.
+    u32 split_hash = entries[split].hash;
+    if (entries[split - 1].hash == split_hash)
+        split_hash |= 1;
+    return split_hash;
+}
+
+static void initialize_directory_index_node(Bytes block, size_t count)
+{
+    memset(block.data(), 0, block.size());
+    // An unused entry covering the entire block makes index nodes look like empty directory blocks.
+    reinterpret_cast<ext2_dir_entry_2*>(block.data())->rec_len = block.size();
+    auto& count_and_limit = *reinterpret_cast<ext2_dx_countlimit*>(block.data() + directory_index_node_entries_offset);
+    count_and_limit.limit = (block.size() - directory_index_node_entries_offset) / sizeof(ext2_dx_entry);
+    count_and_limit.count = count;
+}
+
+bool Ext2FSInode::has_directory_index() const
+{
+    return is_directory() && (m_raw_inode.i_flags & EXT2_INDEX_FL) && fs().supports_directory_index();
+}
+
+void Ext2FSInode::clear_directory_index()
+{
+    if (!(m_raw_inode.i_flags & EXT2_INDEX_FL))
+        return;
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::clear_directory_index(): No longer maintaining directory index", identifier());
+    m_raw_inode.i_flags &= ~EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+}
+
+ErrorOr<ByteBuffer> Ext2FSInode::read_directory_block(size_t logical_block_index) const
+{
+    auto block_size = fs().block_size();
+    auto block = TRY(ByteBuffer::create_uninitialized(block_size));
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(block.data());
+    auto nread = TRY(read_bytes(logical_block_index * block_size, block_size, buffer, nullptr));
+    if (nread != block_size)
+        return EIO;
+    return block;
+}
+
+ErrorOr<void> Ext2FSInode::write_directory_block(size_t logical_block_index, ReadonlyBytes block)
+{
+    VERIFY(block.size() == fs().block_size());
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(const_cast<u8*>(block.data()));
+    auto nwritten = TRY(write_bytes(logical_block_index * block.size(), block.size(), buffer, nullptr));
+    if (nwritten != block.size())
+        return EIO;
+    return {};
+}
+
+ErrorOr<size_t> Ext2FSInode::append_directory_block()
+{
+    auto block_size = fs().block_size();
+    size_t logical_block_index = size() / block_size;
+    TRY(resize(size() + block_size));
+    return logical_block_index;
+}
+
+ErrorOr<Optional<Ext2FSDirectoryIndexPath>> Ext2FSInode::find_directory_index_path(StringView name) const
+{
+    VERIFY(has_directory_index());
+    auto block_size = fs().block_size();
+    size_t block_count = size() / block_size;
+
+    Ext2FSDirectoryIndexPath path;
+    auto root_block = TRY(read_directory_block(0));
+    auto& root_info = *reinterpret_cast<ext2_dx_root_info const*>(root_block.data() + directory_index_root_info_offset);
+    if (root_info.reserved_zero != 0 || root_info.info_length != sizeof(ext2_dx_root_info)
+        || root_info.indirect_levels > directory_index_max_indirect_levels || root_info.hash_version > EXT2_HASH_TEA) {
+        dbgln("Ext2FSInode[{}]::find_directory_index_path(): Unsupported directory index (hash version {}, {} indirect levels)", identifier(), root_info.hash_version, root_info.indirect_levels);
+        return Optional<Ext2FSDirectoryIndexPath> {};
+    }
+    size_t levels = root_info.indirect_levels;
+    path.hash_version = fs().directory_hash_version(root_info.hash_version);
+    path.hash = fs().hash_directory_entry_name(name, path.hash_version);
+
+    size_t entries_offset = directory_index_root_info_offset + root_info.info_length;
+    TRY(path.frames.try_append({ move(root_block), 0, entries_offset, 0 }));
+
+    for (size_t level = 0; level <= levels; ++level) {
+        auto& frame = path.frames.last();
+        size_t expected_limit = (block_size - frame.entries_offset) / sizeof(ext2_dx_entry);
+        if (frame.limit() != expected_limit || frame.count() == 0 || frame.count() > frame.limit()) {
+            dbgln("Ext2FSInode[{}]::find_directory_index_path(): Corrupted index block {} (count: {}, limit: {})", identifier(), frame.logical_block_index, frame.count(), frame.limit());
+            return Optional<Ext2FSDirectoryIndexPath> {};
+        }
+
+        // Find the last entry whose hash isn't greater than ours. The first entry has an implicit hash of 0.
+        size_t low = 1;
+        size_t high = frame.count();
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (frame.entries()[middle].hash > path.hash)
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        frame.position = low - 1;
+
+        auto next_block_index = frame.block_at(frame.position);
+        if (next_block_index == 0 || next_block_index >= block_count) {
+            dbgln("Ext2FSInode[{}]::find_directory_index_path(): Index block {} points to invalid block {}", identifier(), frame.logical_block_index, next_block_index);
+            return Optional<Ext2FSDirectoryIndexPath> {};
+        }
+        if (level == levels)
+            break;
+        auto node_block = TRY(read_directory_block(next_block_index));
+        TRY(path.frames.try_append({ move(node_block), next_block_index, directory_index_node_entries_offset, 0 }));
+    }
+    return path;
+}
+
+ErrorOr<bool> Ext2FSInode::advance_directory_index_path(Ext2FSDirectoryIndexPath& path) const
+{
+    // Find the innermost index block that has more entries after the one we're at.
+    size_t level = path.frames.size();
+    while (level > 0 && path.frames[level - 1].position + 1 >= path.frames[level - 1].count())
+        --level;
+    if (level == 0)
+        return false;
+
+    // Only keep going if the next leaf continues with the hash we're looking for.
+    auto& frame = path.frames[level - 1];
+    if ((frame.entries()[frame.position + 1].hash & ~1u) != path.hash)
+        return false;
+    ++frame.position;
+
+    size_t block_count = size() / fs().block_size();
+    for (; level < path.frames.size(); ++level) {
+        auto& parent = path.frames[level - 1];
+        auto node_block_index = parent.block_at(parent.position);
+        if (node_block_index == 0 || node_block_index >= block_count)
+            return EIO;
+        auto& node = path.frames[level];
+        node.block = TRY(read_directory_block(node_block_index));
+        node.logical_block_index = node_block_index;
+        node.position = 0;
+        if (node.count() == 0 || node.count() > node.limit())
+            return EIO;
+    }
+    return path.leaf_block_index() < block_count;
+}
+
+ErrorOr<Optional<InodeIndex>> Ext2FSInode::lookup_in_directory_index(Ext2FSDirectoryIndexPath& path, StringView name) const
+{
+    while (true) {
+        auto leaf = TRY(read_directory_block(path.leaf_block_index()));
+        if (auto inode_index = TRY(find_in_directory_block(leaf.bytes(), name)); inode_index.has_value())
+            return inode_index;
+        if (!TRY(advance_directory_index_path(path)))
+            return Optional<InodeIndex> {};
+    }
+}
+
+ErrorOr<void> Ext2FSInode::make_room_in_directory_index(Ext2FSDirectoryIndexPath& path)
+{
+    if (path.parent_of_leaf().count() < path.parent_of_leaf().limit())
+        return {};
+
+    auto block_size = fs().block_size();
+
+    if (path.frames.size() == 1) {
+        // The root is full, move all of its entries into a new index node below it.
+        auto node_block_index = TRY(append_directory_block());
+        auto node_block = TRY(ByteBuffer::create_uninitialized(block_size));
+        auto& root = path.root();
+        initialize_directory_index_node(node_block.bytes(), root.count());
+        memcpy(node_block.data() + directory_index_node_entries_offset + sizeof(ext2_dx_countlimit),
+            root.block.data() + root.entries_offset + sizeof(ext2_dx_countlimit),
+            root.count() * sizeof(ext2_dx_entry) - sizeof(ext2_dx_countlimit));
+        Ext2FSDirectoryIndexFrame node { move(node_block), node_block_index, directory_index_node_entries_offset, root.position };
+
+        root.count_and_limit().count = 1;
+        root.entries()[0].block = node_block_index;
+        root.position = 0;
+        path.root_info().indirect_levels = 1;
+
+        TRY(write_directory_block(node.logical_block_index, node.block));
+        TRY(write_directory_block(0, path.root().block));
+        TRY(path.frames.try_append(move(node)));
+        return {};
+    }
+
+    VERIFY(path.frames.size() == 2);
+    if (path.root().count() >= path.root().limit()) {
+        dbgln("Ext2FSInode[{}]::make_room_in_directory_index(): Directory index is full", identifier());
+        return ENOSPC;
+    }
+
+    // Split the full index node in two, and add the new one to the root.
+    auto new_node_block_index = TRY(append_directory_block());
+    auto new_node_block = TRY(ByteBuffer::create_uninitialized(block_size));
+    auto& node = path.frames[1];
+    size_t count = node.count();
+    size_t split = count / 2;
+    u32 split_hash = node.entries()[split].hash;
+    initialize_directory_index_node(new_node_block.bytes(), count - split);
+    memcpy(new_node_block.data() + directory_index_node_entries_offset + sizeof(ext2_dx_countlimit),
+        reinterpret_cast<u8 const*>(&node.entries()[split]) + sizeof(ext2_dx_countlimit),
+        (count - split) * sizeof(ext2_dx_entry) - sizeof(ext2_dx_countlimit));
+    node.count_and_limit().count = split;
+    path.root().insert_after_position(split_hash, new_node_block_index);
+
+    TRY(write_directory_block(new_node_block_index, new_node_block));
+    TRY(write_directory_block(node.logical_block_index, node.block));
+    TRY(write_directory_block(0, path.root().block));
+
+    if (node.position >= split) {
+        node.block = move(new_node_block);
+        node.logical_block_index = new_node_block_index;
+        node.position -= split;
+        ++path.root().position;
+    }
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::collect_hashed_directory_entries(Bytes block, u8 hash_version, Vector<Ext2FSHashedDirectoryEntry>& entries) const
+{
+    return for_each_entry_in_directory_block(block, [&](auto& entry, auto*) {
+        if (entry.inode == 0)
+            return IterationDecision::Continue;
+        StringView name { entry.name, entry.name_len };
+        // NOTE: We've made sure there's enough capacity up front, as there can't be more entries than this in a block.
+        entries.unchecked_append({ fs().hash_directory_entry_name(name, hash_version), entry.inode, entry.file_type, name });
+        return IterationDecision::Continue;
+    });
+}
+
+ErrorOr<void> Ext2FSInode::add_directory_entry_to_index(Ext2FSDirectoryIndexPath& path, StringView name, InodeIndex inode_index, u8 file_type)
+{
+    auto leaf_block_index = path.leaf_block_index();
+    auto leaf = TRY(read_directory_block(leaf_block_index));
+    if (TRY(insert_into_directory_block(leaf.bytes(), name, inode_index, file_type)))
+        return write_directory_block(leaf_block_index, leaf);
+
+    // The leaf is full, so we have to split it in two. Make sure there's room for the new leaf in the index first.
+    TRY(make_room_in_directory_index(path));
+
+    auto block_size = fs().block_size();
+    Vector<Ext2FSHashedDirectoryEntry> entries;
+    TRY(entries.try_ensure_capacity(block_size / EXT2_DIR_REC_LEN(1) + 1));
+    TRY(collect_hashed_directory_entries(leaf.bytes(), path.hash_version, entries));
+    entries.unchecked_append({ path.hash, inode_index, file_type, name });
+    quick_sort(entries, [](auto& a, auto& b) { return a.hash < b.hash; });
+
+    auto split = directory_entries_split_point(entries);
+    auto lower_leaf = TRY(ByteBuffer::create_uninitialized(block_size));
+    auto upper_leaf = TRY(ByteBuffer::create_uninitialized(block_size));
+    lay_out_directory_block(lower_leaf.bytes(), entries.span().trim(split));
+    lay_out_directory_block(upper_leaf.bytes(), entries.span().slice(split));
+
+    auto upper_leaf_block_index = TRY(append_directory_block());
+    auto& parent = path.parent_of_leaf();
+    parent.insert_after_position(directory_index_split_hash(entries, split), upper_leaf_block_index);
+
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::add_directory_entry_to_index(): Split leaf {} at hash {:#x}, {} entries moved to {}", identifier(), leaf_block_index, entries[split].hash, entries.size() - split, upper_leaf_block_index);
+
+    TRY(write_directory_block(upper_leaf_block_index, upper_leaf));
+    TRY(write_directory_block(leaf_block_index, lower_leaf));
+    return write_directory_block(parent.logical_block_index, parent.block);
+}
+
+ErrorOr<void> Ext2FSInode::build_directory_index(ByteBuffer& first_block, StringView name, InodeIndex inode_index, u8 file_type)
+{
+    VERIFY(size() == fs().block_size());
+    auto block_size = fs().block_size();
+
+    u8 on_disk_hash_version = fs().super_block().s_def_hash_version;
+    if (on_disk_hash_version > EXT2_HASH_TEA)
+        on_disk_hash_version = EXT2_HASH_HALF_MD4;
+    auto hash_version = fs().directory_hash_version(on_disk_hash_version);
+
+    // The first two entries have to be "." and "..", they stay in the root block.
+    Vector<Ext2FSHashedDirectoryEntry> entries;
+    TRY(entries.try_ensure_capacity(block_size / EXT2_DIR_REC_LEN(1) + 1));
+    TRY(collect_hashed_directory_entries(first_block.bytes(), hash_version, entries));
+    if (entries.size() < 3 || entries[0].name != "."sv || entries[1].name != ".."sv)
+        return EINVAL;
+    auto parent_inode_index = entries[1].inode_index;
+    entries.remove(0, 2);
+    entries.unchecked_append({ fs().hash_directory_entry_name(name, hash_version), inode_index, file_type, name });
+    quick_sort(entries, [](auto& a, auto& b) { return a.hash < b.hash; });
+
+    auto split = directory_entries_split_point(entries);
+    auto lower_leaf = TRY(ByteBuffer::create_uninitialized(block_size));
+    auto upper_leaf = TRY(ByteBuffer::create_uninitialized(block_size));
+    lay_out_directory_block(lower_leaf.bytes(), entries.span().trim(split));
+    lay_out_directory_block(upper_leaf.bytes(), entries.span().slice(split));
+
+    auto root_block = TRY(ByteBuffer::create_zeroed(block_size));
+    Ext2FSHashedDirectoryEntry dot_entries[] = { { 0, index(), EXT2_FT_DIR, "."sv }, { 0, parent_inode_index, EXT2_FT_DIR, ".."sv } };
+    lay_out_directory_block(root_block.bytes(), dot_entries);
+
+    auto& root_info = *reinterpret_cast<ext2_dx_root_info*>(root_block.data() + directory_index_root_info_offset);
+    root_info.hash_version = on_disk_hash_version;
+    root_info.info_length = sizeof(ext2_dx_root_info);
+    Ext2FSDirectoryIndexFrame root { move(root_block), 0, directory_index_root_info_offset + sizeof(ext2_dx_root_info), 0 };
+    root.count_and_limit().limit = (block_size - root.entries_offset) / sizeof(ext2_dx_entry);
+    root.count_and_limit().count = 1;
+
+    auto lower_leaf_block_index = TRY(append_directory_block());
+    auto upper_leaf_block_index = TRY(append_directory_block());
+    root.entries()[0].block = lower_leaf_block_index;
+    root.insert_after_position(directory_index_split_hash(entries, split), upper_leaf_block_index);
+
+    dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::build_directory_index(): Indexing {} entries with hash version {}", identifier(), entries.size(), hash_version);
+
+    TRY(write_directory_block(lower_leaf_block_index, lower_leaf));
+    TRY(write_directory_block(upper_leaf_block_index, upper_leaf));
+    TRY(write_directory_block(0, root.block));
+
+    m_raw_inode.i_flags |= EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::add_directory_entry(StringView name, InodeIndex inode_index, u8 file_type)
+{
+    VERIFY(m_inode_lock.is_locked());
+
+    if (has_directory_index()) {
+        if (auto lookup_path = TRY(find_directory_index_path(name)); lookup_path.has_value()) {
+            // Entries with the same name end up in the same leaf (or the ones right after it), so that's all we have to check.
+            if (TRY(lookup_in_directory_index(lookup_path.value(), name)).has_value())
+                return EEXIST;
+            auto path = TRY(find_directory_index_path(name));
+            VERIFY(path.has_value());
+            return add_directory_entry_to_index(path.value(), name, inode_index, file_type);
+        }
+        // We can't make sense of the index, so stop using it. The directory itself is still fine without it.
+        clear_directory_index();
+    }
+
+    auto block_size = fs().block_size();
+    size_t block_count = size() / block_size;
+    Optional<size_t> free_block_index;
+    ByteBuffer free_block;
+    for (size_t block_index = 0; block_index < block_count; ++block_index) {
+        auto block = TRY(read_directory_block(block_index));
+        if (TRY(find_in_directory_block(block.bytes(), name)).has_value())
+            return EEXIST;
+        if (!free_block_index.has_value() && TRY(insert_into_directory_block(block.bytes(), name, inode_index, file_type))) {
+            free_block_index = block_index;
+            free_block = move(block);
+        }
+    }
+    if (free_block_index.has_value())
+        return write_directory_block(free_block_index.value(), free_block);
+
+    // The directory is about to outgrow its first block, which is when it's worth indexing it.
+    if (block_count == 1 && fs().supports_directory_index() && !fs().is_readonly()) {
+        auto first_block = TRY(read_directory_block(0));
+        auto result = build_directory_index(first_block, name, inode_index, file_type);
+        if (!result.is_error() || result.error().code() != EINVAL)
+            return result;
+    }
+
+    auto new_block_index = TRY(append_directory_block());
+    auto new_block = TRY(ByteBuffer::create_uninitialized(block_size));
+    Ext2FSHashedDirectoryEntry new_entry[] = { { 0, inode_index, file_type, name } };
+    lay_out_directory_block(new_block.bytes(), new_entry);
+    return write_directory_block(new_block_index, new_block);
+}
+
+ErrorOr<InodeIndex> Ext2FSInode::remove_directory_entry(StringView name)
+{
+    VERIFY(m_inode_lock.is_locked());
+
+    if (has_directory_index()) {
+        if (auto path = TRY(find_directory_index_path(name)); path.has_value()) {
+            while (true) {
+                auto leaf_block_index = path->leaf_block_index();
+                auto leaf = TRY(read_directory_block(leaf_block_index));
+                if (auto inode_index = TRY(remove_from_directory_block(leaf.bytes(), name)); inode_index.has_value()) {
+                    TRY(write_directory_block(leaf_block_index, leaf));
+                    return inode_index.release_value();
+                }
+                if (!TRY(advance_directory_index_path(path.value())))
+                    return ENOENT;
+            }
+        }
+        clear_directory_index();
+    }
+
+    size_t block_count = size() / fs().block_size();
+    for (size_t block_index = 0; block_index < block_count; ++block_index) {
+        auto block = TRY(read_directory_block(block_index));
+        if (auto inode_index = TRY(remove_from_directory_block(block.bytes(), name)); inode_index.has_value()) {
+            TRY(write_directory_block(block_index, block));
+            return inode_index.release_value();
+        }
+    }
+    return ENOENT;
+}
+
 ErrorOr<void> Ext2FSInode::write_directory(Vector<Ext2FSDirectoryEntry>& entries)
 {
     MutexLocker locker(m_inode_lock);
@@ -1136,25 +1953,22 @@ ErrorOr<void> Ext2FSInode::add_child(Inode& child, StringView name, mode_t mode)
 
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::add_child(): Adding inode {} with name '{}' and mode {:o} to directory {}", identifier(), child.index(), name, mode, index());
 
-    Vector<Ext2FSDirectoryEntry> entries;
-    TRY(traverse_as_directory([&](auto& entry) -> ErrorOr<void> {
-        if (name == entry.name)
-            return EEXIST;
-        auto entry_name = TRY(KString::try_create(entry.name));
-        TRY(entries.try_append({ move(entry_name), entry.inode.index(), entry.file_type }));
-        return {};
-    }));
-
     TRY(child.increment_link_count());
 
-    auto entry_name = TRY(KString::try_create(name));
-    TRY(entries.try_empend(move(entry_name), child.index(), to_ext2_file_type(mode)));
-
-    TRY(write_directory(entries));
-    TRY(populate_lookup_cache());
+    if (auto result = add_directory_entry(name, child.index(), to_ext2_file_type(mode)); result.is_error()) {
+        (void)child.decrement_link_count();
+        return result.release_error();
+    }
 
-    auto cache_entry_name = TRY(KString::try_create(name));
-    TRY(m_lookup_cache.try_set(move(cache_entry_name), child.index()));
+    // Indexed directories don't need the lookup cache, and it may have been dropped while indexing this one.
+    if (!m_lookup_cache.is_empty()) {
+        if (has_directory_index()) {
+            m_lookup_cache.clear();
+        } else {
+            auto cache_entry_name = TRY(KString::try_create(name));
+            TRY(m_lookup_cache.try_set(move(cache_entry_name), child.index()));
+        }
+    }
     did_add_child(child.identifier(), name);
     return {};
 }
@@ -1165,27 +1979,11 @@ ErrorOr<void> Ext2FSInode::remove_child(StringView name)
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::remove_child(): Removing '{}'", identifier(), name);
     VERIFY(is_directory());
 
-    TRY(populate_lookup_cache());
-
-    auto it = m_lookup_cache.find(name);
-    if (it == m_lookup_cache.end())
-        return ENOENT;
-    auto child_inode_index = (*it).value;
-
+    auto child_inode_index = TRY(remove_directory_entry(name));
     InodeIdentifier child_id { fsid(), child_inode_index };
 
-    Vector<Ext2FSDirectoryEntry> entries;
-    TRY(traverse_as_directory([&](auto& entry) -> ErrorOr<void> {
-        if (name != entry.name) {
-            auto entry_name = TRY(KString::try_create(entry.name));
-            TRY(entries.try_append({ move(entry_name), entry.inode.index(), entry.file_type }));
-        }
-        return {};
-    }));
-
-    TRY(write_directory(entries));
-
-    m_lookup_cache.remove(it);
+    if (auto it = m_lookup_cache.find(name); it != m_lookup_cache.end())
+        m_lookup_cache.remove(it);
 
     auto child_inode = TRY(fs().get_inode(child_id));
     TRY(child_inode->decrement_link_count());
@@ -1223,9 +2021,9 @@ ErrorOr<void> Ext2FS::write_ext2_inode(InodeIndex inode, ext2_inode const& e2ino
     return write_block(block_index, buffer, inode_size(), offset);
 }
 
-auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) -> ErrorOr<Vector<BlockIndex>>
+auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count, InodeIndex owner, BlockIndex goal) -> ErrorOr<Vector<BlockIndex>>
 {
-    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {})", preferred_group_index, count);
+    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {}, owner: {}, goal: {})", preferred_group_index, count, owner, goal);
     if (count == 0)
         return Vector<BlockIndex> {};
 
@@ -1233,6 +2031,9 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     TRY(blocks.try_ensure_capacity(count));
 
     MutexLocker locker(m_lock);
+    if (owner.value())
+        TRY(allocate_reserved_blocks(owner, preferred_group_index, goal, count, blocks));
+
     auto group_index = preferred_group_index;
 
     if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
@@ -1279,6 +2080,137 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     return blocks;
 }
 
+ErrorOr<void> Ext2FS::allocate_reserved_blocks(InodeIndex owner, GroupIndex preferred_group_index, BlockIndex goal, size_t count, Vector<BlockIndex>& blocks)
+{
+    VERIFY(m_lock.is_locked());
+
+    // Take the reservation out of the list, it'll go back in as the most recently used one.
+    Optional<BlockReservation> reservation;
+    for (size_t i = 0; i < m_block_reservations.size(); ++i) {
+        if (m_block_reservations[i].inode == owner) {
+            reservation = m_block_reservations.take(i);
+            break;
+        }
+    }
+    // The reservation is only of use if the file continues where it left off.
+    if (reservation.has_value() && goal.value() && reservation->next != goal)
+        reservation.clear();
+
+    size_t const max_reservation_size = min(max<size_t>(max_block_reservation_bytes / block_size(), min_block_reservation_size), blocks_per_group());
+    size_t reservation_size = reservation.has_value() ? reservation->size : 0;
+
+    while (blocks.size() < count) {
+        if (!reservation.has_value() || reservation->next == reservation->end) {
+            auto remaining_count = count - blocks.size();
+            reservation_size = clamp(max(reservation_size * 2, remaining_count), min_block_reservation_size, max_reservation_size);
+            auto new_goal = blocks.is_empty() ? goal : BlockIndex { blocks.last().value() + 1 };
+            reservation = TRY(reserve_blocks(owner, preferred_group_index, new_goal, reservation_size));
+            if (!reservation.has_value())
+                break;
+        }
+
+        auto block_index = reservation->next;
+        reservation->next = block_index.value() + 1;
+
+        // Reservations are only advisory, so someone else may have allocated the block in the meantime.
+        if (TRY(get_block_allocation_state(block_index))) {
+            reservation.clear();
+            continue;
+        }
+        TRY(set_block_allocation_state(block_index, true));
+        blocks.unchecked_append(block_index);
+        dbgln_if(EXT2_DEBUG, "  allocated > {} (reserved)", block_index);
+    }
+
+    if (reservation.has_value() && reservation->next != reservation->end) {
+        if (m_block_reservations.size() >= max_block_reservations)
+            m_block_reservations.remove(0);
+        TRY(m_block_reservations.try_append(reservation.release_value()));
+    }
+    return {};
+}
+
+auto Ext2FS::reserve_blocks(InodeIndex owner, GroupIndex preferred_group_index, BlockIndex goal, size_t size) -> ErrorOr<Optional<BlockReservation>>
+{
+    auto goal_group_index = group_index_from_block_index(goal);
+    if (goal_group_index.value() && goal_group_index <= m_block_group_count) {
+        if (auto reservation = TRY(reserve_blocks_in_group(owner, goal_group_index, goal, size)); reservation.has_value())
+            return reservation;
+    }
+    if (preferred_group_index.value() && preferred_group_index != goal_group_index) {
+        if (auto reservation = TRY(reserve_blocks_in_group(owner, preferred_group_index, 0, size)); reservation.has_value())
+            return reservation;
+    }
+    for (GroupIndex group_index = 1; group_index <= m_block_group_count; group_index = GroupIndex { group_index.value() + 1 }) {
+        if (group_index == goal_group_index || group_index == preferred_group_index)
+            continue;
+        if (auto reservation = TRY(reserve_blocks_in_group(owner, group_index, 0, size)); reservation.has_value())
+            return reservation;
+    }
+    return Optional<BlockReservation> {};
+}
+
+auto Ext2FS::reserve_blocks_in_group(InodeIndex owner, GroupIndex group_index, BlockIndex goal, size_t size) -> ErrorOr<Optional<BlockReservation>>
+{
+    auto const& bgd = group_descriptor(group_index);
+    if (!bgd.bg_free_blocks_count)
+        return Optional<BlockReservation> {};
+
+    auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+    size_t blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
+    BlockIndex first_block_in_group = (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
+    BlockIndex end_of_group = first_block_in_group.value() + blocks_in_group;
+
+    // Work on a copy of the bitmap, in which blocks reserved by other inodes are treated as being in use.
+    memcpy(m_reservation_bitmap_buffer->data(), cached_bitmap->buffer->data(), ceil_div(blocks_in_group, static_cast<size_t>(8)));
+    Bitmap bitmap { m_reservation_bitmap_buffer->data(), blocks_in_group };
+    for (auto& other : m_block_reservations) {
+        VERIFY(other.inode != owner);
+        auto start = max(other.next, first_block_in_group);
+        auto end = min(other.end, end_of_group);
+        if (start < end)
+            bitmap.set_range(start.value() - first_block_in_group.value(), end.value() - start.value(), true);
+    }
+
+    size_t goal_bit = 0;
+    if (goal >= first_block_in_group && goal < end_of_group)
+        goal_bit = goal.value() - first_block_in_group.value();
+
+    auto make_reservation = [&](size_t first_bit, size_t length) -> Optional<BlockReservation> {
+        VERIFY(length > 0);
+        BlockIndex start = first_block_in_group.value() + first_bit;
+        return BlockReservation { owner, start, start.value() + length, size };
+    };
+
+    // Prefer continuing right at the goal, even if there isn't all that much space there...
+    if (goal_bit && !bitmap.get(goal_bit)) {
+        size_t first_bit = goal_bit;
+        if (auto length = bitmap.find_next_range_of_unset_bits(first_bit, 1, size); length.has_value() && first_bit == goal_bit)
+            return make_reservation(first_bit, length.value());
+    }
+
+    // ...otherwise, look for the first free range of the requested size after it, then anywhere in the group.
+    for (size_t start_bit : { goal_bit, static_cast<size_t>(0) }) {
+        size_t first_bit = start_bit;
+        if (auto length = bitmap.find_next_range_of_unset_bits(first_bit, size, size); length.has_value())
+            return make_reservation(first_bit, length.value());
+        if (start_bit == 0)
+            break;
+    }
+
+    // Settle for whatever's the largest free range in the group.
+    size_t found_range_size = 0;
+    if (auto first_bit = bitmap.find_longest_range_of_unset_bits(size, found_range_size); first_bit.has_value() && found_range_size > 0)
+        return make_reservation(first_bit.value(), found_range_size);
+    return Optional<BlockReservation> {};
+}
+
+void Ext2FS::discard_block_reservation(InodeIndex inode)
+{
+    MutexLocker locker(m_lock);
+    m_block_reservations.remove_first_matching([&](auto& reservation) { return reservation.inode == inode; });
+}
+
 ErrorOr<InodeIndex> Ext2FS::allocate_inode(GroupIndex preferred_group)
 {
     dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_inode(preferred_group: {})", preferred_group);
@@ -1343,7 +2275,7 @@ Ext2FS::GroupIndex Ext2FS::group_index_from_block_index(BlockIndex block_index)
 {
     if (!block_index)
         return 0;
-    return (block_index.value() - 1) / blocks_per_group() + 1;
+    return (block_index.value() - first_block_index().value()) / blocks_per_group() + 1;
 }
 
 auto Ext2FS::group_index_from_inode(InodeIndex inode) const -> GroupIndex
@@ -1423,6 +2355,19 @@ ErrorOr<Ext2FS::CachedBitmap*> Ext2FS::get_bitmap_block(BlockIndex bitmap_block_
     return m_cached_bitmaps.last().ptr();
 }
 
+ErrorOr<bool> Ext2FS::get_block_allocation_state(BlockIndex block_index)
+{
+    VERIFY(block_index != 0);
+    MutexLocker locker(m_lock);
+
+    auto group_index = group_index_from_block_index(block_index);
+    unsigned index_in_group = (block_index.value() - first_block_index().value()) - ((group_index.value() - 1) * blocks_per_group());
+    auto const& bgd = group_descriptor(group_index);
+
+    auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+    return cached_bitmap->bitmap(blocks_per_group()).get(index_in_group);
+}
+
 ErrorOr<void> Ext2FS::set_block_allocation_state(BlockIndex block_index, bool new_state)
 {
     VERIFY(block_index != 0);
@@ -1524,6 +2469,32 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FSInode::lookup(StringView name)
 {
     VERIFY(is_directory());
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]:lookup(): Looking up '{}'", identifier(), name);
+
+    Optional<InodeIndex> indexed_inode_index;
+    bool found_in_index = TRY([&]() -> ErrorOr<bool> {
+        MutexLocker locker(m_inode_lock);
+        if (!has_directory_index())
+            return false;
+        // "." and ".." always live in the first block, which isn't part of the index.
+        if (name == "."sv || name == ".."sv) {
+            auto first_block = TRY(read_directory_block(0));
+            indexed_inode_index = TRY(find_in_directory_block(first_block.bytes(), name));
+            return true;
+        }
+        auto path = TRY(find_directory_index_path(name));
+        if (!path.has_value())
+            return false;
+        indexed_inode_index = TRY(lookup_in_directory_index(path.value(), name));
+        return true;
+    }());
+    if (found_in_index) {
+        if (!indexed_inode_index.has_value()) {
+            dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]:lookup(): '{}' not found", identifier(), name);
+            return ENOENT;
+        }
+        return fs().get_inode({ fsid(), indexed_inode_index.value() });
+    }
+
     TRY(populate_lookup_cache());
 
     InodeIndex inode_index;
@@ -1679,12 +2650,15 @@ ErrorOr<void> Ext2FS::prepare_to_unmount()
 {
     MutexLocker locker(m_lock);
 
+    Memory::PageCache::the().invalidate_file_system(*this);
+
     for (auto& it : m_inode_cache) {
         if (it.value->ref_count() > 1)
             return EBUSY;
     }
 
     m_inode_cache.clear();
+    m_block_reservations.clear();
     m_root_inode = nullptr;
     return {};
 }
@@ -22,6 +22,8 @@ namespace Kernel {
 
 class Ext2FS;
 struct Ext2FSDirectoryEntry;
+struct Ext2FSDirectoryIndexPath;
+struct Ext2FSHashedDirectoryEntry;
 
 class Ext2FSInode final : public Inode {
     friend class Ext2FS;
@@ -36,6 +38,8 @@ public:
 private:
     // ^Inode
     virtual ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const override;
+    virtual ErrorOr<size_t> read_bytes_for_page_cache(off_t, size_t, UserOrKernelBuffer& buffer) const override;
+    virtual void start_readahead(u64 offset, size_t size) override;
     virtual InodeMetadata metadata() const override;
     virtual ErrorOr<void> traverse_as_directory(Function<ErrorOr<void>(FileSystem::DirectoryEntryView const&)>) const override;
     virtual ErrorOr<NonnullRefPtr<Inode>> lookup(StringView name) override;
@@ -54,7 +58,23 @@ private:
     virtual ErrorOr<void> truncate(u64) override;
     virtual ErrorOr<int> get_block_address(int) override;
 
+    ErrorOr<size_t> read_bytes_impl(off_t, size_t, UserOrKernelBuffer& buffer, bool allow_cache) const;
     ErrorOr<void> write_directory(Vector<Ext2FSDirectoryEntry>&);
+    ErrorOr<ByteBuffer> read_directory_block(size_t logical_block_index) const;
+    ErrorOr<void> write_directory_block(size_t logical_block_index, ReadonlyBytes);
+    ErrorOr<size_t> append_directory_block();
+    ErrorOr<void> add_directory_entry(StringView name, InodeIndex, u8 file_type);
+    ErrorOr<InodeIndex> remove_directory_entry(StringView name);
+
+    bool has_directory_index() const;
+    void clear_directory_index();
+    ErrorOr<Optional<Ext2FSDirectoryIndexPath>> find_directory_index_path(StringView name) const;
+    ErrorOr<bool> advance_directory_index_path(Ext2FSDirectoryIndexPath&) const;
+    ErrorOr<Optional<InodeIndex>> lookup_in_directory_index(Ext2FSDirectoryIndexPath&, StringView name) const;
+    ErrorOr<void> make_room_in_directory_index(Ext2FSDirectoryIndexPath&);
+    ErrorOr<void> collect_hashed_directory_entries(Bytes block, u8 hash_version, Vector<Ext2FSHashedDirectoryEntry>&) const;
+    ErrorOr<void> add_directory_entry_to_index(Ext2FSDirectoryIndexPath&, StringView name, InodeIndex, u8 file_type);
+    ErrorOr<void> build_directory_index(ByteBuffer& first_block, StringView name, InodeIndex, u8 file_type);
     ErrorOr<void> populate_lookup_cache() const;
     ErrorOr<void> resize(u64);
     ErrorOr<void> write_indirect_block(BlockBasedFileSystem::BlockIndex, Span<BlockBasedFileSystem::BlockIndex>);
@@ -63,6 +83,7 @@ private:
     ErrorOr<void> grow_triply_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, Span<BlockBasedFileSystem::BlockIndex>, Vector<BlockBasedFileSystem::BlockIndex>&, unsigned&);
     ErrorOr<void> shrink_triply_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, size_t, unsigned&);
     ErrorOr<void> flush_block_list();
+    size_t contiguous_block_count(size_t first_block_logical_index, size_t max_count) const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list() const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_with_meta_blocks() const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_impl(bool include_block_list_blocks) const;
@@ -103,6 +124,7 @@ public:
     virtual u8 internal_file_type_to_directory_entry_type(DirectoryEntryView const& entry) const override;
 
     FeaturesReadOnly get_features_readonly() const;
+    bool supports_directory_index() const;
 
 private:
     TYPEDEF_DISTINCT_ORDERED_ID(unsigned, GroupIndex);
@@ -119,6 +141,9 @@ private:
     u64 blocks_per_group() const;
     u64 inode_size() const;
 
+    u8 directory_hash_version(u8 on_disk_hash_version) const;
+    u32 hash_directory_entry_name(StringView, u8 hash_version) const;
+
     ErrorOr<void> write_ext2_inode(InodeIndex, ext2_inode const&);
     bool find_block_containing_inode(InodeIndex, BlockIndex& block_index, unsigned& offset) const;
 
@@ -130,15 +155,17 @@ private:
     ErrorOr<NonnullRefPtr<Inode>> create_inode(Ext2FSInode& parent_inode, StringView name, mode_t, dev_t, UserID, GroupID);
     ErrorOr<NonnullRefPtr<Inode>> create_directory(Ext2FSInode& parent_inode, StringView name, mode_t, UserID, GroupID);
     virtual void flush_writes() override;
+    virtual void flush_metadata_writes() override;
 
     BlockIndex first_block_index() const;
     ErrorOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
-    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count, InodeIndex owner = 0, BlockIndex goal = 0);
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
 
     ErrorOr<bool> get_inode_allocation_state(InodeIndex) const;
     ErrorOr<void> set_inode_allocation_state(InodeIndex, bool);
+    ErrorOr<bool> get_block_allocation_state(BlockIndex);
     ErrorOr<void> set_block_allocation_state(BlockIndex, bool);
 
     void uncache_inode(InodeIndex);
@@ -180,6 +207,25 @@ private:
     ErrorOr<void> update_bitmap_block(BlockIndex bitmap_block, size_t bit_index, bool new_state, u32& super_block_counter, u16& group_descriptor_counter);
 
     Vector<OwnPtr<CachedBitmap>> m_cached_bitmaps;
+
+    // Inodes that are being written to get a window of free blocks reserved for them, so their data
+    // ends up laid out contiguously on disk, even when multiple files grow at the same time.
+    // Reservations only live in memory, nothing is marked as allocated until it's actually used.
+    struct BlockReservation {
+        InodeIndex inode;
+        BlockIndex next;
+        BlockIndex end;
+        size_t size { 0 };
+    };
+
+    ErrorOr<void> allocate_reserved_blocks(InodeIndex owner, GroupIndex preferred_group_index, BlockIndex goal, size_t count, Vector<BlockIndex>& blocks);
+    ErrorOr<Optional<BlockReservation>> reserve_blocks(InodeIndex owner, GroupIndex preferred_group_index, BlockIndex goal, size_t size);
+    ErrorOr<Optional<BlockReservation>> reserve_blocks_in_group(InodeIndex owner, GroupIndex, BlockIndex goal, size_t size);
+    void discard_block_reservation(InodeIndex);
+
+    // NOTE: Ordered from least to most recently used.
+    Vector<BlockReservation> m_block_reservations;
+    OwnPtr<KBuffer> m_reservation_bitmap_buffer;
     RefPtr<Ext2FSInode> m_root_inode;
 };
 
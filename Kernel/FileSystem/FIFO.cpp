@@ -109,6 +109,7 @@ bool FIFO::can_write(OpenFileDescription const&, u64) const
 
 ErrorOr<size_t> FIFO::read(OpenFileDescription& fd, u64, UserOrKernelBuffer& buffer, size_t size)
 {
+    MutexLocker locker(m_read_lock);
     if (m_buffer->is_empty()) {
         if (!m_writers)
             return 0;
@@ -118,6 +119,27 @@ ErrorOr<size_t> FIFO::read(OpenFileDescription& fd, u64, UserOrKernelBuffer& buf
     return m_buffer->read(buffer, size);
 }
 
+ErrorOr<size_t> FIFO::drain_into(OpenFileDescription& fd, Bytes scratch, Function<ErrorOr<size_t>(UserOrKernelBuffer const&, size_t)> const& sink)
+{
+    // NOTE: Holding the read lock keeps other readers from taking the data out from under us
+    //       while it's on its way to the sink.
+    MutexLocker locker(m_read_lock);
+    if (m_buffer->is_empty()) {
+        if (!m_writers)
+            return 0;
+        if (!fd.is_blocking())
+            return EAGAIN;
+    }
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(scratch.data());
+    auto nread = TRY(m_buffer->peek(buffer, scratch.size()));
+    if (nread == 0)
+        return 0;
+    auto nconsumed = TRY(sink(buffer, nread));
+    VERIFY(nconsumed <= nread);
+    m_buffer->discard(nconsumed);
+    return nconsumed;
+}
+
 ErrorOr<size_t> FIFO::write(OpenFileDescription& fd, u64, UserOrKernelBuffer const& buffer, size_t size)
 {
     if (!m_readers) {
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Function.h>
 #include <Kernel/DoubleBuffer.h>
 #include <Kernel/FileSystem/File.h>
 #include <Kernel/Locking/Mutex.h>
@@ -38,6 +39,11 @@ public:
     void detach(Direction);
 #pragma GCC diagnostic pop
 
+    // Hands the pipe's contents to `sink` (by way of `scratch`), and only removes as much
+    // of it from the pipe as `sink` says it has consumed. This lets splice() move data
+    // into files that may not take all of it at once.
+    ErrorOr<size_t> drain_into(OpenFileDescription&, Bytes scratch, Function<ErrorOr<size_t>(UserOrKernelBuffer const&, size_t)> const& sink);
+
 private:
     // ^File
     virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override;
@@ -62,6 +68,7 @@ private:
     WaitQueue m_read_open_queue;
     WaitQueue m_write_open_queue;
     Mutex m_open_lock;
+    Mutex m_read_lock { "FIFO read" };
 };
 
 }
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <AK/Error.h>
+#include <AK/IntrusiveList.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/RefCounted.h>
 #include <AK/StringView.h>
@@ -23,8 +24,34 @@ class File;
 
 class FileBlockerSet final : public Thread::BlockerSet {
 public:
+    // A watcher gets notified whenever the state of the file may have changed, without
+    // having to keep a thread blocked on it (this is what epoll is built on).
+    class Watcher {
+    public:
+        virtual ~Watcher() = default;
+
+        // NOTE: This is called with the blocker set's lock held, so it must not block.
+        virtual void file_state_may_have_changed() = 0;
+
+    private:
+        friend class FileBlockerSet;
+        IntrusiveListNode<Watcher> m_watcher_list_node;
+    };
+
     FileBlockerSet() { }
 
+    void add_watcher(Watcher& watcher)
+    {
+        SpinlockLocker lock(m_lock);
+        m_watchers.append(watcher);
+    }
+
+    void remove_watcher(Watcher& watcher)
+    {
+        SpinlockLocker lock(m_lock);
+        m_watchers.remove(watcher);
+    }
+
     virtual bool should_add_blocker(Thread::Blocker& b, void* data) override
     {
         VERIFY(b.blocker_type() == Thread::Blocker::Type::File);
@@ -40,7 +67,12 @@ public:
             auto& blocker = static_cast<Thread::FileBlocker&>(b);
             return blocker.unblock_if_conditions_are_met(false, data);
         });
+        for (auto& watcher : m_watchers)
+            watcher.file_state_may_have_changed();
     }
+
+private:
+    IntrusiveList<&Watcher::m_watcher_list_node> m_watchers;
 };
 
 // File is the base class for anything that can be referenced by a OpenFileDescription.
@@ -114,6 +146,7 @@ public:
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
     virtual bool is_inode_watcher() const { return false; }
+    virtual bool is_epoll() const { return false; }
 
     virtual FileBlockerSet& blocker_set() { return m_blocker_set; }
 
@@ -49,21 +49,37 @@ FileSystem::DirectoryEntryView::DirectoryEntryView(StringView n, InodeIdentifier
 {
 }
 
+static NonnullRefPtrVector<FileSystem, 32> all_file_systems_snapshot()
+{
+    NonnullRefPtrVector<FileSystem, 32> file_systems;
+    InterruptDisabler disabler;
+    for (auto& it : all_file_systems())
+        file_systems.append(*it.value);
+    return file_systems;
+}
+
 void FileSystem::sync()
 {
     Inode::sync_all();
 
-    NonnullRefPtrVector<FileSystem, 32> file_systems;
-    {
-        InterruptDisabler disabler;
-        for (auto& it : all_file_systems())
-            file_systems.append(*it.value);
-    }
-
-    for (auto& fs : file_systems)
+    for (auto& fs : all_file_systems_snapshot())
         fs.flush_writes();
 }
 
+void FileSystem::sync_metadata()
+{
+    Inode::sync_all();
+
+    for (auto& fs : all_file_systems_snapshot())
+        fs.flush_metadata_writes();
+}
+
+void FileSystem::write_back_all()
+{
+    for (auto& fs : all_file_systems_snapshot())
+        fs.write_back_dirty_data();
+}
+
 void FileSystem::lock_all()
 {
     for (auto& it : all_file_systems()) {
@@ -29,12 +29,15 @@ public:
     FileSystemID fsid() const { return m_fsid; }
     static FileSystem* from_fsid(FileSystemID);
     static void sync();
+    static void sync_metadata();
+    static void write_back_all();
     static void lock_all();
 
     virtual ErrorOr<void> initialize() = 0;
     virtual StringView class_name() const = 0;
     virtual Inode& root_inode() = 0;
     virtual bool supports_watchers() const { return false; }
+    virtual bool supports_page_cache() const { return false; }
 
     bool is_readonly() const { return m_readonly; }
 
@@ -54,6 +57,13 @@ public:
     };
 
     virtual void flush_writes() { }
+    // Only writes back metadata, and leaves buffered file contents to write_back_dirty_data().
+    virtual void flush_metadata_writes() { flush_writes(); }
+    // Called periodically (and whenever there's too much dirty data) to write back buffered file contents.
+    virtual void write_back_dirty_data() { }
+    // Slows down the current thread if it dirties buffered data faster than it can be written back.
+    // NOTE: This may sleep for a while, so callers must not be holding any inode locks.
+    virtual void throttle_writer() { }
 
     u64 block_size() const { return m_block_size; }
     size_t fragment_size() const { return m_fragment_size; }
@@ -26,6 +26,7 @@ class Inode : public ListedRefCounted<Inode, LockType::Spinlock>
     , public Weakable<Inode> {
     friend class VirtualFileSystem;
     friend class FileSystem;
+    friend class Memory::PageCache;
 
 public:
     virtual ~Inode();
@@ -52,6 +53,10 @@ public:
     virtual void detach(OpenFileDescription&) { }
     virtual void did_seek(OpenFileDescription&, off_t) { }
     virtual ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const = 0;
+    // File systems with a block cache of their own can bypass it here, so file contents don't end up being cached twice.
+    virtual ErrorOr<size_t> read_bytes_for_page_cache(off_t offset, size_t count, UserOrKernelBuffer& buffer) const { return read_bytes(offset, count, buffer, nullptr); }
+    // Asks the file system to start reading the given range into memory, without waiting for it to arrive.
+    virtual void start_readahead(u64, size_t) { }
     virtual ErrorOr<void> traverse_as_directory(Function<ErrorOr<void>(FileSystem::DirectoryEntryView const&)>) const = 0;
     virtual ErrorOr<NonnullRefPtr<Inode>> lookup(StringView name) = 0;
     virtual ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const& data, OpenFileDescription*) = 0;
@@ -10,6 +10,7 @@
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/Memory/PageCache.h>
 #include <Kernel/Memory/PrivateInodeVMObject.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
 #include <Kernel/Process.h>
@@ -29,20 +30,48 @@ ErrorOr<size_t> InodeFile::read(OpenFileDescription& description, u64 offset, Us
     if (Checked<off_t>::addition_would_overflow(offset, count))
         return EOVERFLOW;
 
-    auto nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
+    size_t nread = 0;
+    if (Memory::PageCache::should_cache(*m_inode, &description))
+        nread = TRY(Memory::PageCache::the().read_bytes(*m_inode, offset, count, buffer, &description));
+    else
+        nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
     if (nread > 0) {
         Thread::current()->did_file_read(nread);
         evaluate_block_conditions();
+        start_readahead_if_sequential(description, offset, nread);
     }
     return nread;
 }
 
+void InodeFile::start_readahead_if_sequential(OpenFileDescription& description, u64 offset, size_t nread)
+{
+    if (description.is_direct())
+        return;
+    auto range = description.update_readahead_window(offset, nread, m_inode->size());
+    if (!range.has_value())
+        return;
+    // If the end of the window is already in memory, the rest of it most likely is as well.
+    if (Memory::PageCache::the().is_resident(*m_inode, range->offset + range->size - 1))
+        return;
+    m_inode->start_readahead(range->offset, range->size);
+}
+
 ErrorOr<size_t> InodeFile::write(OpenFileDescription& description, u64 offset, UserOrKernelBuffer const& data, size_t count)
 {
     if (Checked<off_t>::addition_would_overflow(offset, count))
         return EOVERFLOW;
 
-    auto nwritten = TRY(m_inode->write_bytes(offset, count, data, &description));
+    // Don't let anyone dirty the block cache faster than it can be written back.
+    // NOTE: We do this before anyone takes the inode lock, as it may put us to sleep for a while.
+    if (!description.is_direct())
+        m_inode->fs().throttle_writer();
+
+    size_t nwritten = 0;
+    // NOTE: O_DIRECT writes don't populate the page cache, but they still have to update the pages it already holds.
+    if (Memory::PageCache::should_cache(*m_inode, nullptr))
+        nwritten = TRY(Memory::PageCache::the().write_bytes(*m_inode, offset, count, data, &description));
+    else
+        nwritten = TRY(m_inode->write_bytes(offset, count, data, &description));
     if (nwritten > 0) {
         auto mtime_result = m_inode->set_mtime(kgettimeofday().to_truncated_seconds());
         Thread::current()->did_file_write(nwritten);
@@ -83,7 +112,9 @@ ErrorOr<Memory::Region*> InodeFile::mmap(Process& process, OpenFileDescription&
 {
     // FIXME: If PROT_EXEC, check that the underlying file system isn't mounted noexec.
     RefPtr<Memory::InodeVMObject> vmobject;
-    if (shared)
+    if (shared && Memory::PageCache::should_cache(inode(), &description))
+        vmobject = TRY(Memory::PageCache::the().vmobject_for(inode()));
+    else if (shared)
         vmobject = TRY(Memory::SharedInodeVMObject::try_create_with_inode(inode()));
     else
         vmobject = TRY(Memory::PrivateInodeVMObject::try_create_with_inode(inode()));
@@ -100,6 +131,7 @@ ErrorOr<NonnullOwnPtr<KString>> InodeFile::pseudo_path(OpenFileDescription const
 ErrorOr<void> InodeFile::truncate(u64 size)
 {
     TRY(m_inode->truncate(size));
+    Memory::PageCache::the().invalidate(*m_inode);
     TRY(m_inode->set_mtime(kgettimeofday().to_truncated_seconds()));
     return {};
 }
@@ -50,6 +50,9 @@ public:
 
 private:
     explicit InodeFile(NonnullRefPtr<Inode>&&);
+
+    void start_readahead_if_sequential(OpenFileDescription&, u64 offset, size_t nread);
+
     NonnullRefPtr<Inode> m_inode;
 };
 
@@ -9,6 +9,7 @@
 #include <Kernel/API/POSIX/errno.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/EPoll.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
@@ -327,6 +328,18 @@ InodeWatcher* OpenFileDescription::inode_watcher()
     return static_cast<InodeWatcher*>(m_file.ptr());
 }
 
+bool OpenFileDescription::is_epoll() const
+{
+    return m_file->is_epoll();
+}
+
+EPoll* OpenFileDescription::epoll()
+{
+    if (!is_epoll())
+        return nullptr;
+    return static_cast<EPoll*>(m_file.ptr());
+}
+
 bool OpenFileDescription::is_master_pty() const
 {
     return m_file->is_master_pty();
@@ -498,6 +511,11 @@ bool OpenFileDescription::is_directory() const
     return m_state.with([](auto& state) { return state.is_directory; });
 }
 
+Optional<ReadaheadWindow::Range> OpenFileDescription::update_readahead_window(u64 offset, size_t nread, u64 file_size)
+{
+    return m_state.with([&](auto& state) { return state.readahead_window.did_read(offset, nread, file_size); });
+}
+
 bool OpenFileDescription::is_blocking() const
 {
     return m_state.with([](auto& state) { return state.is_blocking; });
@@ -8,9 +8,11 @@
 
 #include <AK/Badge.h>
 #include <AK/RefCounted.h>
+#include <AK/Weakable.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
+#include <Kernel/FileSystem/ReadaheadWindow.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/VirtualAddress.h>
@@ -22,7 +24,9 @@ public:
     virtual ~OpenFileDescriptionData() = default;
 };
 
-class OpenFileDescription : public RefCounted<OpenFileDescription> {
+class OpenFileDescription
+    : public RefCounted<OpenFileDescription>
+    , public Weakable<OpenFileDescription> {
 public:
     static ErrorOr<NonnullRefPtr<OpenFileDescription>> try_create(Custody&);
     static ErrorOr<NonnullRefPtr<OpenFileDescription>> try_create(File&);
@@ -65,6 +69,8 @@ public:
 
     bool is_directory() const;
 
+    Optional<ReadaheadWindow::Range> update_readahead_window(u64 offset, size_t nread, u64 file_size);
+
     File& file() { return *m_file; }
     File const& file() const { return *m_file; }
 
@@ -80,6 +86,9 @@ public:
     InodeWatcher const* inode_watcher() const;
     InodeWatcher* inode_watcher();
 
+    bool is_epoll() const;
+    EPoll* epoll();
+
     bool is_master_pty() const;
     MasterPTY const* master_pty() const;
     MasterPTY* master_pty();
@@ -153,6 +162,7 @@ private:
         bool should_append : 1 { false };
         bool direct : 1 { false };
         FIFO::Direction fifo_direction : 2 { FIFO::Direction::Neither };
+        ReadaheadWindow readahead_window;
     };
 
     SpinlockProtected<State> m_state;
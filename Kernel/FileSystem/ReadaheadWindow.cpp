@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/ReadaheadWindow.h>
+
+namespace Kernel {
+
+Optional<ReadaheadWindow::Range> ReadaheadWindow::did_read(u64 offset, size_t count, u64 file_size)
+{
+    if (count == 0)
+        return {};
+
+    bool is_sequential = offset == m_next_offset;
+    m_next_offset = offset + count;
+
+    if (!is_sequential) {
+        m_size = 0;
+        m_end = 0;
+        m_trigger_offset = 0;
+        return {};
+    }
+
+    if (m_size == 0) {
+        m_size = initial_size;
+        m_end = m_next_offset;
+        m_trigger_offset = m_next_offset;
+    }
+
+    // Only start on the next window once the reader is halfway through the previous one.
+    if (m_next_offset < m_trigger_offset)
+        return {};
+
+    Range range;
+    range.offset = max(m_end, m_next_offset);
+    if (range.offset >= file_size)
+        return {};
+    range.size = min(static_cast<u64>(m_size), file_size - range.offset);
+
+    m_end = range.offset + range.size;
+    m_trigger_offset = range.offset + range.size / 2;
+    m_size = min(m_size * 2, maximum_size);
+    return range;
+}
+
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Tracks how a file is being read through a single OpenFileDescription, and decides
+// how much of the file should be read ahead of a sequential reader.
+// The window starts out small and doubles every time the reader catches up with it,
+// so that streaming large files keeps enough requests in flight to hide the disk latency.
+// Any non-sequential access resets it.
+class ReadaheadWindow {
+public:
+    static constexpr size_t initial_size = 16 * KiB;
+    static constexpr size_t maximum_size = 512 * KiB;
+
+    struct Range {
+        u64 offset { 0 };
+        size_t size { 0 };
+    };
+
+    Optional<Range> did_read(u64 offset, size_t count, u64 file_size);
+
+private:
+    u64 m_next_offset { 0 };
+    u64 m_end { 0 };
+    u64 m_trigger_offset { 0 };
+    size_t m_size { 0 };
+};
+
+}
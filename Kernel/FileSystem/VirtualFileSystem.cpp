@@ -18,6 +18,7 @@
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/KLexicalPath.h>
 #include <Kernel/KSyms.h>
+#include <Kernel/Memory/PageCache.h>
 #include <Kernel/Process.h>
 #include <Kernel/Sections.h>
 
@@ -282,6 +283,7 @@ ErrorOr<NonnullRefPtr<OpenFileDescription>> VirtualFileSystem::open(StringView p
 
     if (should_truncate_file) {
         TRY(inode.truncate(0));
+        Memory::PageCache::the().invalidate(inode);
         TRY(inode.set_mtime(kgettimeofday().to_truncated_seconds()));
     }
     auto description = TRY(OpenFileDescription::try_create(custody));
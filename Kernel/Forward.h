@@ -23,6 +23,7 @@ class DevTmpFSRootDirectoryInode;
 class Device;
 class DiskCache;
 class DoubleBuffer;
+class EPoll;
 class File;
 class OpenFileDescription;
 class FileSystem;
@@ -72,6 +73,7 @@ class AnonymousVMObject;
 class InodeVMObject;
 class MappedROM;
 class MemoryManager;
+class PageCache;
 class PageDirectory;
 class PhysicalPage;
 class PhysicalRegion;
@@ -132,6 +132,27 @@ u32 FutexQueue::wake_all(bool& is_empty)
     return did_wake;
 }
 
+void FutexQueue::add_pi_waiter(PIWaiter& waiter)
+{
+    SpinlockLocker lock(m_lock);
+    m_pi_waiters.append(waiter);
+}
+
+void FutexQueue::remove_pi_waiter(PIWaiter& waiter)
+{
+    SpinlockLocker lock(m_lock);
+    m_pi_waiters.remove(waiter);
+}
+
+u32 FutexQueue::highest_pi_waiter_priority() const
+{
+    SpinlockLocker lock(m_lock);
+    u32 priority = 0;
+    for (auto& waiter : m_pi_waiters)
+        priority = max(priority, waiter.priority);
+    return priority;
+}
+
 bool FutexQueue::is_empty_and_no_imminent_waits_locked()
 {
     return m_imminent_waits == 0 && is_empty_locked();
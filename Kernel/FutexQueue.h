@@ -7,6 +7,7 @@
 #pragma once
 
 #include <AK/Atomic.h>
+#include <AK/IntrusiveList.h>
 #include <AK/RefCounted.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/VMObject.h>
@@ -41,12 +42,29 @@ public:
     }
     bool is_empty_and_no_imminent_waits_locked();
 
+    // Bookkeeping for FUTEX_LOCK_PI / FUTEX_UNLOCK_PI. The owner is whoever
+    // the waiters last saw in the futex word.
+    ThreadID pi_owner() const { return m_pi_owner; }
+    void set_pi_owner(ThreadID owner) { m_pi_owner = owner; }
+
+    // Every thread blocked in FUTEX_LOCK_PI lends the owner its priority for
+    // as long as it stays queued, so it has to take it back when it leaves.
+    struct PIWaiter {
+        u32 priority { 0 };
+        IntrusiveListNode<PIWaiter> list_node;
+    };
+    void add_pi_waiter(PIWaiter&);
+    void remove_pi_waiter(PIWaiter&);
+    u32 highest_pi_waiter_priority() const;
+
 protected:
     virtual bool should_add_blocker(Thread::Blocker& b, void*) override;
 
 private:
     size_t m_imminent_waits { 1 }; // We only create this object if we're going to be waiting, so start out with 1
     bool m_was_removed { false };
+    ThreadID m_pi_owner { 0 };
+    IntrusiveList<&PIWaiter::list_node> m_pi_waiters;
 };
 
 }
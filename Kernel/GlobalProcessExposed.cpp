@@ -21,7 +21,10 @@
 #include <Kernel/Interrupts/GenericInterruptHandler.h>
 #include <Kernel/Interrupts/InterruptManagement.h>
 #include <Kernel/KBufferBuilder.h>
+#include <Kernel/Locking/MutexStatistics.h>
+#include <Kernel/Memory/PageCache.h>
 #include <Kernel/Net/LocalSocket.h>
+#include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkingManagement.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCPSocket.h>
@@ -67,6 +70,17 @@ private:
             TRY(obj.add("link_speed", adapter.link_speed()));
             TRY(obj.add("link_full_duplex", adapter.link_full_duplex()));
             TRY(obj.add("mtu", adapter.mtu()));
+            auto queues = TRY(obj.add_array("receive_queues"));
+            for (size_t i = 0; i < adapter.receive_queue_count(); ++i) {
+                auto statistics = adapter.receive_queue_statistics(i);
+                auto queue_object = TRY(queues.add_object());
+                TRY(queue_object.add("packets", statistics.packets));
+                TRY(queue_object.add("bytes", statistics.bytes));
+                TRY(queue_object.add("dropped", statistics.dropped));
+                TRY(queue_object.add("batches", statistics.batches));
+                TRY(queue_object.finish());
+            }
+            TRY(queues.finish());
             TRY(obj.finish());
             return {};
         }));
@@ -124,6 +138,15 @@ private:
             TRY(obj.add("bytes_in", socket.bytes_in()));
             TRY(obj.add("packets_out", socket.packets_out()));
             TRY(obj.add("bytes_out", socket.bytes_out()));
+            TRY(obj.add("send_window", socket.send_window_size()));
+            TRY(obj.add("congestion_window", socket.congestion_window()));
+            TRY(obj.add("slow_start_threshold", socket.slow_start_threshold()));
+            TRY(obj.add("smoothed_rtt_ms", socket.smoothed_round_trip_time().to_milliseconds()));
+            TRY(obj.add("rto_ms", socket.retransmit_timeout().to_milliseconds()));
+            TRY(obj.add("retransmitted_packets", socket.retransmitted_packets()));
+            TRY(obj.add("sack", socket.is_sack_permitted()));
+            TRY(obj.add("timestamps", socket.has_timestamps()));
+            TRY(obj.add("window_scaling", socket.has_window_scaling()));
             if (Process::current().is_superuser() || Process::current().uid() == socket.origin_uid()) {
                 TRY(obj.add("origin_pid", socket.origin_pid().value()));
                 TRY(obj.add("origin_uid", socket.origin_uid().value()));
@@ -315,6 +338,19 @@ private:
     mutable Mutex m_lock;
 };
 
+#if LOOPBACK_DEBUG
+class ProcFSLoopbackDropsPackets : public ProcFSSystemBoolean {
+public:
+    static NonnullRefPtr<ProcFSLoopbackDropsPackets> must_create(ProcFSSystemDirectory const&);
+
+    virtual bool value() const override { return g_loopback_drops_packets.load(); }
+    virtual void set_value(bool new_value) override { g_loopback_drops_packets.store(new_value); }
+
+private:
+    ProcFSLoopbackDropsPackets();
+};
+#endif
+
 UNMAP_AFTER_INIT NonnullRefPtr<ProcFSDumpKmallocStacks> ProcFSDumpKmallocStacks::must_create(ProcFSSystemDirectory const&)
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSDumpKmallocStacks).release_nonnull();
@@ -328,6 +364,13 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSCapsLockRemap> ProcFSCapsLockRemap::must_cr
     return adopt_ref_if_nonnull(new (nothrow) ProcFSCapsLockRemap).release_nonnull();
 }
 
+#if LOOPBACK_DEBUG
+UNMAP_AFTER_INIT NonnullRefPtr<ProcFSLoopbackDropsPackets> ProcFSLoopbackDropsPackets::must_create(ProcFSSystemDirectory const&)
+{
+    return adopt_ref_if_nonnull(new (nothrow) ProcFSLoopbackDropsPackets).release_nonnull();
+}
+#endif
+
 UNMAP_AFTER_INIT ProcFSDumpKmallocStacks::ProcFSDumpKmallocStacks()
     : ProcFSSystemBoolean("kmalloc_stacks"sv)
 {
@@ -343,6 +386,13 @@ UNMAP_AFTER_INIT ProcFSCapsLockRemap::ProcFSCapsLockRemap()
 {
 }
 
+#if LOOPBACK_DEBUG
+UNMAP_AFTER_INIT ProcFSLoopbackDropsPackets::ProcFSLoopbackDropsPackets()
+    : ProcFSSystemBoolean("loopback_drops_packets"sv)
+{
+}
+#endif
+
 class ProcFSSelfProcessDirectory final : public ProcFSExposedLink {
 public:
     static NonnullRefPtr<ProcFSSelfProcessDirectory> must_create();
@@ -407,6 +457,7 @@ private:
         get_kmalloc_stats(stats);
 
         auto system_memory = MM.get_system_memory_info();
+        auto page_cache = Memory::PageCache::the().statistics();
 
         auto json = TRY(JsonObjectSerializer<>::try_create(builder));
         TRY(json.add("kmalloc_allocated", stats.bytes_allocated));
@@ -417,6 +468,16 @@ private:
         TRY(json.add("user_physical_uncommitted", system_memory.user_physical_pages_uncommitted));
         TRY(json.add("super_physical_allocated", system_memory.super_physical_pages_used));
         TRY(json.add("super_physical_available", system_memory.super_physical_pages - system_memory.super_physical_pages_used));
+        TRY(json.add("huge_pages_mapped", system_memory.huge_pages_mapped));
+        TRY(json.add("huge_page_allocations", system_memory.huge_page_allocations));
+        TRY(json.add("huge_page_allocation_failures", system_memory.huge_page_allocation_failures));
+        TRY(json.add("huge_page_promotions", system_memory.huge_page_promotions));
+        TRY(json.add("huge_page_demotions", system_memory.huge_page_demotions));
+        TRY(json.add("page_cache_inodes", page_cache.cached_inodes));
+        TRY(json.add("page_cache_resident", page_cache.resident_pages));
+        TRY(json.add("page_cache_hits", page_cache.hits));
+        TRY(json.add("page_cache_misses", page_cache.misses));
+        TRY(json.add("page_cache_evicted", page_cache.evicted_pages));
         TRY(json.add("kmalloc_call_count", stats.kmalloc_call_count));
         TRY(json.add("kfree_call_count", stats.kfree_call_count));
         TRY(json.finish());
@@ -612,6 +673,36 @@ private:
         return {};
     }
 };
+class ProcFSLockStatistics final : public ProcFSGlobalInformation {
+public:
+    static NonnullRefPtr<ProcFSLockStatistics> must_create();
+
+private:
+    ProcFSLockStatistics();
+    virtual ErrorOr<void> try_generate(KBufferBuilder& builder) override
+    {
+        auto array = TRY(JsonArraySerializer<>::try_create(builder));
+        TRY(MutexStatistics::for_each([&](MutexStatistics const& statistics) -> ErrorOr<void> {
+            auto obj = TRY(array.add_object());
+            TRY(obj.add("name", statistics.name));
+            TRY(obj.add("contended", statistics.contended_acquisitions.load()));
+            TRY(obj.add("acquired_by_spinning", statistics.spin_acquisitions.load()));
+            TRY(obj.add("acquired_after_blocking", statistics.blocked_acquisitions.load()));
+            TRY(obj.add("total_wait_time_ns", statistics.total_wait_time_ns.load()));
+            TRY(obj.add("max_wait_time_ns", statistics.max_wait_time_ns.load()));
+#if LOCK_DEBUG
+            if (auto* file = statistics.last_contended_file.load()) {
+                TRY(obj.add("last_contended_file", file));
+                TRY(obj.add("last_contended_line", statistics.last_contended_line.load()));
+            }
+#endif
+            TRY(obj.finish());
+            return {};
+        }));
+        TRY(array.finish());
+        return {};
+    }
+};
 class ProcFSDmesg final : public ProcFSGlobalInformation {
 public:
     static NonnullRefPtr<ProcFSDmesg> must_create();
@@ -838,6 +929,10 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSCPUInformation> ProcFSCPUInformation::must_
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSCPUInformation).release_nonnull();
 }
+UNMAP_AFTER_INIT NonnullRefPtr<ProcFSLockStatistics> ProcFSLockStatistics::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) ProcFSLockStatistics).release_nonnull();
+}
 UNMAP_AFTER_INIT NonnullRefPtr<ProcFSDmesg> ProcFSDmesg::must_create()
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSDmesg).release_nonnull();
@@ -904,6 +999,10 @@ UNMAP_AFTER_INIT ProcFSCPUInformation::ProcFSCPUInformation()
     : ProcFSGlobalInformation("cpuinfo"sv)
 {
 }
+UNMAP_AFTER_INIT ProcFSLockStatistics::ProcFSLockStatistics()
+    : ProcFSGlobalInformation("lockstat"sv)
+{
+}
 UNMAP_AFTER_INIT ProcFSDmesg::ProcFSDmesg()
     : ProcFSGlobalInformation("dmesg"sv)
 {
@@ -952,6 +1051,9 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSSystemDirectory> ProcFSSystemDirectory::mus
     directory->m_components.append(ProcFSDumpKmallocStacks::must_create(directory));
     directory->m_components.append(ProcFSUBSanDeadly::must_create(directory));
     directory->m_components.append(ProcFSCapsLockRemap::must_create(directory));
+#if LOOPBACK_DEBUG
+    directory->m_components.append(ProcFSLoopbackDropsPackets::must_create(directory));
+#endif
     return directory;
 }
 
@@ -974,6 +1076,7 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSRootDirectory> ProcFSRootDirectory::must_cr
     directory->m_components.append(ProcFSSystemStatistics::must_create());
     directory->m_components.append(ProcFSOverallProcesses::must_create());
     directory->m_components.append(ProcFSCPUInformation::must_create());
+    directory->m_components.append(ProcFSLockStatistics::must_create());
     directory->m_components.append(ProcFSDmesg::must_create());
     directory->m_components.append(ProcFSInterrupts::must_create());
     directory->m_components.append(ProcFSKeymap::must_create());
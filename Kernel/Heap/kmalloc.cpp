@@ -121,6 +121,20 @@ public:
     size_t slab_size() const { return m_slab_size; }
 
     void* allocate()
+    {
+        auto* ptr = take_slab();
+        memset(ptr, KMALLOC_SCRUB_BYTE, m_slab_size);
+        return ptr;
+    }
+
+    void deallocate(void* ptr)
+    {
+        memset(ptr, KFREE_SCRUB_BYTE, m_slab_size);
+        return_slab(ptr);
+    }
+
+    // NOTE: These don't scrub the slabs, that's up to whoever hands them out to (or takes them back from) the rest of the kernel.
+    void* take_slab()
     {
         if (m_usable_blocks.is_empty()) {
             // FIXME: This allocation wastes `block_size` bytes due to the implementation of kmalloc_aligned().
@@ -137,15 +151,11 @@ public:
         auto* ptr = block->allocate();
         if (block->is_full())
             m_full_blocks.append(*block);
-
-        memset(ptr, KMALLOC_SCRUB_BYTE, m_slab_size);
         return ptr;
     }
 
-    void deallocate(void* ptr)
+    void return_slab(void* ptr)
     {
-        memset(ptr, KFREE_SCRUB_BYTE, m_slab_size);
-
         auto* block = (KmallocSlabBlock*)((FlatPtr)ptr & KmallocSlabBlock::block_mask);
         bool block_was_full = block->is_full();
         block->deallocate(ptr);
@@ -391,7 +401,8 @@ struct KmallocGlobalData {
 
     KmallocSubheap::List subheaps;
 
-    KmallocSlabheap slabheaps[6] = { 16, 32, 64, 128, 256, 512 };
+    static constexpr size_t slabheap_count = 6;
+    KmallocSlabheap slabheaps[slabheap_count] = { 16, 32, 64, 128, 256, 512 };
 
     bool expansion_in_progress { false };
 };
@@ -404,6 +415,177 @@ static size_t g_kfree_call_count;
 static size_t g_nested_kfree_calls;
 bool g_dump_kmalloc_stacks;
 
+static Optional<size_t> slabheap_index_for(size_t size)
+{
+    for (size_t i = 0; i < KmallocGlobalData::slabheap_count; ++i) {
+        if (size <= g_kmalloc_global->slabheaps[i].slab_size())
+            return i;
+    }
+    return {};
+}
+
+// A small stack of free slabs of one size class, owned by a single processor.
+class KmallocSlabMagazine {
+public:
+    static constexpr size_t capacity = 32;
+    // Magazines are refilled from (and flushed to) the shared slabheap this many slabs at a time.
+    static constexpr size_t batch_size = capacity / 2;
+
+    bool is_empty() const { return m_count == 0; }
+    bool is_full() const { return m_count == capacity; }
+    size_t count() const { return m_count; }
+
+    void push(void* ptr)
+    {
+        VERIFY(!is_full());
+        m_slabs[m_count++] = ptr;
+    }
+
+    void* pop()
+    {
+        VERIFY(!is_empty());
+        return m_slabs[--m_count];
+    }
+
+private:
+    size_t m_count { 0 };
+    void* m_slabs[capacity];
+};
+
+// Every processor keeps a magazine of free slabs for each slabheap, so small allocations and
+// deallocations usually don't have to take the kmalloc lock, which all processors contend on.
+// NOTE: The cache has a lock of its own, but it's only ever contended when we get migrated while
+//       using it, or when someone reads the statistics.
+class KmallocProcessorCache {
+public:
+    void* allocate(size_t slabheap_index)
+    {
+        auto& slabheap = g_kmalloc_global->slabheaps[slabheap_index];
+        void* ptr;
+        {
+            SpinlockLocker locker(m_lock);
+            ++m_kmalloc_call_count;
+            auto& magazine = m_magazines[slabheap_index];
+            auto& statistics = m_statistics[slabheap_index];
+            if (magazine.is_empty()) {
+                ++statistics.misses;
+                SpinlockLocker global_locker(s_lock);
+                for (size_t i = 0; i < KmallocSlabMagazine::batch_size; ++i)
+                    magazine.push(slabheap.take_slab());
+            } else {
+                ++statistics.hits;
+            }
+            ptr = magazine.pop();
+        }
+        memset(ptr, KMALLOC_SCRUB_BYTE, slabheap.slab_size());
+        return ptr;
+    }
+
+    void deallocate(size_t slabheap_index, void* ptr)
+    {
+        auto& slabheap = g_kmalloc_global->slabheaps[slabheap_index];
+        memset(ptr, KFREE_SCRUB_BYTE, slabheap.slab_size());
+
+        SpinlockLocker locker(m_lock);
+        ++m_kfree_call_count;
+        auto& magazine = m_magazines[slabheap_index];
+        auto& statistics = m_statistics[slabheap_index];
+        if (magazine.is_full()) {
+            ++statistics.flushes;
+            SpinlockLocker global_locker(s_lock);
+            for (size_t i = 0; i < KmallocSlabMagazine::batch_size; ++i)
+                slabheap.return_slab(magazine.pop());
+        }
+        magazine.push(ptr);
+        ++statistics.frees;
+    }
+
+    // Adds what this processor has been up to, to the given statistics.
+    void add_statistics(kmalloc_stats& stats, Span<kmalloc_slabheap_stats> slabheap_stats)
+    {
+        SpinlockLocker locker(m_lock);
+        stats.kmalloc_call_count += m_kmalloc_call_count;
+        stats.kfree_call_count += m_kfree_call_count;
+        for (size_t i = 0; i < KmallocGlobalData::slabheap_count; ++i) {
+            // Slabs sitting in a magazine are free as far as anyone outside of kmalloc is concerned.
+            size_t cached_bytes = m_magazines[i].count() * g_kmalloc_global->slabheaps[i].slab_size();
+            // NOTE: The magazine might have been refilled since the slabheap was looked at.
+            stats.bytes_allocated -= min(stats.bytes_allocated, cached_bytes);
+            stats.bytes_free += cached_bytes;
+            if (i >= slabheap_stats.size())
+                continue;
+            slabheap_stats[i].bytes_allocated -= min(slabheap_stats[i].bytes_allocated, cached_bytes);
+            slabheap_stats[i].bytes_free += cached_bytes;
+            slabheap_stats[i].cached_slabs += m_magazines[i].count();
+            slabheap_stats[i].magazine_hits += m_statistics[i].hits;
+            slabheap_stats[i].magazine_misses += m_statistics[i].misses;
+            slabheap_stats[i].magazine_frees += m_statistics[i].frees;
+            slabheap_stats[i].magazine_flushes += m_statistics[i].flushes;
+        }
+    }
+
+private:
+    struct Statistics {
+        size_t hits { 0 };
+        size_t misses { 0 };
+        size_t frees { 0 };
+        size_t flushes { 0 };
+    };
+
+    Spinlock m_lock;
+    KmallocSlabMagazine m_magazines[KmallocGlobalData::slabheap_count];
+    Statistics m_statistics[KmallocGlobalData::slabheap_count];
+    size_t m_kmalloc_call_count { 0 };
+    size_t m_kfree_call_count { 0 };
+};
+
+// NOTE: This matches the inline capacity of the ProcessorContainer.
+static constexpr size_t max_processor_caches = 64;
+static KmallocProcessorCache* s_processor_caches[max_processor_caches];
+static bool s_processor_caches_enabled;
+
+static KmallocProcessorCache* current_processor_cache()
+{
+    if (!s_processor_caches_enabled)
+        return nullptr;
+    return s_processor_caches[Processor::current_id()];
+}
+
+void kmalloc_enable_processor_cache()
+{
+    // NOTE: Until this has been called on a processor, it allocates straight from the shared heaps.
+    auto* cache = new KmallocProcessorCache;
+    auto processor_id = Processor::current_id();
+    VERIFY(processor_id < max_processor_caches);
+    VERIFY(!s_processor_caches[processor_id]);
+    s_processor_caches[processor_id] = cache;
+    s_processor_caches_enabled = true;
+}
+
+static void add_kmalloc_perf_event(size_t size, void* ptr)
+{
+    Thread* current_thread = Thread::current();
+    if (!current_thread)
+        current_thread = Processor::idle_thread();
+    if (current_thread) {
+        // FIXME: By the time we check this, we have already allocated above.
+        //        This means that in the case of an infinite recursion, we can't catch it this way.
+        VERIFY(current_thread->is_allocation_enabled());
+        PerformanceManager::add_kmalloc_perf_event(*current_thread, size, (FlatPtr)ptr);
+    }
+}
+
+static void add_kfree_perf_event(void* ptr)
+{
+    Thread* current_thread = Thread::current();
+    if (!current_thread)
+        current_thread = Processor::idle_thread();
+    if (current_thread) {
+        VERIFY(current_thread->is_allocation_enabled());
+        PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
+    }
+}
+
 void kmalloc_enable_expand()
 {
     g_kmalloc_global->enable_expansion();
@@ -429,6 +611,17 @@ UNMAP_AFTER_INIT void kmalloc_init()
 void* kmalloc(size_t size)
 {
     kmalloc_verify_nospinlock_held();
+
+    if (!g_dump_kmalloc_stacks) {
+        if (auto slabheap_index = slabheap_index_for(size); slabheap_index.has_value()) {
+            if (auto* cache = current_processor_cache()) {
+                void* ptr = cache->allocate(slabheap_index.value());
+                add_kmalloc_perf_event(size, ptr);
+                return ptr;
+            }
+        }
+    }
+
     SpinlockLocker lock(s_lock);
     ++g_kmalloc_call_count;
 
@@ -438,17 +631,7 @@ void* kmalloc(size_t size)
     }
 
     void* ptr = g_kmalloc_global->allocate(size);
-
-    Thread* current_thread = Thread::current();
-    if (!current_thread)
-        current_thread = Processor::idle_thread();
-    if (current_thread) {
-        // FIXME: By the time we check this, we have already allocated above.
-        //        This means that in the case of an infinite recursion, we can't catch it this way.
-        VERIFY(current_thread->is_allocation_enabled());
-        PerformanceManager::add_kmalloc_perf_event(*current_thread, size, (FlatPtr)ptr);
-    }
-
+    add_kmalloc_perf_event(size, ptr);
     return ptr;
 }
 
@@ -472,19 +655,23 @@ void kfree_sized(void* ptr, size_t size)
     VERIFY(size > 0);
 
     kmalloc_verify_nospinlock_held();
+
+    // NOTE: Dumping a backtrace happens with the kmalloc lock held, and the processor caches have to be entered before it.
+    if (auto slabheap_index = slabheap_index_for(size); slabheap_index.has_value() && !g_dump_kmalloc_stacks) {
+        if (auto* cache = current_processor_cache()) {
+            VERIFY(g_kmalloc_global->is_valid_kmalloc_address(VirtualAddress { ptr }));
+            add_kfree_perf_event(ptr);
+            cache->deallocate(slabheap_index.value(), ptr);
+            return;
+        }
+    }
+
     SpinlockLocker lock(s_lock);
     ++g_kfree_call_count;
     ++g_nested_kfree_calls;
 
-    if (g_nested_kfree_calls == 1) {
-        Thread* current_thread = Thread::current();
-        if (!current_thread)
-            current_thread = Processor::idle_thread();
-        if (current_thread) {
-            VERIFY(current_thread->is_allocation_enabled());
-            PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
-        }
-    }
+    if (g_nested_kfree_calls == 1)
+        add_kfree_perf_event(ptr);
 
     g_kmalloc_global->deallocate(ptr, size);
     --g_nested_kfree_calls;
@@ -581,9 +768,35 @@ void operator delete[](void* ptr, size_t size) noexcept
 
 void get_kmalloc_stats(kmalloc_stats& stats)
 {
-    SpinlockLocker lock(s_lock);
-    stats.bytes_allocated = g_kmalloc_global->allocated_bytes();
-    stats.bytes_free = g_kmalloc_global->free_bytes();
-    stats.kmalloc_call_count = g_kmalloc_call_count;
-    stats.kfree_call_count = g_kfree_call_count;
+    get_kmalloc_stats(stats, nullptr, 0);
+}
+
+void get_kmalloc_stats(kmalloc_stats& stats, kmalloc_slabheap_stats* slabheap_stats_data, size_t slabheap_stats_count)
+{
+    Span<kmalloc_slabheap_stats> slabheap_stats { slabheap_stats_data, slabheap_stats_count };
+    {
+        SpinlockLocker lock(s_lock);
+        stats.bytes_allocated = g_kmalloc_global->allocated_bytes();
+        stats.bytes_free = g_kmalloc_global->free_bytes();
+        stats.kmalloc_call_count = g_kmalloc_call_count;
+        stats.kfree_call_count = g_kfree_call_count;
+        for (size_t i = 0; i < min(slabheap_stats.size(), KmallocGlobalData::slabheap_count); ++i) {
+            auto& slabheap = g_kmalloc_global->slabheaps[i];
+            slabheap_stats[i] = {};
+            slabheap_stats[i].slab_size = slabheap.slab_size();
+            slabheap_stats[i].bytes_allocated = slabheap.allocated_bytes();
+            slabheap_stats[i].bytes_free = slabheap.free_bytes();
+        }
+    }
+
+    // NOTE: The processor caches take the kmalloc lock while holding their own, so we can't look at them while holding it.
+    for (auto* cache : s_processor_caches) {
+        if (cache)
+            cache->add_statistics(stats, slabheap_stats);
+    }
+}
+
+size_t kmalloc_slabheap_count()
+{
+    return KmallocGlobalData::slabheap_count;
 }
@@ -50,6 +50,20 @@ struct kmalloc_stats {
 };
 void get_kmalloc_stats(kmalloc_stats&);
 
+struct kmalloc_slabheap_stats {
+    size_t slab_size;
+    size_t bytes_allocated;
+    size_t bytes_free;
+    // Free slabs held in the per-processor magazines.
+    size_t cached_slabs;
+    size_t magazine_hits;
+    size_t magazine_misses;
+    size_t magazine_frees;
+    size_t magazine_flushes;
+};
+size_t kmalloc_slabheap_count();
+void get_kmalloc_stats(kmalloc_stats&, kmalloc_slabheap_stats*, size_t slabheap_stats_count);
+
 extern bool g_dump_kmalloc_stacks;
 
 inline void* operator new(size_t, void* p) { return p; }
@@ -86,3 +100,4 @@ inline void kfree_aligned(void* ptr)
 size_t kmalloc_good_size(size_t);
 
 void kmalloc_enable_expand();
+void kmalloc_enable_processor_cache();
@@ -45,6 +45,8 @@ public:
     bool flush();
     OwnPtr<KBuffer> build();
 
+    size_t length() const { return m_size; }
+
     ReadonlyBytes bytes() const
     {
         if (!m_buffer)
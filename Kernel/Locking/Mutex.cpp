@@ -5,12 +5,15 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
 #include <Kernel/Debug.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Locking/LockLocation.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Scheduler.h>
 #include <Kernel/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
@@ -25,7 +28,35 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
     auto* current_thread = Thread::current();
 
     SpinlockLocker lock(m_lock);
+    bool did_spin = false;
     bool did_block = false;
+
+    bool is_contended = m_mode != Mode::Unlocked
+        && !(m_mode == Mode::Shared && mode == Mode::Shared)
+        && !(m_mode == Mode::Exclusive && m_holder == current_thread);
+    MutexStatistics* statistics = nullptr;
+    Time wait_start;
+    if (is_contended) {
+        statistics = this->statistics();
+        if (statistics) {
+            statistics->record_contention(location);
+            if (TimeManagement::is_initialized())
+                wait_start = TimeManagement::the().monotonic_time(TimePrecision::Precise);
+        }
+        auto spin_result = spin_while_holder_is_running(lock);
+        did_spin = spin_result != SpinResult::DidNotSpin;
+        if (spin_result == SpinResult::HolderReleased)
+            dbgln_if(LOCK_TRACE_DEBUG, "Mutex::lock @ {} ({}): holder released the lock while we were spinning", this, m_name);
+    }
+    ScopeGuard record_wait_time([&] {
+        if (!statistics)
+            return;
+        u64 wait_time_ns = 0;
+        if (TimeManagement::is_initialized() && wait_start != Time {})
+            wait_time_ns = (TimeManagement::the().monotonic_time(TimePrecision::Precise) - wait_start).to_nanoseconds();
+        statistics->record_acquisition(did_spin, did_block, wait_time_ns);
+    });
+
     Mode current_mode = m_mode;
     switch (current_mode) {
     case Mode::Unlocked: {
@@ -203,6 +234,64 @@ void Mutex::unlock()
     }
 }
 
+bool Mutex::has_blocked_waiters()
+{
+    return m_blocked_thread_lists.with([&](auto& lists) {
+        return !lists.exclusive.is_empty() || !lists.shared.is_empty() || !lists.exclusive_big_lock.is_empty();
+    });
+}
+
+Mutex::SpinResult Mutex::spin_while_holder_is_running(SpinlockLocker<Spinlock>& lock)
+{
+    VERIFY(lock.have_lock());
+
+    // Only an exclusive holder is known, so that is the only case where we
+    // can tell whether it is about to release the lock.
+    if (m_behavior != MutexBehavior::Regular || m_mode != Mode::Exclusive || !m_holder)
+        return SpinResult::DidNotSpin;
+    // The holder can only be running while we wait if threads are scheduled
+    // on more than one processor.
+    if (Scheduler::scheduling_processor_count() < 2)
+        return SpinResult::DidNotSpin;
+
+    // Once someone is asleep on this lock, unlock() hands ownership directly
+    // to the first waiter. Spinning then could only let us barge past them, so
+    // we queue up behind them instead.
+    if (has_blocked_waiters())
+        return SpinResult::DidNotSpin;
+
+    RefPtr<Thread> holder = m_holder;
+    lock.unlock();
+
+    bool released = false;
+    for (size_t i = 0; i < max_spin_iterations; ++i) {
+        if (AK::atomic_load(&m_mode, AK::MemoryOrder::memory_order_relaxed) == Mode::Unlocked) {
+            released = true;
+            break;
+        }
+        // If the holder got preempted or blocked, it won't release the lock
+        // any time soon.
+        if (holder->state() != Thread::State::Running)
+            break;
+        Processor::wait_check();
+    }
+
+    // Drop our reference before re-taking the spinlock, as it may be the last one.
+    holder = nullptr;
+    lock.lock();
+    if (released && m_mode == Mode::Unlocked)
+        return SpinResult::HolderReleased;
+    return SpinResult::HolderKeptLock;
+}
+
+MutexStatistics* Mutex::statistics()
+{
+    VERIFY(m_lock.is_locked());
+    if (!m_statistics)
+        m_statistics = MutexStatistics::for_name(m_name);
+    return m_statistics;
+}
+
 void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock>& lock, u32 requested_locks)
 {
     if constexpr (LOCK_IN_CRITICAL_DEBUG)
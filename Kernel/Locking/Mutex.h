@@ -14,6 +14,7 @@
 #include <Kernel/Forward.h>
 #include <Kernel/Locking/LockLocation.h>
 #include <Kernel/Locking/LockMode.h>
+#include <Kernel/Locking/MutexStatistics.h>
 #include <Kernel/WaitQueue.h>
 
 namespace Kernel {
@@ -82,8 +83,21 @@ private:
     // FIXME: remove this after annihilating Process::m_big_lock
     using BigLockBlockedThreadList = IntrusiveList<&Thread::m_big_lock_blocked_threads_list_node>;
 
+    // How often a contending thread polls an exclusive holder that is running
+    // on another processor before it gives up and blocks.
+    static constexpr size_t max_spin_iterations = 4096;
+
+    enum class SpinResult {
+        DidNotSpin,
+        HolderReleased,
+        HolderKeptLock,
+    };
+
     void block(Thread&, Mode, SpinlockLocker<Spinlock>&, u32);
     void unblock_waiters(Mode);
+    [[nodiscard]] bool has_blocked_waiters();
+    [[nodiscard]] SpinResult spin_while_holder_is_running(SpinlockLocker<Spinlock>&);
+    [[nodiscard]] MutexStatistics* statistics();
 
     StringView m_name;
     Mode m_mode { Mode::Unlocked };
@@ -120,6 +134,9 @@ private:
 
     mutable Spinlock m_lock;
 
+    // Looked up lazily the first time this Mutex is contended.
+    MutexStatistics* m_statistics { nullptr };
+
 #if LOCK_SHARED_UPGRADE_DEBUG
     HashMap<Thread*, u32> m_shared_holders_map;
 #endif
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <Kernel/Locking/MutexStatistics.h>
+#include <Kernel/Locking/Spinlock.h>
+
+namespace Kernel {
+
+static constexpr size_t max_mutex_statistics_entries = 512;
+
+struct MutexStatisticsSlot {
+    Atomic<bool> in_use { false };
+    MutexStatistics statistics;
+};
+
+static Array<MutexStatisticsSlot, max_mutex_statistics_entries> s_slots;
+static Spinlock s_slots_lock;
+
+void MutexStatistics::record_contention([[maybe_unused]] LockLocation const& location)
+{
+    contended_acquisitions++;
+#if LOCK_DEBUG
+    last_contended_file.store(location.filename(), AK::MemoryOrder::memory_order_relaxed);
+    last_contended_line = location.line_number();
+#endif
+}
+
+void MutexStatistics::record_acquisition(bool did_spin, bool did_block, u64 wait_time_ns)
+{
+    if (did_block)
+        blocked_acquisitions++;
+    else if (did_spin)
+        spin_acquisitions++;
+    total_wait_time_ns += wait_time_ns;
+
+    auto current_max = max_wait_time_ns.load();
+    while (wait_time_ns > current_max) {
+        if (max_wait_time_ns.compare_exchange_strong(current_max, wait_time_ns))
+            break;
+    }
+}
+
+MutexStatistics* MutexStatistics::for_name(StringView name)
+{
+    if (name.is_empty())
+        name = "(unnamed)"sv;
+
+    SpinlockLocker locker(s_slots_lock);
+    auto start = name.hash() % max_mutex_statistics_entries;
+    for (size_t i = 0; i < max_mutex_statistics_entries; ++i) {
+        auto& slot = s_slots[(start + i) % max_mutex_statistics_entries];
+        if (!slot.in_use.load(AK::MemoryOrder::memory_order_relaxed)) {
+            slot.statistics.name = name;
+            slot.in_use.store(true, AK::MemoryOrder::memory_order_release);
+            return &slot.statistics;
+        }
+        if (slot.statistics.name == name)
+            return &slot.statistics;
+    }
+    return nullptr;
+}
+
+ErrorOr<void> MutexStatistics::for_each(Function<ErrorOr<void>(MutexStatistics const&)> callback)
+{
+    // Slots are never released, so we can walk them without holding the lock.
+    for (auto& slot : s_slots) {
+        if (!slot.in_use.load(AK::MemoryOrder::memory_order_acquire))
+            continue;
+        TRY(callback(slot.statistics));
+    }
+    return {};
+}
+
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+#include <Kernel/Locking/LockLocation.h>
+
+namespace Kernel {
+
+// Contention counters shared by all Mutexes with the same name. Entries are
+// created on first contention and are never freed, so a Mutex may keep a
+// pointer to its entry for as long as it lives.
+struct MutexStatistics {
+    StringView name;
+
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> contended_acquisitions { 0 };
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> spin_acquisitions { 0 };
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> blocked_acquisitions { 0 };
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> total_wait_time_ns { 0 };
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> max_wait_time_ns { 0 };
+
+#if LOCK_DEBUG
+    // The most recent call site that had to wait for this lock.
+    Atomic<char const*> last_contended_file { nullptr };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> last_contended_line { 0 };
+#endif
+
+    void record_contention(LockLocation const&);
+    void record_acquisition(bool did_spin, bool did_block, u64 wait_time_ns);
+
+    // Returns nullptr if the table is full.
+    static MutexStatistics* for_name(StringView);
+    static ErrorOr<void> for_each(Function<ErrorOr<void>(MutexStatistics const&)>);
+};
+
+}
@@ -137,7 +137,18 @@ AnonymousVMObject::AnonymousVMObject(FixedArray<RefPtr<PhysicalPage>>&& new_phys
 {
     if (strategy == AllocationStrategy::AllocateNow) {
         // Allocate all pages right now. We know we can get all because we committed the amount needed
-        for (size_t i = 0; i < page_count(); ++i)
+        // NOTE: We grab huge pages for as long as we can get them, so a region mapping us at
+        //       a huge page aligned address can use them. Once that fails, regular pages will do.
+        size_t i = 0;
+        while (page_count() - i >= pages_per_huge_page) {
+            auto huge_page_or_error = m_unused_committed_pages->take_huge_page();
+            if (huge_page_or_error.is_error())
+                break;
+            auto huge_page = huge_page_or_error.release_value();
+            for (size_t j = 0; j < pages_per_huge_page; ++j)
+                physical_pages()[i++] = move(huge_page.ptr_at(j));
+        }
+        for (; i < page_count(); ++i)
             physical_pages()[i] = m_unused_committed_pages->take_one();
     } else {
         auto& initial_page = (strategy == AllocationStrategy::Reserve) ? MM.lazy_committed_page() : MM.shared_zero_page();
@@ -256,6 +267,11 @@ NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Reg
     return m_unused_committed_pages->take_one();
 }
 
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> AnonymousVMObject::allocate_committed_huge_page(Badge<Region>)
+{
+    return m_unused_committed_pages->take_huge_page();
+}
+
 ErrorOr<void> AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
@@ -67,6 +67,26 @@ int InodeVMObject::release_all_clean_pages()
     return count;
 }
 
+size_t InodeVMObject::resident_page_count() const
+{
+    SpinlockLocker locker(m_lock);
+    size_t count = 0;
+    for (auto& physical_page : m_physical_pages) {
+        if (physical_page)
+            ++count;
+    }
+    return count;
+}
+
+bool InodeVMObject::has_mappings() const
+{
+    bool has_mappings = false;
+    const_cast<InodeVMObject&>(*this).for_each_region([&](auto&) {
+        has_mappings = true;
+    });
+    return has_mappings;
+}
+
 u32 InodeVMObject::writable_mappings() const
 {
     u32 count = 0;
@@ -23,7 +23,9 @@ public:
     size_t amount_clean() const;
 
     int release_all_clean_pages();
+    size_t resident_page_count() const;
 
+    bool has_mappings() const;
     u32 writable_mappings() const;
     u32 executable_mappings() const;
 
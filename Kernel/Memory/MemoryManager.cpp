@@ -568,6 +568,8 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
     PageDirectoryEntry const& pde = pd[page_directory_index];
     if (!pde.is_present())
         return nullptr;
+    // NOTE: Huge pages don't have a page table to look into, ensure_pte() splits them up if needed.
+    VERIFY(!pde.is_huge());
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
@@ -583,11 +585,13 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     auto& pde = pd[page_directory_index];
-    if (pde.is_present())
+    if (pde.is_present() && !pde.is_huge())
         return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 
+    // NOTE: When splitting up a huge page, every entry of the new page table gets filled in below.
+    bool is_huge = pde.is_huge();
     bool did_purge = false;
-    auto page_table_or_error = allocate_user_physical_page(ShouldZeroFill::Yes, &did_purge);
+    auto page_table_or_error = allocate_user_physical_page(is_huge ? ShouldZeroFill::No : ShouldZeroFill::Yes, &did_purge);
     if (page_table_or_error.is_error()) {
         dbgln("MM: Unable to allocate page table to map {}", vaddr);
         return nullptr;
@@ -600,7 +604,31 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pd = quickmap_pd(page_directory, page_directory_table_index);
         VERIFY(&pde == &pd[page_directory_index]); // Sanity check
 
-        VERIFY(!pde.is_present()); // Should have not changed
+        VERIFY(pde.is_huge() == is_huge); // Should have not changed
+        VERIFY(is_huge || !pde.is_present());
+    }
+    if (is_huge) {
+        // Someone wants to map a single page inside of a huge page, so we have to demote it to
+        // a page table that maps the same memory with the same permissions first.
+        // NOTE: The TLB may still hold the huge translation, but it's equivalent to the new one,
+        //       and whoever remaps a page in here flushes it anyway.
+        auto huge_page_base = pde.huge_page_base();
+        auto* ptes = quickmap_pt(page_table->paddr());
+        for (size_t i = 0; i < pages_per_huge_page; ++i) {
+            auto& pte = ptes[i];
+            pte.clear();
+            pte.set_physical_page_base(huge_page_base + i * PAGE_SIZE);
+            pte.set_writable(pde.is_writable());
+            pte.set_user_allowed(pde.is_user_allowed());
+            pte.set_write_through(pde.is_write_through());
+            pte.set_cache_disabled(pde.is_cache_disabled());
+            pte.set_global(pde.is_global());
+            pte.set_execute_disabled(pde.is_execute_disabled());
+            pte.set_present(true);
+        }
+        pde.clear();
+        --m_system_memory_info.huge_pages_mapped;
+        ++m_system_memory_info.huge_page_demotions;
     }
     pde.set_page_table_base(page_table->paddr().get());
     pde.set_user_allowed(true);
@@ -614,6 +642,32 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
     return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 }
 
+PageDirectoryEntry& MemoryManager::ensure_huge_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    VERIFY(vaddr.get() % huge_page_size == 0);
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    if (pde.is_huge())
+        return pde;
+
+    if (pde.is_present()) {
+        // The huge page takes over everything this page table mapped, so we can get rid of it.
+        // NOTE: This unref matches the leaked ref in MemoryManager::ensure_pte()
+        get_physical_page_entry(PhysicalAddress { pde.page_table_base() }).allocated.physical_page.unref();
+        pde.clear();
+        ++m_system_memory_info.huge_page_promotions;
+    }
+    pde.set_huge(true);
+    ++m_system_memory_info.huge_pages_mapped;
+    return pde;
+}
+
 void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress vaddr, IsLastPTERelease is_last_pte_release)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -625,6 +679,12 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && pde.is_huge()) {
+        // Huge pages only ever belong to a single region, and it's going away as a whole.
+        pde.clear();
+        --m_system_memory_info.huge_pages_mapped;
+        return;
+    }
     if (pde.is_present()) {
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
@@ -656,6 +716,8 @@ UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
         new MemoryManager;
         kmalloc_enable_expand();
     }
+
+    kmalloc_enable_processor_cache();
 }
 
 Region* MemoryManager::kernel_region_from_vaddr(VirtualAddress address)
@@ -812,7 +874,14 @@ ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region(size_t size
         name_kstring = TRY(KString::try_create(name));
     auto vmobject = TRY(AnonymousVMObject::try_create_with_size(size, strategy));
     auto region = TRY(Region::create_unplaced(move(vmobject), 0, move(name_kstring), access, cacheable));
-    TRY(m_region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size));
+    // Large regions that are populated right away likely came out of huge pages, so put them
+    // somewhere they can be mapped as such and spare the TLB.
+    size_t alignment = PAGE_SIZE;
+    if (strategy == AllocationStrategy::AllocateNow && size >= huge_page_size) {
+        alignment = huge_page_size;
+        region->set_wants_huge_pages(true);
+    }
+    TRY(m_region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size, alignment));
     TRY(region->map(kernel_page_directory()));
     return region;
 }
@@ -955,6 +1024,24 @@ ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_user_physical_page(
             }
             return IterationDecision::Continue;
         });
+    }
+
+    if (!page) {
+        // Next, we look for clean file pages that are only being kept around by the page cache.
+        for_each_vmobject([&](auto& vmobject) {
+            if (!vmobject.is_shared_inode())
+                return IterationDecision::Continue;
+            auto& inode_vmobject = static_cast<SharedInodeVMObject&>(vmobject);
+            if (!inode_vmobject.is_in_page_cache() || inode_vmobject.has_mappings())
+                return IterationDecision::Continue;
+            if (inode_vmobject.release_all_clean_pages() > 0) {
+                page = find_free_user_physical_page(false);
+                purged_pages = true;
+                VERIFY(page);
+                return IterationDecision::Break;
+            }
+            return IterationDecision::Continue;
+        });
         if (!page) {
             dmesgln("MM: no user physical pages available");
             return ENOMEM;
@@ -972,6 +1059,53 @@ ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_user_physical_page(
     return page.release_nonnull();
 }
 
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> MemoryManager::find_free_huge_user_physical_pages(bool committed)
+{
+    VERIFY(s_mm_lock.is_locked());
+    if (committed)
+        VERIFY(m_system_memory_info.user_physical_pages_committed >= pages_per_huge_page);
+    else if (m_system_memory_info.user_physical_pages_uncommitted < pages_per_huge_page)
+        return ENOMEM;
+
+    for (auto& region : m_user_physical_regions) {
+        auto physical_pages = region.take_naturally_aligned_free_pages(pages_per_huge_page);
+        if (physical_pages.is_empty())
+            continue;
+
+        if (committed)
+            m_system_memory_info.user_physical_pages_committed -= pages_per_huge_page;
+        else
+            m_system_memory_info.user_physical_pages_uncommitted -= pages_per_huge_page;
+        m_system_memory_info.user_physical_pages_used += pages_per_huge_page;
+        ++m_system_memory_info.huge_page_allocations;
+
+        // NOTE: We may be in the middle of handling a page fault, so we zero the pages one at a time
+        //       instead of mapping all of them into a temporary kernel region.
+        for (auto& page : physical_pages) {
+            auto* ptr = quickmap_page(page);
+            memset(ptr, 0, PAGE_SIZE);
+            unquickmap_page();
+        }
+        return physical_pages;
+    }
+
+    // NOTE: We don't purge anything to make room for a huge page, the caller can always fall back to regular pages.
+    ++m_system_memory_info.huge_page_allocation_failures;
+    return ENOMEM;
+}
+
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> MemoryManager::allocate_committed_huge_user_physical_pages(Badge<CommittedPhysicalPageSet>)
+{
+    SpinlockLocker lock(s_mm_lock);
+    return find_free_huge_user_physical_pages(true);
+}
+
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> MemoryManager::allocate_huge_user_physical_pages()
+{
+    SpinlockLocker lock(s_mm_lock);
+    return find_free_huge_user_physical_pages(false);
+}
+
 ErrorOr<NonnullRefPtrVector<PhysicalPage>> MemoryManager::allocate_contiguous_user_physical_pages(size_t size)
 {
     VERIFY(!(size % PAGE_SIZE));
@@ -1217,6 +1351,15 @@ NonnullRefPtr<PhysicalPage> CommittedPhysicalPageSet::take_one()
     return MM.allocate_committed_user_physical_page({}, MemoryManager::ShouldZeroFill::Yes);
 }
 
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> CommittedPhysicalPageSet::take_huge_page()
+{
+    if (m_page_count < pages_per_huge_page)
+        return ENOMEM;
+    auto physical_pages = TRY(MM.allocate_committed_huge_user_physical_pages({}));
+    m_page_count -= pages_per_huge_page;
+    return physical_pages;
+}
+
 void CommittedPhysicalPageSet::uncommit_one()
 {
     VERIFY(m_page_count > 0);
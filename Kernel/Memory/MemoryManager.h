@@ -37,6 +37,10 @@ constexpr FlatPtr page_round_down(FlatPtr x)
     return ((FlatPtr)(x)) & ~(PAGE_SIZE - 1);
 }
 
+// A huge page is mapped by a single page directory entry instead of a whole page table.
+constexpr size_t huge_page_size = 2 * MiB;
+constexpr size_t pages_per_huge_page = huge_page_size / PAGE_SIZE;
+
 inline FlatPtr virtual_to_low_physical(FlatPtr virtual_)
 {
     return virtual_ - physical_to_virtual_offset;
@@ -123,6 +127,9 @@ public:
     size_t page_count() const { return m_page_count; }
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
+    // Takes pages_per_huge_page physically contiguous, huge page aligned pages at once.
+    // If we can't find that many in one piece, nothing is taken.
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> take_huge_page();
     void uncommit_one();
 
     void operator=(CommittedPhysicalPageSet&&) = delete;
@@ -136,6 +143,7 @@ class MemoryManager {
     friend class AnonymousVMObject;
     friend class Region;
     friend class RegionTree;
+    friend class SharedInodeVMObject;
     friend class VMObject;
     friend struct ::KmallocGlobalData;
 
@@ -175,6 +183,8 @@ public:
 
     NonnullRefPtr<PhysicalPage> allocate_committed_user_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_committed_huge_user_physical_pages(Badge<CommittedPhysicalPageSet>);
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_huge_user_physical_pages();
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_supervisor_physical_page();
     ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_contiguous_supervisor_physical_pages(size_t size);
     ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_contiguous_user_physical_pages(size_t size);
@@ -198,6 +208,11 @@ public:
         PhysicalSize user_physical_pages_uncommitted { 0 };
         PhysicalSize super_physical_pages { 0 };
         PhysicalSize super_physical_pages_used { 0 };
+        PhysicalSize huge_pages_mapped { 0 };
+        u64 huge_page_allocations { 0 };
+        u64 huge_page_allocation_failures { 0 };
+        u64 huge_page_promotions { 0 };
+        u64 huge_page_demotions { 0 };
     };
 
     SystemMemoryInfo get_system_memory_info()
@@ -267,6 +282,7 @@ private:
     static Region* find_region_from_vaddr(VirtualAddress);
 
     RefPtr<PhysicalPage> find_free_user_physical_page(bool);
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> find_free_huge_user_physical_pages(bool committed);
 
     ALWAYS_INLINE u8* quickmap_page(PhysicalPage& page)
     {
@@ -280,6 +296,7 @@ private:
 
     PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry* ensure_pte(PageDirectory&, VirtualAddress);
+    PageDirectoryEntry& ensure_huge_pde(PageDirectory&, VirtualAddress);
     enum class IsLastPTERelease {
         Yes,
         No
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/PageCache.h>
+
+namespace Kernel::Memory {
+
+// Once less than 1/16th of user physical memory is left uncommitted, the page cache
+// starts giving back its least recently used pages until 1/8th is available again.
+static constexpr size_t low_free_memory_divisor = 16;
+static constexpr size_t target_free_memory_divisor = 8;
+
+static Singleton<PageCache> s_the;
+
+PageCache& PageCache::the()
+{
+    return *s_the;
+}
+
+bool PageCache::should_cache(Inode const& inode, OpenFileDescription const* description)
+{
+    if (description && description->is_direct())
+        return false;
+    if (!inode.fs().supports_page_cache())
+        return false;
+    auto metadata = inode.metadata();
+    // Unlinked files are about to go away, don't keep them (or their contents) alive.
+    return metadata.is_regular_file() && metadata.link_count > 0;
+}
+
+ErrorOr<NonnullRefPtr<SharedInodeVMObject>> PageCache::vmobject_for(Inode& inode)
+{
+    auto previous_vmobject = inode.shared_vmobject();
+    auto vmobject = TRY(SharedInodeVMObject::try_create_with_inode(inode));
+    if (previous_vmobject && previous_vmobject.ptr() != vmobject.ptr())
+        forget(*previous_vmobject);
+
+    m_state.with([&](auto& state) {
+        // Move it to the back of the list, as it's now the most recently used one.
+        state.lru.append(*vmobject);
+    });
+    return vmobject;
+}
+
+ErrorOr<size_t> PageCache::read_bytes(Inode& inode, off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description)
+{
+    VERIFY(offset >= 0);
+    MutexLocker locker(inode.m_inode_lock);
+
+    auto vmobject = TRY(vmobject_for(inode));
+
+    u64 size = inode.size();
+    if (static_cast<u64>(offset) >= size)
+        return 0;
+    count = min(static_cast<u64>(count), size - offset);
+
+    size_t nread = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    while (nread < count) {
+        u64 position = offset + nread;
+        size_t page_index = position / PAGE_SIZE;
+        if (page_index >= vmobject->page_count()) {
+            // FIXME: A VMObject can't grow along with its file while it's mapped somewhere,
+            //        so read whatever it doesn't cover directly from the inode.
+            auto remaining_buffer = buffer.offset(nread);
+            nread += TRY(inode.read_bytes(position, count - nread, remaining_buffer, description));
+            break;
+        }
+
+        size_t offset_in_page = position % PAGE_SIZE;
+        size_t chunk_size = min(static_cast<size_t>(PAGE_SIZE) - offset_in_page, count - nread);
+
+        u8 page_buffer[PAGE_SIZE];
+        Bytes page_bytes { page_buffer, PAGE_SIZE };
+        // Kernel readers (like sendfile() and splice()) get whole pages copied straight into their buffer.
+        bool const copy_directly = buffer.is_kernel_buffer() && chunk_size == PAGE_SIZE;
+        if (copy_directly)
+            page_bytes = { static_cast<u8*>(const_cast<void*>(buffer.user_or_kernel_ptr())) + nread, PAGE_SIZE };
+
+        if (vmobject->copy_resident_page(page_index, page_bytes)) {
+            ++hits;
+        } else {
+            TRY(vmobject->page_in(page_index, page_bytes));
+            ++misses;
+        }
+
+        if (!copy_directly)
+            TRY(buffer.write(page_buffer + offset_in_page, nread, chunk_size));
+        nread += chunk_size;
+    }
+
+    m_state.with([&](auto& state) {
+        state.hits += hits;
+        state.misses += misses;
+    });
+
+    if (misses)
+        balance(*vmobject);
+    return nread;
+}
+
+ErrorOr<size_t> PageCache::write_bytes(Inode& inode, off_t offset, size_t count, UserOrKernelBuffer const& data, OpenFileDescription* description)
+{
+    VERIFY(offset >= 0);
+    MutexLocker locker(inode.m_inode_lock);
+
+    auto nwritten = TRY(inode.write_bytes(offset, count, data, description));
+
+    auto vmobject = inode.shared_vmobject();
+    if (!vmobject)
+        return nwritten;
+
+    // Bring any resident pages up to date with what we just wrote to the inode.
+    for (size_t copied = 0; copied < nwritten;) {
+        u64 position = offset + copied;
+        size_t page_index = position / PAGE_SIZE;
+        if (page_index >= vmobject->page_count())
+            break;
+
+        size_t offset_in_page = position % PAGE_SIZE;
+        size_t chunk_size = min(static_cast<size_t>(PAGE_SIZE) - offset_in_page, nwritten - copied);
+
+        u8 chunk[PAGE_SIZE];
+        if (data.read(chunk, copied, chunk_size).is_error()) {
+            // We can't tell what ended up in the inode, so just forget everything we know.
+            invalidate(inode);
+            return nwritten;
+        }
+        vmobject->update_resident_page(page_index, offset_in_page, { chunk, chunk_size });
+        copied += chunk_size;
+    }
+
+    if (inode.size() > vmobject->size() && !vmobject->has_mappings()) {
+        // The file outgrew the VMObject. Drop it, so the next read creates one that covers the entire file.
+        forget(*vmobject);
+    }
+    return nwritten;
+}
+
+bool PageCache::is_resident(Inode const& inode, u64 offset) const
+{
+    auto vmobject = inode.shared_vmobject();
+    if (!vmobject)
+        return false;
+    size_t page_index = offset / PAGE_SIZE;
+    if (page_index >= vmobject->page_count())
+        return false;
+    return vmobject->is_page_resident(page_index);
+}
+
+void PageCache::forget(SharedInodeVMObject& vmobject)
+{
+    // NOTE: Our callers hold a reference to the VMObject, so removing it from
+    //       the list won't destroy it while we're holding the lock.
+    m_state.with([&](auto& state) {
+        state.lru.remove(vmobject);
+    });
+}
+
+void PageCache::invalidate(Inode& inode)
+{
+    auto vmobject = inode.shared_vmobject();
+    if (!vmobject)
+        return;
+    forget(*vmobject);
+
+    // Pages of writable shared mappings may have been modified without having been
+    // synced back to the inode, so we have to leave those alone.
+    if (vmobject->writable_mappings() == 0)
+        vmobject->release_all_clean_pages();
+}
+
+void PageCache::invalidate_file_system(FileSystem const& file_system)
+{
+    NonnullRefPtrVector<SharedInodeVMObject> vmobjects;
+    m_state.with([&](auto& state) {
+        for (auto& vmobject : state.lru) {
+            if (&vmobject.inode().fs() != &file_system)
+                continue;
+            if (vmobjects.try_append(vmobject).is_error())
+                break;
+        }
+        for (auto& vmobject : vmobjects)
+            state.lru.remove(vmobject);
+    });
+    // NOTE: The VMObjects (and with them, their inodes) may be destroyed here, once we're no longer holding the lock.
+}
+
+void PageCache::balance(SharedInodeVMObject const& keep)
+{
+    auto memory_info = MM.get_system_memory_info();
+    auto low_watermark = memory_info.user_physical_pages / low_free_memory_divisor;
+    if (memory_info.user_physical_pages_uncommitted >= low_watermark)
+        return;
+
+    auto target = memory_info.user_physical_pages / target_free_memory_divisor;
+    evict(target - memory_info.user_physical_pages_uncommitted, keep);
+}
+
+size_t PageCache::evict(size_t page_count, SharedInodeVMObject const& keep)
+{
+    size_t evicted_page_count = 0;
+    while (evicted_page_count < page_count) {
+        auto victim = m_state.with([&](auto& state) -> RefPtr<SharedInodeVMObject> {
+            auto least_recently_used = state.lru.first();
+            if (!least_recently_used || least_recently_used.ptr() == &keep)
+                return nullptr;
+            return state.lru.take_first();
+        });
+        if (!victim)
+            break;
+        if (victim->writable_mappings() == 0)
+            evicted_page_count += victim->release_all_clean_pages();
+    }
+
+    m_state.with([&](auto& state) {
+        state.evicted_pages += evicted_page_count;
+    });
+    return evicted_page_count;
+}
+
+PageCache::Statistics PageCache::statistics() const
+{
+    return m_state.with([&](auto& state) {
+        Statistics statistics;
+        for (auto& vmobject : state.lru) {
+            ++statistics.cached_inodes;
+            statistics.resident_pages += vmobject.resident_page_count();
+        }
+        statistics.hits = state.hits;
+        statistics.misses = state.misses;
+        statistics.evicted_pages = state.evicted_pages;
+        return statistics;
+    });
+}
+
+}
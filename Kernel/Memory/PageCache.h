@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Types.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+#include <Kernel/Memory/SharedInodeVMObject.h>
+#include <Kernel/UserOrKernelBuffer.h>
+
+namespace Kernel::Memory {
+
+// The page cache keeps the contents of recently used regular files in memory.
+// Cached pages live in the inode's SharedInodeVMObject, so read(), write() and
+// shared mappings of a file all operate on the same physical pages.
+// The cache grows for as long as there is free physical memory, and gives back
+// its least recently used pages once memory starts running low.
+class PageCache {
+public:
+    struct Statistics {
+        size_t cached_inodes { 0 };
+        size_t resident_pages { 0 };
+        u64 hits { 0 };
+        u64 misses { 0 };
+        u64 evicted_pages { 0 };
+    };
+
+    static PageCache& the();
+
+    static bool should_cache(Inode const&, OpenFileDescription const*);
+
+    ErrorOr<NonnullRefPtr<SharedInodeVMObject>> vmobject_for(Inode&);
+
+    ErrorOr<size_t> read_bytes(Inode&, off_t, size_t, UserOrKernelBuffer&, OpenFileDescription*);
+    ErrorOr<size_t> write_bytes(Inode&, off_t, size_t, UserOrKernelBuffer const&, OpenFileDescription*);
+
+    bool is_resident(Inode const&, u64 offset) const;
+
+    void invalidate(Inode&);
+    void invalidate_file_system(FileSystem const&);
+
+    Statistics statistics() const;
+
+private:
+    struct State {
+        SharedInodeVMObject::PageCacheList lru;
+        u64 hits { 0 };
+        u64 misses { 0 };
+        u64 evicted_pages { 0 };
+    };
+
+    void forget(SharedInodeVMObject&);
+    void balance(SharedInodeVMObject const& keep);
+    size_t evict(size_t page_count, SharedInodeVMObject const& keep);
+
+    SpinlockProtected<State> m_state;
+};
+
+}
@@ -104,6 +104,32 @@ NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(siz
     return physical_pages;
 }
 
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_naturally_aligned_free_pages(size_t count)
+{
+    VERIFY(is_power_of_two(count));
+    auto order = count_trailing_zeroes(count);
+
+    Optional<PhysicalAddress> page_base;
+    for (auto& zone : m_usable_zones) {
+        page_base = zone.allocate_naturally_aligned_block(order);
+        if (page_base.has_value()) {
+            if (zone.is_empty())
+                m_full_zones.append(zone);
+            break;
+        }
+    }
+
+    if (!page_base.has_value())
+        return {};
+
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    physical_pages.ensure_capacity(count);
+
+    for (size_t i = 0; i < count; ++i)
+        physical_pages.append(PhysicalPage::create(page_base.value().offset(i * PAGE_SIZE)));
+    return physical_pages;
+}
+
 RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
 {
     if (m_usable_zones.is_empty())
@@ -64,6 +64,42 @@ Optional<PhysicalAddress> PhysicalZone::allocate_block(size_t order)
     return m_base_address.offset(result.value() * ZONE_CHUNK_SIZE);
 }
 
+Optional<PhysicalAddress> PhysicalZone::allocate_naturally_aligned_block(size_t order)
+{
+    size_t block_page_count = 1u << order;
+    size_t block_size = block_page_count * PAGE_SIZE;
+    if (m_base_address.get() % block_size == 0)
+        return allocate_block(order);
+
+    // Blocks are only aligned relative to our base address, so take one twice as large;
+    // it's bound to contain an aligned block, and we give back whatever is left around it.
+    auto outer_block = allocate_block(order + 1);
+    if (!outer_block.has_value())
+        return {};
+
+    auto outer_base = outer_block.value();
+    auto aligned_base = PhysicalAddress(align_up_to(outer_base.get(), block_size));
+    size_t pages_before = (aligned_base.get() - outer_base.get()) / PAGE_SIZE;
+    size_t pages_after = block_page_count - pages_before;
+    deallocate_range(outer_base, pages_before);
+    deallocate_range(aligned_base.offset(block_size), pages_after);
+    return aligned_base;
+}
+
+void PhysicalZone::deallocate_range(PhysicalAddress address, size_t page_count)
+{
+    // Give the pages back in the largest blocks the buddy scheme allows at each position.
+    while (page_count > 0) {
+        size_t page_index = (address.get() - m_base_address.get()) / PAGE_SIZE;
+        size_t order = count_trailing_zeroes(page_index | (1u << max_order));
+        while ((1u << order) > page_count)
+            --order;
+        deallocate_block(address, order);
+        address = address.offset((1u << order) * PAGE_SIZE);
+        page_count -= 1u << order;
+    }
+}
+
 Optional<PhysicalZone::ChunkIndex> PhysicalZone::allocate_block_impl(size_t order)
 {
     if (order > max_order)
@@ -29,6 +29,10 @@ public:
     Optional<PhysicalAddress> allocate_block(size_t order);
     void deallocate_block(PhysicalAddress, size_t order);
 
+    // Like allocate_block(), but the physical address is aligned to the size of the block,
+    // even if the zone itself isn't. This is what huge page mappings need.
+    Optional<PhysicalAddress> allocate_naturally_aligned_block(size_t order);
+
     void dump() const;
     size_t available() const { return m_page_count - (m_used_chunks / 2); }
 
@@ -43,6 +47,7 @@ public:
 private:
     Optional<ChunkIndex> allocate_block_impl(size_t order);
     void deallocate_block_impl(ChunkIndex, size_t order);
+    void deallocate_range(PhysicalAddress, size_t page_count);
 
     struct BuddyBucket {
         bool get_buddy_bit(ChunkIndex index) const
@@ -22,6 +22,9 @@
 
 namespace Kernel::Memory {
 
+// How many pages around a faulting page of an inode-backed region are read and mapped along with it.
+static constexpr size_t inode_fault_around_page_count = 16;
+
 Region::Region()
     : m_range(VirtualRange({}, 0))
 {
@@ -109,6 +112,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
         region->set_mmap(m_mmap);
         region->set_shared(m_shared);
         region->set_syscall_region(is_syscall_region());
+        region->set_wants_huge_pages(m_huge_pages);
         return region;
     }
 
@@ -136,6 +140,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
     }
     clone_region->set_syscall_region(is_syscall_region());
     clone_region->set_mmap(m_mmap);
+    clone_region->set_wants_huge_pages(m_huge_pages);
     return clone_region;
 }
 
@@ -239,6 +244,58 @@ bool Region::map_individual_page_impl(size_t page_index)
     return true;
 }
 
+Optional<size_t> Region::huge_page_index_containing(size_t page_index) const
+{
+    auto huge_page_vaddr = vaddr_from_page_index(page_index).get() & ~(huge_page_size - 1);
+    if (huge_page_vaddr < vaddr().get() || huge_page_vaddr + huge_page_size > vaddr().get() + size())
+        return {};
+    return page_index_from_address(VirtualAddress { huge_page_vaddr });
+}
+
+bool Region::can_map_huge_page(size_t page_index) const
+{
+    if (!m_huge_pages || !vmobject().is_anonymous())
+        return false;
+    // NOTE: Purging swaps out pages behind our back, so purgeable memory sticks to regular pages.
+    if (static_cast<AnonymousVMObject const&>(vmobject()).is_purgeable())
+        return false;
+    if ((!is_readable() && !is_writable()) || !m_cacheable || m_write_combine)
+        return false;
+
+    auto const* first_page = physical_page(page_index);
+    if (!first_page || first_page->paddr().get() % huge_page_size != 0)
+        return false;
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        auto const* page = physical_page(page_index + i);
+        if (!page || page->paddr() != first_page->paddr().offset(i * PAGE_SIZE))
+            return false;
+        // Pages that still have to be copied on write need to be mapped read-only on their own.
+        if (is_writable() && should_cow(page_index + i))
+            return false;
+    }
+    return true;
+}
+
+void Region::map_huge_page_impl(size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+
+    auto huge_page_vaddr = vaddr_from_page_index(page_index);
+    bool user_allowed = huge_page_vaddr.get() >= USER_RANGE_BASE && is_user_address(huge_page_vaddr);
+
+    auto& pde = MM.ensure_huge_pde(*m_page_directory, huge_page_vaddr);
+    pde.set_huge_page_base(physical_page(page_index)->paddr().get());
+    pde.set_writable(is_writable());
+    pde.set_write_through(false);
+    pde.set_cache_disabled(false);
+    pde.set_global(m_page_directory.ptr() == &MM.kernel_page_directory());
+    if (Processor::current().has_nx())
+        pde.set_execute_disabled(!is_executable());
+    pde.set_user_allowed(user_allowed);
+    pde.set_present(true);
+}
+
 bool Region::do_remap_vmobject_page(size_t page_index, bool with_flush)
 {
     if (!m_page_directory)
@@ -248,6 +305,16 @@ bool Region::do_remap_vmobject_page(size_t page_index, bool with_flush)
     SpinlockLocker page_lock(m_page_directory->get_lock());
     SpinlockLocker lock(s_mm_lock);
     VERIFY(physical_page(page_index));
+    if (m_huge_pages) {
+        // Whatever changed about this page might have been the last thing keeping us from using a huge page.
+        auto huge_page_index = huge_page_index_containing(page_index);
+        if (huge_page_index.has_value() && can_map_huge_page(huge_page_index.value())) {
+            map_huge_page_impl(huge_page_index.value());
+            if (with_flush)
+                MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(huge_page_index.value()), pages_per_huge_page);
+            return true;
+        }
+    }
     bool success = map_individual_page_impl(page_index);
     if (with_flush)
         MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(page_index));
@@ -309,6 +376,11 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
     set_page_directory(page_directory);
     size_t page_index = 0;
     while (page_index < page_count()) {
+        if (m_huge_pages && huge_page_index_containing(page_index) == page_index && can_map_huge_page(page_index)) {
+            map_huge_page_impl(page_index);
+            page_index += pages_per_huge_page;
+            continue;
+        }
         if (!map_individual_page_impl(page_index))
             break;
         ++page_index;
@@ -425,7 +497,9 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     if (current_thread != nullptr)
         current_thread->did_zero_fault();
 
-    if (page_slot->is_lazy_committed_page()) {
+    if (m_huge_pages && try_allocate_huge_page_for_zero_fault(page_index_in_region)) {
+        dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED HUGE PAGE CONTAINING {}", page_slot->paddr());
+    } else if (page_slot->is_lazy_committed_page()) {
         VERIFY(m_vmobject->is_anonymous());
         page_slot = static_cast<AnonymousVMObject&>(*m_vmobject).allocate_committed_page({});
         dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED COMMITTED {}", page_slot->paddr());
@@ -446,6 +520,40 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+bool Region::try_allocate_huge_page_for_zero_fault(size_t page_index_in_region)
+{
+    auto huge_page_index = huge_page_index_containing(page_index_in_region);
+    if (!huge_page_index.has_value())
+        return false;
+    auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject());
+    if (anonymous_vmobject.is_purgeable())
+        return false;
+
+    // We only take over huge pages that haven't been touched at all yet, so nothing has to be copied.
+    size_t lazy_committed_page_count = 0;
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        auto const* page = physical_page(huge_page_index.value() + i);
+        if (page->is_lazy_committed_page())
+            ++lazy_committed_page_count;
+        else if (!page->is_shared_zero_page())
+            return false;
+    }
+
+    // NOTE: Pages come either all from our committed pages, or all from the uncommitted ones, never from both.
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> physical_pages_or_error = ENOMEM;
+    if (lazy_committed_page_count == pages_per_huge_page)
+        physical_pages_or_error = anonymous_vmobject.allocate_committed_huge_page({});
+    else if (lazy_committed_page_count == 0)
+        physical_pages_or_error = MM.allocate_huge_user_physical_pages();
+    if (physical_pages_or_error.is_error())
+        return false;
+
+    auto physical_pages = physical_pages_or_error.release_value();
+    for (size_t i = 0; i < pages_per_huge_page; ++i)
+        physical_page_slot(huge_page_index.value() + i) = move(physical_pages.ptr_at(i));
+    return true;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -463,6 +571,89 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
     return response;
 }
 
+bool Region::map_around(size_t page_index, size_t first_page_index, size_t end_page_index)
+{
+    SpinlockLocker locker(vmobject().m_lock);
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    SpinlockLocker lock(s_mm_lock);
+    // The page that faulted has to be mapped, everything around it is just an optimization.
+    bool success = map_individual_page_impl(page_index);
+    for (size_t neighbour_index = first_page_index; success && neighbour_index < end_page_index; ++neighbour_index) {
+        if (neighbour_index == page_index || !physical_page(neighbour_index))
+            continue;
+        // NOTE: We don't care if we run out of page tables here.
+        if (!map_individual_page_impl(neighbour_index))
+            break;
+    }
+    MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(first_page_index), end_page_index - first_page_index);
+    return success;
+}
+
+ErrorOr<void> Region::read_inode_page(size_t page_index_in_region)
+{
+    auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+
+    u8 page_buffer[PAGE_SIZE];
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
+    auto nread = TRY(inode_vmobject.inode().read_bytes_for_page_cache(translate_to_vmobject_page(page_index_in_region) * PAGE_SIZE, PAGE_SIZE, buffer));
+    if (nread < PAGE_SIZE) {
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    }
+
+    SpinlockLocker locker(inode_vmobject.m_lock);
+    auto& vmobject_physical_page_entry = inode_vmobject.physical_pages()[translate_to_vmobject_page(page_index_in_region)];
+    // Someone else may have faulted in this page while we were reading from the inode.
+    // No harm done (other than some duplicate work), we just keep theirs.
+    if (!vmobject_physical_page_entry.is_null())
+        return {};
+
+    auto physical_page_or_error = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (physical_page_or_error.is_error()) {
+        dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
+        return ENOMEM;
+    }
+    vmobject_physical_page_entry = physical_page_or_error.release_value();
+
+    SpinlockLocker mm_locker(s_mm_lock);
+    u8* dest_ptr = MM.quickmap_page(*vmobject_physical_page_entry);
+    memcpy(dest_ptr, page_buffer, PAGE_SIZE);
+    MM.unquickmap_page();
+    return {};
+}
+
+ErrorOr<void> Region::read_inode_pages(size_t first_page_index, size_t end_page_index)
+{
+    auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+
+    // Read straight into the pages that end up in the VMObject, through a temporary kernel mapping.
+    size_t read_page_count = end_page_index - first_page_index;
+    NonnullRefPtrVector<PhysicalPage> new_physical_pages;
+    TRY(new_physical_pages.try_ensure_capacity(read_page_count));
+    for (size_t i = 0; i < read_page_count; ++i)
+        new_physical_pages.unchecked_append(TRY(MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No)));
+
+    auto buffer_vmobject = TRY(AnonymousVMObject::try_create_with_physical_pages(new_physical_pages.span()));
+    auto buffer_region = TRY(MM.allocate_kernel_region_with_vmobject(*buffer_vmobject, read_page_count * PAGE_SIZE, "Inode fault"sv, Region::Access::ReadWrite));
+
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(buffer_region->vaddr().as_ptr());
+    auto nread = TRY(inode_vmobject.inode().read_bytes_for_page_cache(translate_to_vmobject_page(first_page_index) * PAGE_SIZE, read_page_count * PAGE_SIZE, buffer));
+    if (nread < read_page_count * PAGE_SIZE) {
+        // If we read less than we asked for, zero out the rest to avoid leaking uninitialized data.
+        memset(buffer_region->vaddr().offset(nread).as_ptr(), 0, read_page_count * PAGE_SIZE - nread);
+    }
+
+    SpinlockLocker locker(inode_vmobject.m_lock);
+    for (size_t i = 0; i < read_page_count; ++i) {
+        auto& vmobject_physical_page_entry = inode_vmobject.physical_pages()[translate_to_vmobject_page(first_page_index + i)];
+        // Someone else may have faulted in some of these pages while we were reading from the inode.
+        // No harm done (other than some duplicate work), we just keep theirs.
+        if (vmobject_physical_page_entry.is_null())
+            vmobject_physical_page_entry = new_physical_pages[i];
+    }
+    return {};
+}
+
 PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -472,70 +663,56 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
 
     auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
 
+    // We don't just page in the page that faulted, but look at a whole window of pages around it.
+    // Missing pages next to it are read along with it, and everything the VMObject already has
+    // gets mapped right away, so sequential accesses don't have to take a fault for every page.
     auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
-    auto& vmobject_physical_page_entry = inode_vmobject.physical_pages()[page_index_in_vmobject];
+    auto window_start_in_vmobject = max(page_index_in_vmobject - page_index_in_vmobject % inode_fault_around_page_count, first_page_index());
+    auto window_end_in_vmobject = min(window_start_in_vmobject + inode_fault_around_page_count, first_page_index() + page_count());
+    auto window_start = window_start_in_vmobject - first_page_index();
+    auto window_end = window_end_in_vmobject - first_page_index();
 
+    size_t read_start = page_index_in_region;
+    size_t read_end = page_index_in_region + 1;
     {
         SpinlockLocker locker(inode_vmobject.m_lock);
-        if (!vmobject_physical_page_entry.is_null()) {
+        if (physical_page(page_index_in_region)) {
             dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else before reading, remapping.");
-            if (!remap_vmobject_page(page_index_in_vmobject))
+            if (!map_around(page_index_in_region, window_start, window_end))
                 return PageFaultResponse::OutOfMemory;
             return PageFaultResponse::Continue;
         }
+        while (read_start > window_start && !physical_page(read_start - 1))
+            --read_start;
+        while (read_end < window_end && !physical_page(read_end))
+            ++read_end;
     }
 
-    dbgln_if(PAGE_FAULT_DEBUG, "Inode fault in {} page index: {}", name(), page_index_in_region);
+    dbgln_if(PAGE_FAULT_DEBUG, "Inode fault in {} page index: {}, reading pages {}-{}", name(), page_index_in_region, read_start, read_end - 1);
 
     auto current_thread = Thread::current();
     if (current_thread)
         current_thread->did_inode_fault();
 
-    u8 page_buffer[PAGE_SIZE];
-    auto& inode = inode_vmobject.inode();
-
-    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
-    auto result = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
+    ErrorOr<void> result {};
+    if (read_end - read_start > 1) {
+        result = read_inode_pages(read_start, read_end);
+        // Reading the neighbouring pages is just an optimization, so under memory pressure we only read the one that faulted.
+        if (result.is_error() && result.error().code() == ENOMEM)
+            result = read_inode_page(page_index_in_region);
+    } else {
+        result = read_inode_page(page_index_in_region);
+    }
 
     if (result.is_error()) {
+        if (result.error().code() == ENOMEM)
+            return PageFaultResponse::OutOfMemory;
         dmesgln("handle_inode_fault: Error ({}) while reading from inode", result.error());
         return PageFaultResponse::ShouldCrash;
     }
 
-    auto nread = result.value();
-    if (nread < PAGE_SIZE) {
-        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
-        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
-    }
-
-    SpinlockLocker locker(inode_vmobject.m_lock);
-
-    if (!vmobject_physical_page_entry.is_null()) {
-        // Someone else faulted in this page while we were reading from the inode.
-        // No harm done (other than some duplicate work), remap the page here and return.
-        dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else, remapping.");
-        if (!remap_vmobject_page(page_index_in_vmobject))
-            return PageFaultResponse::OutOfMemory;
-        return PageFaultResponse::Continue;
-    }
-
-    auto vmobject_physical_page_or_error = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
-    if (vmobject_physical_page_or_error.is_error()) {
-        dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
-        return PageFaultResponse::OutOfMemory;
-    }
-    vmobject_physical_page_entry = vmobject_physical_page_or_error.release_value();
-
-    {
-        SpinlockLocker mm_locker(s_mm_lock);
-        u8* dest_ptr = MM.quickmap_page(*vmobject_physical_page_entry);
-        memcpy(dest_ptr, page_buffer, PAGE_SIZE);
-        MM.unquickmap_page();
-    }
-
-    if (!remap_vmobject_page(page_index_in_vmobject))
+    if (!map_around(page_index_in_region, window_start, window_end))
         return PageFaultResponse::OutOfMemory;
-
     return PageFaultResponse::Continue;
 }
 
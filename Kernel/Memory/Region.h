@@ -91,6 +91,11 @@ public:
     [[nodiscard]] bool is_mmap() const { return m_mmap; }
     void set_mmap(bool mmap) { m_mmap = mmap; }
 
+    // Regions that want huge pages get their memory in huge page sized pieces where possible,
+    // and have those mapped with a single page directory entry each.
+    [[nodiscard]] bool wants_huge_pages() const { return m_huge_pages; }
+    void set_wants_huge_pages(bool huge_pages) { m_huge_pages = huge_pages; }
+
     [[nodiscard]] bool is_write_combine() const { return m_write_combine; }
     ErrorOr<void> set_write_combine(bool);
 
@@ -213,8 +218,15 @@ private:
     [[nodiscard]] PageFaultResponse handle_cow_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_inode_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_zero_fault(size_t page_index);
+    [[nodiscard]] bool try_allocate_huge_page_for_zero_fault(size_t page_index);
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
+    [[nodiscard]] bool map_around(size_t page_index, size_t first_page_index, size_t end_page_index);
+    ErrorOr<void> read_inode_page(size_t page_index);
+    ErrorOr<void> read_inode_pages(size_t first_page_index, size_t end_page_index);
+    [[nodiscard]] Optional<size_t> huge_page_index_containing(size_t page_index) const;
+    [[nodiscard]] bool can_map_huge_page(size_t page_index) const;
+    void map_huge_page_impl(size_t page_index);
 
     RefPtr<PageDirectory> m_page_directory;
     VirtualRange m_range;
@@ -228,6 +240,7 @@ private:
     bool m_mmap : 1 { false };
     bool m_syscall_region : 1 { false };
     bool m_write_combine : 1 { false };
+    bool m_huge_pages : 1 { false };
 
     IntrusiveRedBlackTreeNode<FlatPtr, Region, RawPtr<Region>> m_tree_node;
     IntrusiveListNode<Region> m_vmobject_list_node;
@@ -6,6 +6,7 @@
 
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
 
 namespace Kernel::Memory {
@@ -13,8 +14,13 @@ namespace Kernel::Memory {
 ErrorOr<NonnullRefPtr<SharedInodeVMObject>> SharedInodeVMObject::try_create_with_inode(Inode& inode)
 {
     size_t size = inode.size();
-    if (auto shared_vmobject = inode.shared_vmobject())
-        return shared_vmobject.release_nonnull();
+    if (auto shared_vmobject = inode.shared_vmobject()) {
+        // If the file has grown since this VMObject was created and nobody has it mapped
+        // anymore (it may still be kept around by the page cache), replace it with one
+        // that covers the entire file.
+        if (shared_vmobject->size() >= size || shared_vmobject->has_mappings())
+            return shared_vmobject.release_nonnull();
+    }
     auto new_physical_pages = TRY(VMObject::try_create_physical_pages(size));
     auto dirty_pages = TRY(Bitmap::try_create(new_physical_pages.size(), false));
     auto vmobject = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) SharedInodeVMObject(inode, move(new_physical_pages), move(dirty_pages))));
@@ -59,4 +65,74 @@ ErrorOr<void> SharedInodeVMObject::sync(off_t offset_in_pages, size_t pages)
     return {};
 }
 
+bool SharedInodeVMObject::is_page_resident(size_t page_index) const
+{
+    VERIFY(page_index < page_count());
+    SpinlockLocker locker(m_lock);
+    return !m_physical_pages[page_index].is_null();
+}
+
+bool SharedInodeVMObject::copy_resident_page(size_t page_index, Bytes buffer) const
+{
+    VERIFY(page_index < page_count());
+    VERIFY(buffer.size() == PAGE_SIZE);
+
+    SpinlockLocker locker(m_lock);
+    auto const& physical_page = m_physical_pages[page_index];
+    if (!physical_page)
+        return false;
+    MM.copy_physical_page(const_cast<PhysicalPage&>(*physical_page), buffer.data());
+    return true;
+}
+
+ErrorOr<void> SharedInodeVMObject::page_in(size_t page_index, Bytes buffer)
+{
+    VERIFY(page_index < page_count());
+    VERIFY(buffer.size() == PAGE_SIZE);
+
+    auto kernel_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer.data());
+    auto nread = TRY(m_inode->read_bytes_for_page_cache(page_index * PAGE_SIZE, PAGE_SIZE, kernel_buffer));
+    if (nread < PAGE_SIZE) {
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        memset(buffer.data() + nread, 0, PAGE_SIZE - nread);
+    }
+
+    auto new_physical_page = TRY(MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No));
+
+    SpinlockLocker locker(m_lock);
+    auto& physical_page = m_physical_pages[page_index];
+    if (physical_page) {
+        // Someone else paged this in while we were reading from the inode. Their copy may
+        // have been written to since, so hand out that one instead.
+        MM.copy_physical_page(*physical_page, buffer.data());
+        return {};
+    }
+
+    {
+        SpinlockLocker mm_locker(s_mm_lock);
+        u8* dest_ptr = MM.quickmap_page(*new_physical_page);
+        memcpy(dest_ptr, buffer.data(), PAGE_SIZE);
+        MM.unquickmap_page();
+    }
+    physical_page = move(new_physical_page);
+    return {};
+}
+
+bool SharedInodeVMObject::update_resident_page(size_t page_index, size_t offset_in_page, ReadonlyBytes data)
+{
+    VERIFY(page_index < page_count());
+    VERIFY(offset_in_page + data.size() <= PAGE_SIZE);
+
+    SpinlockLocker locker(m_lock);
+    auto& physical_page = m_physical_pages[page_index];
+    if (!physical_page)
+        return false;
+
+    SpinlockLocker mm_locker(s_mm_lock);
+    u8* page_data = MM.quickmap_page(*physical_page);
+    memcpy(page_data + offset_in_page, data.data(), data.size());
+    MM.unquickmap_page();
+    return true;
+}
+
 }
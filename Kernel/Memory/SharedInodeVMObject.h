@@ -20,6 +20,13 @@ public:
 
     ErrorOr<void> sync(off_t offset_in_pages = 0, size_t pages = -1);
 
+    bool is_page_resident(size_t page_index) const;
+    bool copy_resident_page(size_t page_index, Bytes buffer) const;
+    ErrorOr<void> page_in(size_t page_index, Bytes buffer);
+    bool update_resident_page(size_t page_index, size_t offset_in_page, ReadonlyBytes data);
+
+    bool is_in_page_cache() const { return m_page_cache_list_node.is_in_list(); }
+
 private:
     virtual bool is_shared_inode() const override { return true; }
 
@@ -29,6 +36,11 @@ private:
     virtual StringView class_name() const override { return "SharedInodeVMObject"sv; }
 
     SharedInodeVMObject& operator=(SharedInodeVMObject const&) = delete;
+
+    IntrusiveListNode<SharedInodeVMObject, RefPtr<SharedInodeVMObject>> m_page_cache_list_node;
+
+public:
+    using PageCacheList = IntrusiveList<&SharedInodeVMObject::m_page_cache_list_node>;
 };
 
 }
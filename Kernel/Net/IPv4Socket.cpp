@@ -425,8 +425,12 @@ bool IPv4Socket::did_receive(IPv4Address const& source_address, u16 source_port,
     if (buffer_mode() == BufferMode::Bytes) {
         VERIFY(m_receive_buffer);
 
+        // NOTE: Only the payload ends up in the receive buffer, so that's what has to fit.
+        auto payload_size_or_error = protocol_size(packet);
+        if (payload_size_or_error.is_error())
+            return false;
         size_t space_in_receive_buffer = m_receive_buffer->space_for_writing();
-        if (packet_size > space_in_receive_buffer) {
+        if (payload_size_or_error.value() > space_in_receive_buffer) {
             dbgln("IPv4Socket({}): did_receive refusing packet since buffer is full.", this);
             VERIFY(m_can_read);
             return false;
@@ -95,6 +95,9 @@ protected:
     static ErrorOr<NonnullOwnPtr<DoubleBuffer>> try_create_receive_buffer();
     void drop_receive_buffer();
 
+    size_t receive_buffer_capacity() const { return m_receive_buffer ? m_receive_buffer->capacity() : 0; }
+    size_t receive_buffer_space_for_writing() const { return m_receive_buffer ? m_receive_buffer->space_for_writing() : 0; }
+
 private:
     virtual bool is_ipv4() const override { return true; }
 
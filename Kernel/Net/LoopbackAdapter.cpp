@@ -5,12 +5,46 @@
  */
 
 #include <AK/Singleton.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Net/EthernetFrameHeader.h>
+#include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/TCP.h>
 
 namespace Kernel {
 
+// Loopback traffic is spread over several receive queues, so the parallel receive path gets
+// exercised on machines without a multi-queue network card.
+static constexpr size_t loopback_receive_queue_count = 4;
+
 static bool s_loopback_initialized = false;
 
+#if LOOPBACK_DEBUG
+// Loss recovery can't be tested on a link that never loses anything, so debug builds can be
+// told to drop every eighth TCP segment that carries data.
+Atomic<bool> g_loopback_drops_packets;
+static constexpr u32 dropped_segment_interval = 8;
+static Atomic<u32> s_data_segments_sent;
+
+static bool should_drop(ReadonlyBytes frame)
+{
+    if (!g_loopback_drops_packets.load(AK::MemoryOrder::memory_order_relaxed))
+        return false;
+    if (frame.size() < sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + sizeof(TCPPacket))
+        return false;
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    if (eth.ether_type() != EtherType::IPv4)
+        return false;
+    auto& ipv4 = *static_cast<IPv4Packet const*>(eth.payload());
+    if ((IPv4Protocol)ipv4.protocol() != IPv4Protocol::TCP)
+        return false;
+    auto& tcp = *static_cast<TCPPacket const*>(ipv4.payload());
+    if (ipv4.payload_size() <= tcp.header_size())
+        return false;
+    return (s_data_segments_sent.fetch_add(1, AK::MemoryOrder::memory_order_relaxed) + 1) % dropped_segment_interval == 0;
+}
+#endif
+
 RefPtr<LoopbackAdapter> LoopbackAdapter::try_create()
 {
     auto interface_name = KString::try_create("loop"sv);
@@ -25,6 +59,9 @@ LoopbackAdapter::LoopbackAdapter(NonnullOwnPtr<KString> interface_name)
     VERIFY(!s_loopback_initialized);
     s_loopback_initialized = true;
     set_mtu(65536);
+    set_receive_queue_count(loopback_receive_queue_count);
+    // Nothing we send to ourselves can get corrupted or has to fit through a smaller link.
+    set_offloads(NetworkOffload::TCPChecksum | NetworkOffload::TCPSegmentation | NetworkOffload::ReceiveChecksum);
     set_mac_address({ 19, 85, 2, 9, 0x55, 0xaa });
 }
 
@@ -32,8 +69,19 @@ LoopbackAdapter::~LoopbackAdapter() = default;
 
 void LoopbackAdapter::send_raw(ReadonlyBytes payload)
 {
+#if LOOPBACK_DEBUG
+    if (should_drop(payload)) {
+        dbgln("LoopbackAdapter: Dropping {} byte(s) on purpose.", payload.size());
+        return;
+    }
+#endif
     dbgln("LoopbackAdapter: Sending {} byte(s) to myself.", payload.size());
     did_receive(payload);
 }
 
+void LoopbackAdapter::send_raw_with_offload(ReadonlyBytes payload, PacketOffload const&)
+{
+    send_raw(payload);
+}
+
 }
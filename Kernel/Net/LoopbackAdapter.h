@@ -6,10 +6,16 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
+#include <Kernel/Debug.h>
 #include <Kernel/Net/NetworkAdapter.h>
 
 namespace Kernel {
 
+#if LOOPBACK_DEBUG
+extern Atomic<bool> g_loopback_drops_packets;
+#endif
+
 class LoopbackAdapter final : public NetworkAdapter {
 private:
     LoopbackAdapter(NonnullOwnPtr<KString>);
@@ -19,6 +25,7 @@ public:
     virtual ~LoopbackAdapter() override;
 
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, PacketOffload const&) override;
     virtual StringView class_name() const override { return "LoopbackAdapter"sv; }
     virtual bool link_up() override { return true; }
     virtual bool link_full_duplex() override { return true; }
@@ -4,11 +4,12 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <Kernel/Arch/x86/InterruptDisabler.h>
+#include <AK/HashFunctions.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/NetworkAdapter.h>
 #include <Kernel/Net/NetworkingManagement.h>
+#include <Kernel/Net/TCP.h>
 #include <Kernel/Process.h>
 #include <Kernel/StdLib.h>
 
@@ -21,11 +22,142 @@ NetworkAdapter::NetworkAdapter(NonnullOwnPtr<KString> interface_name)
 
 NetworkAdapter::~NetworkAdapter() = default;
 
-void NetworkAdapter::send_packet(ReadonlyBytes packet)
+void NetworkAdapter::send_packet(ReadonlyBytes packet, PacketOffload const& offload)
 {
-    m_packets_out++;
-    m_bytes_out += packet.size();
-    send_raw(packet);
+    auto required_offloads = offload.required_offloads();
+    if (required_offloads == NetworkOffload::None) {
+        m_packets_out++;
+        m_bytes_out += packet.size();
+        send_raw(packet);
+        return;
+    }
+    if (has_offloads(required_offloads)) {
+        m_packets_out++;
+        m_bytes_out += packet.size();
+        send_raw_with_offload(packet, offload);
+        return;
+    }
+    send_with_software_offload(packet, offload);
+}
+
+// The internet checksum can be summed up in words of any size, as long as the carries are
+// added back in and the result is folded down to 16 bits in the end (RFC 1071, section 2).
+// Summing in native byte order also gives a result in the byte order of the data.
+static ALWAYS_INLINE u64 add_to_checksum(u64 sum, u64 value)
+{
+    sum += value;
+    return sum + (sum < value);
+}
+
+static u64 add_to_checksum(u64 sum, ReadonlyBytes bytes)
+{
+    size_t offset = 0;
+    for (; offset + sizeof(u64) <= bytes.size(); offset += sizeof(u64)) {
+        u64 word;
+        memcpy(&word, bytes.offset_pointer(offset), sizeof(word));
+        sum = add_to_checksum(sum, word);
+    }
+    if (offset < bytes.size()) {
+        u64 word = 0;
+        memcpy(&word, bytes.offset_pointer(offset), bytes.size() - offset);
+        sum = add_to_checksum(sum, word);
+    }
+    return sum;
+}
+
+// Copies the data and adds it to the checksum in the same pass, so it's only read once.
+static u64 copy_and_add_to_checksum(u64 sum, u8* destination, ReadonlyBytes source)
+{
+    size_t offset = 0;
+    for (; offset + sizeof(u64) <= source.size(); offset += sizeof(u64)) {
+        u64 word;
+        memcpy(&word, source.offset_pointer(offset), sizeof(word));
+        memcpy(destination + offset, &word, sizeof(word));
+        sum = add_to_checksum(sum, word);
+    }
+    if (offset < source.size()) {
+        u64 word = 0;
+        memcpy(&word, source.offset_pointer(offset), source.size() - offset);
+        memcpy(destination + offset, &word, source.size() - offset);
+        sum = add_to_checksum(sum, word);
+    }
+    return sum;
+}
+
+static u16 finish_checksum(u64 sum)
+{
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return ~static_cast<u16>(sum);
+}
+
+void NetworkAdapter::send_with_software_offload(ReadonlyBytes frame, PacketOffload const& offload)
+{
+    VERIFY(frame.size() >= ipv4_payload_offset() + sizeof(TCPPacket));
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    auto& ipv4 = *static_cast<IPv4Packet const*>(eth.payload());
+    VERIFY(eth.ether_type() == EtherType::IPv4);
+    VERIFY((IPv4Protocol)ipv4.protocol() == IPv4Protocol::TCP);
+    auto& tcp = *static_cast<TCPPacket const*>(ipv4.payload());
+
+    size_t headers_size = ipv4_payload_offset() + tcp.header_size();
+    VERIFY(frame.size() >= headers_size);
+    auto payload = frame.slice(headers_size);
+    size_t segment_size = offload.tcp_segment_size ? offload.tcp_segment_size : payload.size();
+    VERIFY(sizeof(IPv4Packet) + tcp.header_size() + min(segment_size, payload.size()) <= mtu());
+
+    auto segment = acquire_packet_buffer(headers_size + min(segment_size, payload.size()));
+    if (!segment) {
+        dbgln("Dropping TCP packet as there is not enough memory to segment it");
+        return;
+    }
+
+    struct [[gnu::packed]] PseudoHeader {
+        IPv4Address source;
+        IPv4Address destination;
+        u8 zero;
+        u8 protocol;
+        NetworkOrdered<u16> payload_size;
+    };
+
+    u32 sequence_number = tcp.sequence_number();
+    size_t offset = 0;
+    do {
+        size_t chunk_size = min(segment_size, payload.size() - offset);
+        bool is_last_segment = offset + chunk_size == payload.size();
+
+        segment->buffer->set_size(headers_size + chunk_size);
+        auto* segment_data = segment->buffer->data();
+        memcpy(segment_data, frame.data(), headers_size);
+
+        auto& segment_ipv4 = *(IPv4Packet*)(segment_data + layer3_payload_offset());
+        segment_ipv4.set_length(sizeof(IPv4Packet) + tcp.header_size() + chunk_size);
+        segment_ipv4.set_checksum(0);
+        segment_ipv4.set_checksum(segment_ipv4.compute_checksum());
+
+        auto& segment_tcp = *(TCPPacket*)(segment_data + ipv4_payload_offset());
+        segment_tcp.set_sequence_number(sequence_number + offset);
+        // Only the last segment gets to push the data or to close the connection.
+        if (!is_last_segment)
+            segment_tcp.set_flags(tcp.flags() & ~(TCPFlags::PSH | TCPFlags::FIN));
+        segment_tcp.set_checksum(0);
+
+        PseudoHeader pseudo_header { ipv4.source(), ipv4.destination(), 0, (u8)IPv4Protocol::TCP, static_cast<u16>(tcp.header_size() + chunk_size) };
+        u64 sum = add_to_checksum(0, { &pseudo_header, sizeof(pseudo_header) });
+        sum = add_to_checksum(sum, { &segment_tcp, tcp.header_size() });
+        sum = copy_and_add_to_checksum(sum, segment_data + headers_size, payload.slice(offset, chunk_size));
+        // NOTE: The checksum was summed up in network byte order already.
+        segment_tcp.set_checksum(AK::convert_between_host_and_network_endian(finish_checksum(sum)));
+
+        m_packets_out++;
+        m_bytes_out += segment->buffer->size();
+        send_raw(segment->bytes());
+        offset += chunk_size;
+    } while (offset < payload.size());
+
+    release_packet_buffer(*segment);
 }
 
 void NetworkAdapter::send(MACAddress const& destination, ARPPacket const& packet)
@@ -47,7 +179,8 @@ void NetworkAdapter::send(MACAddress const& destination, ARPPacket const& packet
 void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Address const& source_ipv4, MACAddress const& destination_mac, IPv4Address const& destination_ipv4, IPv4Protocol protocol, size_t payload_size, u8 type_of_service, u8 ttl)
 {
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
-    VERIFY(ipv4_packet_size <= mtu());
+    // NOTE: TCP packets that are going to be segmented can be larger than the MTU.
+    VERIFY(ipv4_packet_size <= max_ipv4_packet_size);
 
     size_t ethernet_frame_size = ipv4_payload_offset() + payload_size;
     VERIFY(packet.buffer->size() == ethernet_frame_size);
@@ -69,51 +202,111 @@ void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Addres
     ipv4.set_checksum(ipv4.compute_checksum());
 }
 
-void NetworkAdapter::did_receive(ReadonlyBytes payload)
+void NetworkAdapter::set_receive_queue_count(size_t count)
 {
-    InterruptDisabler disabler;
-    m_packets_in++;
-    m_bytes_in += payload.size();
+    VERIFY(count > 0 && count <= max_receive_queues);
+    VERIFY(!on_receive);
+    m_receive_queue_count = count;
+}
 
-    if (m_packet_queue_size == max_packet_buffers) {
-        // FIXME: Keep track of the number of dropped packets
-        return;
-    }
+size_t NetworkAdapter::receive_queue_for_frame(ReadonlyBytes frame) const
+{
+    if (m_receive_queue_count == 1)
+        return 0;
 
-    auto packet = acquire_packet_buffer(payload.size());
-    if (!packet) {
-        dbgln("Discarding packet because we're out of memory");
-        return;
+    // Everything that isn't IPv4 (ARP, mostly) is rare enough to just go to the first queue.
+    if (frame.size() < sizeof(EthernetFrameHeader) + sizeof(IPv4Packet))
+        return 0;
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    if (eth.ether_type() != EtherType::IPv4)
+        return 0;
+    auto& ipv4 = *static_cast<IPv4Packet const*>(eth.payload());
+
+    // NOTE: The hash is the same for both directions of a flow, so on loopback both ends of a
+    //       connection are handled by the same thread, too.
+    u32 addresses = ipv4.source().to_u32() ^ ipv4.destination().to_u32();
+    u32 ports = 0;
+    auto protocol = (IPv4Protocol)ipv4.protocol();
+    bool has_ports = protocol == IPv4Protocol::TCP || protocol == IPv4Protocol::UDP;
+    // Only the first fragment of a datagram carries the ports.
+    if (has_ports && ipv4.fragment_offset() == 0 && frame.size() >= sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + 2 * sizeof(u16)) {
+        auto const* port_pair = static_cast<u16 const*>(ipv4.payload());
+        ports = port_pair[0] ^ port_pair[1];
     }
+    return pair_int_hash(addresses, ports) % m_receive_queue_count;
+}
+
+void NetworkAdapter::did_receive(ReadonlyBytes payload)
+{
+    auto queue_index = receive_queue_for_frame(payload);
+    {
+        SpinlockLocker locker(m_packet_lock);
+        m_packets_in++;
+        m_bytes_in += payload.size();
 
-    memcpy(packet->buffer->data(), payload.data(), payload.size());
+        auto& queue = m_receive_queues[queue_index];
+        if (queue.size == max_packet_buffers) {
+            queue.statistics.dropped++;
+            return;
+        }
 
-    m_packet_queue.append(*packet);
-    m_packet_queue_size++;
+        auto packet = acquire_packet_buffer_locked(payload.size());
+        if (!packet) {
+            queue.statistics.dropped++;
+            dbgln("Discarding packet because we're out of memory");
+            return;
+        }
+
+        memcpy(packet->buffer->data(), payload.data(), payload.size());
+
+        queue.packets.append(*packet);
+        queue.size++;
+        queue.statistics.packets++;
+        queue.statistics.bytes += payload.size();
+    }
 
     if (on_receive)
-        on_receive();
+        on_receive(queue_index);
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp)
+size_t NetworkAdapter::dequeue_packets(size_t queue_index, Span<RefPtr<PacketWithTimestamp>> packets)
 {
-    InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return 0;
-    auto packet_with_timestamp = m_packet_queue.take_first();
-    m_packet_queue_size--;
-    packet_timestamp = packet_with_timestamp->timestamp;
-    auto& packet_buffer = packet_with_timestamp->buffer;
-    size_t packet_size = packet_buffer->size();
-    VERIFY(packet_size <= buffer_size);
-    memcpy(buffer, packet_buffer->data(), packet_size);
-    release_packet_buffer(*packet_with_timestamp);
-    return packet_size;
+    VERIFY(queue_index < m_receive_queue_count);
+    SpinlockLocker locker(m_packet_lock);
+    auto& queue = m_receive_queues[queue_index];
+    size_t count = 0;
+    while (count < packets.size() && !queue.packets.is_empty()) {
+        packets[count++] = queue.packets.take_first();
+        queue.size--;
+    }
+    if (count > 0)
+        queue.statistics.batches++;
+    return count;
+}
+
+bool NetworkAdapter::has_queued_packets(size_t queue_index) const
+{
+    VERIFY(queue_index < m_receive_queue_count);
+    SpinlockLocker locker(m_packet_lock);
+    return !m_receive_queues[queue_index].packets.is_empty();
+}
+
+NetworkAdapter::ReceiveQueueStatistics NetworkAdapter::receive_queue_statistics(size_t queue_index) const
+{
+    VERIFY(queue_index < m_receive_queue_count);
+    SpinlockLocker locker(m_packet_lock);
+    return m_receive_queues[queue_index].statistics;
 }
 
 RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
 {
-    InterruptDisabler disabler;
+    SpinlockLocker locker(m_packet_lock);
+    return acquire_packet_buffer_locked(size);
+}
+
+RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer_locked(size_t size)
+{
+    VERIFY(m_packet_lock.is_locked());
     if (m_unused_packets.is_empty()) {
         auto buffer_or_error = KBuffer::try_create_with_size(size, Memory::Region::Access::ReadWrite, "Packet Buffer", AllocationStrategy::AllocateNow);
         if (buffer_or_error.is_error())
@@ -145,10 +338,19 @@ RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
 
 void NetworkAdapter::release_packet_buffer(PacketWithTimestamp& packet)
 {
-    InterruptDisabler disabler;
+    SpinlockLocker locker(m_packet_lock);
     m_unused_packets.append(packet);
 }
 
+void NetworkAdapter::release_packet_buffers(Span<RefPtr<PacketWithTimestamp>> packets)
+{
+    SpinlockLocker locker(m_packet_lock);
+    for (auto& packet : packets) {
+        m_unused_packets.append(*packet);
+        packet = nullptr;
+    }
+}
+
 void NetworkAdapter::set_ipv4_address(IPv4Address const& address)
 {
     m_ipv4_address = address;
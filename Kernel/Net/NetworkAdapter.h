@@ -6,15 +6,19 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/ByteBuffer.h>
+#include <AK/EnumBits.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
 #include <AK/MACAddress.h>
+#include <AK/NumericLimits.h>
 #include <AK/Types.h>
 #include <AK/WeakPtr.h>
 #include <AK/Weakable.h>
 #include <Kernel/Bus/PCI/Definitions.h>
 #include <Kernel/KBuffer.h>
+#include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
@@ -27,6 +31,37 @@ class NetworkAdapter;
 
 using NetworkByteBuffer = AK::Detail::ByteBuffer<1500>;
 
+// The work an adapter can take off the protocol stack's hands.
+enum class NetworkOffload : u8 {
+    None = 0,
+    // Fills in the TCP checksum of outgoing packets.
+    TCPChecksum = 1 << 0,
+    // Splits outgoing TCP packets larger than the MTU into segments.
+    TCPSegmentation = 1 << 1,
+    // Verifies the IPv4 and TCP checksums of incoming packets, and drops them if they're wrong.
+    ReceiveChecksum = 1 << 2,
+};
+
+AK_ENUM_BITWISE_OPERATORS(NetworkOffload);
+
+// What still has to be done to an outgoing frame before it can go on the wire.
+struct PacketOffload {
+    // The TCP checksum hasn't been computed yet.
+    bool tcp_checksum { false };
+    // The TCP payload has to be split into segments of this size. 0 if the frame fits into the MTU.
+    u16 tcp_segment_size { 0 };
+
+    NetworkOffload required_offloads() const
+    {
+        auto offloads = NetworkOffload::None;
+        if (tcp_checksum)
+            offloads |= NetworkOffload::TCPChecksum;
+        if (tcp_segment_size)
+            offloads |= NetworkOffload::TCPSegmentation;
+        return offloads;
+    }
+};
+
 struct PacketWithTimestamp : public RefCounted<PacketWithTimestamp> {
     PacketWithTimestamp(NonnullOwnPtr<KBuffer> buffer, Time timestamp)
         : buffer(move(buffer))
@@ -45,6 +80,15 @@ class NetworkAdapter : public RefCounted<NetworkAdapter>
     , public Weakable<NetworkAdapter> {
 public:
     static constexpr i32 LINKSPEED_INVALID = -1;
+    static constexpr size_t max_receive_queues = 8;
+    static constexpr size_t max_ipv4_packet_size = NumericLimits<u16>::max();
+
+    struct ReceiveQueueStatistics {
+        u64 packets { 0 };
+        u64 bytes { 0 };
+        u64 dropped { 0 };
+        u64 batches { 0 };
+    };
 
     virtual ~NetworkAdapter();
 
@@ -71,9 +115,18 @@ public:
     void send(MACAddress const&, ARPPacket const&);
     void fill_in_ipv4_header(PacketWithTimestamp&, IPv4Address const&, MACAddress const&, IPv4Address const&, IPv4Protocol, size_t, u8 type_of_service, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp);
+    // Takes up to `packets.size()` packets off the given receive queue at once.
+    // They have to be handed back with release_packet_buffer() once they've been processed.
+    size_t dequeue_packets(size_t queue_index, Span<RefPtr<PacketWithTimestamp>> packets);
 
-    bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
+    size_t receive_queue_count() const { return m_receive_queue_count; }
+    // Has to be called before the adapter is handed to the NetworkTask, which makes sure there's at least one queue per worker.
+    void set_receive_queue_count(size_t);
+    bool has_queued_packets(size_t queue_index) const;
+    ReceiveQueueStatistics receive_queue_statistics(size_t queue_index) const;
+
+    NetworkOffload offloads() const { return m_offloads; }
+    bool has_offloads(NetworkOffload offloads) const { return (m_offloads & offloads) == offloads; }
 
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
@@ -85,21 +138,30 @@ public:
 
     RefPtr<PacketWithTimestamp> acquire_packet_buffer(size_t);
     void release_packet_buffer(PacketWithTimestamp&);
+    void release_packet_buffers(Span<RefPtr<PacketWithTimestamp>>);
 
     constexpr size_t layer3_payload_offset() const { return sizeof(EthernetFrameHeader); }
     constexpr size_t ipv4_payload_offset() const { return layer3_payload_offset() + sizeof(IPv4Packet); }
 
-    Function<void()> on_receive;
+    Function<void(size_t queue_index)> on_receive;
 
-    void send_packet(ReadonlyBytes);
+    // Frames that need offloaded work the adapter can't do are taken care of in software.
+    void send_packet(ReadonlyBytes, PacketOffload const& = {});
 
 protected:
     NetworkAdapter(NonnullOwnPtr<KString>);
     void set_mac_address(MACAddress const& mac_address) { m_mac_address = mac_address; }
     void did_receive(ReadonlyBytes);
     virtual void send_raw(ReadonlyBytes) = 0;
+    // Only called with work the adapter announced it can do with set_offloads().
+    virtual void send_raw_with_offload(ReadonlyBytes, PacketOffload const&) { VERIFY_NOT_REACHED(); }
+    void set_offloads(NetworkOffload offloads) { m_offloads = offloads; }
 
 private:
+    size_t receive_queue_for_frame(ReadonlyBytes) const;
+    void send_with_software_offload(ReadonlyBytes, PacketOffload const&);
+    RefPtr<PacketWithTimestamp> acquire_packet_buffer_locked(size_t);
+
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     IPv4Address m_ipv4_netmask;
@@ -110,8 +172,15 @@ private:
 
     using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
 
-    PacketList m_packet_queue;
-    size_t m_packet_queue_size { 0 };
+    struct ReceiveQueue {
+        PacketList packets;
+        size_t size { 0 };
+        ReceiveQueueStatistics statistics;
+    };
+
+    mutable Spinlock m_packet_lock;
+    Array<ReceiveQueue, max_receive_queues> m_receive_queues;
+    size_t m_receive_queue_count { 1 };
     PacketList m_unused_packets;
     NonnullOwnPtr<KString> m_name;
     u32 m_packets_in { 0 };
@@ -119,6 +188,7 @@ private:
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
     u32 m_mtu { 1500 };
+    NetworkOffload m_offloads { NetworkOffload::None };
 };
 
 }
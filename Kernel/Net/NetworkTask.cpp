@@ -7,6 +7,7 @@
 #include <Kernel/Debug.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/MutexProtected.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
@@ -22,47 +23,57 @@
 #include <Kernel/Net/UDP.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/Process.h>
+#include <Kernel/Scheduler.h>
 
 namespace Kernel {
 
 static void handle_arp(EthernetFrameHeader const&, size_t frame_size);
-static void handle_ipv4(EthernetFrameHeader const&, size_t frame_size, Time const& packet_timestamp);
+static void handle_ipv4(NetworkAdapter&, EthernetFrameHeader const&, size_t frame_size, Time const& packet_timestamp);
 static void handle_icmp(EthernetFrameHeader const&, IPv4Packet const&, Time const& packet_timestamp);
 static void handle_udp(IPv4Packet const&, Time const& packet_timestamp);
-static void handle_tcp(IPv4Packet const&, Time const& packet_timestamp);
+static void handle_tcp(NetworkAdapter&, IPv4Packet const&, Time const& packet_timestamp);
 static void send_delayed_tcp_ack(RefPtr<TCPSocket> socket);
 static void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, RefPtr<NetworkAdapter> adapter);
 static void flush_delayed_tcp_acks();
 static void retransmit_tcp_packets();
 
-static Thread* network_task = nullptr;
-static HashTable<RefPtr<TCPSocket>>* delayed_ack_sockets;
+// Packets are taken off a receive queue this many at a time, so the queue lock isn't
+// bounced back and forth with the interrupt handler for every single one of them.
+static constexpr size_t max_packets_per_batch = 32;
+
+// Each worker thread handles a subset of the adapters' receive queues. Since an adapter
+// always puts the packets of a flow on the same queue, a TCP connection is only ever
+// processed by one worker, and with that on one processor.
+struct NetworkWorker {
+    size_t index { 0 };
+    Thread* thread { nullptr };
+    WaitQueue packet_wait_queue;
+};
+
+static NetworkWorker* s_workers[NetworkAdapter::max_receive_queues];
+static size_t s_worker_count = 0;
+static SpinlockProtected<HashTable<RefPtr<TCPSocket>>>* delayed_ack_sockets;
 
 [[noreturn]] static void NetworkTask_main(void*);
 
 void NetworkTask::spawn()
 {
-    RefPtr<Thread> thread;
-    auto name = KString::try_create("NetworkTask");
-    if (name.is_error())
-        TODO();
-    (void)Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, nullptr);
-    network_task = thread;
-}
-
-bool NetworkTask::is_current()
-{
-    return Thread::current() == network_task;
-}
+    delayed_ack_sockets = new SpinlockProtected<HashTable<RefPtr<TCPSocket>>>;
 
-void NetworkTask_main(void*)
-{
-    delayed_ack_sockets = new HashTable<RefPtr<TCPSocket>>;
+    // Workers are pinned to a processor each, so only spawn as many as there are processors that actually run threads.
+    s_worker_count = min<size_t>(Scheduler::scheduling_processor_count(), NetworkAdapter::max_receive_queues);
+    for (size_t i = 0; i < s_worker_count; ++i) {
+        s_workers[i] = new NetworkWorker;
+        s_workers[i]->index = i;
+    }
 
-    WaitQueue packet_wait_queue;
-    int pending_packets = 0;
     NetworkingManagement::the().for_each([&](auto& adapter) {
-        dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
+        // Most adapters only have a single queue in hardware, so we steer their packets to one queue per worker in software.
+        // That way, receive processing is spread over all processors no matter which adapter the packets come from.
+        if (adapter.receive_queue_count() < s_worker_count)
+            adapter.set_receive_queue_count(s_worker_count);
+
+        dmesgln("NetworkTask: {} network adapter found: hw={}, receive queues={}", adapter.class_name(), adapter.mac_address().to_string(), adapter.receive_queue_count());
 
         if (adapter.class_name() == "LoopbackAdapter"sv) {
             adapter.set_ipv4_address({ 127, 0, 0, 1 });
@@ -70,63 +81,94 @@ void NetworkTask_main(void*)
             adapter.set_ipv4_gateway({ 0, 0, 0, 0 });
         }
 
-        adapter.on_receive = [&]() {
-            pending_packets++;
-            packet_wait_queue.wake_all();
+        adapter.on_receive = [](size_t queue_index) {
+            s_workers[queue_index % s_worker_count]->packet_wait_queue.wake_all();
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, Time& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
+    for (size_t i = 0; i < s_worker_count; ++i) {
+        RefPtr<Thread> thread;
+        auto name = i == 0 ? KString::try_create("NetworkTask"sv) : KString::formatted("NetworkTask #{}", i);
+        if (name.is_error())
+            TODO();
+        // NOTE: With a single worker, there's no point in keeping it away from the other processors.
+        u32 affinity = s_worker_count > 1 ? 1u << i : THREAD_AFFINITY_DEFAULT;
+        (void)Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, s_workers[i], affinity);
+        s_workers[i]->thread = thread;
+    }
+}
+
+bool NetworkTask::is_current()
+{
+    auto* current_thread = Thread::current();
+    for (size_t i = 0; i < s_worker_count; ++i) {
+        if (s_workers[i]->thread == current_thread)
+            return true;
+    }
+    return false;
+}
+
+static void handle_frame(NetworkAdapter& adapter, ReadonlyBytes frame, Time const& packet_timestamp)
+{
+    if (frame.size() < sizeof(EthernetFrameHeader)) {
+        dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", frame.size());
+        return;
+    }
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), frame.size());
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, frame.size());
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(adapter, eth, frame.size(), packet_timestamp);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
+    }
+}
+
+void NetworkTask_main(void* data)
+{
+    auto& worker = *static_cast<NetworkWorker*>(data);
+    // Only the first worker takes care of the TCP timers.
+    bool handles_timers = worker.index == 0;
+
+    Array<RefPtr<PacketWithTimestamp>, max_packets_per_batch> packets;
+
+    for (;;) {
+        if (handles_timers) {
+            flush_delayed_tcp_acks();
+            retransmit_tcp_packets();
+        }
+
+        NonnullRefPtrVector<NetworkAdapter, 8> adapters;
         NetworkingManagement::the().for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
-            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
+            (void)adapters.try_append(adapter);
         });
-        return packet_size;
-    };
 
-    size_t buffer_size = 64 * KiB;
-    auto region_or_error = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer", Memory::Region::Access::ReadWrite);
-    if (region_or_error.is_error())
-        TODO();
-    auto buffer_region = region_or_error.release_value();
-    auto buffer = (u8*)buffer_region->vaddr().get();
-    Time packet_timestamp;
+        size_t processed_packets = 0;
+        for (auto& adapter : adapters) {
+            for (size_t queue_index = worker.index; queue_index < adapter.receive_queue_count(); queue_index += s_worker_count) {
+                auto count = adapter.dequeue_packets(queue_index, packets.span());
+                if (count == 0)
+                    continue;
+                dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask #{}: Dequeued {} packet(s) from {} queue {}", worker.index, count, adapter.name(), queue_index);
+                for (size_t i = 0; i < count; ++i)
+                    handle_frame(adapter, packets[i]->bytes(), packets[i]->timestamp);
+                adapter.release_packet_buffers(packets.span().trim(count));
+                processed_packets += count;
+            }
+        }
 
-    for (;;) {
-        flush_delayed_tcp_acks();
-        retransmit_tcp_packets();
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
+        if (processed_packets == 0) {
             auto timeout_time = Time::from_milliseconds(500);
             auto timeout = Thread::BlockTimeout { false, &timeout_time };
-            [[maybe_unused]] auto result = packet_wait_queue.wait_on(timeout, "NetworkTask");
-            continue;
-        }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
-            continue;
-        }
-        auto& eth = *(EthernetFrameHeader const*)buffer;
-        dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
-
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
-            break;
-        case EtherType::IPv6:
-            // ignore
-            break;
-        default:
-            dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
+            [[maybe_unused]] auto result = worker.packet_wait_queue.wait_on(timeout, "NetworkTask");
         }
     }
 }
@@ -179,7 +221,7 @@ void handle_arp(EthernetFrameHeader const& eth, size_t frame_size)
     }
 }
 
-void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, Time const& packet_timestamp)
+void handle_ipv4(NetworkAdapter& receiving_adapter, EthernetFrameHeader const& eth, size_t frame_size, Time const& packet_timestamp)
 {
     constexpr size_t minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
@@ -199,6 +241,14 @@ void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, Time const&
         return;
     }
 
+    if (!receiving_adapter.has_offloads(NetworkOffload::ReceiveChecksum)) {
+        size_t header_length = packet.internet_header_length() * sizeof(u32);
+        if (header_length < sizeof(IPv4Packet) || header_length > actual_ipv4_packet_length || internet_checksum(&packet, header_length) != 0) {
+            dbgln("handle_ipv4: Dropping packet with bad header checksum");
+            return;
+        }
+    }
+
     dbgln_if(IPV4_DEBUG, "handle_ipv4: source={}, destination={}", packet.source(), packet.destination());
 
     NetworkingManagement::the().for_each([&](auto& adapter) {
@@ -216,7 +266,7 @@ void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, Time const&
     case IPv4Protocol::UDP:
         return handle_udp(packet, packet_timestamp);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet, packet_timestamp);
+        return handle_tcp(receiving_adapter, packet, packet_timestamp);
     default:
         dbgln_if(IPV4_DEBUG, "handle_ipv4: Unhandled protocol {:#02x}", packet.protocol());
         break;
@@ -310,13 +360,23 @@ void send_delayed_tcp_ack(RefPtr<TCPSocket> socket)
         return;
     }
 
-    delayed_ack_sockets->set(move(socket));
+    delayed_ack_sockets->with([&](auto& sockets) {
+        sockets.set(move(socket));
+    });
 }
 
 void flush_delayed_tcp_acks()
 {
+    // NOTE: The other workers keep adding sockets while we're going through them, and we
+    //       can't hold on to the spinlock while we're taking the sockets' mutexes.
+    auto sockets = delayed_ack_sockets->with([](auto& sockets) {
+        return move(sockets);
+    });
+    if (sockets.is_empty())
+        return;
+
     Vector<RefPtr<TCPSocket>, 32> remaining_sockets;
-    for (auto& socket : *delayed_ack_sockets) {
+    for (auto& socket : sockets) {
         MutexLocker locker(socket->mutex());
         if (socket->should_delay_next_ack()) {
             MUST(remaining_sockets.try_append(socket));
@@ -325,13 +385,14 @@ void flush_delayed_tcp_acks()
         [[maybe_unused]] auto result = socket->send_ack();
     }
 
-    if (remaining_sockets.size() != delayed_ack_sockets->size()) {
-        delayed_ack_sockets->clear();
-        if (remaining_sockets.size() > 0)
-            dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
+    if (remaining_sockets.is_empty())
+        return;
+    if (remaining_sockets.size() != sockets.size())
+        dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
+    delayed_ack_sockets->with([&](auto& sockets) {
         for (auto&& socket : remaining_sockets)
-            delayed_ack_sockets->set(move(socket));
-    }
+            sockets.set(move(socket));
+    });
 }
 
 void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, RefPtr<NetworkAdapter> adapter)
@@ -368,7 +429,7 @@ void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, Re
     routing_decision.adapter->release_packet_buffer(*packet);
 }
 
-void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
+void handle_tcp(NetworkAdapter& receiving_adapter, IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
 {
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         dbgln("handle_tcp: IPv4 payload is too small to be a TCP packet ({}, need {})", ipv4_packet.payload_size(), sizeof(TCPPacket));
@@ -390,6 +451,11 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
 
     size_t payload_size = ipv4_packet.payload_size() - tcp_packet.header_size();
 
+    if (!receiving_adapter.has_offloads(NetworkOffload::ReceiveChecksum) && TCPSocket::compute_tcp_checksum(ipv4_packet.source(), ipv4_packet.destination(), tcp_packet, payload_size) != 0) {
+        dbgln("handle_tcp: Dropping packet with bad checksum");
+        return;
+    }
+
     dbgln_if(TCP_DEBUG, "handle_tcp: source={}:{}, destination={}:{}, seq_no={}, ack_no={}, flags={:#04x} ({}{}{}{}), window_size={}, payload_size={}",
         ipv4_packet.source().to_string(),
         tcp_packet.source_port(),
@@ -459,6 +525,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->process_syn_options(tcp_packet);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -472,11 +539,13 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         switch (tcp_packet.flags()) {
         case TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->process_syn_options(tcp_packet);
             (void)socket->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             socket->set_state(TCPSocket::State::SynReceived);
             return;
         case TCPFlags::ACK | TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->process_syn_options(tcp_packet);
             (void)socket->send_ack(true);
             socket->set_state(TCPSocket::State::Established);
             socket->set_setup_state(Socket::SetupState::Completed);
@@ -620,17 +689,20 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         }
 
         if (tcp_packet.sequence_number() != socket->ack_number()) {
-            dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
-            if (socket->duplicate_acks() < TCPSocket::maximum_duplicate_acks) {
-                dbgln_if(TCP_DEBUG, "Sending ACK with same ack number to trigger fast retransmission");
-                socket->set_duplicate_acks(socket->duplicate_acks() + 1);
-                [[maybe_unused]] auto result = socket->send_ack(true);
+            if (payload_size == 0)
+                return;
+            if (!tcp_packet.has_fin() && tcp_sequence_less_than(socket->ack_number(), tcp_packet.sequence_number())) {
+                dbgln_if(TCP_DEBUG, "Queueing out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
+                socket->queue_out_of_order_segment(ipv4_packet, packet_timestamp);
+            } else {
+                dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
             }
+            // RFC 5681, section 4.2: Tell the sender right away what we're missing (and, with SACK, what we have),
+            // so it can retransmit without waiting for its timer.
+            [[maybe_unused]] auto result = socket->send_ack(true);
             return;
         }
 
-        socket->set_duplicate_acks(0);
-
         if (tcp_packet.has_fin()) {
             if (payload_size != 0)
                 socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp);
@@ -647,7 +719,13 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
                 socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
                 dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
                     tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
-                send_delayed_tcp_ack(socket);
+                if (socket->has_out_of_order_segments()) {
+                    // This filled (part of) a gap, so the sender should hear about it right away (RFC 5681, section 4.2).
+                    socket->deliver_out_of_order_segments();
+                    [[maybe_unused]] auto result = socket->send_ack(true);
+                } else {
+                    send_delayed_tcp_ack(socket);
+                }
             }
         }
     }
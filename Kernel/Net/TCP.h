@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <AK/Array.h>
+#include <AK/ByteReader.h>
+#include <AK/Optional.h>
 #include <AK/StdLibExtras.h>
 #include <Kernel/Net/IPv4.h>
 
@@ -22,6 +25,16 @@ struct TCPFlags {
     };
 };
 
+enum class TCPOptionKind : u8 {
+    End = 0,
+    NoOperation = 1,
+    MSS = 2,
+    WindowScale = 3,
+    SACKPermitted = 4,
+    SACK = 5,
+    Timestamp = 8,
+};
+
 class [[gnu::packed]] TCPOptionMSS {
 public:
     TCPOptionMSS(u16 value)
@@ -32,13 +45,71 @@ public:
     u16 value() const { return m_value; }
 
 private:
-    u8 m_option_kind { 0x02 };
+    u8 m_option_kind { to_underlying(TCPOptionKind::MSS) };
     u8 m_option_length { sizeof(TCPOptionMSS) };
     NetworkOrdered<u16> m_value;
 };
 
 static_assert(AssertSize<TCPOptionMSS, 4>());
 
+// RFC 7323, section 2
+class [[gnu::packed]] TCPOptionWindowScale {
+public:
+    TCPOptionWindowScale(u8 shift_count)
+        : m_shift_count(shift_count)
+    {
+    }
+
+    u8 shift_count() const { return m_shift_count; }
+
+private:
+    // NOTE: The leading no-op keeps whatever follows aligned to 4 bytes.
+    u8 m_padding { to_underlying(TCPOptionKind::NoOperation) };
+    u8 m_option_kind { to_underlying(TCPOptionKind::WindowScale) };
+    u8 m_option_length { 3 };
+    u8 m_shift_count { 0 };
+};
+
+static_assert(AssertSize<TCPOptionWindowScale, 4>());
+
+// RFC 2018, section 2
+class [[gnu::packed]] TCPOptionSACKPermitted {
+private:
+    u8 m_padding[2] { to_underlying(TCPOptionKind::NoOperation), to_underlying(TCPOptionKind::NoOperation) };
+    u8 m_option_kind { to_underlying(TCPOptionKind::SACKPermitted) };
+    u8 m_option_length { 2 };
+};
+
+static_assert(AssertSize<TCPOptionSACKPermitted, 4>());
+
+// RFC 7323, section 3
+class [[gnu::packed]] TCPOptionTimestamp {
+public:
+    TCPOptionTimestamp(u32 value, u32 echo_reply)
+        : m_value(value)
+        , m_echo_reply(echo_reply)
+    {
+    }
+
+private:
+    u8 m_padding[2] { to_underlying(TCPOptionKind::NoOperation), to_underlying(TCPOptionKind::NoOperation) };
+    u8 m_option_kind { to_underlying(TCPOptionKind::Timestamp) };
+    u8 m_option_length { 10 };
+    NetworkOrdered<u32> m_value;
+    NetworkOrdered<u32> m_echo_reply;
+};
+
+static_assert(AssertSize<TCPOptionTimestamp, 12>());
+
+struct TCPSACKBlock {
+    u32 left_edge { 0 };
+    u32 right_edge { 0 };
+};
+
+// Sequence numbers wrap around, so they have to be compared relative to each other (RFC 793, section 3.3).
+constexpr bool tcp_sequence_less_than(u32 a, u32 b) { return static_cast<i32>(a - b) < 0; }
+constexpr bool tcp_sequence_less_than_or_equal(u32 a, u32 b) { return static_cast<i32>(a - b) <= 0; }
+
 class [[gnu::packed]] TCPPacket {
 public:
     TCPPacket() = default;
@@ -81,6 +152,13 @@ public:
     void const* payload() const { return ((u8 const*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
+    ReadonlyBytes options() const
+    {
+        if (header_size() <= sizeof(TCPPacket))
+            return {};
+        return { ((u8 const*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) };
+    }
+
 private:
     NetworkOrdered<u16> m_source_port;
     NetworkOrdered<u16> m_destination_port;
@@ -95,4 +173,76 @@ private:
 
 static_assert(AssertSize<TCPPacket, 20>());
 
+struct TCPOptions {
+    static constexpr size_t max_sack_blocks = 4;
+
+    Optional<u16> mss;
+    Optional<u8> window_scale;
+    bool sack_permitted { false };
+    Optional<u32> timestamp_value;
+    u32 timestamp_echo_reply { 0 };
+    Array<TCPSACKBlock, max_sack_blocks> sack_blocks;
+    size_t sack_block_count { 0 };
+
+    static TCPOptions parse(TCPPacket const& packet)
+    {
+        TCPOptions options;
+        auto bytes = packet.options();
+        auto read_u16 = [&](size_t offset) {
+            u16 value;
+            ByteReader::load(bytes.offset_pointer(offset), value);
+            return AK::convert_between_host_and_network_endian(value);
+        };
+        auto read_u32 = [&](size_t offset) {
+            u32 value;
+            ByteReader::load(bytes.offset_pointer(offset), value);
+            return AK::convert_between_host_and_network_endian(value);
+        };
+
+        for (size_t offset = 0; offset < bytes.size();) {
+            auto kind = static_cast<TCPOptionKind>(bytes[offset]);
+            if (kind == TCPOptionKind::End)
+                break;
+            if (kind == TCPOptionKind::NoOperation) {
+                ++offset;
+                continue;
+            }
+            if (offset + 1 >= bytes.size())
+                break;
+            size_t length = bytes[offset + 1];
+            if (length < 2 || offset + length > bytes.size())
+                break;
+
+            switch (kind) {
+            case TCPOptionKind::MSS:
+                if (length == 4)
+                    options.mss = read_u16(offset + 2);
+                break;
+            case TCPOptionKind::WindowScale:
+                if (length == 3)
+                    options.window_scale = bytes[offset + 2];
+                break;
+            case TCPOptionKind::SACKPermitted:
+                if (length == 2)
+                    options.sack_permitted = true;
+                break;
+            case TCPOptionKind::SACK:
+                for (size_t block_offset = offset + 2; block_offset + 8 <= offset + length && options.sack_block_count < max_sack_blocks; block_offset += 8)
+                    options.sack_blocks[options.sack_block_count++] = { read_u32(block_offset), read_u32(block_offset + 4) };
+                break;
+            case TCPOptionKind::Timestamp:
+                if (length == 10) {
+                    options.timestamp_value = read_u32(offset + 2);
+                    options.timestamp_echo_reply = read_u32(offset + 6);
+                }
+                break;
+            default:
+                break;
+            }
+            offset += length;
+        }
+        return options;
+    }
+};
+
 }
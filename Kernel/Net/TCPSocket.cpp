@@ -19,9 +19,31 @@
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
+// RFC 6928, section 2
+static u32 initial_congestion_window(u32 mss)
+{
+    return min(10 * mss, max(2 * mss, 14600u));
+}
+
+static u8 window_shift_for(size_t window_size)
+{
+    // RFC 7323, section 2.3: The shift count is capped at 14.
+    u8 shift = 0;
+    while (shift < 14 && (window_size >> shift) > NumericLimits<u16>::max())
+        ++shift;
+    return shift;
+}
+
+// RFC 7323 only asks for a clock that ticks somewhere between once per millisecond and once per second.
+static u32 timestamp_now()
+{
+    return static_cast<u32>(TimeManagement::the().monotonic_time().to_milliseconds());
+}
+
 void TCPSocket::for_each(Function<void(TCPSocket const&)> callback)
 {
     sockets_by_tuple().for_each_shared([&](auto const& it) {
@@ -165,7 +187,9 @@ void TCPSocket::release_for_accept(RefPtr<TCPSocket> socket)
 TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer)
     : IPv4Socket(SOCK_STREAM, protocol, move(receive_buffer), move(scratch_buffer))
 {
-    m_last_retransmit_time = kgettimeofday();
+    m_last_retransmit_time = TimeManagement::the().monotonic_time();
+    m_receive_window_shift = window_shift_for(receive_buffer_capacity());
+    m_congestion_window = initial_congestion_window(m_send_mss);
 }
 
 TCPSocket::~TCPSocket()
@@ -205,12 +229,151 @@ ErrorOr<size_t> TCPSocket::protocol_send(UserOrKernelBuffer const& data, size_t
     RoutingDecision routing_decision = route_to(peer_address(), local_address(), bound_interface());
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
-    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-    data_length = min(data_length, mss);
+    size_t mss = min<size_t>(routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket), m_send_mss) - data_options_size();
+
+    size_t budget = send_budget();
+    bool is_window_probe = false;
+    if (budget == 0) {
+        bool has_packets_in_flight = m_unacked_packets.with_shared([](auto& unacked_packets) { return !unacked_packets.packets.is_empty(); });
+        if (has_packets_in_flight)
+            return set_so_error(EAGAIN);
+        // The peer has closed its window. Probe it with a single byte, the persist timer keeps repeating
+        // that until an ACK tells us the window has opened up again (RFC 9293, section 3.8.6.1).
+        budget = 1;
+        is_window_probe = true;
+    }
+
+    // Bulk data goes to the adapter in one large packet, which it (or its software fallback) then splits
+    // into segments. That way, the data is copied, checksummed and tracked in one go instead of once per segment.
+    size_t send_size = mss;
+    if (data_length > mss) {
+        size_t max_large_send_size = NetworkAdapter::max_ipv4_packet_size - sizeof(IPv4Packet) - sizeof(TCPPacket) - maximum_tcp_options_size;
+        send_size = max(mss, max_large_send_size / mss * mss);
+    }
+
+    data_length = min(data_length, min(send_size, budget));
     TRY(send_tcp_packet(TCPFlags::PSH | TCPFlags::ACK, &data, data_length, &routing_decision));
+    if (is_window_probe) {
+        m_unacked_packets.with_exclusive([](auto& unacked_packets) {
+            unacked_packets.packets.last().is_window_probe = true;
+        });
+        m_last_window_probe_time = TimeManagement::the().monotonic_time();
+        m_window_probe_attempts = 0;
+        m_unanswered_window_probes = 0;
+    }
     return data_length;
 }
 
+size_t TCPSocket::send_budget() const
+{
+    return m_unacked_packets.with_shared([&](auto& unacked_packets) -> size_t {
+        // We may neither overrun the peer's receive window, nor put more into the network than the congestion window allows.
+        size_t window_space = m_send_window_size > unacked_packets.size ? m_send_window_size - unacked_packets.size : 0;
+        size_t congestion_space = m_congestion_window > unacked_packets.pipe ? m_congestion_window - unacked_packets.pipe : 0;
+        return min(window_space, congestion_space);
+    });
+}
+
+size_t TCPSocket::receive_window() const
+{
+    // Whatever we've queued out of order will end up in the receive buffer too, so it can't be offered again.
+    size_t space = receive_buffer_space_for_writing();
+    return space > m_out_of_order_bytes ? space - m_out_of_order_bytes : 0;
+}
+
+u16 TCPSocket::advertised_window_size(u16 flags)
+{
+    // RFC 7323, section 2.2: The window in a SYN segment is never scaled.
+    if (flags & TCPFlags::SYN)
+        return min(receive_window(), NumericLimits<u16>::max());
+
+    u8 shift = m_window_scaling_enabled ? m_receive_window_shift : 0;
+    u16 window = min(receive_window() >> shift, NumericLimits<u16>::max());
+    m_last_advertised_window = static_cast<u32>(window) << shift;
+    return window;
+}
+
+size_t TCPSocket::build_tcp_options(u16 flags, u16 mss, Bytes buffer) const
+{
+    size_t size = 0;
+    auto append = [&](auto const& option) {
+        VERIFY(size + sizeof(option) <= buffer.size());
+        memcpy(buffer.offset_pointer(size), &option, sizeof(option));
+        size += sizeof(option);
+    };
+
+    if (flags & TCPFlags::SYN) {
+        // We offer everything we support in our SYN, a SYN|ACK can only agree to what the peer offered.
+        bool is_offer = !(flags & TCPFlags::ACK);
+        append(TCPOptionMSS { mss });
+        if (is_offer || m_sack_permitted)
+            append(TCPOptionSACKPermitted {});
+        if (is_offer || m_timestamps_enabled)
+            append(TCPOptionTimestamp { timestamp_now(), m_timestamp_recent });
+        if (is_offer || m_window_scaling_enabled)
+            append(TCPOptionWindowScale { m_receive_window_shift });
+        return size;
+    }
+
+    if (m_timestamps_enabled)
+        append(TCPOptionTimestamp { timestamp_now(), m_timestamp_recent });
+
+    if (!m_sack_permitted || !(flags & TCPFlags::ACK) || m_out_of_order_segments.is_empty())
+        return size;
+
+    // RFC 2018, section 3: The first block has to report the most recently received segment,
+    // and there's only room for three blocks next to the timestamp option.
+    Array<TCPSACKBlock, TCPOptions::max_sack_blocks> blocks;
+    size_t block_count = 0;
+    size_t max_block_count = m_timestamps_enabled ? 3 : 4;
+    auto for_each_block = [&](auto callback) {
+        Optional<TCPSACKBlock> current;
+        for (auto& segment : m_out_of_order_segments) {
+            if (current.has_value() && current->right_edge == segment.sequence_number) {
+                current->right_edge += segment.payload_size;
+                continue;
+            }
+            if (current.has_value())
+                callback(current.value());
+            current = TCPSACKBlock { segment.sequence_number, segment.sequence_number + segment.payload_size };
+        }
+        if (current.has_value())
+            callback(current.value());
+    };
+    auto contains_latest_segment = [&](TCPSACKBlock const& block) {
+        return tcp_sequence_less_than_or_equal(block.left_edge, m_last_out_of_order_sequence_number)
+            && tcp_sequence_less_than(m_last_out_of_order_sequence_number, block.right_edge);
+    };
+    for_each_block([&](auto const& block) {
+        if (contains_latest_segment(block))
+            blocks[block_count++] = block;
+    });
+    for_each_block([&](auto const& block) {
+        if (block_count < max_block_count && !contains_latest_segment(block))
+            blocks[block_count++] = block;
+    });
+
+    VERIFY(size + 4 + block_count * 8 <= buffer.size());
+    buffer[size++] = to_underlying(TCPOptionKind::NoOperation);
+    buffer[size++] = to_underlying(TCPOptionKind::NoOperation);
+    buffer[size++] = to_underlying(TCPOptionKind::SACK);
+    buffer[size++] = 2 + block_count * 8;
+    for (size_t i = 0; i < block_count; ++i) {
+        NetworkOrdered<u32> left_edge = blocks[i].left_edge;
+        NetworkOrdered<u32> right_edge = blocks[i].right_edge;
+        memcpy(buffer.offset_pointer(size), &left_edge, sizeof(left_edge));
+        memcpy(buffer.offset_pointer(size + 4), &right_edge, sizeof(right_edge));
+        size += 8;
+    }
+    return size;
+}
+
+size_t TCPSocket::data_options_size() const
+{
+    u8 options[maximum_tcp_options_size];
+    return build_tcp_options(TCPFlags::PSH | TCPFlags::ACK, 0, { options, sizeof(options) });
+}
+
 ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
 {
     if (!allow_duplicate && m_last_ack_number_sent == m_ack_number)
@@ -226,8 +389,9 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     auto ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
 
-    bool const has_mss_option = flags == TCPFlags::SYN;
-    const size_t options_size = has_mss_option ? sizeof(TCPOptionMSS) : 0;
+    u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    u8 options[maximum_tcp_options_size];
+    const size_t options_size = build_tcp_options(flags, mss, { options, sizeof(options) });
     const size_t tcp_header_size = sizeof(TCPPacket) + options_size;
     const size_t buffer_size = ipv4_payload_offset + tcp_header_size + payload_size;
     auto packet = routing_decision.adapter->acquire_packet_buffer(buffer_size);
@@ -241,7 +405,7 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(NumericLimits<u16>::max());
+    tcp_packet.set_window_size(advertised_window_size(flags));
     tcp_packet.set_sequence_number(m_sequence_number);
     tcp_packet.set_data_offset(tcp_header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
@@ -259,29 +423,43 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
         tcp_packet.set_ack_number(m_ack_number);
     }
 
+    u32 sequence_number = m_sequence_number;
     if (flags & TCPFlags::SYN) {
         ++m_sequence_number;
     } else {
         m_sequence_number += payload_size;
     }
 
-    if (has_mss_option) {
-        u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-        TCPOptionMSS mss_option { mss };
-        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + sizeof(mss_option));
-        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), &mss_option, sizeof(mss_option));
+    if (options_size > 0) {
+        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + options_size);
+        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), options, options_size);
     }
 
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    PacketOffload offload;
+    size_t segment_size = min<size_t>(mss, m_send_mss) - options_size;
+    if (payload_size > segment_size) {
+        VERIFY(!(flags & TCPFlags::SYN));
+        offload.tcp_segment_size = segment_size;
+    }
+    // Each segment needs its own checksum anyway, so there's no point in computing one for the whole thing.
+    if (offload.tcp_segment_size || routing_decision.adapter->has_offloads(NetworkOffload::TCPChecksum))
+        offload.tcp_checksum = true;
+    else
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
 
-    routing_decision.adapter->send_packet(packet->bytes());
+    routing_decision.adapter->send_packet(packet->bytes(), offload);
 
     m_packets_out++;
     m_bytes_out += buffer_size;
     if (tcp_packet.has_syn() || payload_size > 0) {
+        auto now = TimeManagement::the().monotonic_time();
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            unacked_packets.packets.append({ m_sequence_number, move(packet), ipv4_payload_offset, *routing_decision.adapter });
+            // RFC 6298, section 5.1: Start the retransmission timer if it isn't running already.
+            if (unacked_packets.packets.is_empty())
+                m_last_retransmit_time = now;
+            unacked_packets.packets.append({ m_sequence_number, move(packet), ipv4_payload_offset, *routing_decision.adapter, 0, sequence_number, static_cast<u32>(payload_size), now, offload });
             unacked_packets.size += payload_size;
+            unacked_packets.pipe += payload_size;
             enqueue_for_retransmit();
         });
     } else {
@@ -293,50 +471,451 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
 void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    auto options = TCPOptions::parse(packet);
+
+    // RFC 7323, section 4.3: Only remember timestamps from segments that don't leave a gap in front of them.
+    if (m_timestamps_enabled && options.timestamp_value.has_value() && tcp_sequence_less_than_or_equal(packet.sequence_number(), m_ack_number))
+        m_timestamp_recent = options.timestamp_value.value();
+
+    if (packet.has_ack())
+        process_acknowledgement(packet, options, size - packet.header_size());
+
+    m_packets_in++;
+    m_bytes_in += packet.header_size() + size;
+}
+
+void TCPSocket::process_acknowledgement(TCPPacket const& packet, TCPOptions const& options, size_t payload_size)
+{
+    u32 ack_number = packet.ack_number();
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+
+    // Nothing we ever sent can be acknowledged by this.
+    if (tcp_sequence_less_than(m_sequence_number, ack_number))
+        return;
+
+    // The peer is still there, so we can keep probing its window for as long as it stays closed.
+    m_unanswered_window_probes = 0;
+
+    u32 send_window_size = packet.window_size();
+    if (!packet.has_syn())
+        send_window_size <<= m_send_window_shift;
+    bool window_changed = send_window_size != m_send_window_size;
+
+    auto now = TimeManagement::the().monotonic_time();
+
+    if (tcp_sequence_less_than_or_equal(m_send_unacknowledged, ack_number)) {
+        // Once the window opens up again, an outstanding window probe gets a full retransmission timeout of its own.
+        if (m_send_window_size == 0 && send_window_size != 0)
+            m_last_retransmit_time = now;
+        m_send_window_size = send_window_size;
+    }
+
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        // RFC 5681, section 2: This is a duplicate ACK if it acknowledges nothing new and carries nothing else.
+        // A closed window means the peer is answering our window probes, not that anything got lost.
+        bool is_duplicate = ack_number == m_send_unacknowledged
+            && payload_size == 0
+            && !packet.has_syn() && !packet.has_fin()
+            && !window_changed
+            && send_window_size != 0
+            && !unacked_packets.packets.is_empty();
 
         int removed = 0;
-        m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            while (!unacked_packets.packets.is_empty()) {
-                auto& packet = unacked_packets.packets.first();
-
-                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
-
-                if (packet.ack_number <= ack_number) {
-                    auto old_adapter = packet.adapter.strong_ref();
-                    if (old_adapter)
-                        old_adapter->release_packet_buffer(*packet.buffer);
-                    TCPPacket& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                    auto payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
-                    unacked_packets.size -= payload_size;
-                    evaluate_block_conditions();
-                    unacked_packets.packets.take_first();
-                    removed++;
+        size_t acked_bytes = 0;
+        Optional<Time> round_trip_time;
+        while (!unacked_packets.packets.is_empty()) {
+            auto& unacked_packet = unacked_packets.packets.first();
+
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", unacked_packet.ack_number);
+
+            if (!tcp_sequence_less_than_or_equal(unacked_packet.ack_number, ack_number))
+                break;
+
+            auto old_adapter = unacked_packet.adapter.strong_ref();
+            if (old_adapter)
+                old_adapter->release_packet_buffer(*unacked_packet.buffer);
+            unacked_packets.size -= unacked_packet.payload_size;
+            if (!unacked_packet.sacked && !unacked_packet.lost)
+                unacked_packets.pipe -= unacked_packet.payload_size;
+            acked_bytes += unacked_packet.payload_size;
+            // Karn's algorithm: A retransmitted packet doesn't tell us which transmission got acknowledged.
+            if (unacked_packet.tx_counter == 0)
+                round_trip_time = now - unacked_packet.sent_time;
+            unacked_packets.packets.take_first();
+            removed++;
+        }
+
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
+
+        bool acknowledged_new_data = tcp_sequence_less_than(m_send_unacknowledged, ack_number);
+        if (acknowledged_new_data) {
+            m_send_unacknowledged = ack_number;
+            m_duplicate_acks = 0;
+            m_retransmit_attempts = 0;
+            // RFC 6298, section 5.3: Restart the retransmission timer for whatever is still outstanding.
+            m_last_retransmit_time = now;
+
+            // With timestamps, every ACK gives us a sample, retransmission or not (RFC 7323, section 4).
+            if (m_timestamps_enabled && options.timestamp_echo_reply != 0)
+                update_round_trip_time(Time::from_milliseconds(timestamp_now() - options.timestamp_echo_reply));
+            else if (round_trip_time.has_value())
+                update_round_trip_time(round_trip_time.value());
+        }
+
+        // Loss is reported (and has to be repaired) one segment at a time, not one large send at a time.
+        if (options.sack_block_count > 0 || m_in_fast_recovery)
+            split_into_segments(unacked_packets);
+
+        process_sack_blocks(unacked_packets, options);
+
+        u32 mss = m_send_mss;
+        // Keep the recovery point right behind us, so it doesn't end up on the wrong side of a wrapped sequence number.
+        if (acknowledged_new_data && !m_in_fast_recovery && tcp_sequence_less_than(m_recovery_point, ack_number - 1))
+            m_recovery_point = ack_number - 1;
+
+        if (acknowledged_new_data && acked_bytes > 0) {
+            if (m_in_fast_recovery) {
+                if (tcp_sequence_less_than_or_equal(m_recovery_point, ack_number)) {
+                    // RFC 6582, section 3.2, step 3: A full acknowledgement ends the recovery, and deflates the window.
+                    m_in_fast_recovery = false;
+                    m_congestion_window = min(m_slow_start_threshold, max<u32>(unacked_packets.size, mss) + mss);
                 } else {
-                    break;
+                    // RFC 6582, section 3.2, step 4: A partial acknowledgement points us straight at the next hole.
+                    if (!unacked_packets.packets.is_empty())
+                        mark_lost(unacked_packets, unacked_packets.packets.first());
+                    if (!m_sack_permitted) {
+                        m_congestion_window -= min<u32>(acked_bytes, m_congestion_window);
+                        if (acked_bytes >= mss)
+                            m_congestion_window += mss;
+                    }
                 }
+            } else if (m_congestion_window < m_slow_start_threshold) {
+                // RFC 5681, section 3.1: Slow start.
+                m_congestion_window += min<u32>(acked_bytes, mss);
+            } else {
+                // RFC 5681, section 3.1: Congestion avoidance grows the window by one segment per round trip.
+                m_bytes_acked_in_congestion_avoidance += acked_bytes;
+                if (m_bytes_acked_in_congestion_avoidance >= m_congestion_window) {
+                    m_bytes_acked_in_congestion_avoidance -= m_congestion_window;
+                    m_congestion_window += mss;
+                }
+            }
+        } else if (is_duplicate) {
+            ++m_duplicate_acks;
+            if (m_in_fast_recovery) {
+                // RFC 5681, section 3.2, step 4: Without SACK, every duplicate ACK means a segment has left the network.
+                // With SACK, the scoreboard has already taken care of that.
+                if (!m_sack_permitted)
+                    m_congestion_window += mss;
+            } else if (m_duplicate_acks == duplicate_ack_threshold && tcp_sequence_less_than(m_recovery_point, ack_number)) {
+                enter_fast_recovery(unacked_packets);
             }
+        }
 
-            if (unacked_packets.packets.is_empty()) {
-                m_retransmit_attempts = 0;
-                dequeue_for_retransmit();
+        if (m_in_fast_recovery && m_sack_permitted)
+            mark_sack_holes_lost(unacked_packets);
+
+        retransmit_lost_packets(unacked_packets);
+
+        if (unacked_packets.packets.is_empty()) {
+            m_retransmit_attempts = 0;
+            dequeue_for_retransmit();
+        }
+    });
+
+    evaluate_block_conditions();
+}
+
+void TCPSocket::process_sack_blocks(UnackedPackets& unacked_packets, TCPOptions const& options)
+{
+    if (!m_sack_permitted)
+        return;
+
+    for (size_t i = 0; i < options.sack_block_count; ++i) {
+        auto const& block = options.sack_blocks[i];
+        // Ignore anything that's already been acknowledged, or that we never sent (RFC 2018, section 8).
+        if (tcp_sequence_less_than_or_equal(block.right_edge, m_send_unacknowledged) || tcp_sequence_less_than(m_sequence_number, block.right_edge))
+            continue;
+        for (auto& packet : unacked_packets.packets) {
+            if (packet.sacked || packet.payload_size == 0)
+                continue;
+            if (!tcp_sequence_less_than_or_equal(block.left_edge, packet.sequence_number) || !tcp_sequence_less_than_or_equal(packet.ack_number, block.right_edge))
+                continue;
+            packet.sacked = true;
+            if (packet.lost)
+                packet.lost = false;
+            else
+                unacked_packets.pipe -= packet.payload_size;
+        }
+    }
+}
+
+void TCPSocket::split_into_segments(UnackedPackets& unacked_packets)
+{
+    // Large sends are tracked as a single packet while everything goes well. Once segments start going missing,
+    // we have to keep track of them one by one, so we only ever send again what was actually lost.
+    for (auto it = unacked_packets.packets.begin(); !it.is_end(); ++it) {
+        auto& packet = *it;
+        size_t segment_size = packet.offload.tcp_segment_size;
+        if (segment_size == 0 || packet.payload_size <= segment_size)
+            continue;
+        auto adapter = packet.adapter.strong_ref();
+        if (!adapter)
+            continue;
+
+        u8 const* data = packet.buffer->buffer->data();
+        auto const& tcp_packet = *(TCPPacket const*)(data + packet.ipv4_payload_offset);
+        size_t headers_size = packet.ipv4_payload_offset + tcp_packet.header_size();
+
+        // Build all of the segments first, so we can keep the packet in one piece if we run out of memory.
+        Vector<OutgoingPacket> segments;
+        size_t acked_bytes = 0;
+        bool out_of_memory = false;
+        for (size_t offset = 0; offset < packet.payload_size; offset += segment_size) {
+            u32 sequence_number = packet.sequence_number + offset;
+            size_t chunk_size = min(segment_size, packet.payload_size - offset);
+            // The peer may have acknowledged the start of the packet already.
+            if (tcp_sequence_less_than_or_equal(sequence_number + chunk_size, m_send_unacknowledged)) {
+                acked_bytes += chunk_size;
+                continue;
             }
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
-        });
+            auto buffer = adapter->acquire_packet_buffer(headers_size + chunk_size);
+            if (!buffer) {
+                out_of_memory = true;
+                break;
+            }
+            u8* segment_data = buffer->buffer->data();
+            memcpy(segment_data, data, headers_size);
+            memcpy(segment_data + headers_size, data + headers_size + offset, chunk_size);
+
+            auto& segment_tcp = *(TCPPacket*)(segment_data + packet.ipv4_payload_offset);
+            segment_tcp.set_sequence_number(sequence_number);
+            // Only the last segment gets to push the data or to close the connection.
+            if (offset + chunk_size != packet.payload_size)
+                segment_tcp.set_flags(tcp_packet.flags() & ~(TCPFlags::PSH | TCPFlags::FIN));
+
+            PacketOffload offload;
+            segment_tcp.set_checksum(0);
+            if (adapter->has_offloads(NetworkOffload::TCPChecksum))
+                offload.tcp_checksum = true;
+            else
+                segment_tcp.set_checksum(compute_tcp_checksum(local_address(), peer_address(), segment_tcp, chunk_size));
+
+            OutgoingPacket segment { sequence_number + static_cast<u32>(chunk_size), buffer, packet.ipv4_payload_offset, *adapter, packet.tx_counter, sequence_number, static_cast<u32>(chunk_size), packet.sent_time, offload, packet.sacked, packet.lost };
+            if (segments.try_append(move(segment)).is_error()) {
+                adapter->release_packet_buffer(*buffer);
+                out_of_memory = true;
+                break;
+            }
+        }
+
+        if (out_of_memory || segments.is_empty()) {
+            for (auto& segment : segments)
+                adapter->release_packet_buffer(*segment.buffer);
+            continue;
+        }
+
+        unacked_packets.size -= acked_bytes;
+        if (!packet.sacked && !packet.lost)
+            unacked_packets.pipe -= acked_bytes;
+        adapter->release_packet_buffer(*packet.buffer);
+
+        // NOTE: The iterator has already looked up the packet after this one, so it won't visit the segments we insert here.
+        *it = segments.take_first();
+        for (size_t i = segments.size(); i > 0; --i)
+            unacked_packets.packets.insert_after(it, move(segments[i - 1]));
     }
+}
 
-    m_packets_in++;
-    m_bytes_in += packet.header_size() + size;
+void TCPSocket::enter_fast_recovery(UnackedPackets& unacked_packets)
+{
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) entering fast recovery, {} bytes in flight", this, unacked_packets.size);
+
+    split_into_segments(unacked_packets);
+
+    u32 mss = m_send_mss;
+    // RFC 5681, section 3.2, steps 2 and 3
+    m_slow_start_threshold = max<u32>(unacked_packets.size / 2, 2 * mss);
+    m_congestion_window = m_slow_start_threshold;
+    if (!m_sack_permitted)
+        m_congestion_window += duplicate_ack_threshold * mss;
+    m_bytes_acked_in_congestion_avoidance = 0;
+    m_in_fast_recovery = true;
+    m_recovery_point = m_sequence_number;
+
+    for (auto& packet : unacked_packets.packets) {
+        if (!packet.sacked) {
+            mark_lost(unacked_packets, packet);
+            break;
+        }
+    }
+}
+
+void TCPSocket::mark_lost(UnackedPackets& unacked_packets, OutgoingPacket& packet)
+{
+    if (packet.lost || packet.sacked)
+        return;
+    packet.lost = true;
+    unacked_packets.pipe -= packet.payload_size;
+}
+
+void TCPSocket::mark_sack_holes_lost(UnackedPackets& unacked_packets)
+{
+    // RFC 6675, section 4: A segment counts as lost once enough data behind it has arrived at the peer.
+    size_t sacked_bytes_above = 0;
+    for (auto& packet : unacked_packets.packets) {
+        if (packet.sacked)
+            sacked_bytes_above += packet.payload_size;
+    }
+
+    size_t threshold = (duplicate_ack_threshold - 1) * m_send_mss;
+    for (auto& packet : unacked_packets.packets) {
+        if (packet.sacked) {
+            sacked_bytes_above -= packet.payload_size;
+            continue;
+        }
+        if (sacked_bytes_above <= threshold)
+            break;
+        // Anything we already sent again during this recovery gets another chance before we give up on it.
+        if (packet.tx_counter == 0)
+            mark_lost(unacked_packets, packet);
+    }
+}
+
+void TCPSocket::retransmit_lost_packets(UnackedPackets& unacked_packets)
+{
+    bool has_lost_packets = false;
+    for (auto& packet : unacked_packets.packets) {
+        if (packet.lost) {
+            has_lost_packets = true;
+            break;
+        }
+    }
+    if (!has_lost_packets)
+        return;
+
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return;
+
+    for (auto& packet : unacked_packets.packets) {
+        if (!packet.lost)
+            continue;
+        // Always let one packet through, otherwise a congestion window smaller than a packet would stall us.
+        // NOTE: Lost packets are split into segments whenever there's memory for it, so that's normally a single segment.
+        if (unacked_packets.pipe > 0 && unacked_packets.pipe + packet.payload_size > m_congestion_window)
+            break;
+        packet.lost = false;
+        unacked_packets.pipe += packet.payload_size;
+        resend_packet(packet, routing_decision);
+    }
+}
+
+void TCPSocket::update_round_trip_time(Time sample)
+{
+    // RFC 6298, section 2
+    i64 round_trip_time = sample.to_microseconds();
+    i64 smoothed_round_trip_time = m_smoothed_round_trip_time.to_microseconds();
+    i64 round_trip_time_variance = m_round_trip_time_variance.to_microseconds();
+    if (!m_has_round_trip_time_sample) {
+        smoothed_round_trip_time = round_trip_time;
+        round_trip_time_variance = round_trip_time / 2;
+        m_has_round_trip_time_sample = true;
+    } else {
+        i64 delta = smoothed_round_trip_time - round_trip_time;
+        round_trip_time_variance = (3 * round_trip_time_variance + (delta < 0 ? -delta : delta)) / 4;
+        smoothed_round_trip_time = (7 * smoothed_round_trip_time + round_trip_time) / 8;
+    }
+    m_smoothed_round_trip_time = Time::from_microseconds(smoothed_round_trip_time);
+    m_round_trip_time_variance = Time::from_microseconds(round_trip_time_variance);
+
+    // Our clock ticks once per millisecond. The RFC recommends not going below a second, and allows capping it at a minute.
+    i64 retransmit_timeout = smoothed_round_trip_time + max<i64>(1000, 4 * round_trip_time_variance);
+    m_retransmit_timeout = Time::from_microseconds(clamp<i64>(retransmit_timeout, 1'000'000, 60'000'000));
+}
+
+void TCPSocket::process_syn_options(TCPPacket const& packet)
+{
+    auto options = TCPOptions::parse(packet);
+
+    m_send_mss = options.mss.value_or(default_mss);
+    m_congestion_window = initial_congestion_window(m_send_mss);
+    m_send_window_size = packet.window_size();
+
+    // RFC 7323, section 2.2: Window scaling only applies if both sides asked for it.
+    m_window_scaling_enabled = options.window_scale.has_value();
+    if (m_window_scaling_enabled) {
+        m_send_window_shift = min(options.window_scale.value(), 14);
+    } else {
+        m_send_window_shift = 0;
+        m_receive_window_shift = 0;
+    }
+
+    m_sack_permitted = options.sack_permitted;
+
+    m_timestamps_enabled = options.timestamp_value.has_value();
+    if (m_timestamps_enabled)
+        m_timestamp_recent = options.timestamp_value.value();
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) negotiated mss={}, window_shift={}/{}, sack={}, timestamps={}",
+        this, m_send_mss, m_send_window_shift, m_receive_window_shift, m_sack_permitted, m_timestamps_enabled);
+}
+
+void TCPSocket::queue_out_of_order_segment(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
+{
+    auto& tcp_packet = *static_cast<TCPPacket const*>(ipv4_packet.payload());
+    u32 sequence_number = tcp_packet.sequence_number();
+    u32 payload_size = ipv4_packet.payload_size() - tcp_packet.header_size();
+
+    // Don't hold on to more than we could take once the gap in front of it is filled.
+    if (payload_size > receive_window())
+        return;
+
+    // Keep the queue sorted, and drop anything that overlaps what we already have.
+    auto it = m_out_of_order_segments.begin();
+    for (; !it.is_end(); ++it) {
+        if (tcp_sequence_less_than(sequence_number, it->sequence_number + it->payload_size) && tcp_sequence_less_than(it->sequence_number, sequence_number + payload_size))
+            return;
+        if (tcp_sequence_less_than(sequence_number, it->sequence_number))
+            break;
+    }
+
+    auto packet_or_error = KBuffer::try_create_with_bytes({ &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() });
+    if (packet_or_error.is_error())
+        return;
+
+    OutOfOrderSegment segment { sequence_number, payload_size, ipv4_packet.source(), tcp_packet.source_port(), packet_timestamp, packet_or_error.release_value() };
+    if (it.is_end())
+        m_out_of_order_segments.append(move(segment));
+    else
+        m_out_of_order_segments.insert_before(it, move(segment));
+    m_out_of_order_bytes += payload_size;
+    m_last_out_of_order_sequence_number = sequence_number;
+}
+
+void TCPSocket::deliver_out_of_order_segments()
+{
+    while (!m_out_of_order_segments.is_empty()) {
+        if (tcp_sequence_less_than(m_ack_number, m_out_of_order_segments.first().sequence_number))
+            break;
+
+        auto segment = m_out_of_order_segments.take_first();
+        m_out_of_order_bytes -= segment.payload_size;
+        // NOTE: Retransmissions use the same boundaries as the original, so anything that doesn't line up is something we already have.
+        if (segment.sequence_number != m_ack_number)
+            continue;
+        if (!did_receive(segment.source_address, segment.source_port, segment.packet->bytes(), segment.timestamp))
+            continue;
+        m_ack_number = segment.sequence_number + segment.payload_size;
+    }
 }
 
 bool TCPSocket::should_delay_next_ack() const
 {
-    // FIXME: We don't know the MSS here so make a reasonable guess.
-    const size_t mss = 1500;
+    // NOTE: We don't know what size the peer's segments are going to be, but they're usually as large as ours.
+    u32 mss = m_send_mss;
 
     // RFC 1122 says we should send an ACK for every two full-sized segments.
     if (m_ack_number >= m_last_ack_number_sent + 2 * mss)
@@ -433,7 +1012,7 @@ ErrorOr<void> TCPSocket::protocol_connect(OpenFileDescription& description, Shou
     if (auto result = allocate_local_port_if_needed(); result.error_or_port.is_error())
         return result.error_or_port.release_error();
 
-    m_sequence_number = get_good_random<u32>();
+    set_sequence_number(get_good_random<u32>());
     m_ack_number = 0;
 
     set_setup_state(SetupState::InProgress);
@@ -558,15 +1137,21 @@ void TCPSocket::dequeue_for_retransmit()
 
 void TCPSocket::retransmit_packets()
 {
-    auto now = kgettimeofday();
+    auto now = TimeManagement::the().monotonic_time();
+
+    // A window probe that isn't accepted isn't lost, the peer just isn't reading yet.
+    if (is_probing_window()) {
+        probe_window(now);
+        return;
+    }
 
     // RFC6298 says we should have at least one second between retransmits. According to
     // RFC1122 we must do exponential backoff - even for SYN packets.
-    i64 retransmit_interval = 1;
-    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts; i++)
+    i64 retransmit_interval = m_retransmit_timeout.to_milliseconds();
+    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts && retransmit_interval < 60'000; i++)
         retransmit_interval *= 2;
 
-    if (m_last_retransmit_time > now - Time::from_seconds(retransmit_interval))
+    if (m_last_retransmit_time > now - Time::from_milliseconds(retransmit_interval))
         return;
 
     dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) handling retransmit", this);
@@ -581,46 +1166,111 @@ void TCPSocket::retransmit_packets()
         return;
     }
 
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        if (unacked_packets.packets.is_empty())
+            return;
+
+        // RFC 5681, section 3.1: A timeout means the network is in much worse shape than a few duplicate ACKs would suggest.
+        // Only the first one gets to halve the window though, later ones would just be halving what's left of it.
+        u32 mss = m_send_mss;
+        if (m_retransmit_attempts == 1)
+            m_slow_start_threshold = max<u32>(unacked_packets.size / 2, 2 * mss);
+        m_congestion_window = mss;
+        m_bytes_acked_in_congestion_avoidance = 0;
+        m_in_fast_recovery = false;
+        m_recovery_point = m_sequence_number;
+        m_duplicate_acks = 0;
+
+        // RFC 2018, section 8: The peer is allowed to discard data it has SACKed, so everything has to be sent again.
+        // Only the first segment goes out now, the rest follows as ACKs open up the congestion window again.
+        split_into_segments(unacked_packets);
+        for (auto& packet : unacked_packets.packets) {
+            packet.sacked = false;
+            packet.lost = true;
+        }
+        unacked_packets.pipe = 0;
+        retransmit_lost_packets(unacked_packets);
+    });
+}
+
+bool TCPSocket::is_probing_window() const
+{
+    if (m_send_window_size != 0)
+        return false;
+    return m_unacked_packets.with_shared([](auto& unacked_packets) {
+        return !unacked_packets.packets.is_empty() && unacked_packets.packets.first().is_window_probe;
+    });
+}
+
+void TCPSocket::probe_window(Time const& now)
+{
+    // The persist timer backs off just like the retransmit timer, but it doesn't count towards the retransmit limit.
+    // We only give up on a peer that stops answering our probes altogether.
+    i64 probe_interval = m_retransmit_timeout.to_milliseconds();
+    for (decltype(m_window_probe_attempts) i = 0; i < m_window_probe_attempts && probe_interval < 60'000; i++)
+        probe_interval *= 2;
+
+    if (m_last_window_probe_time > now - Time::from_milliseconds(probe_interval))
+        return;
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) probing closed window", this);
+
+    m_last_window_probe_time = now;
+    if (probe_interval < 60'000)
+        ++m_window_probe_attempts;
+
+    if (++m_unanswered_window_probes > maximum_retransmits) {
+        set_state(TCPSocket::State::Closed);
+        set_error(TCPSocket::Error::RetransmitTimeout);
+        set_setup_state(Socket::SetupState::Completed);
+        return;
+    }
+
     auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
     if (routing_decision.is_zero())
         return;
 
     m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-        for (auto& packet : unacked_packets.packets) {
-            packet.tx_counter++;
-
-            if constexpr (TCP_SOCKET_DEBUG) {
-                auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                    local_address(), local_port(),
-                    peer_address(), peer_port(),
-                    (tcp_packet.has_syn() ? "SYN " : ""),
-                    (tcp_packet.has_ack() ? "ACK " : ""),
-                    (tcp_packet.has_fin() ? "FIN " : ""),
-                    (tcp_packet.has_rst() ? "RST " : ""),
-                    tcp_packet.sequence_number(),
-                    tcp_packet.ack_number(),
-                    packet.tx_counter);
-            }
+        if (!unacked_packets.packets.is_empty())
+            resend_packet(unacked_packets.packets.first(), routing_decision);
+    });
+}
 
-            size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
-            if (ipv4_payload_offset != packet.ipv4_payload_offset) {
-                // FIXME: Add support for this. This can happen if after a route change
-                // we ended up on another adapter which doesn't have the same layer 2 type
-                // like the previous adapter.
-                VERIFY_NOT_REACHED();
-            }
+void TCPSocket::resend_packet(OutgoingPacket& packet, RoutingDecision& routing_decision)
+{
+    packet.tx_counter++;
+
+    if constexpr (TCP_SOCKET_DEBUG) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
 
-            auto packet_buffer = packet.buffer->bytes();
+    size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
+    if (ipv4_payload_offset != packet.ipv4_payload_offset) {
+        // FIXME: Add support for this. This can happen if after a route change
+        // we ended up on another adapter which doesn't have the same layer 2 type
+        // like the previous adapter.
+        VERIFY_NOT_REACHED();
+    }
 
-            routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
-                local_address(), routing_decision.next_hop, peer_address(),
-                IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
-            routing_decision.adapter->send_packet(packet_buffer);
-            m_packets_out++;
-            m_bytes_out += packet_buffer.size();
-        }
-    });
+    auto packet_buffer = packet.buffer->bytes();
+
+    routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
+        local_address(), routing_decision.next_hop, peer_address(),
+        IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
+    routing_decision.adapter->send_packet(packet_buffer, packet.offload);
+    m_packets_out++;
+    m_bytes_out += packet_buffer.size();
+    m_retransmitted_packets++;
 }
 
 bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size) const
@@ -631,11 +1281,27 @@ bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size)
     if (m_state == State::SynSent || m_state == State::SynReceived)
         return false;
 
-    if (!file_description.is_blocking())
+    if (send_budget() > 0)
         return true;
 
+    // With nothing in flight, we can always send a probe into a closed window.
     return m_unacked_packets.with_shared([&](auto& unacked_packets) {
-        return unacked_packets.size + size <= m_send_window_size;
+        return unacked_packets.packets.is_empty();
     });
 }
+
+ErrorOr<size_t> TCPSocket::recvfrom(OpenFileDescription& description, UserOrKernelBuffer& buffer, size_t buffer_length, int flags, Userspace<sockaddr*> user_addr, Userspace<socklen_t*> user_addr_length, Time& packet_timestamp)
+{
+    auto nreceived = TRY(IPv4Socket::recvfrom(description, buffer, buffer_length, flags, user_addr, user_addr_length, packet_timestamp));
+
+    // RFC 1122, section 4.2.3.3: Let the peer know once the window has opened up far enough to be worth it,
+    // otherwise a sender that filled it up completely would be left waiting for its retransmission timer.
+    MutexLocker locker(mutex());
+    if (nreceived > 0 && m_state == State::Established) {
+        size_t threshold = min(receive_buffer_capacity() / 2, static_cast<size_t>(m_send_mss));
+        if (receive_window() >= m_last_advertised_window + threshold)
+            (void)send_ack(true);
+    }
+    return nreceived;
+}
 }
@@ -11,8 +11,10 @@
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedList.h>
 #include <AK/WeakPtr.h>
+#include <Kernel/KBuffer.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/TCP.h>
 
 namespace Kernel {
 
@@ -126,7 +128,12 @@ public:
     void set_error(Error error) { m_error = error; }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
-    void set_sequence_number(u32 n) { m_sequence_number = n; }
+    void set_sequence_number(u32 n)
+    {
+        m_sequence_number = n;
+        m_send_unacknowledged = n;
+        m_recovery_point = n;
+    }
     u32 ack_number() const { return m_ack_number; }
     u32 sequence_number() const { return m_sequence_number; }
     u32 packets_in() const { return m_packets_in; }
@@ -134,15 +141,28 @@ public:
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
 
-    // FIXME: Make this configurable?
-    static constexpr u32 maximum_duplicate_acks = 5;
-    void set_duplicate_acks(u32 acks) { m_duplicate_acks = acks; }
-    u32 duplicate_acks() const { return m_duplicate_acks; }
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    u32 send_window_size() const { return m_send_window_size; }
+    Time smoothed_round_trip_time() const { return m_smoothed_round_trip_time; }
+    Time retransmit_timeout() const { return m_retransmit_timeout; }
+    u32 retransmitted_packets() const { return m_retransmitted_packets; }
+    bool is_sack_permitted() const { return m_sack_permitted; }
+    bool has_timestamps() const { return m_timestamps_enabled; }
+    bool has_window_scaling() const { return m_window_scaling_enabled; }
 
     ErrorOr<void> send_ack(bool allow_duplicate = false);
     ErrorOr<void> send_tcp_packet(u16 flags, UserOrKernelBuffer const* = nullptr, size_t = 0, RoutingDecision* = nullptr);
     void receive_tcp_packet(TCPPacket const&, u16 size);
 
+    // Picks up what the peer offered in its SYN (MSS, window scaling, SACK and timestamps).
+    void process_syn_options(TCPPacket const&);
+
+    // Segments that arrive ahead of ack_number() are held on to until the gap in front of them is filled.
+    bool has_out_of_order_segments() const { return !m_out_of_order_segments.is_empty(); }
+    void queue_out_of_order_segment(IPv4Packet const&, Time const& packet_timestamp);
+    void deliver_out_of_order_segments();
+
     bool should_delay_next_ack() const;
 
     static MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
@@ -161,6 +181,7 @@ public:
     virtual ErrorOr<void> close() override;
 
     virtual bool can_write(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> recvfrom(OpenFileDescription&, UserOrKernelBuffer&, size_t, int flags, Userspace<sockaddr*>, Userspace<socklen_t*>, Time&) override;
 
     static NetworkOrdered<u16> compute_tcp_checksum(IPv4Address const& source, IPv4Address const& destination, TCPPacket const&, u16 payload_size);
 
@@ -185,6 +206,30 @@ private:
     void enqueue_for_retransmit();
     void dequeue_for_retransmit();
 
+    struct OutgoingPacket;
+    struct UnackedPackets;
+
+    // The data offset field can't describe a header larger than 60 bytes.
+    static constexpr size_t maximum_tcp_options_size = 40;
+
+    size_t build_tcp_options(u16 flags, u16 mss, Bytes buffer) const;
+    size_t data_options_size() const;
+    size_t receive_window() const;
+    u16 advertised_window_size(u16 flags);
+    size_t send_budget() const;
+
+    void process_acknowledgement(TCPPacket const&, TCPOptions const&, size_t payload_size);
+    void process_sack_blocks(UnackedPackets&, TCPOptions const&);
+    void split_into_segments(UnackedPackets&);
+    void update_round_trip_time(Time sample);
+    void enter_fast_recovery(UnackedPackets&);
+    void mark_lost(UnackedPackets&, OutgoingPacket&);
+    void mark_sack_holes_lost(UnackedPackets&);
+    void retransmit_lost_packets(UnackedPackets&);
+    void resend_packet(OutgoingPacket&, RoutingDecision&);
+    bool is_probing_window() const;
+    void probe_window(Time const& now);
+
     WeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
@@ -204,26 +249,82 @@ private:
         size_t ipv4_payload_offset;
         WeakPtr<NetworkAdapter> adapter;
         int tx_counter { 0 };
+        u32 sequence_number { 0 };
+        u32 payload_size { 0 };
+        Time sent_time;
+        PacketOffload offload;
+        // The peer told us it has this one (RFC 2018).
+        bool sacked { false };
+        // We believe this one never made it and it's waiting to be sent again.
+        bool lost { false };
+        // A single byte sent into a closed window, to find out when it opens up again.
+        bool is_window_probe { false };
     };
 
     struct UnackedPackets {
         SinglyLinkedList<OutgoingPacket> packets;
+        // Payload bytes we've sent but haven't been acknowledged cumulatively.
         size_t size { 0 };
+        // Payload bytes we believe are still in the network, i.e. neither SACKed nor lost (the "pipe" from RFC 6675).
+        size_t pipe { 0 };
     };
 
     MutexProtected<UnackedPackets> m_unacked_packets;
 
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        u32 payload_size { 0 };
+        IPv4Address source_address;
+        u16 source_port { 0 };
+        Time timestamp;
+        NonnullOwnPtr<KBuffer> packet;
+    };
+
+    SinglyLinkedList<OutOfOrderSegment> m_out_of_order_segments;
+    size_t m_out_of_order_bytes { 0 };
+    u32 m_last_out_of_order_sequence_number { 0 };
+
+    // Congestion control, as in RFC 5681 with the NewReno modifications from RFC 6582.
+    static constexpr u32 duplicate_ack_threshold = 3;
     u32 m_duplicate_acks { 0 };
+    u32 m_send_unacknowledged { 0 };
+    u32 m_congestion_window { 0 };
+    u32 m_slow_start_threshold { NumericLimits<u32>::max() };
+    u32 m_bytes_acked_in_congestion_avoidance { 0 };
+    bool m_in_fast_recovery { false };
+    u32 m_recovery_point { 0 };
+
+    // Negotiated during the handshake.
+    static constexpr u16 default_mss = 536;
+    u16 m_send_mss { default_mss };
+    bool m_window_scaling_enabled { false };
+    u8 m_send_window_shift { 0 };
+    u8 m_receive_window_shift { 0 };
+    bool m_sack_permitted { false };
+    bool m_timestamps_enabled { false };
+    u32 m_timestamp_recent { 0 };
 
     u32 m_last_ack_number_sent { 0 };
     Time m_last_ack_sent_time;
+    u32 m_last_advertised_window { 0 };
 
     // FIXME: Make this configurable (sysctl)
     static constexpr u32 maximum_retransmits = 5;
     Time m_last_retransmit_time;
     u32 m_retransmit_attempts { 0 };
+    u32 m_retransmitted_packets { 0 };
+
+    // RFC 9293, section 3.8.6.1: The persist timer keeps probing a closed window for as long as the peer answers.
+    Time m_last_window_probe_time;
+    u32 m_window_probe_attempts { 0 };
+    u32 m_unanswered_window_probes { 0 };
+
+    // RFC 6298
+    bool m_has_round_trip_time_sample { false };
+    Time m_smoothed_round_trip_time;
+    Time m_round_trip_time_variance;
+    Time m_retransmit_timeout { Time::from_seconds(1) };
 
-    // FIXME: Parse window size TCP option from the peer
     u32 m_send_window_size { 64 * KiB };
 
     IntrusiveListNode<TCPSocket> m_retransmit_list_node;
@@ -99,6 +99,14 @@ ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, Threa
         return EINVAL;
 
     PerformanceEvent event;
+    TRY(build_event(event, pid, tid, ip, bp, type, lost_samples, arg1, arg2, arg3, arg4, arg5, arg6));
+    at(m_count++) = event;
+    return {};
+}
+
+ErrorOr<void> PerformanceEventBuffer::build_event(PerformanceEvent& event, ProcessID pid, ThreadID tid,
+    FlatPtr ip, FlatPtr bp, int type, u32 lost_samples, FlatPtr arg1, FlatPtr arg2, StringView arg3, FlatPtr arg4, u64 arg5, ErrorOr<FlatPtr> const& arg6)
+{
     event.type = type;
     event.lost_samples = lost_samples;
 
@@ -183,7 +191,6 @@ ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, Threa
     event.pid = pid.value();
     event.tid = tid.value();
     event.timestamp = TimeManagement::the().uptime_ms();
-    at(m_count++) = event;
     return {};
 }
 
@@ -194,6 +201,102 @@ PerformanceEvent& PerformanceEventBuffer::at(size_t index)
     return events[index];
 }
 
+template<typename Serializer>
+static ErrorOr<void> add_event_fields(Serializer& event_object, PerformanceEvent const& event, bool show_kernel_addresses, u32 lost_samples)
+{
+    switch (event.type) {
+    case PERF_EVENT_SAMPLE:
+        TRY(event_object.add("type", "sample"));
+        break;
+    case PERF_EVENT_MALLOC:
+        TRY(event_object.add("type", "malloc"));
+        TRY(event_object.add("ptr", static_cast<u64>(event.data.malloc.ptr)));
+        TRY(event_object.add("size", static_cast<u64>(event.data.malloc.size)));
+        break;
+    case PERF_EVENT_FREE:
+        TRY(event_object.add("type", "free"));
+        TRY(event_object.add("ptr", static_cast<u64>(event.data.free.ptr)));
+        break;
+    case PERF_EVENT_MMAP:
+        TRY(event_object.add("type", "mmap"));
+        TRY(event_object.add("ptr", static_cast<u64>(event.data.mmap.ptr)));
+        TRY(event_object.add("size", static_cast<u64>(event.data.mmap.size)));
+        TRY(event_object.add("name", event.data.mmap.name));
+        break;
+    case PERF_EVENT_MUNMAP:
+        TRY(event_object.add("type", "munmap"));
+        TRY(event_object.add("ptr", static_cast<u64>(event.data.munmap.ptr)));
+        TRY(event_object.add("size", static_cast<u64>(event.data.munmap.size)));
+        break;
+    case PERF_EVENT_PROCESS_CREATE:
+        TRY(event_object.add("type", "process_create"));
+        TRY(event_object.add("parent_pid", static_cast<u64>(event.data.process_create.parent_pid)));
+        TRY(event_object.add("executable", event.data.process_create.executable));
+        break;
+    case PERF_EVENT_PROCESS_EXEC:
+        TRY(event_object.add("type", "process_exec"));
+        TRY(event_object.add("executable", event.data.process_exec.executable));
+        break;
+    case PERF_EVENT_PROCESS_EXIT:
+        TRY(event_object.add("type", "process_exit"));
+        break;
+    case PERF_EVENT_THREAD_CREATE:
+        TRY(event_object.add("type", "thread_create"));
+        TRY(event_object.add("parent_tid", static_cast<u64>(event.data.thread_create.parent_tid)));
+        break;
+    case PERF_EVENT_THREAD_EXIT:
+        TRY(event_object.add("type", "thread_exit"));
+        break;
+    case PERF_EVENT_CONTEXT_SWITCH:
+        TRY(event_object.add("type", "context_switch"));
+        TRY(event_object.add("next_pid", static_cast<u64>(event.data.context_switch.next_pid)));
+        TRY(event_object.add("next_tid", static_cast<u64>(event.data.context_switch.next_tid)));
+        break;
+    case PERF_EVENT_KMALLOC:
+        TRY(event_object.add("type", "kmalloc"));
+        TRY(event_object.add("ptr", static_cast<u64>(event.data.kmalloc.ptr)));
+        TRY(event_object.add("size", static_cast<u64>(event.data.kmalloc.size)));
+        break;
+    case PERF_EVENT_KFREE:
+        TRY(event_object.add("type", "kfree"));
+        TRY(event_object.add("ptr", static_cast<u64>(event.data.kfree.ptr)));
+        TRY(event_object.add("size", static_cast<u64>(event.data.kfree.size)));
+        break;
+    case PERF_EVENT_PAGE_FAULT:
+        TRY(event_object.add("type", "page_fault"));
+        break;
+    case PERF_EVENT_SYSCALL:
+        TRY(event_object.add("type", "syscall"));
+        break;
+    case PERF_EVENT_SIGNPOST:
+        TRY(event_object.add("type"sv, "signpost"sv));
+        TRY(event_object.add("arg1"sv, event.data.signpost.arg1));
+        TRY(event_object.add("arg2"sv, event.data.signpost.arg2));
+        break;
+    case PERF_EVENT_READ:
+        TRY(event_object.add("type", "read"));
+        TRY(event_object.add("fd", event.data.read.fd));
+        TRY(event_object.add("size"sv, event.data.read.size));
+        TRY(event_object.add("filename_index"sv, event.data.read.filename_index));
+        TRY(event_object.add("start_timestamp"sv, event.data.read.start_timestamp));
+        TRY(event_object.add("success"sv, event.data.read.success));
+        break;
+    }
+    TRY(event_object.add("pid", event.pid));
+    TRY(event_object.add("tid", event.tid));
+    TRY(event_object.add("timestamp", event.timestamp));
+    TRY(event_object.add("lost_samples", lost_samples));
+    auto stack_array = TRY(event_object.add_array("stack"));
+    for (size_t j = 0; j < event.stack_size; ++j) {
+        auto address = event.stack[j];
+        if (!show_kernel_addresses && !Memory::is_user_address(VirtualAddress { address }))
+            address = 0xdeadc0de;
+        TRY(stack_array.add(address));
+    }
+    TRY(stack_array.finish());
+    return {};
+}
+
 template<typename Serializer>
 ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
 {
@@ -225,98 +328,9 @@ ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
         }
 
         auto event_object = TRY(array.add_object());
-        switch (event.type) {
-        case PERF_EVENT_SAMPLE:
-            TRY(event_object.add("type", "sample"));
-            break;
-        case PERF_EVENT_MALLOC:
-            TRY(event_object.add("type", "malloc"));
-            TRY(event_object.add("ptr", static_cast<u64>(event.data.malloc.ptr)));
-            TRY(event_object.add("size", static_cast<u64>(event.data.malloc.size)));
-            break;
-        case PERF_EVENT_FREE:
-            TRY(event_object.add("type", "free"));
-            TRY(event_object.add("ptr", static_cast<u64>(event.data.free.ptr)));
-            break;
-        case PERF_EVENT_MMAP:
-            TRY(event_object.add("type", "mmap"));
-            TRY(event_object.add("ptr", static_cast<u64>(event.data.mmap.ptr)));
-            TRY(event_object.add("size", static_cast<u64>(event.data.mmap.size)));
-            TRY(event_object.add("name", event.data.mmap.name));
-            break;
-        case PERF_EVENT_MUNMAP:
-            TRY(event_object.add("type", "munmap"));
-            TRY(event_object.add("ptr", static_cast<u64>(event.data.munmap.ptr)));
-            TRY(event_object.add("size", static_cast<u64>(event.data.munmap.size)));
-            break;
-        case PERF_EVENT_PROCESS_CREATE:
-            TRY(event_object.add("type", "process_create"));
-            TRY(event_object.add("parent_pid", static_cast<u64>(event.data.process_create.parent_pid)));
-            TRY(event_object.add("executable", event.data.process_create.executable));
-            break;
-        case PERF_EVENT_PROCESS_EXEC:
-            TRY(event_object.add("type", "process_exec"));
-            TRY(event_object.add("executable", event.data.process_exec.executable));
-            break;
-        case PERF_EVENT_PROCESS_EXIT:
-            TRY(event_object.add("type", "process_exit"));
-            break;
-        case PERF_EVENT_THREAD_CREATE:
-            TRY(event_object.add("type", "thread_create"));
-            TRY(event_object.add("parent_tid", static_cast<u64>(event.data.thread_create.parent_tid)));
-            break;
-        case PERF_EVENT_THREAD_EXIT:
-            TRY(event_object.add("type", "thread_exit"));
-            break;
-        case PERF_EVENT_CONTEXT_SWITCH:
-            TRY(event_object.add("type", "context_switch"));
-            TRY(event_object.add("next_pid", static_cast<u64>(event.data.context_switch.next_pid)));
-            TRY(event_object.add("next_tid", static_cast<u64>(event.data.context_switch.next_tid)));
-            break;
-        case PERF_EVENT_KMALLOC:
-            TRY(event_object.add("type", "kmalloc"));
-            TRY(event_object.add("ptr", static_cast<u64>(event.data.kmalloc.ptr)));
-            TRY(event_object.add("size", static_cast<u64>(event.data.kmalloc.size)));
-            break;
-        case PERF_EVENT_KFREE:
-            TRY(event_object.add("type", "kfree"));
-            TRY(event_object.add("ptr", static_cast<u64>(event.data.kfree.ptr)));
-            TRY(event_object.add("size", static_cast<u64>(event.data.kfree.size)));
-            break;
-        case PERF_EVENT_PAGE_FAULT:
-            TRY(event_object.add("type", "page_fault"));
-            break;
-        case PERF_EVENT_SYSCALL:
-            TRY(event_object.add("type", "syscall"));
-            break;
-        case PERF_EVENT_SIGNPOST:
-            TRY(event_object.add("type"sv, "signpost"sv));
-            TRY(event_object.add("arg1"sv, event.data.signpost.arg1));
-            TRY(event_object.add("arg2"sv, event.data.signpost.arg2));
-            break;
-        case PERF_EVENT_READ:
-            TRY(event_object.add("type", "read"));
-            TRY(event_object.add("fd", event.data.read.fd));
-            TRY(event_object.add("size"sv, event.data.read.size));
-            TRY(event_object.add("filename_index"sv, event.data.read.filename_index));
-            TRY(event_object.add("start_timestamp"sv, event.data.read.start_timestamp));
-            TRY(event_object.add("success"sv, event.data.read.success));
-            break;
-        }
-        TRY(event_object.add("pid", event.pid));
-        TRY(event_object.add("tid", event.tid));
-        TRY(event_object.add("timestamp", event.timestamp));
-        TRY(event_object.add("lost_samples", seen_first_sample ? event.lost_samples : 0));
+        TRY(add_event_fields(event_object, event, show_kernel_addresses, seen_first_sample ? event.lost_samples : 0));
         if (event.type == PERF_EVENT_SAMPLE)
             seen_first_sample = true;
-        auto stack_array = TRY(event_object.add_array("stack"));
-        for (size_t j = 0; j < event.stack_size; ++j) {
-            auto address = event.stack[j];
-            if (!show_kernel_addresses && !Memory::is_user_address(VirtualAddress { address }))
-                address = 0xdeadc0de;
-            TRY(stack_array.add(address));
-        }
-        TRY(stack_array.finish());
         TRY(event_object.finish());
     }
     TRY(array.finish());
@@ -330,6 +344,16 @@ ErrorOr<void> PerformanceEventBuffer::to_json(KBufferBuilder& builder) const
     return to_json_impl(object);
 }
 
+ErrorOr<void> PerformanceEventBuffer::event_to_json(KBufferBuilder& builder, PerformanceEvent const& event, bool show_kernel_addresses, Optional<u32> processor)
+{
+    auto event_object = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(add_event_fields(event_object, event, show_kernel_addresses, event.lost_samples));
+    if (processor.has_value())
+        TRY(event_object.add("processor", processor.value()));
+    TRY(event_object.finish());
+    return {};
+}
+
 OwnPtr<PerformanceEventBuffer> PerformanceEventBuffer::try_create_with_size(size_t buffer_size)
 {
     auto buffer_or_error = KBuffer::try_create_with_size(buffer_size, Memory::Region::Access::ReadWrite, "Performance events", AllocationStrategy::AllocateNow);
@@ -130,6 +130,11 @@ public:
 
     ErrorOr<void> to_json(KBufferBuilder&) const;
 
+    // Fills in an event without storing it anywhere, for users that keep their own storage.
+    static ErrorOr<void> build_event(PerformanceEvent&, ProcessID, ThreadID, FlatPtr ip, FlatPtr bp, int type, u32 lost_samples,
+        FlatPtr arg1, FlatPtr arg2, StringView arg3, FlatPtr arg4 = 0, u64 arg5 = {}, ErrorOr<FlatPtr> const& arg6 = 0);
+    static ErrorOr<void> event_to_json(KBufferBuilder&, PerformanceEvent const&, bool show_kernel_addresses, Optional<u32> processor = {});
+
     ErrorOr<void> add_process(Process const&, ProcessEventType event_type);
 
     ErrorOr<FlatPtr> register_string(NonnullOwnPtr<KString>);
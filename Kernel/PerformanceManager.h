@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <Kernel/Devices/PerformanceEventStreamDevice.h>
 #include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/Thread.h>
@@ -84,6 +85,8 @@ public:
     {
         if (current_thread.is_profiling_suppressed())
             return;
+        if (PerformanceEventStreamDevice::is_streaming())
+            PerformanceEventStreamDevice::append_context_switch(current_thread, next_thread);
         if (auto* event_buffer = current_thread.process().current_perf_events_buffer()) {
             [[maybe_unused]] auto res = event_buffer->append(PERF_EVENT_CONTEXT_SWITCH, next_thread.pid().value(), next_thread.tid().value(), nullptr);
         }
@@ -272,6 +272,9 @@ public:
     ErrorOr<FlatPtr> sys$create_inode_watcher(u32 flags);
     ErrorOr<FlatPtr> sys$inode_watcher_add_watch(Userspace<Syscall::SC_inode_watcher_add_watch_params const*> user_params);
     ErrorOr<FlatPtr> sys$inode_watcher_remove_watch(int fd, int wd);
+    ErrorOr<FlatPtr> sys$epoll_create1(int flags);
+    ErrorOr<FlatPtr> sys$epoll_ctl(Userspace<Syscall::SC_epoll_ctl_params const*>);
+    ErrorOr<FlatPtr> sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*>);
     ErrorOr<FlatPtr> sys$dbgputstr(Userspace<char const*>, size_t);
     ErrorOr<FlatPtr> sys$dump_backtrace();
     ErrorOr<FlatPtr> sys$gettid();
@@ -297,6 +300,8 @@ public:
     ErrorOr<FlatPtr> sys$readv(int fd, Userspace<const struct iovec*> iov, int iov_count);
     ErrorOr<FlatPtr> sys$write(int fd, Userspace<u8 const*>, size_t);
     ErrorOr<FlatPtr> sys$writev(int fd, Userspace<const struct iovec*> iov, int iov_count);
+    ErrorOr<FlatPtr> sys$sendfile(Userspace<Syscall::SC_sendfile_params const*>);
+    ErrorOr<FlatPtr> sys$splice(Userspace<Syscall::SC_splice_params const*>);
     ErrorOr<FlatPtr> sys$fstat(int fd, Userspace<stat*>);
     ErrorOr<FlatPtr> sys$stat(Userspace<Syscall::SC_stat_params const*>);
     ErrorOr<FlatPtr> sys$lseek(int fd, Userspace<off_t*>, int whence);
@@ -549,6 +554,7 @@ private:
 
     ErrorOr<void> do_exec(NonnullRefPtr<OpenFileDescription> main_program_description, NonnullOwnPtrVector<KString> arguments, NonnullOwnPtrVector<KString> environment, RefPtr<OpenFileDescription> interpreter_description, Thread*& new_main_thread, u32& prev_flags, const ElfW(Ehdr) & main_program_header);
     ErrorOr<FlatPtr> do_write(OpenFileDescription&, UserOrKernelBuffer const&, size_t);
+    ErrorOr<FlatPtr> do_transfer(OpenFileDescription& source, Optional<off_t>& source_offset, OpenFileDescription& destination, Optional<off_t>& destination_offset, size_t count, bool nonblocking);
 
     ErrorOr<FlatPtr> do_statvfs(FileSystem const& path, Custody const*, statvfs* buf);
 
@@ -72,6 +72,15 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
+u32 Scheduler::scheduling_processor_count()
+{
+#if SCHEDULE_ON_ALL_PROCESSORS
+    return Processor::count();
+#else
+    return 1;
+#endif
+}
+
 Thread& Scheduler::pull_next_runnable_thread()
 {
     auto affinity_mask = 1u << Processor::current_id();
@@ -169,7 +178,7 @@ void Scheduler::enqueue_runnable_thread(Thread& thread)
     VERIFY(g_scheduler_lock.is_locked_by_current_processor());
     if (thread.is_idle_thread())
         return;
-    auto priority = thread_priority_to_priority_index(thread.priority());
+    auto priority = thread_priority_to_priority_index(thread.effective_priority());
 
     g_ready_queues->with([&](auto& ready_queues) {
         VERIFY(thread.m_runnable_priority < 0);
@@ -451,6 +460,13 @@ void Scheduler::timer_tick(RegisterState const& regs)
     VERIFY(current_thread->current_trap());
     VERIFY(current_thread->current_trap()->regs == &regs);
 
+    // Every processor samples itself for /dev/perf, unlike the profile timer.
+    if (PerformanceEventStreamDevice::is_streaming()) {
+        if (!current_thread->is_idle_thread())
+            PerformanceEventStreamDevice::append_cpu_sample(*current_thread, regs);
+        PerformanceEventStreamDevice::notify_reader_if_needed();
+    }
+
 #if !SCHEDULE_ON_ALL_PROCESSORS
     if (!Processor::is_bootstrap_processor())
         return; // TODO: This prevents scheduling on other CPUs!
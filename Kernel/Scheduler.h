@@ -55,6 +55,7 @@ public:
     static bool is_initialized();
     static TotalTimeScheduled get_total_time_scheduled();
     static void add_time_scheduled(u64, bool);
+    static u32 scheduling_processor_count();
     static u64 (*current_time)();
 };
 
@@ -33,6 +33,8 @@ public:
     virtual bool shutdown() override;
     virtual size_t devices_count() const override;
     virtual void start_request(ATADevice const&, AsyncBlockDeviceRequest&) override;
+    // Every port keeps its own queue of requests, and may have many commands in flight with NCQ.
+    virtual bool can_start_requests_concurrently() const override { return true; }
     virtual void complete_current_request(AsyncDeviceRequest::RequestResult) override;
 
     const AHCI::HBADefinedCapabilities& hba_capabilities() const { return m_capabilities; };
@@ -97,41 +97,71 @@ void AHCIPort::handle_interrupt()
         });
         return;
     }
-    if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS)) {
-        m_wait_for_completion = false;
-
-        // Now schedule reading/writing the buffer as soon as we leave the irq handler.
-        // This is important so that we can safely access the buffers, which could
-        // trigger page faults
-        if (!m_current_request) {
-            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled, probably identify request", representative_port_index());
-        } else {
-            g_io_work->queue([this]() {
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled", representative_port_index());
-                MutexLocker locker(m_lock);
-                VERIFY(m_current_request);
-                VERIFY(m_current_scatter_list);
-                if (!m_connected_device) {
-                    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
-                    complete_current_request(AsyncDeviceRequest::Failure);
-                    return;
-                }
-                if (m_current_request->request_type() == AsyncBlockDeviceRequest::Read) {
-                    if (auto result = m_current_request->write_to_buffer(m_current_request->buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * m_current_request->block_count()); result.is_error()) {
-                        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
-                        m_current_scatter_list = nullptr;
-                        complete_current_request(AsyncDeviceRequest::MemoryFault);
-                        return;
-                    }
+    // Queued commands report their completion with a Set Device Bits FIS, all others with a D2H Register (or PIO Setup) FIS.
+    bool commands_may_have_completed = m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::SDB);
+
+    // Note: Clear the interrupt status before looking at which commands completed, so we
+    // get another interrupt for anything that completes while we're looking.
+    m_interrupt_status.clear();
+
+    if (!commands_may_have_completed)
+        return;
+
+    // Commands may complete in any order, so find all the ones that the HBA is done with.
+    u32 completed_command_slots;
+    {
+        SpinlockLocker lock(m_hard_lock);
+        u32 active_command_slots = m_port_registers.ci | m_port_registers.sact;
+        completed_command_slots = m_issued_command_slots & ~active_command_slots;
+        m_issued_command_slots &= ~completed_command_slots;
+    }
+    if (completed_command_slots == 0) {
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled, probably identify request", representative_port_index());
+        return;
+    }
+
+    // Now schedule reading/writing the buffers as soon as we leave the irq handler.
+    // This is important so that we can safely access the buffers, which could
+    // trigger page faults
+    g_io_work->queue([this, completed_command_slots]() {
+        complete_command_slots(completed_command_slots);
+    });
+}
+
+void AHCIPort::complete_command_slots(u32 completed_command_slots)
+{
+    Vector<FinishedRequest> finished_requests;
+    {
+        MutexLocker locker(m_lock);
+        for (u8 index = 0; index < m_command_slots_count; index++) {
+            if (!(completed_command_slots & (1u << index)))
+                continue;
+            auto& slot = m_command_slots[index];
+            VERIFY(slot.request);
+            VERIFY(slot.scatter_list);
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request in command slot {} handled", representative_port_index(), index);
+
+            auto& request = *slot.request;
+            auto result = AsyncDeviceRequest::Success;
+            if (!m_connected_device) {
+                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, device is gone.", representative_port_index());
+                result = AsyncDeviceRequest::Failure;
+            } else if (request.request_type() == AsyncBlockDeviceRequest::Read) {
+                if (auto read_result = request.write_to_buffer(request.buffer(), slot.scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count()); read_result.is_error()) {
+                    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
+                    result = AsyncDeviceRequest::MemoryFault;
                 }
-                m_current_scatter_list = nullptr;
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
-                complete_current_request(AsyncDeviceRequest::Success);
-            });
+            }
+            finished_requests.append({ request, result });
+            release_command_slot(index);
         }
+        // Some command slots were freed up, so whoever had to wait can go now.
+        start_pending_requests(finished_requests);
     }
 
-    m_interrupt_status.clear();
+    // NOTE: Completing a request might start another one on this port, so we must not hold the lock anymore.
+    for (auto& finished_request : finished_requests)
+        finished_request.request->complete(finished_request.result);
 }
 
 bool AHCIPort::is_interrupts_enabled() const
@@ -141,13 +171,28 @@ bool AHCIPort::is_interrupts_enabled() const
 
 void AHCIPort::recover_from_fatal_error()
 {
-    MutexLocker locker(m_lock);
-    SpinlockLocker lock(m_hard_lock);
-    dmesgln("{}: AHCI Port {} fatal error, shutting down!", m_parent_handler->hba_controller()->pci_address(), representative_port_index());
-    dmesgln("{}: AHCI Port {} fatal error, SError {}", m_parent_handler->hba_controller()->pci_address(), representative_port_index(), (u32)m_port_registers.serr);
-    stop_command_list_processing();
-    stop_fis_receiving();
-    m_interrupt_enable.clear();
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>> failed_requests;
+    {
+        MutexLocker locker(m_lock);
+        SpinlockLocker lock(m_hard_lock);
+        dmesgln("{}: AHCI Port {} fatal error, shutting down!", m_parent_handler->hba_controller()->pci_address(), representative_port_index());
+        dmesgln("{}: AHCI Port {} fatal error, SError {}", m_parent_handler->hba_controller()->pci_address(), representative_port_index(), (u32)m_port_registers.serr);
+        stop_command_list_processing();
+        stop_fis_receiving();
+        m_interrupt_enable.clear();
+
+        // None of the commands in flight are going to complete anymore, and nothing else will be started.
+        failed_requests = move(m_pending_requests);
+        m_issued_command_slots = 0;
+        for (u8 index = 0; index < m_command_slots_count; index++) {
+            if (!m_command_slots[index].request)
+                continue;
+            failed_requests.append(*m_command_slots[index].request);
+            release_command_slot(index);
+        }
+    }
+    for (auto& request : failed_requests)
+        request->complete(AsyncDeviceRequest::Failure);
 }
 
 void AHCIPort::eject()
@@ -307,6 +352,9 @@ bool AHCIPort::initialize()
             m_port_registers.cmd = m_port_registers.cmd | (1 << 24);
         }
 
+        if (try_to_enable_native_command_queuing(*identify_block))
+            dmesgln("AHCI Port {}: Native command queuing enabled with {} command slots", representative_port_index(), m_command_slots_count);
+
         dmesgln("AHCI Port {}: Device found, Capacity={}, Bytes per logical sector={}, Bytes per physical sector={}", representative_port_index(), max_addressable_sector * logical_sector_size, logical_sector_size, physical_sector_size);
 
         // FIXME: We don't support ATAPI devices yet, so for now we don't "create" them
@@ -319,6 +367,41 @@ bool AHCIPort::initialize()
     return true;
 }
 
+bool AHCIPort::try_to_enable_native_command_queuing(ATAIdentifyBlock const& identify_block)
+{
+    VERIFY(m_lock.is_locked());
+    m_command_slots_count = 1;
+    m_native_command_queuing_enabled = false;
+
+    // Both the HBA and the device have to support NCQ, which lets the device reorder commands so seeks can overlap.
+    if (is_atapi_attached() || !m_parent_handler->hba_capabilities().native_command_queuing_supported)
+        return false;
+    if (!(identify_block.serial_ata_capabilities & (1 << 8)))
+        return false;
+    size_t device_queue_depth = (identify_block.queue_depth & 0x1f) + 1;
+    size_t command_slots_count = min(min(device_queue_depth, m_parent_handler->hba_capabilities().max_command_list_entries_count), max_command_slots_count);
+    if (command_slots_count < 2)
+        return false;
+
+    // Every command slot needs its own command table and DMA buffer.
+    while (m_command_table_pages.size() < command_slots_count) {
+        auto page_or_error = MM.allocate_supervisor_physical_page();
+        if (page_or_error.is_error())
+            return false;
+        m_command_table_pages.append(page_or_error.release_value());
+    }
+    while (m_dma_buffers.size() < command_slots_count * dma_pages_per_command_slot) {
+        auto page_or_error = MM.allocate_supervisor_physical_page();
+        if (page_or_error.is_error())
+            return false;
+        m_dma_buffers.append(page_or_error.release_value());
+    }
+
+    m_command_slots_count = command_slots_count;
+    m_native_command_queuing_enabled = true;
+    return true;
+}
+
 char const* AHCIPort::try_disambiguate_sata_status()
 {
     switch (m_port_registers.ssts & 0xf) {
@@ -438,25 +521,28 @@ size_t AHCIPort::calculate_descriptors_count(size_t block_count) const
 {
     VERIFY(m_connected_device);
     size_t needed_dma_regions_count = Memory::page_round_up((block_count * m_connected_device->block_size())).value() / PAGE_SIZE;
-    VERIFY(needed_dma_regions_count <= m_dma_buffers.size());
+    VERIFY(needed_dma_regions_count <= dma_pages_per_command_slot);
     return needed_dma_regions_count;
 }
 
-Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request)
+Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_list(u8 command_slot_index)
 {
     VERIFY(m_lock.is_locked());
+    auto& slot = m_command_slots[command_slot_index];
+    VERIFY(slot.request);
+    auto& request = *slot.request;
     VERIFY(request.block_count() > 0);
 
     NonnullRefPtrVector<Memory::PhysicalPage> allocated_dma_regions;
     for (size_t index = 0; index < calculate_descriptors_count(request.block_count()); index++) {
-        allocated_dma_regions.append(m_dma_buffers.at(index));
+        allocated_dma_regions.append(m_dma_buffers.at(command_slot_index * dma_pages_per_command_slot + index));
     }
 
-    m_current_scatter_list = Memory::ScatterGatherList::try_create(request, allocated_dma_regions.span(), m_connected_device->block_size());
-    if (!m_current_scatter_list)
+    slot.scatter_list = Memory::ScatterGatherList::try_create(request, allocated_dma_regions.span(), m_connected_device->block_size());
+    if (!slot.scatter_list)
         return AsyncDeviceRequest::Failure;
     if (request.request_type() == AsyncBlockDeviceRequest::Write) {
-        if (auto result = request.read_from_buffer(request.buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count()); result.is_error()) {
+        if (auto result = request.read_from_buffer(request.buffer(), slot.scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count()); result.is_error()) {
             return AsyncDeviceRequest::MemoryFault;
         }
     }
@@ -465,36 +551,52 @@ Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_li
 
 void AHCIPort::start_request(AsyncBlockDeviceRequest& request)
 {
-    MutexLocker locker(m_lock);
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request start", representative_port_index());
-    VERIFY(!m_current_request);
-    VERIFY(!m_current_scatter_list);
-
-    m_current_request = request;
-
-    auto result = prepare_and_set_scatter_list(request);
-    if (result.has_value()) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        locker.unlock();
-        complete_current_request(result.value());
-        return;
+    Vector<FinishedRequest> failed_requests;
+    {
+        MutexLocker locker(m_lock);
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request start", representative_port_index());
+        if (m_pending_requests.try_append(request).is_error()) {
+            locker.unlock();
+            request.complete(AsyncDeviceRequest::Failure);
+            return;
+        }
+        start_pending_requests(failed_requests);
     }
+    for (auto& failed_request : failed_requests)
+        failed_request.request->complete(failed_request.result);
+}
 
-    auto success = access_device(request.request_type(), request.block_index(), request.block_count());
-    if (!success) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        locker.unlock();
-        complete_current_request(AsyncDeviceRequest::Failure);
-        return;
+void AHCIPort::start_pending_requests(Vector<FinishedRequest>& failed_requests)
+{
+    VERIFY(m_lock.is_locked());
+    while (!m_pending_requests.is_empty()) {
+        auto command_slot_index = try_to_find_unused_command_header();
+        if (!command_slot_index.has_value())
+            return;
+
+        auto request = m_pending_requests.take_first();
+        auto& slot = m_command_slots[command_slot_index.value()];
+        VERIFY(!slot.request);
+        slot.request = request;
+        m_used_command_slots |= 1u << command_slot_index.value();
+
+        auto result = prepare_and_set_scatter_list(command_slot_index.value());
+        if (!result.has_value() && !access_device(command_slot_index.value()))
+            result = AsyncDeviceRequest::Failure;
+        if (result.has_value()) {
+            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
+            release_command_slot(command_slot_index.value());
+            failed_requests.append({ move(request), result.value() });
+        }
     }
 }
 
-void AHCIPort::complete_current_request(AsyncDeviceRequest::RequestResult result)
+void AHCIPort::release_command_slot(u8 command_slot_index)
 {
-    VERIFY(m_current_request);
-    auto current_request = m_current_request;
-    m_current_request.clear();
-    current_request->complete(result);
+    auto& slot = m_command_slots[command_slot_index];
+    slot.request.clear();
+    slot.scatter_list = nullptr;
+    m_used_command_slots &= ~(1u << command_slot_index);
 }
 
 bool AHCIPort::spin_until_ready() const
@@ -513,35 +615,40 @@ bool AHCIPort::spin_until_ready() const
     return true;
 }
 
-bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64 lba, u8 block_count)
+bool AHCIPort::access_device(u8 command_slot_index)
 {
     VERIFY(m_connected_device);
     VERIFY(is_operable());
     VERIFY(m_lock.is_locked());
-    VERIFY(m_current_scatter_list);
+    auto& slot = m_command_slots[command_slot_index];
+    VERIFY(slot.request);
+    VERIFY(slot.scatter_list);
     SpinlockLocker lock(m_hard_lock);
 
+    auto direction = slot.request->request_type();
+    u64 lba = slot.request->block_index();
+    u16 block_count = slot.request->block_count();
+
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count);
-    if (!spin_until_ready())
+    // Note: Queued commands don't keep the device busy, so only wait if the device can't take another command.
+    if (!m_native_command_queuing_enabled && !spin_until_ready())
         return false;
 
-    auto unused_command_header = try_to_find_unused_command_header();
-    VERIFY(unused_command_header.has_value());
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()].paddr().get();
-    command_list_entries[unused_command_header.value()].ctbau = 0;
-    command_list_entries[unused_command_header.value()].prdbc = 0;
-    command_list_entries[unused_command_header.value()].prdtl = m_current_scatter_list->scatters_count();
+    command_list_entries[command_slot_index].ctba = m_command_table_pages[command_slot_index].paddr().get();
+    command_list_entries[command_slot_index].ctbau = 0;
+    command_list_entries[command_slot_index].prdbc = 0;
+    command_list_entries[command_slot_index].prdtl = slot.scatter_list->scatters_count();
 
     // Note: we must set the correct Dword count in this register. Real hardware
     // AHCI controllers do care about this field! QEMU doesn't care if we don't
     // set the correct CFL field in this register, real hardware will set an
     // handshake error bit in PxSERR register if CFL is incorrect.
-    command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
+    command_list_entries[command_slot_index].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba={:#08x}, ctbau={:#08x}, prdbc={:#08x}, prdtl={:#04x}, attributes={:#04x}", representative_port_index(), (u32)command_list_entries[unused_command_header.value()].ctba, (u32)command_list_entries[unused_command_header.value()].ctbau, (u32)command_list_entries[unused_command_header.value()].prdbc, (u16)command_list_entries[unused_command_header.value()].prdtl, (u16)command_list_entries[unused_command_header.value()].attributes);
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba={:#08x}, ctbau={:#08x}, prdbc={:#08x}, prdtl={:#04x}, attributes={:#04x}", representative_port_index(), (u32)command_list_entries[command_slot_index].ctba, (u32)command_list_entries[command_slot_index].ctbau, (u32)command_list_entries[command_slot_index].prdbc, (u16)command_list_entries[command_slot_index].prdtl, (u16)command_list_entries[command_slot_index].attributes);
 
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()].paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)).value(), "AHCI Command Table", Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No).release_value();
+    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[command_slot_index].paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)).value(), "AHCI Command Table", Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No).release_value();
     auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
 
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Allocated command table at {}", representative_port_index(), command_table_region->vaddr());
@@ -550,7 +657,7 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
 
     size_t scatter_entry_index = 0;
     size_t data_transfer_count = (block_count * m_connected_device->block_size());
-    for (auto scatter_page : m_current_scatter_list->vmobject().physical_pages()) {
+    for (auto scatter_page : slot.scatter_list->vmobject().physical_pages()) {
         VERIFY(data_transfer_count != 0);
         VERIFY(scatter_page);
         dbgln_if(AHCI_DEBUG, "AHCI Port {}: Add a transfer scatter entry @ {}", representative_port_index(), scatter_page->paddr());
@@ -574,6 +681,11 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     if (is_atapi_attached()) {
         fis.command = ATA_CMD_PACKET;
         TODO();
+    } else if (m_native_command_queuing_enabled) {
+        if (direction == AsyncBlockDeviceRequest::RequestType::Write)
+            fis.command = ATA_CMD_WRITE_FPDMA_QUEUED;
+        else
+            fis.command = ATA_CMD_READ_FPDMA_QUEUED;
     } else {
         if (direction == AsyncBlockDeviceRequest::RequestType::Write)
             fis.command = ATA_CMD_WRITE_DMA_EXT;
@@ -592,17 +704,27 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     fis.lba_low[0] = lba & 0xff;
     fis.lba_low[1] = (lba >> 8) & 0xff;
     fis.lba_low[2] = (lba >> 16) & 0xff;
-    fis.count = (block_count);
+    if (m_native_command_queuing_enabled) {
+        // For queued commands, the sector count goes into the features register, and the count register holds the tag.
+        fis.features_low = block_count & 0xff;
+        fis.features_high = (block_count >> 8) & 0xff;
+        fis.count = command_slot_index << 3;
+    } else {
+        fis.count = (block_count);
 
-    // The below loop waits until the port is no longer busy before issuing a new command
-    if (!spin_until_ready())
-        return false;
+        // The below loop waits until the port is no longer busy before issuing a new command
+        if (!spin_until_ready())
+            return false;
+    }
 
     full_memory_barrier();
-    mark_command_header_ready_to_process(unused_command_header.value());
+    // Note: The tag has to be marked as active before the command is issued.
+    if (m_native_command_queuing_enabled)
+        m_port_registers.sact = 1u << command_slot_index;
+    mark_command_header_ready_to_process(command_slot_index);
     full_memory_barrier();
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} @ {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, m_dma_buffers[0].paddr());
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} @ {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, m_dma_buffers[command_slot_index * dma_pages_per_command_slot].paddr());
     return true;
 }
 
@@ -703,8 +825,9 @@ bool AHCIPort::shutdown()
 Optional<u8> AHCIPort::try_to_find_unused_command_header()
 {
     VERIFY(m_lock.is_locked());
-    u32 commands_issued = m_port_registers.ci;
-    for (size_t index = 0; index < 32; index++) {
+    // Note: A command slot stays in use until we've handled its completion, even if the HBA is already done with it.
+    u32 commands_issued = m_port_registers.ci | m_port_registers.sact | m_used_command_slots;
+    for (size_t index = 0; index < m_command_slots_count; index++) {
         if (!(commands_issued & 1)) {
             dbgln_if(AHCI_DEBUG, "AHCI Port {}: unused command header at index {}", representative_port_index(), index);
             return index;
@@ -723,13 +846,13 @@ void AHCIPort::start_command_list_processing() const
     m_port_registers.cmd = m_port_registers.cmd | 1;
 }
 
-void AHCIPort::mark_command_header_ready_to_process(u8 command_header_index) const
+void AHCIPort::mark_command_header_ready_to_process(u8 command_header_index)
 {
     VERIFY(m_lock.is_locked());
     VERIFY(m_hard_lock.is_locked());
     VERIFY(is_operable());
-    VERIFY(!m_wait_for_completion);
-    m_wait_for_completion = true;
+    VERIFY(!(m_issued_command_slots & (1u << command_header_index)));
+    m_issued_command_slots |= 1u << command_header_index;
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Marking command header at index {} as ready to process.", representative_port_index(), command_header_index);
     m_port_registers.ci = 1 << command_header_index;
 }
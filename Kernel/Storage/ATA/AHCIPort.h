@@ -6,8 +6,10 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <AK/Weakable.h>
 #include <Kernel/Devices/Device.h>
@@ -22,6 +24,7 @@
 #include <Kernel/Sections.h>
 #include <Kernel/Storage/ATA/AHCI.h>
 #include <Kernel/Storage/ATA/AHCIPortHandler.h>
+#include <Kernel/Storage/ATA/ATA.h>
 #include <Kernel/Storage/ATA/ATADevice.h>
 #include <Kernel/WaitQueue.h>
 
@@ -70,11 +73,19 @@ private:
     ALWAYS_INLINE void spin_up() const;
     ALWAYS_INLINE void power_on() const;
 
+    struct FinishedRequest {
+        NonnullRefPtr<AsyncBlockDeviceRequest> request;
+        AsyncDeviceRequest::RequestResult result;
+    };
+
     void start_request(AsyncBlockDeviceRequest&);
-    void complete_current_request(AsyncDeviceRequest::RequestResult);
-    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u8 block_count);
+    void start_pending_requests(Vector<FinishedRequest>& failed_requests);
+    void complete_command_slots(u32 completed_command_slots);
+    void release_command_slot(u8 command_slot_index);
+    bool access_device(u8 command_slot_index);
     size_t calculate_descriptors_count(size_t block_count) const;
-    [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request);
+    [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(u8 command_slot_index);
+    bool try_to_enable_native_command_queuing(ATAIdentifyBlock const&);
 
     ALWAYS_INLINE bool is_interrupts_enabled() const;
 
@@ -83,7 +94,7 @@ private:
     bool identify_device();
 
     ALWAYS_INLINE void start_command_list_processing() const;
-    ALWAYS_INLINE void mark_command_header_ready_to_process(u8 command_header_index) const;
+    ALWAYS_INLINE void mark_command_header_ready_to_process(u8 command_header_index);
     ALWAYS_INLINE void stop_command_list_processing() const;
 
     ALWAYS_INLINE void start_fis_receiving() const;
@@ -103,11 +114,26 @@ private:
     // Data members
 
     EntropySource m_entropy_source;
-    RefPtr<AsyncBlockDeviceRequest> m_current_request;
     Spinlock m_hard_lock;
     Mutex m_lock { "AHCIPort" };
 
-    mutable bool m_wait_for_completion { false };
+    // Every command slot gets its own DMA buffer, so a request never has to wait for another one to free it.
+    static constexpr size_t dma_pages_per_command_slot = 1;
+    static constexpr size_t max_command_slots_count = 32;
+
+    struct CommandSlot {
+        RefPtr<AsyncBlockDeviceRequest> request;
+        RefPtr<Memory::ScatterGatherList> scatter_list;
+    };
+    Array<CommandSlot, max_command_slots_count> m_command_slots;
+    // Requests that didn't find a free command slot yet, in the order they came in.
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>> m_pending_requests;
+    // Slots that belong to a request, from the moment it gets one until it's completed.
+    u32 m_used_command_slots { 0 };
+    // Slots the HBA has been told to process, and that we haven't seen it finish yet.
+    u32 m_issued_command_slots { 0 };
+    size_t m_command_slots_count { 1 };
+    bool m_native_command_queuing_enabled { false };
 
     NonnullRefPtrVector<Memory::PhysicalPage> m_dma_buffers;
     NonnullRefPtrVector<Memory::PhysicalPage> m_command_table_pages;
@@ -122,7 +148,6 @@ private:
     AHCI::PortInterruptStatusBitField m_interrupt_status;
     AHCI::PortInterruptEnableBitField m_interrupt_enable;
 
-    RefPtr<Memory::ScatterGatherList> m_current_scatter_list;
     bool m_disabled_by_firmware { false };
 };
 }
@@ -22,6 +22,8 @@ class ATAController
     , public Weakable<ATAController> {
 public:
     virtual void start_request(ATADevice const&, AsyncBlockDeviceRequest&) = 0;
+    // Controllers that queue up requests for each device themselves can take new ones while others are still in flight.
+    virtual bool can_start_requests_concurrently() const { return false; }
 
 protected:
     ATAController() = default;
@@ -30,4 +30,10 @@ void ATADevice::start_request(AsyncBlockDeviceRequest& request)
     controller->start_request(*this, request);
 }
 
+bool ATADevice::can_start_requests_concurrently() const
+{
+    auto controller = m_controller.strong_ref();
+    return controller && controller->can_start_requests_concurrently();
+}
+
 }
@@ -38,6 +38,9 @@ public:
 protected:
     ATADevice(ATAController const&, Address, MinorNumber, u16, u16, u64, NonnullOwnPtr<KString>);
 
+    // ^Device
+    virtual bool can_start_requests_concurrently() const override;
+
     WeakPtr<ATAController> m_controller;
     const Address m_ata_address;
     const u16 m_capabilities;
@@ -37,8 +37,6 @@ UNMAP_AFTER_INIT NVMeController::NVMeController(const PCI::DeviceIdentifier& dev
 
 UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
 {
-    // Nr of queues = one queue per core
-    auto nr_of_queues = Processor::count();
     auto irq = is_queue_polled ? Optional<u8> {} : m_pci_device_id.interrupt_line().value();
 
     PCI::enable_memory_space(m_pci_device_id.address());
@@ -61,7 +59,9 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
     VERIFY(IO_QUEUE_SIZE < MQES(caps));
     dbgln_if(NVME_DEBUG, "NVMe: IO queue depth is: {}", IO_QUEUE_SIZE);
 
-    // Create an IO queue per core
+    // Create an IO queue per core, or as many as the controller is willing to give us
+    auto nr_of_queues = TRY(request_io_queue_count(Processor::count()));
+    dbgln_if(NVME_DEBUG, "NVMe: Using {} IO queues for {} processors", nr_of_queues, Processor::count());
     for (u32 cpuid = 0; cpuid < nr_of_queues; ++cpuid) {
         // qid is zero is used for admin queue
         TRY(create_io_queue(cpuid + 1, irq));
@@ -149,6 +149,23 @@ UNMAP_AFTER_INIT u32 NVMeController::get_admin_q_dept()
     return q_depth;
 }
 
+UNMAP_AFTER_INIT ErrorOr<u32> NVMeController::request_io_queue_count(u32 nr_of_queues)
+{
+    // The controller may allocate fewer queues than we asked for, but never more than it reports back.
+    nr_of_queues = min(nr_of_queues, NumericLimits<u16>::max() - 1u);
+    NVMeSubmission sub {};
+    u32 allocated_queues = 0;
+    sub.op = OP_ADMIN_SET_FEATURES;
+    sub.generic.cdw10 = AK::convert_between_host_and_little_endian(FEATURE_NUMBER_OF_QUEUES);
+    sub.generic.cdw11 = AK::convert_between_host_and_little_endian(NUMBER_OF_QUEUES(nr_of_queues, nr_of_queues));
+    auto status = m_admin_queue->submit_sync_sqe(sub, &allocated_queues);
+    if (status) {
+        dmesgln("Failed to set the number of IO queues");
+        return EFAULT;
+    }
+    return min(nr_of_queues, min(NSQA(allocated_queues), NCQA(allocated_queues)));
+}
+
 UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_and_init_namespaces()
 {
 
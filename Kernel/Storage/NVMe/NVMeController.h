@@ -57,6 +57,7 @@ public:
 
 private:
     ErrorOr<void> identify_and_init_namespaces();
+    ErrorOr<u32> request_io_queue_count(u32 nr_of_queues);
     Tuple<u64, u8> get_ns_features(IdentifyNamespace& identify_data_struct);
     ErrorOr<void> create_admin_queue(Optional<u8> irq);
     ErrorOr<void> create_io_queue(u8 qid, Optional<u8> irq);
@@ -114,8 +114,25 @@ enum AdminCommandOpCode {
     OP_ADMIN_CREATE_COMPLETION_QUEUE = 0x5,
     OP_ADMIN_CREATE_SUBMISSION_QUEUE = 0x1,
     OP_ADMIN_IDENTIFY = 0x6,
+    OP_ADMIN_SET_FEATURES = 0x9,
 };
 
+// FEATURES
+static constexpr u8 FEATURE_NUMBER_OF_QUEUES = 0x7;
+// The number of queues is 0 based, both in the request and in the result
+static constexpr u32 NUMBER_OF_QUEUES(u16 nr_of_sqs, u16 nr_of_cqs)
+{
+    return ((nr_of_cqs - 1) << 16) | (nr_of_sqs - 1);
+}
+static constexpr u16 NSQA(u32 x)
+{
+    return (x & 0xffff) + 1;
+}
+static constexpr u16 NCQA(u32 x)
+{
+    return (x >> 16) + 1;
+}
+
 // IO opcodes
 enum IOCommandOpcode {
     OP_NVME_WRITE = 0x1,
@@ -29,16 +29,15 @@ UNMAP_AFTER_INIT NVMeNameSpace::NVMeNameSpace(NonnullRefPtrVector<NVMeQueue> que
 
 void NVMeNameSpace::start_request(AsyncBlockDeviceRequest& request)
 {
-    auto index = Processor::current_id();
-    auto& queue = m_queues.at(index);
-    // TODO: For now we support only IO transfers of size PAGE_SIZE (Going along with the current constraint in the block layer)
-    // Eventually remove this constraint by using the PRP2 field in the submission struct and remove block layer constraint for NVMe driver.
-    VERIFY(request.block_count() <= (PAGE_SIZE / block_size()));
-
-    if (request.request_type() == AsyncBlockDeviceRequest::Read) {
-        queue.read(request, m_nsid, request.block_index(), request.block_count());
-    } else {
-        queue.write(request, m_nsid, request.block_index(), request.block_count());
+    // Requests go to the queue of the processor they're made on, so processors don't contend on the same queue.
+    // If that one already has as many commands in flight as it can take, the least busy queue gets the request instead.
+    auto* queue = &m_queues.at(Processor::current_id() % m_queues.size());
+    if (queue->is_saturated()) {
+        for (auto& candidate : m_queues) {
+            if (candidate.outstanding_request_count() < queue->outstanding_request_count())
+                queue = &candidate;
+        }
     }
+    queue->submit_request(request, m_nsid);
 }
 }
@@ -29,6 +29,9 @@ public:
     void start_request(AsyncBlockDeviceRequest& request) override;
 
 private:
+    // Every queue keeps track of its own commands, so there's no need to wait for one request before starting the next.
+    virtual bool can_start_requests_concurrently() const override { return true; }
+
     u16 m_nsid;
     NonnullRefPtrVector<NVMeQueue> m_queues;
 };
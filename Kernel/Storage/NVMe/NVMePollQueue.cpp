@@ -10,35 +10,42 @@
 #include "NVMeDefinitions.h"
 
 namespace Kernel {
-UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
-    : NVMeQueue(move(rw_dma_region), rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))
+UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(OwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, OwnPtr<Memory::Region> prp_list_region, RefPtr<Memory::PhysicalPage> prp_list_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+    : NVMeQueue(move(rw_dma_region), move(rw_dma_pages), move(prp_list_region), move(prp_list_page), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))
 {
 }
 
 void NVMePollQueue::submit_sqe(NVMeSubmission& sub)
 {
     NVMeQueue::submit_sqe(sub);
-    SpinlockLocker lock_cq(m_cq_lock);
-    while (!process_cq()) {
+    if (is_admin_queue()) {
+        SpinlockLocker lock_cq(m_cq_lock);
+        while (!process_cq()) {
+            IO::delay(1);
+        }
+        return;
+    }
+
+    // Other processors may poll this queue at the same time, so wait until someone has seen our command complete.
+    auto& io = m_ios[sub.cmdid];
+    u16 status;
+    for (;;) {
+        {
+            SpinlockLocker lock_cq(m_cq_lock);
+            process_cq();
+            if (io.completion_status.has_value()) {
+                status = io.completion_status.value();
+                break;
+            }
+        }
         IO::delay(1);
     }
+    finish_io(sub.cmdid, status);
 }
 
-void NVMePollQueue::complete_current_request(u16 status)
+void NVMePollQueue::complete_io(u16 cmdid, u16 status)
 {
-    auto current_request = m_current_request;
-    m_current_request.clear();
-    if (status) {
-        current_request->complete(AsyncBlockDeviceRequest::Failure);
-        return;
-    }
-    if (current_request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
-        if (auto result = current_request->write_to_buffer(current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), current_request->buffer_size()); result.is_error()) {
-            current_request->complete(AsyncDeviceRequest::MemoryFault);
-            return;
-        }
-    }
-    current_request->complete(AsyncDeviceRequest::Success);
-    return;
+    VERIFY(m_cq_lock.is_locked());
+    m_ios[cmdid].completion_status = status;
 }
 }
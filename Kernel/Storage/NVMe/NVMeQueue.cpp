@@ -6,7 +6,6 @@
 
 #include "NVMeQueue.h"
 #include "Kernel/StdLib.h"
-#include "NVMeQueue.h"
 #include <Kernel/Arch/x86/IO.h>
 #include <Kernel/Storage/NVMe/NVMeController.h>
 #include <Kernel/Storage/NVMe/NVMeInterruptQueue.h>
@@ -15,21 +14,28 @@
 namespace Kernel {
 ErrorOr<NonnullRefPtr<NVMeQueue>> NVMeQueue::try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
 {
-    // Note: Allocate DMA region for RW operation. For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
-    RefPtr<Memory::PhysicalPage> rw_dma_page;
-    auto rw_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_page));
+    // Note: The admin queue doesn't transfer any data through us, only IO queues need DMA buffers for reads and writes.
+    OwnPtr<Memory::Region> rw_dma_region;
+    NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages;
+    OwnPtr<Memory::Region> prp_list_region;
+    RefPtr<Memory::PhysicalPage> prp_list_page;
+    if (qid != 0) {
+        VERIFY(max_outstanding_ios < q_depth);
+        rw_dma_region = TRY(MM.allocate_dma_buffer_pages(max_outstanding_ios * max_transfer_size, "NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_pages));
+        // Each command gets a slice of this page for the PRP list describing its part of the DMA buffer.
+        static_assert(max_outstanding_ios * max_transfer_pages * sizeof(u64) <= PAGE_SIZE);
+        prp_list_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue PRP list"sv, Memory::Region::Access::ReadWrite, prp_list_page));
+    }
     if (!irq.has_value()) {
-        auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), *rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+        auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), move(rw_dma_pages), move(prp_list_region), move(prp_list_page), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
         return queue;
     }
-    auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), *rw_dma_page, qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+    auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), move(rw_dma_pages), move(prp_list_region), move(prp_list_page), qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
     return queue;
 }
 
-UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
-    : m_current_request(nullptr)
-    , m_rw_dma_region(move(rw_dma_region))
-    , m_qid(qid)
+UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(OwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, OwnPtr<Memory::Region> prp_list_region, RefPtr<Memory::PhysicalPage> prp_list_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+    : m_qid(qid)
     , m_admin_queue(qid == 0)
     , m_qdepth(q_depth)
     , m_cq_dma_region(move(cq_dma_region))
@@ -37,8 +43,10 @@ UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_regio
     , m_sq_dma_region(move(sq_dma_region))
     , m_sq_dma_page(sq_dma_page)
     , m_db_regs(move(db_regs))
-    , m_rw_dma_page(rw_dma_page)
-
+    , m_rw_dma_region(move(rw_dma_region))
+    , m_rw_dma_pages(move(rw_dma_pages))
+    , m_prp_list_region(move(prp_list_region))
+    , m_prp_list_page(move(prp_list_page))
 {
     m_sqe_array = { reinterpret_cast<NVMeSubmission*>(m_sq_dma_region->vaddr().as_ptr()), m_qdepth };
     m_cqe_array = { reinterpret_cast<NVMeCompletion*>(m_cq_dma_region->vaddr().as_ptr()), m_qdepth };
@@ -74,13 +82,9 @@ u32 NVMeQueue::process_cq()
         // TODO: We don't use AsyncBlockDevice requests for admin queue as it is only applicable for a block device (NVMe namespace)
         //  But admin commands precedes namespace creation. Unify requests to avoid special conditions
         if (m_admin_queue == false) {
-            // As the block layer calls are now sync (as we wait on each requests),
-            // everything is operated on a single request similar to BMIDE driver.
-            // TODO: Remove this constraint eventually.
-            VERIFY(cmdid == m_prev_sq_tail);
-            if (m_current_request) {
-                complete_current_request(status);
-            }
+            VERIFY(cmdid < m_ios.size());
+            VERIFY(m_ios[cmdid].in_use);
+            complete_io(cmdid, status);
         }
         update_cqe_head();
     }
@@ -93,9 +97,10 @@ u32 NVMeQueue::process_cq()
 void NVMeQueue::submit_sqe(NVMeSubmission& sub)
 {
     SpinlockLocker lock(m_sq_lock);
-    // For now let's use sq tail as a unique command id.
-    sub.cmdid = m_sq_tail;
-    m_prev_sq_tail = m_sq_tail;
+    // IO commands are identified by the slot they occupy, admin commands are only ever submitted one at a time.
+    // For now let's use sq tail as a unique command id for those.
+    if (m_admin_queue)
+        sub.cmdid = m_sq_tail;
 
     memcpy(&m_sqe_array[m_sq_tail], &sub, sizeof(NVMeSubmission));
     {
@@ -111,15 +116,15 @@ void NVMeQueue::submit_sqe(NVMeSubmission& sub)
     update_sq_doorbell();
 }
 
-u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
+u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub, u32* command_specific)
 {
     // For now let's use sq tail as a unique command id.
     u16 cqe_cid;
     u16 cid = m_sq_tail;
+    int index;
 
     submit_sqe(sub);
     do {
-        int index;
         {
             SpinlockLocker lock(m_cq_lock);
             index = m_cq_head - 1;
@@ -130,47 +135,185 @@ u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
         IO::delay(1);
     } while (cid != cqe_cid);
 
-    auto status = CQ_STATUS_FIELD(m_cqe_array[m_cq_head].status);
+    if (command_specific)
+        *command_specific = m_cqe_array[index].cmd_spec;
+    auto status = CQ_STATUS_FIELD(m_cqe_array[index].status);
     return status;
 }
 
-void NVMeQueue::read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+void NVMeQueue::submit_request(AsyncBlockDeviceRequest& request, u16 nsid)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    VERIFY(!m_admin_queue);
+    VERIFY(request.block_count() * request.block_size() <= max_transfer_size);
+    {
+        SpinlockLocker lock(m_request_lock);
+        if (m_pending_requests.try_append({ request, nsid }).is_error()) {
+            lock.unlock();
+            request.complete(AsyncDeviceRequest::Failure);
+            return;
+        }
+        m_outstanding_requests++;
+    }
+    submit_pending_ios();
+}
 
-    sub.op = OP_NVME_READ;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
-    // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+void NVMeQueue::submit_pending_ios()
+{
+    for (;;) {
+        Optional<u16> cmdid;
+        {
+            SpinlockLocker lock(m_request_lock);
+            cmdid = reserve_next_io();
+        }
+        if (!cmdid.has_value())
+            return;
+        start_io(cmdid.value());
+    }
+}
 
-    full_memory_barrier();
-    submit_sqe(sub);
+bool NVMeQueue::try_merge_pending_request(NVMeIO& io, PendingRequest const& pending)
+{
+    auto& request = *pending.request;
+    if (pending.nsid != io.nsid || request.request_type() != io.type)
+        return false;
+    // A fault while copying from or to a user buffer has to fail only that request, so only kernel buffers are merged.
+    if (!request.buffer().is_kernel_buffer() || !io.requests.first()->buffer().is_kernel_buffer())
+        return false;
+    auto transfer_size = request.block_count() * request.block_size();
+    if (io.transfer_size + transfer_size > max_transfer_size)
+        return false;
+
+    if (request.block_index() == io.block_index + io.block_count) {
+        io.requests.append(*pending.request);
+    } else if (request.block_index() + request.block_count() == io.block_index) {
+        // NOTE: This stays within the inline capacity, so it never has to allocate.
+        MUST(io.requests.try_insert(0, *pending.request));
+        io.block_index = request.block_index();
+    } else {
+        return false;
+    }
+    io.block_count += request.block_count();
+    io.transfer_size += transfer_size;
+    return true;
 }
 
-void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+Optional<u16> NVMeQueue::reserve_next_io()
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    VERIFY(m_request_lock.is_locked());
+    if (m_pending_requests.is_empty())
+        return {};
+
+    Optional<u16> cmdid;
+    for (u16 i = 0; i < m_ios.size(); ++i) {
+        if (!m_ios[i].in_use) {
+            cmdid = i;
+            break;
+        }
+    }
+    if (!cmdid.has_value())
+        return {};
+
+    auto& io = m_ios[cmdid.value()];
+    auto first = m_pending_requests.take_first();
+    io.in_use = true;
+    io.completion_status.clear();
+    io.type = first.request->request_type();
+    io.nsid = first.nsid;
+    io.block_index = first.request->block_index();
+    io.block_count = first.request->block_count();
+    io.transfer_size = first.request->block_count() * first.request->block_size();
+    io.requests.append(move(first.request));
+
+    // Pull in everything that's waiting right before or after this transfer, so it all goes out as one command.
+    for (size_t i = 0; i < m_pending_requests.size() && io.requests.size() < max_merged_requests;) {
+        if (!try_merge_pending_request(io, m_pending_requests[i])) {
+            ++i;
+            continue;
+        }
+        m_pending_requests.remove(i);
+        // The transfer grew, so requests we've skipped might line up with it now.
+        i = 0;
+    }
+    if (io.requests.size() > 1)
+        dbgln_if(NVME_DEBUG, "NVMe: Merged {} requests into a transfer of {} blocks at {}", io.requests.size(), io.block_count, io.block_index);
+    return cmdid;
+}
 
-    if (auto result = m_current_request->read_from_buffer(m_current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), m_current_request->buffer_size()); result.is_error()) {
-        complete_current_request(AsyncDeviceRequest::MemoryFault);
-        return;
+void NVMeQueue::start_io(u16 cmdid)
+{
+    auto& io = m_ios[cmdid];
+    auto* buffer = io_buffer(cmdid);
+
+    if (io.type == AsyncBlockDeviceRequest::Write) {
+        size_t offset = 0;
+        for (auto& request : io.requests) {
+            if (auto result = request->read_from_buffer(request->buffer(), buffer + offset, request->buffer_size()); result.is_error()) {
+                // Only lone requests can fault here, see try_merge_pending_request().
+                VERIFY(io.requests.size() == 1);
+                SpinlockLocker lock(m_request_lock);
+                auto faulted_request = io.requests.take_first();
+                io.in_use = false;
+                m_outstanding_requests--;
+                lock.unlock();
+                faulted_request->complete(AsyncDeviceRequest::MemoryFault);
+                return;
+            }
+            offset += request->block_count() * request->block_size();
+        }
     }
-    sub.op = OP_NVME_WRITE;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
+
+    // The slice of the DMA buffer belonging to this command is described by at most max_transfer_pages PRP entries.
+    // The first one goes into PRP1, and if there's exactly one more it goes into PRP2. Otherwise PRP2 points to a list of the rest.
+    auto first_page = cmdid * max_transfer_pages;
+    auto page_count = ceil_div(io.transfer_size, static_cast<size_t>(PAGE_SIZE));
+    NVMeSubmission sub {};
+    sub.op = io.type == AsyncBlockDeviceRequest::Read ? OP_NVME_READ : OP_NVME_WRITE;
+    sub.cmdid = cmdid;
+    sub.rw.nsid = io.nsid;
+    sub.rw.slba = AK::convert_between_host_and_little_endian(io.block_index);
     // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+    sub.rw.length = AK::convert_between_host_and_little_endian((io.block_count - 1) & 0xFFFF);
+    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_pages[first_page].paddr().as_ptr()));
+    if (page_count == 2) {
+        sub.rw.data_ptr.prp2 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_pages[first_page + 1].paddr().as_ptr()));
+    } else if (page_count > 2) {
+        auto prp_list_offset = cmdid * max_transfer_pages * sizeof(u64);
+        auto* prp_list = reinterpret_cast<u64*>(m_prp_list_region->vaddr().offset(prp_list_offset).as_ptr());
+        for (size_t i = 1; i < page_count; ++i)
+            prp_list[i - 1] = AK::convert_between_host_and_little_endian(m_rw_dma_pages[first_page + i].paddr().get());
+        sub.rw.data_ptr.prp2 = AK::convert_between_host_and_little_endian(m_prp_list_page->paddr().offset(prp_list_offset).get());
+    }
 
     full_memory_barrier();
     submit_sqe(sub);
 }
 
+void NVMeQueue::finish_io(u16 cmdid, u16 status)
+{
+    auto& io = m_ios[cmdid];
+    VERIFY(io.in_use);
+
+    Array<AsyncDeviceRequest::RequestResult, max_merged_requests> results;
+    size_t offset = 0;
+    for (size_t i = 0; i < io.requests.size(); ++i) {
+        auto& request = io.requests[i];
+        results[i] = status ? AsyncDeviceRequest::Failure : AsyncDeviceRequest::Success;
+        if (!status && io.type == AsyncBlockDeviceRequest::Read && request->write_to_buffer(request->buffer(), io_buffer(cmdid) + offset, request->buffer_size()).is_error())
+            results[i] = AsyncDeviceRequest::MemoryFault;
+        offset += request->block_count() * request->block_size();
+    }
+
+    // The DMA buffer isn't needed anymore, so free up the slot before completing anything.
+    Vector<NonnullRefPtr<AsyncBlockDeviceRequest>, max_merged_requests> requests;
+    {
+        SpinlockLocker lock(m_request_lock);
+        swap(requests, io.requests);
+        io.in_use = false;
+        m_outstanding_requests -= requests.size();
+    }
+    for (size_t i = 0; i < requests.size(); ++i)
+        requests[i]->complete(results[i]);
+}
+
 UNMAP_AFTER_INIT NVMeQueue::~NVMeQueue() = default;
 }
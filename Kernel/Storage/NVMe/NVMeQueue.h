@@ -6,13 +6,17 @@
 
 #pragma once
 
+#include <AK/Array.h>
+#include <AK/Atomic.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefCounted.h>
 #include <AK/RefPtr.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Interrupts/IRQHandler.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/MemoryManager.h>
@@ -26,45 +30,80 @@ struct DoorbellRegister {
     u32 cq_head;
 };
 
-class AsyncBlockDeviceRequest;
 class NVMeQueue : public RefCounted<NVMeQueue> {
 public:
+    // NOTE: Every command gets its own slice of the queue's DMA buffer, so this is what a single
+    //       command (and with that, a few merged requests) can transfer at most.
+    //       It's also well below the smallest MDTS that devices out there report.
+    static constexpr size_t max_transfer_size = 64 * KiB;
+    static constexpr size_t max_transfer_pages = max_transfer_size / PAGE_SIZE;
+    // The number of commands we keep in flight per queue. Anything beyond that waits to be
+    // merged with its neighbours until a command completes.
+    static constexpr size_t max_outstanding_ios = 16;
+    static constexpr size_t max_merged_requests = 16;
+
     static ErrorOr<NonnullRefPtr<NVMeQueue>> try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
     bool is_admin_queue() { return m_admin_queue; };
-    u16 submit_sync_sqe(NVMeSubmission&);
-    void read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
-    void write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
+    u16 submit_sync_sqe(NVMeSubmission&, u32* command_specific = nullptr);
+    void submit_request(AsyncBlockDeviceRequest&, u16 nsid);
     virtual void submit_sqe(NVMeSubmission&);
     virtual ~NVMeQueue();
 
+    // The number of requests handed to this queue that haven't completed yet, used to spread requests across queues.
+    u32 outstanding_request_count() const { return m_outstanding_requests.load(AK::MemoryOrder::memory_order_relaxed); }
+    bool is_saturated() const { return outstanding_request_count() >= max_outstanding_ios; }
+
 protected:
+    // One command in flight, the command identifier is its index in m_ios.
+    struct NVMeIO {
+        Vector<NonnullRefPtr<AsyncBlockDeviceRequest>, max_merged_requests> requests;
+        AsyncBlockDeviceRequest::RequestType type { AsyncBlockDeviceRequest::Read };
+        u16 nsid { 0 };
+        u64 block_index { 0 };
+        u32 block_count { 0 };
+        size_t transfer_size { 0 };
+        bool in_use { false };
+        Optional<u16> completion_status;
+    };
+
     u32 process_cq();
     void update_sq_doorbell()
     {
         m_db_regs->sq_tail = m_sq_tail;
     }
-    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+    NVMeQueue(OwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, OwnPtr<Memory::Region> prp_list_region, RefPtr<Memory::PhysicalPage> prp_list_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+
+    void finish_io(u16 cmdid, u16 status);
+    void submit_pending_ios();
+
+    Array<NVMeIO, max_outstanding_ios> m_ios;
 
 private:
+    struct PendingRequest {
+        NonnullRefPtr<AsyncBlockDeviceRequest> request;
+        u16 nsid;
+    };
+
     bool cqe_available();
     void update_cqe_head();
-    virtual void complete_current_request(u16 status) = 0;
+    virtual void complete_io(u16 cmdid, u16 status) = 0;
     void update_cq_doorbell()
     {
         m_db_regs->cq_head = m_cq_head;
     }
+    Optional<u16> reserve_next_io();
+    bool try_merge_pending_request(NVMeIO&, PendingRequest const&);
+    void start_io(u16 cmdid);
+    u8* io_buffer(u16 cmdid) { return m_rw_dma_region->vaddr().offset(cmdid * max_transfer_size).as_ptr(); }
 
 protected:
     Spinlock m_cq_lock { LockRank::Interrupts };
-    RefPtr<AsyncBlockDeviceRequest> m_current_request;
-    NonnullOwnPtr<Memory::Region> m_rw_dma_region;
     Spinlock m_request_lock;
 
 private:
     u16 m_qid {};
     u8 m_cq_valid_phase { 1 };
     u16 m_sq_tail {};
-    u16 m_prev_sq_tail {};
     u16 m_cq_head {};
     bool m_admin_queue { false };
     u32 m_qdepth {};
@@ -76,6 +115,11 @@ private:
     NonnullRefPtrVector<Memory::PhysicalPage> m_sq_dma_page;
     Span<NVMeCompletion> m_cqe_array;
     Memory::TypedMapping<volatile DoorbellRegister> m_db_regs;
-    NonnullRefPtr<Memory::PhysicalPage> m_rw_dma_page;
+    OwnPtr<Memory::Region> m_rw_dma_region;
+    NonnullRefPtrVector<Memory::PhysicalPage> m_rw_dma_pages;
+    OwnPtr<Memory::Region> m_prp_list_region;
+    RefPtr<Memory::PhysicalPage> m_prp_list_page;
+    Vector<PendingRequest> m_pending_requests;
+    Atomic<u32> m_outstanding_requests { 0 };
 };
 }
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/BlockBasedFileSystem.h>
+#include <Kernel/Heap/kmalloc.h>
+#include <Kernel/Sections.h>
+#include <Kernel/SysFSKernel.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT void KernelSysFSDirectory::initialize()
+{
+    auto kernel_directory = adopt_ref_if_nonnull(new (nothrow) KernelSysFSDirectory()).release_nonnull();
+    SysFSComponentRegistry::the().register_new_component(kernel_directory);
+}
+
+UNMAP_AFTER_INIT KernelSysFSDirectory::KernelSysFSDirectory()
+    : SysFSDirectory(SysFSComponentRegistry::the().root_directory())
+{
+    m_components.append(ReadaheadStatisticsSysFSComponent::must_create());
+    m_components.append(WritebackStatisticsSysFSComponent::must_create());
+    m_components.append(KmallocStatisticsSysFSComponent::must_create());
+    m_components.append(WritebackSettingSysFSComponent::must_create(WritebackSettingSysFSComponent::Setting::DirtyBackgroundRatio));
+    m_components.append(WritebackSettingSysFSComponent::must_create(WritebackSettingSysFSComponent::Setting::DirtyRatio));
+    m_components.append(WritebackSettingSysFSComponent::must_create(WritebackSettingSysFSComponent::Setting::DirtyExpireMilliseconds));
+}
+
+ErrorOr<size_t> KernelStatisticsSysFSComponent::read_bytes(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description) const
+{
+    VERIFY(offset >= 0);
+    if (!description)
+        return Error::from_errno(EIO);
+
+    MutexLocker locker(m_refresh_lock);
+    if (!description->data())
+        return Error::from_errno(EIO);
+
+    auto& data_buffer = static_cast<SysFSInodeData&>(*description->data()).buffer;
+    if (!data_buffer || static_cast<size_t>(offset) >= data_buffer->size())
+        return 0;
+
+    ssize_t nread = min(static_cast<off_t>(data_buffer->size() - offset), static_cast<off_t>(count));
+    TRY(buffer.write(data_buffer->data() + offset, nread));
+    return nread;
+}
+
+ErrorOr<void> KernelStatisticsSysFSComponent::refresh_data(OpenFileDescription& description) const
+{
+    MutexLocker locker(m_refresh_lock);
+    auto& cached_data = description.data();
+    if (!cached_data) {
+        cached_data = adopt_own_if_nonnull(new (nothrow) SysFSInodeData);
+        if (!cached_data)
+            return ENOMEM;
+    }
+    auto builder = TRY(KBufferBuilder::try_create());
+    TRY(try_generate(builder));
+    auto& typed_cached_data = static_cast<SysFSInodeData&>(*cached_data);
+    typed_cached_data.buffer = builder.build();
+    if (!typed_cached_data.buffer)
+        return ENOMEM;
+    return {};
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<ReadaheadStatisticsSysFSComponent> ReadaheadStatisticsSysFSComponent::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) ReadaheadStatisticsSysFSComponent()).release_nonnull();
+}
+
+ErrorOr<void> ReadaheadStatisticsSysFSComponent::try_generate(KBufferBuilder& builder) const
+{
+    auto statistics = BlockBasedFileSystem::readahead_statistics();
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(json.add("requests", statistics.requests));
+    TRY(json.add("blocks", statistics.blocks));
+    TRY(json.add("hits", statistics.hits));
+    TRY(json.add("unused", statistics.unused));
+    TRY(json.finish());
+    return {};
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<WritebackStatisticsSysFSComponent> WritebackStatisticsSysFSComponent::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) WritebackStatisticsSysFSComponent()).release_nonnull();
+}
+
+ErrorOr<void> WritebackStatisticsSysFSComponent::try_generate(KBufferBuilder& builder) const
+{
+    auto statistics = BlockBasedFileSystem::writeback_statistics();
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(json.add("blocks", statistics.blocks));
+    TRY(json.add("requests", statistics.requests));
+    TRY(json.add("throttled_writes", statistics.throttled_writes));
+    TRY(json.add("throttled_ms", statistics.throttled_ms));
+    TRY(json.finish());
+    return {};
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<KmallocStatisticsSysFSComponent> KmallocStatisticsSysFSComponent::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) KmallocStatisticsSysFSComponent()).release_nonnull();
+}
+
+ErrorOr<void> KmallocStatisticsSysFSComponent::try_generate(KBufferBuilder& builder) const
+{
+    Vector<kmalloc_slabheap_stats, 8> slabheap_stats;
+    TRY(slabheap_stats.try_resize(kmalloc_slabheap_count()));
+    kmalloc_stats stats;
+    get_kmalloc_stats(stats, slabheap_stats.data(), slabheap_stats.size());
+
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(json.add("bytes_allocated", stats.bytes_allocated));
+    TRY(json.add("bytes_free", stats.bytes_free));
+    TRY(json.add("kmalloc_calls", stats.kmalloc_call_count));
+    TRY(json.add("kfree_calls", stats.kfree_call_count));
+    auto array = TRY(json.add_array("slabheaps"));
+    for (auto& slabheap : slabheap_stats) {
+        auto obj = TRY(array.add_object());
+        TRY(obj.add("slab_size", slabheap.slab_size));
+        TRY(obj.add("bytes_allocated", slabheap.bytes_allocated));
+        TRY(obj.add("bytes_free", slabheap.bytes_free));
+        TRY(obj.add("cached_slabs", slabheap.cached_slabs));
+        TRY(obj.add("magazine_hits", slabheap.magazine_hits));
+        TRY(obj.add("magazine_misses", slabheap.magazine_misses));
+        TRY(obj.add("magazine_frees", slabheap.magazine_frees));
+        TRY(obj.add("magazine_flushes", slabheap.magazine_flushes));
+        TRY(obj.finish());
+    }
+    TRY(array.finish());
+    TRY(json.finish());
+    return {};
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<WritebackSettingSysFSComponent> WritebackSettingSysFSComponent::must_create(Setting setting)
+{
+    return adopt_ref_if_nonnull(new (nothrow) WritebackSettingSysFSComponent(setting)).release_nonnull();
+}
+
+UNMAP_AFTER_INIT WritebackSettingSysFSComponent::WritebackSettingSysFSComponent(Setting setting)
+    : m_setting(setting)
+{
+}
+
+StringView WritebackSettingSysFSComponent::name() const
+{
+    switch (m_setting) {
+    case Setting::DirtyBackgroundRatio:
+        return "dirty_background_ratio"sv;
+    case Setting::DirtyRatio:
+        return "dirty_ratio"sv;
+    case Setting::DirtyExpireMilliseconds:
+        return "dirty_expire_ms"sv;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+mode_t WritebackSettingSysFSComponent::permissions() const
+{
+    return S_IRUSR | S_IRGRP | S_IROTH | S_IWUSR;
+}
+
+ErrorOr<void> WritebackSettingSysFSComponent::try_generate(KBufferBuilder& builder) const
+{
+    auto settings = BlockBasedFileSystem::writeback_settings();
+    switch (m_setting) {
+    case Setting::DirtyBackgroundRatio:
+        return builder.appendff("{}\n", settings.dirty_background_ratio);
+    case Setting::DirtyRatio:
+        return builder.appendff("{}\n", settings.dirty_ratio);
+    case Setting::DirtyExpireMilliseconds:
+        return builder.appendff("{}\n", settings.dirty_expire_ms);
+    }
+    VERIFY_NOT_REACHED();
+}
+
+ErrorOr<size_t> WritebackSettingSysFSComponent::write_bytes(off_t offset, size_t count, UserOrKernelBuffer const& data, OpenFileDescription*)
+{
+    if (offset > 0)
+        return EINVAL;
+    char buffer[16];
+    if (count == 0 || count > sizeof(buffer))
+        return EINVAL;
+    TRY(data.read(buffer, count));
+
+    auto value = StringView { buffer, count }.trim_whitespace().to_uint();
+    if (!value.has_value())
+        return EINVAL;
+
+    auto settings = BlockBasedFileSystem::writeback_settings();
+    switch (m_setting) {
+    case Setting::DirtyBackgroundRatio:
+        settings.dirty_background_ratio = value.value();
+        break;
+    case Setting::DirtyRatio:
+        settings.dirty_ratio = value.value();
+        break;
+    case Setting::DirtyExpireMilliseconds:
+        settings.dirty_expire_ms = value.value();
+        break;
+    }
+    TRY(BlockBasedFileSystem::set_writeback_settings(settings));
+    return count;
+}
+
+ErrorOr<void> WritebackSettingSysFSComponent::truncate(u64 size)
+{
+    // NOTE: This allows writing to the node with O_TRUNC (e.g. from the shell), the actual value is never truncated.
+    if (size != 0)
+        return EPERM;
+    return {};
+}
+
+}
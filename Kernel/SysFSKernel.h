@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/FileSystem/SysFS.h>
+#include <Kernel/KBufferBuilder.h>
+#include <Kernel/Locking/Mutex.h>
+
+namespace Kernel {
+
+class KernelSysFSDirectory final : public SysFSDirectory {
+public:
+    virtual StringView name() const override { return "kernel"sv; }
+    static void initialize();
+
+private:
+    KernelSysFSDirectory();
+};
+
+// A read-only node whose contents are generated when it's opened (or seeked back to the start).
+class KernelStatisticsSysFSComponent : public SysFSComponent {
+public:
+    virtual ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer&, OpenFileDescription*) const override;
+
+protected:
+    KernelStatisticsSysFSComponent() = default;
+
+    virtual ErrorOr<void> refresh_data(OpenFileDescription&) const override;
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const = 0;
+
+    mutable Mutex m_refresh_lock;
+};
+
+class ReadaheadStatisticsSysFSComponent final : public KernelStatisticsSysFSComponent {
+public:
+    virtual StringView name() const override { return "readahead"sv; }
+    static NonnullRefPtr<ReadaheadStatisticsSysFSComponent> must_create();
+
+private:
+    ReadaheadStatisticsSysFSComponent() = default;
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const override;
+};
+
+class WritebackStatisticsSysFSComponent final : public KernelStatisticsSysFSComponent {
+public:
+    virtual StringView name() const override { return "writeback"sv; }
+    static NonnullRefPtr<WritebackStatisticsSysFSComponent> must_create();
+
+private:
+    WritebackStatisticsSysFSComponent() = default;
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const override;
+};
+
+class KmallocStatisticsSysFSComponent final : public KernelStatisticsSysFSComponent {
+public:
+    virtual StringView name() const override { return "kmalloc"sv; }
+    static NonnullRefPtr<KmallocStatisticsSysFSComponent> must_create();
+
+private:
+    KmallocStatisticsSysFSComponent() = default;
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const override;
+};
+
+class WritebackSettingSysFSComponent final : public KernelStatisticsSysFSComponent {
+public:
+    enum class Setting {
+        DirtyBackgroundRatio,
+        DirtyRatio,
+        DirtyExpireMilliseconds,
+    };
+
+    virtual StringView name() const override;
+    static NonnullRefPtr<WritebackSettingSysFSComponent> must_create(Setting);
+
+    virtual mode_t permissions() const override;
+    virtual ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const&, OpenFileDescription*) override;
+    virtual ErrorOr<void> truncate(u64) override;
+    virtual ErrorOr<void> set_mtime(time_t) override { return {}; }
+
+private:
+    explicit WritebackSettingSysFSComponent(Setting);
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const override;
+
+    Setting const m_setting;
+};
+
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/EPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+// Don't let a single call pin down an arbitrarily large kernel buffer.
+static constexpr int max_events_per_wait = 1024;
+
+ErrorOr<FlatPtr> Process::sys$epoll_create1(int flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+    if ((flags & EPOLL_CLOEXEC) != flags)
+        return EINVAL;
+
+    auto fd_allocation = TRY(allocate_fd());
+    auto epoll = TRY(EPoll::try_create());
+    auto description = TRY(OpenFileDescription::try_create(move(epoll)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        fds[fd_allocation.fd].set(move(description));
+
+        if (flags & EPOLL_CLOEXEC)
+            fds[fd_allocation.fd].set_flags(fds[fd_allocation.fd].flags() | FD_CLOEXEC);
+
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_ctl(Userspace<Syscall::SC_epoll_ctl_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    auto epoll_description = TRY(open_file_description(params.epfd));
+    if (!epoll_description->is_epoll())
+        return EINVAL;
+    auto* epoll = epoll_description->epoll();
+
+    auto description = TRY(open_file_description(params.fd));
+    if (description.ptr() == epoll_description.ptr())
+        return EINVAL;
+
+    epoll_event event {};
+    if (params.op == EPOLL_CTL_ADD || params.op == EPOLL_CTL_MOD) {
+        Userspace<epoll_event const*> user_event((FlatPtr)params.event);
+        TRY(copy_from_user(&event, user_event));
+        if ((event.events & (EPOLLIN | EPOLLPRI | EPOLLOUT | EPOLLERR | EPOLLHUP | EPOLLRDHUP | EPOLLONESHOT | EPOLLET)) != event.events)
+            return EINVAL;
+    }
+
+    dbgln_if(IO_DEBUG, "sys$epoll_ctl({}, {}, {}, {:#x})", params.epfd, params.op, params.fd, event.events);
+
+    switch (params.op) {
+    case EPOLL_CTL_ADD:
+        TRY(epoll->add(params.fd, *description, event));
+        return 0;
+    case EPOLL_CTL_MOD:
+        TRY(epoll->modify(params.fd, *description, event));
+        return 0;
+    case EPOLL_CTL_DEL:
+        TRY(epoll->remove(params.fd, *description));
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    if (params.maxevents <= 0)
+        return EINVAL;
+    size_t max_events = min(params.maxevents, max_events_per_wait);
+
+    auto description = TRY(open_file_description(params.epfd));
+    if (!description->is_epoll())
+        return EINVAL;
+    auto* epoll = description->epoll();
+
+    Thread::BlockTimeout timeout;
+    if (params.timeout) {
+        auto timeout_time = TRY(copy_time_from_user(params.timeout));
+        // NOTE: The relative timeout is turned into a deadline right away, so it can be reused below.
+        timeout = Thread::BlockTimeout(false, &timeout_time);
+    }
+
+    sigset_t sigmask = {};
+    if (params.sigmask)
+        TRY(copy_from_user(&sigmask, params.sigmask));
+
+    Vector<epoll_event> events;
+    TRY(events.try_resize(max_events));
+
+    auto* current_thread = Thread::current();
+
+    u32 previous_signal_mask = 0;
+    if (params.sigmask)
+        previous_signal_mask = current_thread->update_signal_mask(sigmask);
+    ScopeGuard rollback_signal_mask([&]() {
+        if (params.sigmask)
+            current_thread->update_signal_mask(previous_signal_mask);
+    });
+
+    dbgln_if(IO_DEBUG, "sys$epoll_wait({}, {}, timeout={})", params.epfd, max_events, params.timeout);
+
+    size_t ready_count = 0;
+    for (;;) {
+        ready_count = epoll->collect_ready_events(events.span());
+        if (ready_count > 0)
+            break;
+
+        // Nothing is ready, so wait for one of the watched files to put something on the ready list.
+        Thread::SelectBlocker::FDVector fds_info;
+        TRY(fds_info.try_append({ description, Thread::FileBlocker::BlockFlags::Read }));
+        auto block_result = current_thread->block<Thread::SelectBlocker>(timeout, fds_info);
+        if (block_result.was_interrupted())
+            return EINTR;
+        if (block_result == Thread::BlockResult::InterruptedByTimeout) {
+            ready_count = epoll->collect_ready_events(events.span());
+            break;
+        }
+    }
+
+    if (ready_count > 0)
+        TRY(copy_to_user(params.events, events.data(), ready_count * sizeof(epoll_event)));
+    return ready_count;
+}
+
+}
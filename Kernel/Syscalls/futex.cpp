@@ -38,12 +38,13 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
     switch (cmd) {
     case FUTEX_WAIT:
     case FUTEX_WAIT_BITSET:
-    case FUTEX_REQUEUE:
-    case FUTEX_CMP_REQUEUE: {
+    case FUTEX_LOCK_PI: {
+        // NOTE: FUTEX_REQUEUE and FUTEX_CMP_REQUEUE use this slot for val2, not for a timeout.
         if (params.timeout) {
             auto timeout_time = TRY(copy_time_from_user(params.timeout));
             bool is_absolute = cmd != FUTEX_WAIT;
-            clockid_t clock_id = use_realtime_clock ? CLOCK_REALTIME_COARSE : CLOCK_MONOTONIC_COARSE;
+            // FUTEX_LOCK_PI timeouts are always measured against the realtime clock.
+            clockid_t clock_id = (use_realtime_clock || cmd == FUTEX_LOCK_PI) ? CLOCK_REALTIME_COARSE : CLOCK_MONOTONIC_COARSE;
             timeout = Thread::BlockTimeout(is_absolute, &timeout_time, nullptr, clock_id);
         }
         if (cmd == FUTEX_WAIT_BITSET && params.val3 == FUTEX_BITSET_MATCH_ANY)
@@ -99,15 +100,15 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
     auto user_address = FlatPtr(params.userspace_address);
     auto user_address2 = FlatPtr(params.userspace_address2);
 
-    auto do_wait = [&](u32 bitset) -> ErrorOr<FlatPtr> {
+    auto do_wait = [&](u32 expected_value, u32 bitset, Function<void(FutexQueue&)> before_blocking = nullptr) -> ErrorOr<FlatPtr> {
         bool did_create;
         RefPtr<FutexQueue> futex_queue;
         do {
             auto user_value = user_atomic_load_relaxed(params.userspace_address);
             if (!user_value.has_value())
                 return EFAULT;
-            if (user_value.value() != params.val) {
-                dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, params.val);
+            if (user_value.value() != expected_value) {
+                dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, expected_value);
                 return EAGAIN;
             }
             atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
@@ -120,6 +121,9 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
             // was removed before we were able to queue an imminent wait.
         } while (!did_create && !futex_queue->queue_imminent_wait());
 
+        if (before_blocking)
+            before_blocking(*futex_queue);
+
         // We must not hold the lock before blocking. But we have a reference
         // to the FutexQueue so that we can keep it alive.
 
@@ -166,9 +170,136 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
         return woken_or_requeued;
     };
 
+    // Recompute the priority the current thread inherits from waiters on the
+    // priority-inheritance futexes it still owns.
+    auto update_inherited_priority = [&](Thread& thread) {
+        u32 inherited_priority = 0;
+        SpinlockLocker locker(m_futex_lock);
+        for (auto& it : m_futex_queues) {
+            if (it.value->pi_owner() == thread.tid())
+                inherited_priority = max(inherited_priority, it.value->highest_pi_waiter_priority());
+        }
+        thread.set_inherited_priority(inherited_priority);
+    };
+
+    // NOTE: All futex operations of a process are serialized by its big lock,
+    // which is only dropped once a waiter is actually blocked. This means an
+    // unlocker can never slip in between a waiter checking the futex word and
+    // going to sleep.
+    auto do_lock_pi = [&](bool try_only) -> ErrorOr<FlatPtr> {
+        auto* current_thread = Thread::current();
+        u32 tid = static_cast<u32>(current_thread->tid().value()) & FUTEX_TID_MASK;
+        for (;;) {
+            auto user_value = user_atomic_load_relaxed(params.userspace_address);
+            if (!user_value.has_value())
+                return EFAULT;
+            u32 value = user_value.value();
+            u32 owner_tid = value & FUTEX_TID_MASK;
+
+            if (owner_tid == 0) {
+                // Nobody owns the lock, so claim it. Keep the waiters flag, so
+                // that we have to come back here to hand it on once we unlock.
+                u32 expected = value;
+                auto exchanged = user_atomic_compare_exchange_relaxed(params.userspace_address, expected, tid | (value & FUTEX_WAITERS));
+                if (!exchanged.has_value())
+                    return EFAULT;
+                if (!exchanged.value())
+                    continue;
+                atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
+
+                SpinlockLocker locker(m_futex_lock);
+                if (auto futex_queue = find_futex_queue(user_address, false)) {
+                    futex_queue->set_pi_owner(current_thread->tid());
+                    current_thread->raise_inherited_priority(futex_queue->highest_pi_waiter_priority());
+                }
+                return 0;
+            }
+            if (owner_tid == tid)
+                return EDEADLK;
+            if (try_only)
+                return EAGAIN;
+
+            if (!(value & FUTEX_WAITERS)) {
+                // Tell the owner that it has to wake us up.
+                u32 expected = value;
+                auto exchanged = user_atomic_compare_exchange_relaxed(params.userspace_address, expected, value | FUTEX_WAITERS);
+                if (!exchanged.has_value())
+                    return EFAULT;
+                if (!exchanged.value())
+                    continue;
+                value |= FUTEX_WAITERS;
+            }
+
+            FutexQueue::PIWaiter pi_waiter { current_thread->effective_priority(), {} };
+            RefPtr<FutexQueue> waited_on_queue;
+            auto result = do_wait(value, FUTEX_BITSET_MATCH_ANY, [&](FutexQueue& futex_queue) {
+                waited_on_queue = futex_queue;
+                futex_queue.set_pi_owner(owner_tid);
+                futex_queue.add_pi_waiter(pi_waiter);
+                auto owner = Thread::from_tid(owner_tid);
+                if (!owner || owner->pid() != pid())
+                    return;
+                dbgln_if(FUTEX_DEBUG, "futex lock_pi: {} waits for {}, lending it priority {}", *current_thread, *owner, pi_waiter.priority);
+                owner->raise_inherited_priority(pi_waiter.priority);
+            });
+            if (waited_on_queue) {
+                // Whether we were handed the lock, timed out or got interrupted, we no longer
+                // wait on it, so whoever owns it now must stop running with our priority.
+                waited_on_queue->remove_pi_waiter(pi_waiter);
+                if (auto owner = Thread::from_tid(waited_on_queue->pi_owner()); owner && owner->pid() == pid())
+                    update_inherited_priority(*owner);
+            }
+            if (result.is_error()) {
+                if (result.error().code() == EAGAIN)
+                    continue;
+                return result.release_error();
+            }
+            // Let userspace deal with the signal and retry.
+            if (current_thread->has_unmasked_pending_signals())
+                return EINTR;
+        }
+    };
+
+    auto do_unlock_pi = [&]() -> ErrorOr<FlatPtr> {
+        auto* current_thread = Thread::current();
+        u32 tid = static_cast<u32>(current_thread->tid().value()) & FUTEX_TID_MASK;
+        for (;;) {
+            auto user_value = user_atomic_load_relaxed(params.userspace_address);
+            if (!user_value.has_value())
+                return EFAULT;
+            u32 value = user_value.value();
+            if ((value & FUTEX_TID_MASK) != tid)
+                return EPERM;
+
+            bool has_waiters;
+            {
+                SpinlockLocker locker(m_futex_lock);
+                auto futex_queue = find_futex_queue(user_address, false);
+                has_waiters = futex_queue && !futex_queue->is_empty_and_no_imminent_waits();
+                if (futex_queue)
+                    futex_queue->set_pi_owner(0);
+            }
+
+            // If anyone is waiting, leave the waiters flag set: whoever wakes up
+            // and grabs the lock then knows to come back here when unlocking.
+            atomic_thread_fence(AK::MemoryOrder::memory_order_release);
+            u32 expected = value;
+            auto exchanged = user_atomic_compare_exchange_relaxed(params.userspace_address, expected, has_waiters ? FUTEX_WAITERS : 0);
+            if (!exchanged.has_value())
+                return EFAULT;
+            if (!exchanged.value())
+                continue;
+
+            update_inherited_priority(*current_thread);
+            if (has_waiters)
+                do_wake(user_address, 1, {});
+            return 0;
+        }
+    };
+
     switch (cmd) {
     case FUTEX_WAIT:
-        return do_wait(0);
+        return do_wait(params.val, 0);
 
     case FUTEX_WAKE:
         return do_wake(user_address, params.val, {});
@@ -179,7 +310,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
         auto op = _FUTEX_OP(params.val3);
         if (op & FUTEX_OP_ARG_SHIFT) {
             op_arg = 1 << op_arg;
-            op &= FUTEX_OP_ARG_SHIFT;
+            op &= ~FUTEX_OP_ARG_SHIFT;
         }
         atomic_thread_fence(AK::MemoryOrder::memory_order_release);
         switch (op) {
@@ -241,11 +372,20 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
     case FUTEX_CMP_REQUEUE:
         return do_requeue(params.val3);
 
+    case FUTEX_LOCK_PI:
+        return do_lock_pi(false);
+
+    case FUTEX_TRYLOCK_PI:
+        return do_lock_pi(true);
+
+    case FUTEX_UNLOCK_PI:
+        return do_unlock_pi();
+
     case FUTEX_WAIT_BITSET:
         VERIFY(params.val3 != FUTEX_BITSET_MATCH_ANY); // we should have turned it into FUTEX_WAIT
         if (params.val3 == 0)
             return EINVAL;
-        return do_wait(params.val3);
+        return do_wait(params.val, params.val3);
 
     case FUTEX_WAKE_BITSET:
         VERIFY(params.val3 != FUTEX_BITSET_MATCH_ANY); // we should have turned it into FUTEX_WAKE
@@ -174,6 +174,7 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
     bool map_noreserve = flags & MAP_NORESERVE;
     bool map_randomized = flags & MAP_RANDOMIZED;
     bool map_fixed_noreplace = flags & MAP_FIXED_NOREPLACE;
+    bool map_hugepage = flags & MAP_HUGEPAGE;
 
     if (map_shared && map_private)
         return EINVAL;
@@ -189,6 +190,14 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
     if (map_stack && (!map_private || !map_anonymous))
         return EINVAL;
 
+    // Huge pages are only handed out for anonymous memory, and purgeable memory could lose them at any time.
+    if (map_hugepage && (!map_anonymous || (flags & MAP_PURGEABLE)))
+        return EINVAL;
+
+    // Unless we were told where to put it, make sure the mapping can actually make use of huge pages.
+    if (map_hugepage && !(map_fixed || map_fixed_noreplace) && rounded_size >= Memory::huge_page_size)
+        alignment = max(alignment, Memory::huge_page_size);
+
     Memory::Region* region = nullptr;
 
     // If MAP_FIXED is specified, existing mappings that intersect the requested range are removed.
@@ -240,6 +249,8 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
         region->set_shared(true);
     if (map_stack)
         region->set_stack(true);
+    if (map_hugepage)
+        region->set_wants_huge_pages(true);
     region->set_name(move(name));
 
     PerformanceManager::add_mmap_perf_event(*this, *region);
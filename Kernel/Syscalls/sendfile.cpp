@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/FIFO.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+// Data is moved through a kernel buffer of at most this size, so it never has to take a detour through userspace.
+static constexpr size_t max_transfer_chunk_size = 64 * KiB;
+
+ErrorOr<FlatPtr> Process::do_transfer(OpenFileDescription& source, Optional<off_t>& source_offset, OpenFileDescription& destination, Optional<off_t>& destination_offset, size_t count, bool nonblocking)
+{
+    if (count == 0)
+        return 0;
+
+    auto chunk_size = TRY(Memory::page_round_up(min(count, max_transfer_chunk_size)));
+    auto chunk = TRY(KBuffer::try_create_with_size(chunk_size, Memory::Region::Access::ReadWrite, "Transfer buffer"sv));
+
+    // NOTE: `nonblocking` only applies to pipes, other files block (or don't) as their descriptions say.
+    auto write_to_destination = [&](UserOrKernelBuffer const& data, size_t size) -> ErrorOr<size_t> {
+        if (destination_offset.has_value()) {
+            auto nwritten = TRY(destination.write(*destination_offset, data, size));
+            *destination_offset += nwritten;
+            return nwritten;
+        }
+        if (nonblocking && destination.is_fifo()) {
+            if (!destination.can_write())
+                return EAGAIN;
+            return destination.write(data, size);
+        }
+        return TRY(do_write(destination, data, size));
+    };
+
+    auto* fifo = source.is_fifo() ? source.fifo() : nullptr;
+
+    auto transfer_chunk = [&](Bytes chunk_bytes) -> ErrorOr<size_t> {
+        if (fifo) {
+            if (!source.can_read()) {
+                if (nonblocking || !source.is_blocking())
+                    return EAGAIN;
+                auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
+                if (Thread::current()->block<Thread::ReadBlocker>({}, source, unblock_flags).was_interrupted())
+                    return EINTR;
+                if (!has_flag(unblock_flags, Thread::FileBlocker::BlockFlags::Read))
+                    return EAGAIN;
+            }
+            return fifo->drain_into(source, chunk_bytes, [&](auto const& data, size_t size) { return write_to_destination(data, size); });
+        }
+
+        // The source is seekable, so we only advance it by as much as the destination took.
+        off_t position = source_offset.value_or(source.offset());
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(chunk_bytes.data());
+        auto nread = TRY(source.read(buffer, position, chunk_bytes.size()));
+        if (nread == 0)
+            return 0;
+        auto nwritten = TRY(write_to_destination(buffer, nread));
+        if (source_offset.has_value())
+            *source_offset += nwritten;
+        else
+            TRY(source.seek(position + nwritten, SEEK_SET));
+        return nwritten;
+    };
+
+    size_t total_transferred = 0;
+    while (total_transferred < count) {
+        // Don't wait for more data once a pipe has handed us what it had.
+        if (fifo && total_transferred > 0 && !source.can_read())
+            break;
+
+        auto result = transfer_chunk(chunk->bytes().trim(min(count - total_transferred, chunk->size())));
+        if (result.is_error()) {
+            if (total_transferred > 0)
+                break;
+            return result.release_error();
+        }
+        if (result.value() == 0)
+            break;
+        total_transferred += result.value();
+    }
+    return total_transferred;
+}
+
+ErrorOr<FlatPtr> Process::sys$sendfile(Userspace<Syscall::SC_sendfile_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+    if (params.count > NumericLimits<ssize_t>::max())
+        return EINVAL;
+
+    dbgln_if(IO_DEBUG, "sys$sendfile({}, {}, {}, {})", params.out_fd, params.in_fd, params.offset, params.count);
+
+    auto source = TRY(open_file_description(params.in_fd));
+    if (!source->is_readable())
+        return EBADF;
+    // Like on other systems, the data has to come out of a regular file (and with that, the page cache).
+    auto* inode = source->inode();
+    if (!inode || !inode->metadata().is_regular_file())
+        return EINVAL;
+
+    auto destination = TRY(open_file_description(params.out_fd));
+    if (!destination->is_writable())
+        return EBADF;
+
+    Userspace<off_t*> user_offset((FlatPtr)params.offset);
+    Optional<off_t> source_offset;
+    if (user_offset) {
+        off_t offset;
+        TRY(copy_from_user(&offset, user_offset));
+        if (offset < 0)
+            return EINVAL;
+        source_offset = offset;
+    }
+
+    Optional<off_t> destination_offset;
+    auto nwritten = TRY(do_transfer(*source, source_offset, *destination, destination_offset, params.count, false));
+    if (user_offset)
+        TRY(copy_to_user(user_offset, &source_offset.value()));
+    return nwritten;
+}
+
+static ErrorOr<Optional<off_t>> copy_splice_offset_from_user(OpenFileDescription const& description, Userspace<off_t*> user_offset)
+{
+    if (!user_offset)
+        return Optional<off_t> {};
+    if (description.is_fifo() || !description.file().is_seekable())
+        return ESPIPE;
+    off_t offset;
+    TRY(copy_from_user(&offset, user_offset));
+    if (offset < 0)
+        return EINVAL;
+    return Optional<off_t> { offset };
+}
+
+ErrorOr<FlatPtr> Process::sys$splice(Userspace<Syscall::SC_splice_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+    if (params.count > NumericLimits<ssize_t>::max())
+        return EINVAL;
+    if ((params.flags & (SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE)) != params.flags)
+        return EINVAL;
+
+    dbgln_if(IO_DEBUG, "sys$splice({}, {}, {}, {}, {}, {:#x})", params.fd_in, params.off_in, params.fd_out, params.off_out, params.count, params.flags);
+
+    auto source = TRY(open_file_description(params.fd_in));
+    if (!source->is_readable())
+        return EBADF;
+    if (source->is_directory())
+        return EISDIR;
+
+    auto destination = TRY(open_file_description(params.fd_out));
+    if (!destination->is_writable())
+        return EBADF;
+
+    // One end has to be a pipe, and it can't be the same one on both ends.
+    if (!source->is_fifo() && !destination->is_fifo())
+        return EINVAL;
+    if (source->is_fifo() && destination->is_fifo() && source->fifo() == destination->fifo())
+        return EINVAL;
+
+    // FIXME: Support splicing from sockets and devices. Unlike files, they can't take back
+    //        whatever data the pipe didn't have room for.
+    if (!source->is_fifo() && !source->file().is_seekable())
+        return EINVAL;
+
+    Userspace<off_t*> user_source_offset((FlatPtr)params.off_in);
+    Userspace<off_t*> user_destination_offset((FlatPtr)params.off_out);
+    auto source_offset = TRY(copy_splice_offset_from_user(*source, user_source_offset));
+    auto destination_offset = TRY(copy_splice_offset_from_user(*destination, user_destination_offset));
+
+    // NOTE: There's nothing to gain from SPLICE_F_MOVE or SPLICE_F_MORE for us, so they're accepted but ignored.
+    bool nonblocking = params.flags & SPLICE_F_NONBLOCK;
+    auto ntransferred = TRY(do_transfer(*source, source_offset, *destination, destination_offset, params.count, nonblocking));
+
+    if (source_offset.has_value())
+        TRY(copy_to_user(user_source_offset, &source_offset.value()));
+    if (destination_offset.has_value())
+        TRY(copy_to_user(user_destination_offset, &destination_offset.value()));
+    return ntransferred;
+}
+
+}
@@ -4,7 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/Process.h>
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/SyncTask.h>
@@ -18,7 +18,8 @@ UNMAP_AFTER_INIT void SyncTask::spawn()
     (void)Process::create_kernel_process(syncd_thread, KString::must_create("SyncTask"), [] {
         dbgln("SyncTask is running");
         for (;;) {
-            VirtualFileSystem::sync();
+            // NOTE: File contents are written back by the WritebackTask.
+            FileSystem::sync_metadata();
             (void)Thread::current()->sleep(Time::from_seconds(1));
         }
     });
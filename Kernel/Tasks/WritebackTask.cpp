@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/WritebackTask.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+static constexpr i64 writeback_interval_ms = 500;
+
+static Singleton<WaitQueue> s_writeback_wait_queue;
+
+UNMAP_AFTER_INIT void WritebackTask::spawn()
+{
+    RefPtr<Thread> writeback_thread;
+    (void)Process::create_kernel_process(writeback_thread, KString::must_create("WritebackTask"), [] {
+        dbgln("WritebackTask is running");
+        for (;;) {
+            FileSystem::write_back_all();
+            auto timeout = Time::from_milliseconds(writeback_interval_ms);
+            [[maybe_unused]] auto result = s_writeback_wait_queue->wait_on(Thread::BlockTimeout(false, &timeout), "WritebackTask"sv);
+        }
+    });
+}
+
+void WritebackTask::wake()
+{
+    s_writeback_wait_queue->wake_one();
+}
+
+}
@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+namespace Kernel {
+
+class WritebackTask {
+public:
+    static void spawn();
+    static void wake();
+};
+
+}
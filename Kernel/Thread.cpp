@@ -1268,6 +1268,23 @@ ErrorOr<NonnullRefPtr<Thread>> Thread::try_clone(Process& process)
     return clone;
 }
 
+void Thread::set_inherited_priority(u32 priority)
+{
+    SpinlockLocker scheduler_lock(g_scheduler_lock);
+    if (m_inherited_priority.exchange(priority) == priority)
+        return;
+    // If we're waiting to be scheduled, we were queued at our old priority.
+    if (m_state == Thread::State::Runnable && Scheduler::dequeue_runnable_thread(*this))
+        Scheduler::enqueue_runnable_thread(*this);
+}
+
+void Thread::raise_inherited_priority(u32 priority)
+{
+    SpinlockLocker scheduler_lock(g_scheduler_lock);
+    if (priority > inherited_priority())
+        set_inherited_priority(priority);
+}
+
 void Thread::set_state(State new_state, u8 stop_signal)
 {
     State previous_state;
@@ -164,6 +164,13 @@ public:
     void set_priority(u32 p) { m_priority = p; }
     u32 priority() const { return m_priority; }
 
+    // A thread holding a priority-inheritance futex runs at the priority of
+    // its most important waiter, if that is higher than its own.
+    void set_inherited_priority(u32);
+    void raise_inherited_priority(u32);
+    u32 inherited_priority() const { return m_inherited_priority.load(); }
+    u32 effective_priority() const { return max(m_priority, inherited_priority()); }
+
     void detach()
     {
         SpinlockLocker lock(m_lock);
@@ -1266,6 +1273,7 @@ private:
     State m_state { Thread::State::Invalid };
     NonnullOwnPtr<KString> m_name;
     u32 m_priority { THREAD_PRIORITY_NORMAL };
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> m_inherited_priority { 0 };
 
     State m_stop_state { Thread::State::Invalid };
 
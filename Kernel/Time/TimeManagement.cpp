@@ -433,12 +433,67 @@ bool TimeManagement::disable_profile_timer()
     return true;
 }
 
+// The TSC is calibrated against the time keeper over the first few seconds of
+// uptime. Until at least one second has passed, it isn't used at all.
+u64 TimeManagement::calibrate_tsc_for_time_page(u64 tsc, Time now)
+{
+    static constexpr i64 min_calibration_ns = 1'000'000'000;
+    // Keeps the shifted nanosecond count below 2^64.
+    static constexpr i64 max_calibration_ns = 4'000'000'000;
+
+    if (m_tsc_calibration_start_tsc == 0) {
+        m_tsc_calibration_start_tsc = tsc;
+        m_tsc_calibration_start_time = now;
+        return 0;
+    }
+
+    auto elapsed_ns = (now - m_tsc_calibration_start_time).to_nanoseconds();
+    if (elapsed_ns >= min_calibration_ns && elapsed_ns <= max_calibration_ns && tsc > m_tsc_calibration_start_tsc)
+        m_tsc_to_ns_multiplier = ((u64)elapsed_ns << 32) / (tsc - m_tsc_calibration_start_tsc);
+    return m_tsc_to_ns_multiplier;
+}
+
 void TimeManagement::update_time_page()
 {
     auto& page = time_page();
+    auto coarse_monotonic_time = monotonic_time(TimePrecision::Coarse);
+
+    // When this is called, the coarse clocks were just brought up to date, so
+    // they are also the best values we have for the precise clocks.
+    auto precise_monotonic_time = coarse_monotonic_time;
+    auto precise_epoch_time = Time::from_timespec(m_epoch_time);
+
+    u64 tsc = 0;
+    u64 tsc_to_ns_multiplier = 0;
+    auto& processor = Processor::current();
+    if (processor.has_feature(CPUFeature::TSC) && processor.has_feature(CPUFeature::CONSTANT_TSC) && processor.has_feature(CPUFeature::NONSTOP_TSC)) {
+        tsc = read_tsc();
+        tsc_to_ns_multiplier = calibrate_tsc_for_time_page(tsc, coarse_monotonic_time);
+
+        // The page still describes the previous update, and userspace may already
+        // have handed out a time interpolated from it that's later than ours.
+        if (page.tsc_to_ns_multiplier != 0) {
+            auto interpolated_time = Time::from_timespec(page.clocks[CLOCK_MONOTONIC]) + Time::from_nanoseconds(time_page_interpolate_ns(page, tsc));
+            if (interpolated_time > precise_monotonic_time) {
+                precise_epoch_time += interpolated_time - precise_monotonic_time;
+                precise_monotonic_time = interpolated_time;
+            }
+        }
+    }
+
+    // Interpolation stops a bit short of the next update. Otherwise the clocks
+    // could keep creeping ahead of the time keeper whenever it ticks early.
+    u64 update_interval_ns = 1'000'000'000ull / m_time_keeper_timer->frequency();
+
     u32 update_iteration = AK::atomic_fetch_add(&page.update2, 1u, AK::MemoryOrder::memory_order_acquire);
     page.clocks[CLOCK_REALTIME_COARSE] = m_epoch_time;
-    page.clocks[CLOCK_MONOTONIC_COARSE] = monotonic_time(TimePrecision::Coarse).to_timespec();
+    page.clocks[CLOCK_MONOTONIC_COARSE] = coarse_monotonic_time.to_timespec();
+    page.clocks[CLOCK_REALTIME] = precise_epoch_time.to_timespec();
+    page.clocks[CLOCK_MONOTONIC] = precise_monotonic_time.to_timespec();
+    page.clocks[CLOCK_MONOTONIC_RAW] = precise_monotonic_time.to_timespec();
+    page.tsc_at_update = tsc;
+    page.tsc_to_ns_multiplier = tsc_to_ns_multiplier;
+    page.max_interpolation_ns = update_interval_ns - update_interval_ns / 16;
     AK::atomic_store(&page.update1, update_iteration + 1u, AK::MemoryOrder::memory_order_release);
 }
 
@@ -78,6 +78,7 @@ public:
 private:
     TimePage& time_page();
     void update_time_page();
+    u64 calibrate_tsc_for_time_page(u64 tsc, Time now);
 
     bool probe_and_set_legacy_hardware_timers();
     bool probe_and_set_non_legacy_hardware_timers();
@@ -109,6 +110,11 @@ private:
     RefPtr<HardwareTimerBase> m_profile_timer;
 
     NonnullOwnPtr<Memory::Region> m_time_page_region;
+
+    // These are only ever accessed from update_time_page().
+    u64 m_tsc_calibration_start_tsc { 0 };
+    Time m_tsc_calibration_start_time;
+    u64 m_tsc_to_ns_multiplier { 0 };
 };
 
 }
@@ -13,10 +13,14 @@
 namespace Kernel {
 
 WorkQueue* g_io_work;
+WorkQueue* g_readahead_work;
 
 UNMAP_AFTER_INIT void WorkQueue::initialize()
 {
     g_io_work = new WorkQueue("IO WorkQueue");
+    // NOTE: Readahead waits for block device requests, which are completed on the IO work queue,
+    //       so it needs a thread of its own.
+    g_readahead_work = new WorkQueue("Readahead WorkQueue");
 }
 
 UNMAP_AFTER_INIT WorkQueue::WorkQueue(StringView name)
@@ -15,6 +15,7 @@
 namespace Kernel {
 
 extern WorkQueue* g_io_work;
+extern WorkQueue* g_readahead_work;
 
 class WorkQueue {
     AK_MAKE_NONCOPYABLE(WorkQueue);
@@ -22,6 +22,7 @@
 #include <Kernel/Devices/MemoryDevice.h>
 #include <Kernel/Devices/NullDevice.h>
 #include <Kernel/Devices/PCISerialDevice.h>
+#include <Kernel/Devices/PerformanceEventStreamDevice.h>
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/Devices/SelfTTYDevice.h>
 #include <Kernel/Devices/SerialDevice.h>
@@ -54,11 +55,13 @@
 #include <Kernel/Scheduler.h>
 #include <Kernel/Sections.h>
 #include <Kernel/Storage/StorageManagement.h>
+#include <Kernel/SysFSKernel.h>
 #include <Kernel/TTY/ConsoleManagement.h>
 #include <Kernel/TTY/PTYMultiplexer.h>
 #include <Kernel/TTY/VirtualConsole.h>
 #include <Kernel/Tasks/FinalizerTask.h>
 #include <Kernel/Tasks/SyncTask.h>
+#include <Kernel/Tasks/WritebackTask.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/WorkQueue.h>
 #include <Kernel/kstdio.h>
@@ -332,6 +335,7 @@ void init_stage2(void*)
     ConsoleManagement::the().initialize();
 
     SyncTask::spawn();
+    WritebackTask::spawn();
     FinalizerTask::spawn();
 
     auto boot_profiling = kernel_command_line().is_boot_profiling_enabled();
@@ -340,6 +344,7 @@ void init_stage2(void*)
         USB::USBManagement::initialize();
     }
     FirmwareSysFSDirectory::initialize();
+    KernelSysFSDirectory::initialize();
 
     if (!PCI::Access::is_disabled()) {
         VirtIO::detect();
@@ -354,6 +359,7 @@ void init_stage2(void*)
     (void)MemoryDevice::must_create().leak_ref();
     (void)ZeroDevice::must_create().leak_ref();
     (void)FullDevice::must_create().leak_ref();
+    (void)PerformanceEventStreamDevice::must_create().leak_ref();
     (void)RandomDevice::must_create().leak_ref();
     (void)SelfTTYDevice::must_create().leak_ref();
     PTYMultiplexer::initialize();
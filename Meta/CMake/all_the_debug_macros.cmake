@@ -111,6 +111,7 @@ set(LOCK_RESTORE_DEBUG ON)
 set(LOCK_SHARED_UPGRADE_DEBUG ON)
 set(LOCK_TRACE_DEBUG ON)
 set(LOOKUPSERVER_DEBUG ON)
+set(LOOPBACK_DEBUG ON)
 set(MALLOC_DEBUG ON)
 set(MARKDOWN_DEBUG ON)
 set(MATROSKA_DEBUG ON)
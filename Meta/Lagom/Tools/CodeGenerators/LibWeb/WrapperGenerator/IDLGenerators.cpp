@@ -1637,6 +1637,12 @@ public:
 )~~~");
     }
 
+    if (interface.extended_attributes.contains("CustomGet") || interface.extended_attributes.contains("CustomSet") || interface.is_legacy_platform_object()) {
+        generator.append(R"~~~(
+    virtual bool has_exotic_behavior_for(JS::PropertyKey const&) const override { return true; }
+)~~~");
+    }
+
     if (interface.is_legacy_platform_object()) {
         generator.append(R"~~~(
     virtual JS::ThrowCompletionOr<Optional<JS::PropertyDescriptor>> internal_get_own_property(JS::PropertyKey const&) const override;
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Time.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <syscall.h>
+#include <time.h>
+
+static constexpr clockid_t clocks[] = {
+    CLOCK_REALTIME,
+    CLOCK_MONOTONIC,
+    CLOCK_MONOTONIC_RAW,
+    CLOCK_REALTIME_COARSE,
+    CLOCK_MONOTONIC_COARSE,
+};
+
+static Time clock_gettime_via_syscall(clockid_t clock_id)
+{
+    timespec ts {};
+    EXPECT_EQ(static_cast<int>(syscall(SC_clock_gettime, clock_id, &ts)), 0);
+    return Time::from_timespec(ts);
+}
+
+static Time clock_gettime_via_libc(clockid_t clock_id)
+{
+    timespec ts {};
+    EXPECT_EQ(clock_gettime(clock_id, &ts), 0);
+    return Time::from_timespec(ts);
+}
+
+TEST_CASE(monotonic_clocks_never_go_backwards)
+{
+    for (auto clock_id : { CLOCK_MONOTONIC, CLOCK_MONOTONIC_RAW, CLOCK_MONOTONIC_COARSE }) {
+        auto previous = clock_gettime_via_libc(clock_id);
+        for (int i = 0; i < 1'000'000; ++i) {
+            auto now = clock_gettime_via_libc(clock_id);
+            EXPECT(now >= previous);
+            if (now < previous) {
+                warnln("Clock {} went backwards by {}ns", clock_id, (previous - now).to_nanoseconds());
+                break;
+            }
+            previous = now;
+        }
+    }
+}
+
+TEST_CASE(clocks_agree_with_the_kernel)
+{
+    // The kernel's clocks are only updated every few milliseconds, so allow for a bit of slack.
+    auto const tolerance = Time::from_milliseconds(50);
+
+    for (auto clock_id : clocks) {
+        auto before = clock_gettime_via_syscall(clock_id);
+        auto value = clock_gettime_via_libc(clock_id);
+        auto after = clock_gettime_via_syscall(clock_id);
+        EXPECT(value + tolerance >= before);
+        EXPECT(value <= after + tolerance);
+    }
+}
+
+TEST_CASE(invalid_clock)
+{
+    timespec ts {};
+    EXPECT_EQ(clock_gettime(CLOCK_ID_COUNT, &ts), -1);
+    EXPECT_EQ(errno, EINVAL);
+}
+
+static void benchmark_clock(StringView name, clockid_t clock_id)
+{
+    static constexpr int iterations = 1'000'000;
+
+    auto start = clock_gettime_via_libc(CLOCK_MONOTONIC);
+    for (int i = 0; i < iterations; ++i)
+        (void)clock_gettime_via_libc(clock_id);
+    auto libc_ns = (clock_gettime_via_libc(CLOCK_MONOTONIC) - start).to_nanoseconds();
+
+    start = clock_gettime_via_libc(CLOCK_MONOTONIC);
+    for (int i = 0; i < iterations; ++i)
+        (void)clock_gettime_via_syscall(clock_id);
+    auto syscall_ns = (clock_gettime_via_libc(CLOCK_MONOTONIC) - start).to_nanoseconds();
+
+    outln("{}: {}ns per clock_gettime(), {}ns per syscall", name, libc_ns / iterations, syscall_ns / iterations);
+}
+
+BENCHMARK_CASE(clock_gettime_speed)
+{
+    benchmark_clock("CLOCK_REALTIME"sv, CLOCK_REALTIME);
+    benchmark_clock("CLOCK_MONOTONIC"sv, CLOCK_MONOTONIC);
+    benchmark_clock("CLOCK_MONOTONIC_RAW"sv, CLOCK_MONOTONIC_RAW);
+    benchmark_clock("CLOCK_REALTIME_COARSE"sv, CLOCK_REALTIME_COARSE);
+    benchmark_clock("CLOCK_MONOTONIC_COARSE"sv, CLOCK_MONOTONIC_COARSE);
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/ScopeGuard.h>
+#include <LibCore/File.h>
+#include <LibTest/TestCase.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+struct Connection {
+    int server { -1 };
+    int client { -1 };
+    int accepted { -1 };
+    u16 client_port { 0 };
+
+    ~Connection()
+    {
+        close(accepted);
+        close(client);
+        close(server);
+    }
+};
+
+static void connect_over_loopback(Connection& connection)
+{
+    connection.server = socket(AF_INET, SOCK_STREAM, 0);
+    VERIFY(connection.server >= 0);
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    VERIFY(bind(connection.server, (sockaddr const*)&address, sizeof(address)) == 0);
+    VERIFY(listen(connection.server, 1) == 0);
+    socklen_t address_length = sizeof(address);
+    VERIFY(getsockname(connection.server, (sockaddr*)&address, &address_length) == 0);
+
+    connection.client = socket(AF_INET, SOCK_STREAM, 0);
+    VERIFY(connection.client >= 0);
+    VERIFY(connect(connection.client, (sockaddr const*)&address, sizeof(address)) == 0);
+
+    connection.accepted = accept(connection.server, nullptr, nullptr);
+    VERIFY(connection.accepted >= 0);
+
+    address_length = sizeof(address);
+    VERIFY(getsockname(connection.client, (sockaddr*)&address, &address_length) == 0);
+    connection.client_port = ntohs(address.sin_port);
+
+    VERIFY(fcntl(connection.client, F_SETFL, O_NONBLOCK) == 0);
+}
+
+static Optional<JsonObject> tcp_socket_info(u16 local_port)
+{
+    auto file = Core::File::construct("/proc/net/tcp");
+    if (!file->open(Core::OpenMode::ReadOnly))
+        return {};
+    auto json = JsonValue::from_string(file->read_all());
+    if (json.is_error() || !json.value().is_array())
+        return {};
+    for (auto& value : json.value().as_array().values()) {
+        auto& socket = value.as_object();
+        if (socket.get("local_port").to_u32() == local_port)
+            return socket;
+    }
+    return {};
+}
+
+// The knob only exists in kernels built with LOOPBACK_DEBUG.
+static bool set_loopback_drops_packets(bool enabled)
+{
+    int fd = open("/proc/sys/loopback_drops_packets", O_WRONLY);
+    if (fd < 0)
+        return false;
+    VERIFY(write(fd, enabled ? "1" : "0", 1) == 1);
+    close(fd);
+    return true;
+}
+
+static u8 pattern_byte(size_t offset)
+{
+    return static_cast<u8>(offset % 251);
+}
+
+TEST_CASE(window_scaling)
+{
+    Connection connection;
+    connect_over_loopback(connection);
+
+    // As long as nobody reads on the other end, we can't get more data into the network than the peer's window allows.
+    u8 chunk[4096];
+    memset(chunk, 'x', sizeof(chunk));
+    size_t total_written = 0;
+    for (int idle_rounds = 0; idle_rounds < 20;) {
+        auto nwritten = write(connection.client, chunk, sizeof(chunk));
+        if (nwritten > 0) {
+            total_written += nwritten;
+            idle_rounds = 0;
+            continue;
+        }
+        EXPECT_EQ(errno, EAGAIN);
+        usleep(10'000);
+        ++idle_rounds;
+    }
+
+    // Without window scaling, the window can't describe more than 64 KiB.
+    EXPECT(total_written > 65535);
+
+    auto info = tcp_socket_info(connection.client_port);
+    EXPECT(info.has_value());
+    EXPECT(info->get("window_scaling").to_bool());
+}
+
+TEST_CASE(recovery_from_lost_segments)
+{
+    if (!set_loopback_drops_packets(true)) {
+        warnln("Skipping, the loopback adapter can't drop packets without LOOPBACK_DEBUG");
+        return;
+    }
+    ScopeGuard stop_dropping_packets = [] { set_loopback_drops_packets(false); };
+
+    Connection connection;
+    connect_over_loopback(connection);
+
+    constexpr size_t total_size = 2 * MiB;
+    size_t total_written = 0;
+    size_t total_read = 0;
+    int idle_rounds = 0;
+    while (total_read < total_size && idle_rounds < 30) {
+        pollfd fds[2] {
+            { connection.client, static_cast<short>(total_written < total_size ? POLLOUT : 0), 0 },
+            { connection.accepted, POLLIN, 0 },
+        };
+        int rc = poll(fds, 2, 1000);
+        EXPECT(rc >= 0);
+        if (rc == 0) {
+            ++idle_rounds;
+            continue;
+        }
+        idle_rounds = 0;
+
+        if (fds[0].revents & POLLOUT) {
+            u8 chunk[16 * KiB];
+            size_t chunk_size = min(sizeof(chunk), total_size - total_written);
+            for (size_t i = 0; i < chunk_size; ++i)
+                chunk[i] = pattern_byte(total_written + i);
+            auto nwritten = write(connection.client, chunk, chunk_size);
+            if (nwritten > 0)
+                total_written += nwritten;
+            else
+                EXPECT_EQ(errno, EAGAIN);
+        }
+
+        if (fds[1].revents & POLLIN) {
+            u8 chunk[16 * KiB];
+            auto nread = read(connection.accepted, chunk, sizeof(chunk));
+            EXPECT(nread > 0);
+            if (nread <= 0)
+                break;
+            // Everything has to arrive exactly once and in order, no matter what went missing on the way.
+            for (ssize_t i = 0; i < nread; ++i) {
+                if (chunk[i] != pattern_byte(total_read + i)) {
+                    FAIL(String::formatted("Unexpected byte at offset {}", total_read + i));
+                    return;
+                }
+            }
+            total_read += nread;
+        }
+    }
+    EXPECT_EQ(total_read, total_size);
+
+    auto info = tcp_socket_info(connection.client_port);
+    EXPECT(info.has_value());
+    EXPECT(info->get("sack").to_bool());
+    EXPECT(info->get("retransmitted_packets").to_u32() > 0);
+}
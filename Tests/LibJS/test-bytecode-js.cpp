@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/TemporaryChange.h>
 #include <LibJS/Bytecode/Generator.h>
 #include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Interpreter.h>
@@ -39,10 +40,23 @@
     if (result_with_optimizations.is_error())                               \
         dbgln("Error: {}", MUST(result_with_optimizations.throw_completion().value()->to_string(bytecode_interpreter.global_object())));
 
-#define EXPECT_NO_EXCEPTION_ALL(source)           \
-    SETUP_AND_PARSE("(() => {\n" source "\n})()") \
-    EXPECT_NO_EXCEPTION(executable)               \
-    EXPECT_NO_EXCEPTION_WITH_OPTIMIZATIONS(executable)
+#define EXPECT_NO_EXCEPTION_WITH_AGGRESSIVE_OPTIMIZATIONS(parsed_program)                                                                       \
+    TemporaryChange change_optimization_level { JS::Bytecode::g_optimization_level, JS::Bytecode::Interpreter::OptimizationLevel::Aggressive }; \
+    auto aggressively_optimized_executable = MUST(JS::Bytecode::Generator::generate(parsed_program));                                           \
+    auto& aggressive_passes = JS::Bytecode::Interpreter::optimization_pipeline(JS::Bytecode::Interpreter::OptimizationLevel::Aggressive);       \
+    aggressive_passes.perform(*aggressively_optimized_executable);                                                                              \
+                                                                                                                                                \
+    auto result_with_aggressive_optimizations = bytecode_interpreter.run(*aggressively_optimized_executable);                                   \
+                                                                                                                                                \
+    EXPECT(!result_with_aggressive_optimizations.is_error());                                                                                   \
+    if (result_with_aggressive_optimizations.is_error())                                                                                        \
+        dbgln("Error: {}", MUST(result_with_aggressive_optimizations.throw_completion().value()->to_string(bytecode_interpreter.global_object())));
+
+#define EXPECT_NO_EXCEPTION_ALL(source)                \
+    SETUP_AND_PARSE("(() => {\n" source "\n})()")      \
+    EXPECT_NO_EXCEPTION(executable)                    \
+    EXPECT_NO_EXCEPTION_WITH_OPTIMIZATIONS(executable) \
+    EXPECT_NO_EXCEPTION_WITH_AGGRESSIVE_OPTIMIZATIONS(program)
 
 TEST_CASE(empty_program)
 {
@@ -138,3 +152,161 @@ TEST_CASE(catch_exception)
                             "if (hitCatch !== true) throw new Exception('failed');\n"
                             "if (hitFinally !== true) throw new Exception('failed');");
 }
+
+TEST_CASE(constant_folding)
+{
+    EXPECT_NO_EXCEPTION_ALL("if (2 * 3 + 4 !== 10) throw new Exception('failed');\n"
+                            "if ((1 << 31) !== -2147483648 || (-1 >>> 0) !== 4294967295) throw new Exception('failed');\n"
+                            "if (1 / -(0) !== -Infinity || !(0 / 0 !== 0 / 0)) throw new Exception('failed');\n"
+                            "if ('a' + 1 !== 'a1' || 1 + 1 + 'b' !== '2b') throw new Exception('failed');");
+}
+
+TEST_CASE(register_reuse)
+{
+    EXPECT_NO_EXCEPTION_ALL("function f(a, b) {\n"
+                            "    var x = a + b, y = a * b, z = [x, y, a, b];\n"
+                            "    var w = x; x = y; y = w;\n"
+                            "    return x * 1000 + y * 100 + z.length * 10 + z[3];\n"
+                            "}\n"
+                            "if (f(2, 3) !== 6543) throw new Exception('failed');");
+}
+
+// The property caching tests access properties through the same few call sites,
+// so that whatever GetById and PutById remembered from earlier accesses is put
+// to the test by the later ones.
+#define PROPERTY_ACCESSORS                     \
+    "function getFoo(o) { return o.foo; }\n"   \
+    "function setFoo(o, value) {\n"            \
+    "    'use strict';\n"                      \
+    "    o.foo = value;\n"                     \
+    "}\n"                                      \
+    "function check(condition) {\n"            \
+    "    if (!condition)\n"                    \
+    "        throw new Exception('failed');\n" \
+    "}\n"
+
+TEST_CASE(get_by_id_cache_shape_change)
+{
+    EXPECT_NO_EXCEPTION_ALL(PROPERTY_ACCESSORS
+                            "var objects = [{ foo: 1 }, { bar: 0, foo: 2 }, { baz: 0, bar: 0, foo: 3 }, { foo: 4, bar: 0 }];\n"
+                            "for (var i = 0; i < 3; ++i) {\n"
+                            "    for (var j = 0; j < objects.length; ++j)\n"
+                            "        check(getFoo(objects[j]) === j + 1);\n"
+                            "}\n"
+                            "check(getFoo({}) === undefined);\n"
+                            "var o = { foo: 1 };\n"
+                            "check(getFoo(o) === 1);\n"
+                            "o.bar = 2;\n"
+                            "o.foo = 3;\n"
+                            "check(getFoo(o) === 3);\n"
+                            "delete o.foo;\n"
+                            "check(getFoo(o) === undefined);");
+}
+
+TEST_CASE(get_by_id_cache_prototype_change)
+{
+    EXPECT_NO_EXCEPTION_ALL(PROPERTY_ACCESSORS
+                            "var grandparent = { foo: 'grandparent' };\n"
+                            "var parent = Object.create(grandparent);\n"
+                            "var child = Object.create(parent);\n"
+                            "check(getFoo(child) === 'grandparent');\n"
+                            "check(getFoo(child) === 'grandparent');\n"
+                            "parent.foo = 'parent';\n"
+                            "check(getFoo(child) === 'parent');\n"
+                            "child.foo = 'child';\n"
+                            "check(getFoo(child) === 'child');\n"
+                            "delete child.foo;\n"
+                            "check(getFoo(child) === 'parent');\n"
+                            "delete parent.foo;\n"
+                            "check(getFoo(child) === 'grandparent');\n"
+                            "grandparent.foo = 'changed';\n"
+                            "check(getFoo(child) === 'changed');\n"
+                            "var o = Object.create({ foo: 1 });\n"
+                            "check(getFoo(o) === 1);\n"
+                            "Object.setPrototypeOf(o, { foo: 2 });\n"
+                            "check(getFoo(o) === 2);\n"
+                            "Object.setPrototypeOf(o, null);\n"
+                            "check(getFoo(o) === undefined);");
+}
+
+TEST_CASE(get_by_id_cache_accessor)
+{
+    EXPECT_NO_EXCEPTION_ALL(PROPERTY_ACCESSORS
+                            "var o = {};\n"
+                            "Object.defineProperty(o, 'foo', { value: 1, configurable: true });\n"
+                            "check(getFoo(o) === 1);\n"
+                            "Object.defineProperty(o, 'foo', { get: function () { return 2; }, configurable: true });\n"
+                            "check(getFoo(o) === 2);\n"
+                            "var calls = 0;\n"
+                            "var withGetter = { get foo() { return ++calls; } };\n"
+                            "check(getFoo(withGetter) === 1);\n"
+                            "check(getFoo(withGetter) === 2);\n"
+                            "check(getFoo(new Proxy({ foo: 1 }, { get: function () { return 2; } })) === 2);");
+}
+
+TEST_CASE(get_by_id_cache_dictionary_invalidation)
+{
+    EXPECT_NO_EXCEPTION_ALL(PROPERTY_ACCESSORS
+                            "var o = {};\n"
+                            "for (var i = 0; i < 200; ++i)\n"
+                            "    o['p' + i] = i;\n"
+                            "o.foo = 'many';\n"
+                            "check(getFoo(o) === 'many');\n"
+                            "delete o.p0;\n"
+                            "check(getFoo(o) === 'many');\n"
+                            "o.foo = 'changed';\n"
+                            "check(getFoo(o) === 'changed');\n"
+                            "delete o.foo;\n"
+                            "check(getFoo(o) === undefined);\n"
+                            "o.foo = 'again';\n"
+                            "check(getFoo(o) === 'again');");
+}
+
+TEST_CASE(put_by_id_cache_shape_change)
+{
+    EXPECT_NO_EXCEPTION_ALL(PROPERTY_ACCESSORS
+                            "var a = { foo: 1 };\n"
+                            "var b = { bar: 0, foo: 1 };\n"
+                            "for (var i = 0; i < 3; ++i) {\n"
+                            "    setFoo(a, i);\n"
+                            "    setFoo(b, i * 2);\n"
+                            "    check(a.foo === i && b.foo === i * 2);\n"
+                            "}\n"
+                            "var objects = [{}, {}, { bar: 1 }];\n"
+                            "for (var j = 0; j < objects.length; ++j)\n"
+                            "    setFoo(objects[j], j);\n"
+                            "for (var j = 0; j < objects.length; ++j)\n"
+                            "    check(objects[j].foo === j);\n"
+                            "var keys = Object.keys(objects[2]);\n"
+                            "check(keys.length === 2 && keys[0] === 'bar' && keys[1] === 'foo');");
+}
+
+TEST_CASE(put_by_id_cache_accessor)
+{
+    EXPECT_NO_EXCEPTION_ALL(PROPERTY_ACCESSORS
+                            "var value;\n"
+                            "var o = Object.create({ set foo(v) { value = v; } });\n"
+                            "setFoo(o, 1);\n"
+                            "setFoo(o, 2);\n"
+                            "check(value === 2 && !Object.hasOwn(o, 'foo'));\n"
+                            "var p = { foo: 1 };\n"
+                            "setFoo(p, 2);\n"
+                            "Object.defineProperty(p, 'foo', { set: function (v) { value = v; } });\n"
+                            "setFoo(p, 3);\n"
+                            "check(value === 3);");
+}
+
+TEST_CASE(put_by_id_cache_frozen_object)
+{
+    EXPECT_NO_EXCEPTION_ALL(PROPERTY_ACCESSORS
+                            "var o = { foo: 1 };\n"
+                            "setFoo(o, 2);\n"
+                            "Object.freeze(o);\n"
+                            "var threw = false;\n"
+                            "try {\n"
+                            "    setFoo(o, 3);\n"
+                            "} catch (e) {\n"
+                            "    threw = e instanceof TypeError;\n"
+                            "}\n"
+                            "check(threw && o.foo === 2);");
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/Value.h>
+#include <LibJS/Runtime/VM.h>
+#include <LibJS/Script.h>
+#include <LibTest/TestCase.h>
+#include <math.h>
+
+// Every register, argument and indexed property is a Value, so keep an eye on its size.
+static_assert(sizeof(JS::Value) == 8);
+
+TEST_CASE(int32_round_trip)
+{
+    for (i32 value : { 0, 1, -1, 42, NumericLimits<i32>::min(), NumericLimits<i32>::max() }) {
+        JS::Value js_value(value);
+        EXPECT(js_value.is_int32());
+        EXPECT(js_value.is_number());
+        EXPECT(!js_value.is_cell());
+        EXPECT_EQ(js_value.type(), JS::Value::Type::Int32);
+        EXPECT_EQ(js_value.as_i32(), value);
+        EXPECT_EQ(js_value.as_double(), static_cast<double>(value));
+    }
+}
+
+TEST_CASE(integral_doubles_are_stored_as_int32)
+{
+    EXPECT(JS::Value(3.0).is_int32());
+    EXPECT(JS::Value(-2147483648.0).is_int32());
+    EXPECT(!JS::Value(2147483648.0).is_int32());
+    EXPECT(!JS::Value(0.5).is_int32());
+    EXPECT(!JS::Value(-0.0).is_int32());
+    EXPECT(JS::Value(-0.0).is_negative_zero());
+    EXPECT(JS::Value(0.0).is_positive_zero());
+    EXPECT(JS::Value(static_cast<unsigned>(NumericLimits<u32>::max())).is_double());
+}
+
+TEST_CASE(double_round_trip)
+{
+    for (double value : { 0.5, -0.5, 1e300, -1e-300, 4294967296.0, static_cast<double>(INFINITY), static_cast<double>(-INFINITY) }) {
+        JS::Value js_value(value);
+        EXPECT(js_value.is_double());
+        EXPECT_EQ(js_value.type(), JS::Value::Type::Double);
+        EXPECT_EQ(js_value.as_double(), value);
+    }
+    EXPECT(JS::Value(static_cast<double>(INFINITY)).is_positive_infinity());
+    EXPECT(JS::Value(static_cast<double>(-INFINITY)).is_negative_infinity());
+}
+
+TEST_CASE(nans_are_canonicalized)
+{
+    auto negative_nan = bit_cast<double>(0xfff8000000000000ull);
+    auto nan_with_payload = bit_cast<double>(0x7ff0000000000001ull);
+    auto nan_that_looks_like_a_cell = bit_cast<double>(0xfff9000012345678ull);
+    for (double value : { static_cast<double>(NAN), negative_nan, nan_with_payload, nan_that_looks_like_a_cell }) {
+        JS::Value js_value(value);
+        EXPECT(js_value.is_nan());
+        EXPECT(js_value.is_double());
+        EXPECT(!js_value.is_cell());
+        EXPECT_EQ(js_value.encoded(), JS::js_nan().encoded());
+    }
+}
+
+TEST_CASE(special_values)
+{
+    EXPECT(JS::Value().is_empty());
+    EXPECT(JS::js_undefined().is_undefined());
+    EXPECT(JS::js_undefined().is_nullish());
+    EXPECT(JS::js_null().is_null());
+    EXPECT(JS::js_null().is_nullish());
+    EXPECT(!JS::Value(0).is_nullish());
+    EXPECT(!JS::Value(false).is_nullish());
+    EXPECT(JS::Value(true).as_bool());
+    EXPECT(!JS::Value(false).as_bool());
+    EXPECT_EQ(JS::Value(true).type(), JS::Value::Type::Boolean);
+    EXPECT_EQ(JS::Value(static_cast<JS::Object*>(nullptr)).type(), JS::Value::Type::Null);
+}
+
+TEST_CASE(cells_round_trip)
+{
+    auto vm = JS::VM::create();
+    auto interpreter = JS::Interpreter::create<JS::GlobalObject>(*vm);
+    auto& global_object = interpreter->global_object();
+
+    JS::Value object_value(&global_object);
+    EXPECT(object_value.is_object());
+    EXPECT(object_value.is_cell());
+    EXPECT_EQ(&object_value.as_object(), &global_object);
+    EXPECT(JS::Value::is_boxed_cell(object_value.encoded()));
+    EXPECT_EQ(JS::Value::extract_pointer_bits(object_value.encoded()), bit_cast<FlatPtr>(&global_object));
+
+    auto* string = JS::js_string(*vm, "well hello friends");
+    JS::Value string_value(string);
+    EXPECT(string_value.is_string());
+    EXPECT(string_value.is_cell());
+    EXPECT_EQ(&string_value.as_string(), string);
+
+    EXPECT(!JS::Value::is_boxed_cell(JS::Value(1.5).encoded()));
+    EXPECT(!JS::Value::is_boxed_cell(JS::js_nan().encoded()));
+    EXPECT(!JS::Value::is_boxed_cell(JS::Value(static_cast<double>(-INFINITY)).encoded()));
+}
+
+static void run_script(StringView source)
+{
+    auto vm = JS::VM::create();
+    auto interpreter = JS::Interpreter::create<JS::GlobalObject>(*vm);
+    auto script_or_error = JS::Script::parse(source, interpreter->realm());
+    EXPECT(!script_or_error.is_error());
+    auto script = script_or_error.release_value();
+    auto result = interpreter->run(*script);
+    EXPECT(!result.is_error());
+}
+
+// These mostly shuffle numbers in and out of registers and packed array storage,
+// which is where the size of a Value shows.
+BENCHMARK_CASE(array_of_int32s)
+{
+    run_script(R"(
+        const array = [];
+        for (let i = 0; i < 1000000; ++i)
+            array.push(i);
+        let sum = 0;
+        for (let i = 0; i < array.length; ++i)
+            sum = (sum + array[i]) | 0;
+    )"sv);
+}
+
+BENCHMARK_CASE(array_of_doubles)
+{
+    run_script(R"(
+        const array = [];
+        for (let i = 0; i < 1000000; ++i)
+            array.push(i * 0.5);
+        let sum = 0;
+        for (let i = 0; i < array.length; ++i)
+            sum += array[i];
+    )"sv);
+}
+
+BENCHMARK_CASE(array_of_objects)
+{
+    run_script(R"(
+        const array = [];
+        for (let i = 0; i < 200000; ++i)
+            array.push({ value: i });
+        let sum = 0;
+        for (let i = 0; i < array.length; ++i)
+            sum += array[i].value;
+    )"sv);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibPthread/pthread.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <unistd.h>
+
+static void init_priority_inheriting_mutex(pthread_mutex_t& mutex)
+{
+    pthread_mutexattr_t attr;
+    EXPECT_EQ(0, pthread_mutexattr_init(&attr));
+    EXPECT_EQ(0, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT));
+    EXPECT_EQ(0, pthread_mutex_init(&mutex, &attr));
+    EXPECT_EQ(0, pthread_mutexattr_destroy(&attr));
+}
+
+TEST_CASE(mutexattr_protocol)
+{
+    pthread_mutexattr_t attr;
+    EXPECT_EQ(0, pthread_mutexattr_init(&attr));
+
+    int protocol = -1;
+    EXPECT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+    EXPECT_EQ(PTHREAD_PRIO_NONE, protocol);
+
+    EXPECT_EQ(0, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT));
+    EXPECT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+    EXPECT_EQ(PTHREAD_PRIO_INHERIT, protocol);
+
+    EXPECT_EQ(ENOTSUP, pthread_mutexattr_setprotocol(&attr, 0x1337));
+    EXPECT_EQ(0, pthread_mutexattr_destroy(&attr));
+}
+
+TEST_CASE(priority_inheriting_mutex_lock_unlock)
+{
+    pthread_mutex_t mutex;
+    init_priority_inheriting_mutex(mutex);
+
+    EXPECT_EQ(0, pthread_mutex_lock(&mutex));
+    EXPECT_EQ(EBUSY, pthread_mutex_trylock(&mutex));
+    EXPECT_EQ(0, pthread_mutex_unlock(&mutex));
+
+    EXPECT_EQ(0, pthread_mutex_trylock(&mutex));
+    EXPECT_EQ(0, pthread_mutex_unlock(&mutex));
+}
+
+struct ContendedCounter {
+    pthread_mutex_t mutex;
+    int value { 0 };
+};
+
+static constexpr int iterations_per_thread = 10000;
+static constexpr int thread_count = 4;
+
+TEST_CASE(priority_inheriting_mutex_contended)
+{
+    ContendedCounter counter;
+    init_priority_inheriting_mutex(counter.mutex);
+
+    pthread_t threads[thread_count];
+    for (auto& thread : threads) {
+        auto result = pthread_create(
+            &thread, nullptr, [](void* arg) -> void* {
+                auto& counter = *static_cast<ContendedCounter*>(arg);
+                for (int i = 0; i < iterations_per_thread; ++i) {
+                    pthread_mutex_lock(&counter.mutex);
+                    ++counter.value;
+                    pthread_mutex_unlock(&counter.mutex);
+                }
+                return nullptr;
+            },
+            &counter);
+        EXPECT_EQ(0, result);
+    }
+    for (auto& thread : threads)
+        EXPECT_EQ(0, pthread_join(thread, nullptr));
+
+    EXPECT_EQ(thread_count * iterations_per_thread, counter.value);
+}
+
+struct Broadcast {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool go { false };
+    int woken { 0 };
+};
+
+static void test_broadcast_wakes_everyone(Broadcast& broadcast)
+{
+    EXPECT_EQ(0, pthread_cond_init(&broadcast.cond, nullptr));
+
+    pthread_t threads[thread_count];
+    for (auto& thread : threads) {
+        auto result = pthread_create(
+            &thread, nullptr, [](void* arg) -> void* {
+                auto& broadcast = *static_cast<Broadcast*>(arg);
+                pthread_mutex_lock(&broadcast.mutex);
+                while (!broadcast.go)
+                    pthread_cond_wait(&broadcast.cond, &broadcast.mutex);
+                ++broadcast.woken;
+                pthread_mutex_unlock(&broadcast.mutex);
+                return nullptr;
+            },
+            &broadcast);
+        EXPECT_EQ(0, result);
+    }
+
+    // Give the threads a chance to actually go to sleep on the condition variable.
+    usleep(50 * 1000);
+
+    pthread_mutex_lock(&broadcast.mutex);
+    broadcast.go = true;
+    EXPECT_EQ(0, pthread_cond_broadcast(&broadcast.cond));
+    pthread_mutex_unlock(&broadcast.mutex);
+
+    for (auto& thread : threads)
+        EXPECT_EQ(0, pthread_join(thread, nullptr));
+
+    EXPECT_EQ(thread_count, broadcast.woken);
+}
+
+TEST_CASE(cond_broadcast_requeues_waiters)
+{
+    Broadcast broadcast;
+    EXPECT_EQ(0, pthread_mutex_init(&broadcast.mutex, nullptr));
+    test_broadcast_wakes_everyone(broadcast);
+}
+
+TEST_CASE(cond_broadcast_with_priority_inheriting_mutex)
+{
+    Broadcast broadcast;
+    init_priority_inheriting_mutex(broadcast.mutex);
+    test_broadcast_wakes_everyone(broadcast);
+}
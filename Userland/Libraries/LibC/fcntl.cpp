@@ -43,6 +43,13 @@ int inode_watcher_remove_watch(int fd, int wd)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t count, unsigned flags)
+{
+    Syscall::SC_splice_params params { fd_in, off_in, fd_out, off_out, count, flags };
+    int rc = syscall(SC_splice, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 int creat(char const* path, mode_t mode)
 {
     return open(path, O_CREAT | O_WRONLY | O_TRUNC, mode);
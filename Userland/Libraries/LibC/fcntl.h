@@ -20,4 +20,6 @@ int create_inode_watcher(unsigned flags);
 int inode_watcher_add_watch(int fd, char const* path, size_t path_length, unsigned event_mask);
 int inode_watcher_remove_watch(int fd, int wd);
 
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t count, unsigned flags);
+
 __END_DECLS
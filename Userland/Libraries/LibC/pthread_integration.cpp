@@ -97,12 +97,35 @@ static constexpr u32 MUTEX_UNLOCKED = 0;
 static constexpr u32 MUTEX_LOCKED_NO_NEED_TO_WAKE = 1;
 static constexpr u32 MUTEX_LOCKED_NEED_TO_WAKE = 2;
 
+// Priority-inheritance mutexes instead store the owner's TID in mutex->lock,
+// which lets the kernel find the owner and lend it the priority of its waiters.
+// The kernel sets FUTEX_WAITERS in there once someone is waiting.
+static inline u32 locked_value_for(pthread_mutex_t const* mutex)
+{
+    if (mutex->protocol == __PTHREAD_PRIO_INHERIT)
+        return static_cast<u32>(__pthread_self());
+    return MUTEX_LOCKED_NO_NEED_TO_WAKE;
+}
+
+static void lock_priority_inheriting_mutex(pthread_mutex_t* mutex)
+{
+    u32 expected = MUTEX_UNLOCKED;
+    if (AK::atomic_compare_exchange_strong(&mutex->lock, expected, locked_value_for(mutex), AK::memory_order_acquire))
+        return;
+
+    while (futex(&mutex->lock, FUTEX_LOCK_PI, 0, nullptr, nullptr, 0) < 0) {
+        // We get EINTR if a signal arrived while we were waiting; just try again.
+        VERIFY(errno == EINTR);
+    }
+}
+
 int __pthread_mutex_init(pthread_mutex_t* mutex, pthread_mutexattr_t const* attributes)
 {
     mutex->lock = 0;
     mutex->owner = 0;
     mutex->level = 0;
     mutex->type = attributes ? attributes->type : __PTHREAD_MUTEX_NORMAL;
+    mutex->protocol = attributes ? attributes->protocol : __PTHREAD_PRIO_NONE;
     return 0;
 }
 
@@ -111,7 +134,12 @@ int pthread_mutex_init(pthread_mutex_t*, pthread_mutexattr_t const*) __attribute
 int __pthread_mutex_trylock(pthread_mutex_t* mutex)
 {
     u32 expected = MUTEX_UNLOCKED;
-    bool exchanged = AK::atomic_compare_exchange_strong(&mutex->lock, expected, MUTEX_LOCKED_NO_NEED_TO_WAKE, AK::memory_order_acquire);
+    bool exchanged = AK::atomic_compare_exchange_strong(&mutex->lock, expected, locked_value_for(mutex), AK::memory_order_acquire);
+
+    // An unowned priority-inheritance mutex may still have FUTEX_WAITERS set,
+    // in which case only the kernel can hand it to us.
+    if (!exchanged && mutex->protocol == __PTHREAD_PRIO_INHERIT && (expected & FUTEX_TID_MASK) == 0)
+        exchanged = futex(&mutex->lock, FUTEX_TRYLOCK_PI, 0, nullptr, nullptr, 0) == 0;
 
     if (exchanged) [[likely]] {
         if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
@@ -135,7 +163,7 @@ int __pthread_mutex_lock(pthread_mutex_t* mutex)
 {
     // Fast path: attempt to claim the mutex without waiting.
     u32 value = MUTEX_UNLOCKED;
-    bool exchanged = AK::atomic_compare_exchange_strong(&mutex->lock, value, MUTEX_LOCKED_NO_NEED_TO_WAKE, AK::memory_order_acquire);
+    bool exchanged = AK::atomic_compare_exchange_strong(&mutex->lock, value, locked_value_for(mutex), AK::memory_order_acquire);
     if (exchanged) [[likely]] {
         if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
             AK::atomic_store(&mutex->owner, __pthread_self(), AK::memory_order_relaxed);
@@ -150,6 +178,15 @@ int __pthread_mutex_lock(pthread_mutex_t* mutex)
         }
     }
 
+    if (mutex->protocol == __PTHREAD_PRIO_INHERIT) {
+        // Slow path: let the kernel queue us up behind the owner.
+        lock_priority_inheriting_mutex(mutex);
+        if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
+            AK::atomic_store(&mutex->owner, __pthread_self(), AK::memory_order_relaxed);
+        mutex->level = 0;
+        return 0;
+    }
+
     // Slow path: wait, record the fact that we're going to wait, and always
     // remember to wake the next thread up once we release the mutex.
     if (value != MUTEX_LOCKED_NEED_TO_WAKE)
@@ -173,10 +210,14 @@ int __pthread_mutex_lock_pessimistic_np(pthread_mutex_t* mutex)
     // Same as pthread_mutex_lock(), but always set MUTEX_LOCKED_NEED_TO_WAKE,
     // and also don't bother checking for already owning the mutex recursively,
     // because we know we don't. Used in the condition variable implementation.
-    u32 value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
-    while (value != MUTEX_UNLOCKED) {
-        futex_wait(&mutex->lock, value, nullptr, 0);
-        value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
+    if (mutex->protocol == __PTHREAD_PRIO_INHERIT) {
+        lock_priority_inheriting_mutex(mutex);
+    } else {
+        u32 value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
+        while (value != MUTEX_UNLOCKED) {
+            futex_wait(&mutex->lock, value, nullptr, 0);
+            value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
+        }
     }
 
     if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
@@ -195,6 +236,16 @@ int __pthread_mutex_unlock(pthread_mutex_t* mutex)
     if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
         AK::atomic_store(&mutex->owner, 0, AK::memory_order_relaxed);
 
+    if (mutex->protocol == __PTHREAD_PRIO_INHERIT) {
+        // If FUTEX_WAITERS is set, the kernel has to hand the mutex on for us.
+        u32 expected = static_cast<u32>(__pthread_self());
+        if (!AK::atomic_compare_exchange_strong(&mutex->lock, expected, MUTEX_UNLOCKED, AK::memory_order_release)) {
+            int rc = futex(&mutex->lock, FUTEX_UNLOCK_PI, 0, nullptr, nullptr, 0);
+            VERIFY(rc >= 0);
+        }
+        return 0;
+    }
+
     u32 value = AK::atomic_exchange(&mutex->lock, MUTEX_UNLOCKED, AK::memory_order_release);
     if (value == MUTEX_LOCKED_NEED_TO_WAKE) [[unlikely]] {
         int rc = futex_wake(&mutex->lock, 1);
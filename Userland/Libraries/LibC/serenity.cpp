@@ -42,6 +42,8 @@ int futex(uint32_t* userspace_address, int futex_op, uint32_t value, const struc
 {
     int rc;
     switch (futex_op & FUTEX_CMD_MASK) {
+    case FUTEX_REQUEUE:
+    case FUTEX_CMP_REQUEUE:
     case FUTEX_WAKE_OP: {
         // These interpret timeout as a u32 value for val2
         Syscall::SC_futex_params params {
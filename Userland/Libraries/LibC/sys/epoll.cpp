@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include <syscall.h>
+
+extern "C" {
+
+int epoll_create(int size)
+{
+    // NOTE: The size is only a hint, and has been ignored everywhere for a long time. It still has to be positive, though.
+    if (size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return epoll_create1(0);
+}
+
+int epoll_create1(int flags)
+{
+    int rc = syscall(SC_epoll_create1, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int epoll_ctl(int epfd, int op, int fd, epoll_event* event)
+{
+    Syscall::SC_epoll_ctl_params params { epfd, op, fd, event };
+    int rc = syscall(SC_epoll_ctl, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int epoll_wait(int epfd, epoll_event* events, int maxevents, int timeout_ms)
+{
+    return epoll_pwait(epfd, events, maxevents, timeout_ms, nullptr);
+}
+
+int epoll_pwait(int epfd, epoll_event* events, int maxevents, int timeout_ms, sigset_t const* sigmask)
+{
+    timespec timeout;
+    timespec* timeout_ts = &timeout;
+    if (timeout_ms < 0)
+        timeout_ts = nullptr;
+    else
+        timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1'000'000 };
+
+    Syscall::SC_epoll_wait_params params { epfd, events, maxevents, timeout_ts, sigmask };
+    int rc = syscall(SC_epoll_wait, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+}
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <syscall.h>
+
+extern "C" {
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    Syscall::SC_sendfile_params params { out_fd, in_fd, offset, count };
+    int rc = syscall(SC_sendfile, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+}
@@ -407,6 +407,42 @@ static Kernel::TimePage* get_kernel_time_page()
     return s_kernel_time_page;
 }
 
+static bool read_clock_from_time_page(Kernel::TimePage& time_page, clockid_t clock_id, struct timespec& ts)
+{
+    bool needs_interpolation = Kernel::time_page_clock_needs_interpolation(clock_id);
+#if !ARCH(I386) && !ARCH(X86_64)
+    // There's no TSC to interpolate with.
+    if (needs_interpolation)
+        return false;
+#endif
+
+    u32 update_iteration;
+    u64 elapsed_ns = 0;
+    do {
+        update_iteration = AK::atomic_load(&time_page.update1, AK::memory_order_acquire);
+#if ARCH(I386) || ARCH(X86_64)
+        if (needs_interpolation) {
+            if (time_page.tsc_to_ns_multiplier == 0)
+                return false;
+            u32 lsw;
+            u32 msw;
+            asm volatile("rdtsc"
+                         : "=d"(msw), "=a"(lsw));
+            elapsed_ns = Kernel::time_page_interpolate_ns(time_page, ((u64)msw << 32) | lsw);
+        }
+#endif
+        ts = time_page.clocks[clock_id];
+    } while (update_iteration != AK::atomic_load(&time_page.update2, AK::memory_order_acquire));
+
+    // elapsed_ns is always less than a second.
+    ts.tv_nsec += elapsed_ns;
+    if (ts.tv_nsec >= 1'000'000'000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1'000'000'000;
+    }
+    return true;
+}
+
 int clock_gettime(clockid_t clock_id, struct timespec* ts)
 {
     if (Kernel::time_page_supports(clock_id)) {
@@ -416,12 +452,8 @@ int clock_gettime(clockid_t clock_id, struct timespec* ts)
         }
 
         if (auto* kernel_time_page = get_kernel_time_page()) {
-            u32 update_iteration;
-            do {
-                update_iteration = AK::atomic_load(&kernel_time_page->update1, AK::memory_order_acquire);
-                *ts = kernel_time_page->clocks[clock_id];
-            } while (update_iteration != AK::atomic_load(&kernel_time_page->update2, AK::memory_order_acquire));
-            return 0;
+            if (read_clock_from_time_page(*kernel_time_page, clock_id, *ts))
+                return 0;
         }
     }
 
@@ -6,6 +6,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/AnyOf.h>
 #include <AK/Assertions.h>
 #include <AK/Badge.h>
 #include <AK/Debug.h>
@@ -14,6 +15,7 @@
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
 #include <AK/NeverDestroyed.h>
+#include <AK/NumericLimits.h>
 #include <AK/Singleton.h>
 #include <AK/TemporaryChange.h>
 #include <AK/Time.h>
@@ -39,6 +41,14 @@
 extern bool s_global_initializers_ran;
 #endif
 
+// On Serenity, we keep the set of watched file descriptors in the kernel with epoll, instead of
+// handing all of them to select() on every iteration. Other systems still use select().
+// NOTE: Linux has epoll as well, but it refuses to watch regular files, which select() always reports as ready.
+#if defined(__serenity__)
+#    define EVENTLOOP_USES_EPOLL
+#    include <sys/epoll.h>
+#endif
+
 namespace Core {
 
 class InspectorServerConnection;
@@ -73,6 +83,64 @@ static thread_local HashTable<Notifier*>* s_notifiers;
 thread_local int EventLoop::s_wake_pipe_fds[2];
 thread_local bool EventLoop::s_wake_pipe_initialized { false };
 
+#ifdef EVENTLOOP_USES_EPOLL
+// All notifiers of a file descriptor share its entry in the epoll set, which watches for the union of their events.
+struct EpollEntry {
+    Vector<Notifier*, 1> notifiers;
+    u32 events { 0 };
+};
+
+static thread_local int s_epoll_fd { -1 };
+static thread_local HashMap<int, EpollEntry>* s_epoll_entries;
+
+// If the file descriptor may have been closed and reused since it was last added, we have to add it again,
+// even if the events we're interested in stayed the same.
+static void update_epoll_entry(int fd, bool fd_may_have_been_reused = false)
+{
+    auto it = s_epoll_entries->find(fd);
+    if (it == s_epoll_entries->end())
+        return;
+    auto& entry = it->value;
+
+    u32 events = 0;
+    for (auto* notifier : entry.notifiers) {
+        if (notifier->event_mask() & Notifier::Read)
+            events |= EPOLLIN;
+        if (notifier->event_mask() & Notifier::Write)
+            events |= EPOLLOUT;
+        if (notifier->event_mask() & Notifier::Exceptional)
+            VERIFY_NOT_REACHED();
+    }
+    if (events == entry.events && !fd_may_have_been_reused) {
+        if (entry.notifiers.is_empty())
+            s_epoll_entries->remove(it);
+        return;
+    }
+
+    if (events == 0) {
+        // NOTE: The file descriptor may already have been closed, in which case it has left the set on its own.
+        (void)epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    } else {
+        epoll_event event {};
+        event.events = events;
+        event.data.fd = fd;
+        int op = (entry.events == 0 || fd_may_have_been_reused) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        int rc = epoll_ctl(s_epoll_fd, op, fd, &event);
+        // Someone may have closed the file descriptor and opened another one with the same number behind our back.
+        if (rc < 0 && errno == EEXIST)
+            rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        else if (rc < 0 && errno == ENOENT)
+            rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        if (rc < 0)
+            dbgln("Core::EventLoop: Failed to watch fd {}: {}", fd, strerror(errno));
+    }
+
+    entry.events = events;
+    if (entry.notifiers.is_empty())
+        s_epoll_entries->remove(it);
+}
+#endif
+
 void EventLoop::initialize_wake_pipes()
 {
     if (!s_wake_pipe_initialized) {
@@ -85,6 +153,19 @@ void EventLoop::initialize_wake_pipes()
 
 #endif
         VERIFY(rc == 0);
+
+#ifdef EVENTLOOP_USES_EPOLL
+        // The epoll set lives alongside the wake pipe, which it always watches.
+        if (s_epoll_fd >= 0)
+            close(s_epoll_fd);
+        s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        VERIFY(s_epoll_fd >= 0);
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = s_wake_pipe_fds[0];
+        rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, s_wake_pipe_fds[0], &event);
+        VERIFY(rc == 0);
+#endif
         s_wake_pipe_initialized = true;
     }
 }
@@ -322,6 +403,9 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
         s_event_loop_stack = new Vector<EventLoop&>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
         s_notifiers = new HashTable<Notifier*>;
+#ifdef EVENTLOOP_USES_EPOLL
+        s_epoll_entries = new HashMap<int, EpollEntry>;
+#endif
     }
     s_main_event_loop.with_locked([&, this](auto*& main_event_loop) {
         if (main_event_loop == nullptr) {
@@ -644,6 +728,10 @@ void EventLoop::notify_forked(ForkEvent event)
         s_event_loop_stack->clear();
         s_timers->clear();
         s_notifiers->clear();
+#ifdef EVENTLOOP_USES_EPOLL
+        // NOTE: The epoll set is shared with our parent, so we start over with one of our own.
+        s_epoll_entries->clear();
+#endif
         s_wake_pipe_initialized = false;
         initialize_wake_pipes();
         if (auto* info = signals_info<false>()) {
@@ -662,9 +750,14 @@ void EventLoop::notify_forked(ForkEvent event)
 
 void EventLoop::wait_for_event(WaitMode mode)
 {
+#ifdef EVENTLOOP_USES_EPOLL
+    epoll_event ready_events[32];
+#else
     fd_set rfds;
     fd_set wfds;
+#endif
 retry:
+#ifndef EVENTLOOP_USES_EPOLL
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
 
@@ -687,6 +780,7 @@ retry:
         if (notifier->event_mask() & Notifier::Exceptional)
             VERIFY_NOT_REACHED();
     }
+#endif
 
     bool queued_events_is_empty;
     {
@@ -695,23 +789,28 @@ retry:
     }
 
     Time now;
-    struct timeval timeout = { 0, 0 };
+    Time timeout = Time::zero();
     bool should_wait_forever = false;
     if (mode == WaitMode::WaitForEvents && queued_events_is_empty) {
         auto next_timer_expiration = get_next_timer_expiration();
         if (next_timer_expiration.has_value()) {
             now = Time::now_monotonic_coarse();
             auto computed_timeout = next_timer_expiration.value() - now;
-            if (computed_timeout.is_negative())
-                computed_timeout = Time::zero();
-            timeout = computed_timeout.to_timeval();
+            if (!computed_timeout.is_negative())
+                timeout = computed_timeout;
         } else {
             should_wait_forever = true;
         }
     }
 
 try_select_again:
-    int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+#ifdef EVENTLOOP_USES_EPOLL
+    int timeout_ms = should_wait_forever ? -1 : static_cast<int>(min(timeout.to_milliseconds(), static_cast<i64>(NumericLimits<int>::max())));
+    int marked_fd_count = epoll_wait(s_epoll_fd, ready_events, array_size(ready_events), timeout_ms);
+#else
+    auto timeout_timeval = timeout.to_timeval();
+    int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout_timeval);
+#endif
     if (marked_fd_count < 0) {
         int saved_errno = errno;
         if (saved_errno == EINTR) {
@@ -722,7 +821,12 @@ try_select_again:
         dbgln("Core::EventLoop::wait_for_event: {} ({}: {})", marked_fd_count, saved_errno, strerror(saved_errno));
         VERIFY_NOT_REACHED();
     }
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+#ifdef EVENTLOOP_USES_EPOLL
+    bool wake_pipe_is_readable = any_of(ready_events, ready_events + marked_fd_count, [](auto& event) { return event.data.fd == s_wake_pipe_fds[0]; });
+#else
+    bool wake_pipe_is_readable = FD_ISSET(s_wake_pipe_fds[0], &rfds);
+#endif
+    if (wake_pipe_is_readable) {
         int wake_events[8];
         ssize_t nread;
         // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
@@ -780,6 +884,23 @@ try_select_again:
     if (!marked_fd_count)
         return;
 
+#ifdef EVENTLOOP_USES_EPOLL
+    for (int i = 0; i < marked_fd_count; ++i) {
+        auto& ready_event = ready_events[i];
+        auto it = s_epoll_entries->find(ready_event.data.fd);
+        if (it == s_epoll_entries->end())
+            continue;
+        // NOTE: Errors and hangups are reported regardless of what we asked for, let the notifiers find out about them by reading or writing.
+        bool readable = ready_event.events & (EPOLLIN | EPOLLERR | EPOLLHUP);
+        bool writable = ready_event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP);
+        for (auto* notifier : it->value.notifiers) {
+            if (readable && (notifier->event_mask() & Notifier::Event::Read))
+                post_event(*notifier, make<NotifierReadEvent>(notifier->fd()));
+            if (writable && (notifier->event_mask() & Notifier::Event::Write))
+                post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
+        }
+    }
+#else
     for (auto& notifier : *s_notifiers) {
         if (FD_ISSET(notifier->fd(), &rfds)) {
             if (notifier->event_mask() & Notifier::Event::Read)
@@ -790,6 +911,7 @@ try_select_again:
                 post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
         }
     }
+#endif
 }
 
 bool EventLoopTimer::has_expired(Time const& now) const
@@ -853,13 +975,33 @@ bool EventLoop::unregister_timer(int timer_id)
 void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
     VERIFY_EVENT_LOOP_INITIALIZED();
-    s_notifiers->set(&notifier);
+    if (s_notifiers->set(&notifier) != AK::HashSetResult::InsertedNewEntry)
+        return;
+#ifdef EVENTLOOP_USES_EPOLL
+    s_epoll_entries->ensure(notifier.fd()).notifiers.append(&notifier);
+    update_epoll_entry(notifier.fd(), true);
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
     VERIFY_EVENT_LOOP_INITIALIZED();
-    s_notifiers->remove(&notifier);
+    if (!s_notifiers->remove(&notifier))
+        return;
+#ifdef EVENTLOOP_USES_EPOLL
+    if (auto it = s_epoll_entries->find(notifier.fd()); it != s_epoll_entries->end()) {
+        it->value.notifiers.remove_first_matching([&](auto* other) { return other == &notifier; });
+        update_epoll_entry(notifier.fd());
+    }
+#endif
+}
+
+void EventLoop::notifier_event_mask_changed(Badge<Notifier>, [[maybe_unused]] Notifier& notifier)
+{
+#ifdef EVENTLOOP_USES_EPOLL
+    if (s_notifiers && s_notifiers->contains(&notifier))
+        update_epoll_entry(notifier.fd());
+#endif
 }
 
 void EventLoop::wake_current()
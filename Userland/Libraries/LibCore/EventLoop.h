@@ -76,6 +76,7 @@ public:
 
     static void register_notifier(Badge<Notifier>, Notifier&);
     static void unregister_notifier(Badge<Notifier>, Notifier&);
+    static void notifier_event_mask_changed(Badge<Notifier>, Notifier&);
 
     void quit(int);
     void unquit();
@@ -295,6 +295,7 @@ public:
     virtual bool is_eof() const override { return m_helper.is_eof(); }
     virtual bool is_open() const override { return m_helper.is_open(); };
     virtual void close() override { m_helper.close(); };
+    int fd() const { return m_helper.fd(); }
     virtual ErrorOr<size_t> pending_bytes() const override { return m_helper.pending_bytes(); }
     virtual ErrorOr<bool> can_read_without_blocking(int timeout = 0) const override { return m_helper.can_read_without_blocking(timeout); }
     virtual void set_notifications_enabled(bool enabled) override
@@ -844,6 +845,9 @@ public:
 
     virtual size_t buffer_size() const override { return m_helper.buffer_size(); }
 
+    // NOTE: Anything written to the fd directly bypasses (and doesn't care about) the read buffer.
+    int fd() const requires(requires(T const& socket) { socket.fd(); }) { return m_helper.stream().fd(); }
+
     virtual ~BufferedSocket() override = default;
 
 private:
@@ -24,6 +24,7 @@
 
 #ifdef __serenity__
 #    include <serenity.h>
+#    include <sys/sendfile.h>
 #endif
 
 #if defined(__linux__) && !defined(MFD_CLOEXEC)
@@ -101,6 +102,14 @@ ErrorOr<int> recvfd(int sockfd, int options)
     return fd;
 }
 
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    auto rc = ::sendfile(out_fd, in_fd, offset, count);
+    if (rc < 0)
+        return Error::from_syscall("sendfile"sv, -errno);
+    return rc;
+}
+
 ErrorOr<void> ptrace_peekbuf(pid_t tid, void const* tracee_addr, Bytes destination_buf)
 {
     Syscall::SC_ptrace_buf_params buf_params {
@@ -849,7 +849,7 @@ Bytecode::CodeGenerationErrorOr<void> ObjectExpression::generate_bytecode(Byteco
             if (property_kind != Bytecode::Op::PropertyKind::Spread)
                 TRY(property.value().generate_bytecode(generator));
 
-            generator.emit<Bytecode::Op::PutById>(object_reg, key_name, property_kind);
+            generator.emit<Bytecode::Op::PutById>(object_reg, key_name, generator.next_property_lookup_cache(), property_kind);
         } else {
             TRY(property.key().generate_bytecode(generator));
             auto property_reg = generator.allocate_register();
@@ -958,7 +958,7 @@ static Bytecode::CodeGenerationErrorOr<void> generate_object_binding_pattern_byt
             }
 
             generator.emit<Bytecode::Op::Load>(value_reg);
-            generator.emit<Bytecode::Op::GetById>(generator.intern_identifier(identifier));
+            generator.emit<Bytecode::Op::GetById>(generator.intern_identifier(identifier), generator.next_property_lookup_cache());
         } else {
             auto expression = name.get<NonnullRefPtr<Expression>>();
             TRY(expression->generate_bytecode(generator));
@@ -1237,7 +1237,7 @@ Bytecode::CodeGenerationErrorOr<void> CallExpression::generate_bytecode(Bytecode
             generator.emit<Bytecode::Op::GetByValue>(this_reg);
         } else {
             auto identifier_table_ref = generator.intern_identifier(verify_cast<Identifier>(member_expression.property()).string());
-            generator.emit<Bytecode::Op::GetById>(identifier_table_ref);
+            generator.emit<Bytecode::Op::GetById>(identifier_table_ref, generator.next_property_lookup_cache());
         }
         generator.emit<Bytecode::Op::Store>(callee_reg);
     } else {
@@ -1482,7 +1482,7 @@ Bytecode::CodeGenerationErrorOr<void> TaggedTemplateLiteral::generate_bytecode(B
     generator.emit<Bytecode::Op::Store>(raw_strings_reg);
 
     generator.emit<Bytecode::Op::Load>(strings_reg);
-    generator.emit<Bytecode::Op::PutById>(raw_strings_reg, generator.intern_identifier("raw"));
+    generator.emit<Bytecode::Op::PutById>(raw_strings_reg, generator.intern_identifier("raw"), generator.next_property_lookup_cache());
 
     generator.emit<Bytecode::Op::LoadImmediate>(js_undefined());
     auto this_reg = generator.allocate_register();
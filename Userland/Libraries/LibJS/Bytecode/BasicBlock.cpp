@@ -7,6 +7,7 @@
 #include <AK/String.h>
 #include <LibJS/Bytecode/BasicBlock.h>
 #include <LibJS/Bytecode/Op.h>
+#include <string.h>
 #include <sys/mman.h>
 
 namespace JS::Bytecode {
@@ -64,4 +65,28 @@ void BasicBlock::grow(size_t additional_size)
     VERIFY(m_buffer_size <= m_buffer_capacity);
 }
 
+void BasicBlock::remove_instructions(Vector<size_t> const& offsets)
+{
+    // NOTE: Like MergeBlocks, this assumes that instructions can be moved around in memory.
+    size_t write_offset = 0;
+    size_t offsets_index = 0;
+    Bytecode::InstructionStreamIterator it(instruction_stream());
+    while (!it.at_end()) {
+        auto offset = it.offset();
+        auto& instruction = const_cast<Instruction&>(*it);
+        auto length = instruction.length();
+        ++it;
+        if (offsets_index < offsets.size() && offsets[offsets_index] == offset) {
+            ++offsets_index;
+            Instruction::destroy(instruction);
+            continue;
+        }
+        if (write_offset != offset)
+            memmove(m_buffer + write_offset, m_buffer + offset, length);
+        write_offset += length;
+    }
+    VERIFY(offsets_index == offsets.size());
+    m_buffer_size = write_offset;
+}
+
 }
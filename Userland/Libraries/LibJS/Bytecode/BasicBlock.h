@@ -36,6 +36,9 @@ public:
     bool can_grow(size_t additional_size) const { return m_buffer_size + additional_size <= m_buffer_capacity; }
     void grow(size_t additional_size);
 
+    // Destroys the instructions at the given (ascending) offsets and moves the remaining ones up to close the gaps.
+    void remove_instructions(Vector<size_t> const& offsets);
+
     void terminate(Badge<Generator>) { m_is_terminated = true; }
     bool is_terminated() const { return m_is_terminated; }
 
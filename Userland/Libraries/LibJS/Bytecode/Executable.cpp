@@ -5,9 +5,20 @@
  */
 
 #include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Op.h>
 
 namespace JS::Bytecode {
 
+size_t Executable::instruction_count() const
+{
+    size_t count = 0;
+    for (auto& block : basic_blocks) {
+        for (InstructionStreamIterator it { block.instruction_stream() }; !it.at_end(); ++it)
+            ++count;
+    }
+    return count;
+}
+
 void Executable::dump() const
 {
     dbgln("\033[33;1mJS::Bytecode::Executable\033[0m ({})", name);
@@ -6,24 +6,48 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/FlyString.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <AK/WeakPtr.h>
 #include <LibJS/Bytecode/BasicBlock.h>
 #include <LibJS/Bytecode/IdentifierTable.h>
 #include <LibJS/Bytecode/StringTable.h>
+#include <LibJS/Runtime/Shape.h>
 
 namespace JS::Bytecode {
 
+// Remembers where GetById and PutById found their property the last few times,
+// keyed on the shapes of the objects involved.
+struct PropertyLookupCache {
+    static constexpr size_t max_entries = 4;
+    static constexpr size_t max_prototype_chain_length = 4;
+
+    struct Entry {
+        // The shapes of the base object and of every prototype up to and including the one that has the property.
+        AK::Array<WeakPtr<Shape>, max_prototype_chain_length + 1> shapes;
+        AK::Array<u32, max_prototype_chain_length + 1> shape_serial_numbers {};
+        size_t prototype_chain_length { 0 };
+        u32 property_offset { 0 };
+    };
+
+    AK::Array<Entry, max_entries> entries;
+    size_t next_entry_to_replace { 0 };
+};
+
 struct Executable {
     FlyString name;
     NonnullOwnPtrVector<BasicBlock> basic_blocks;
     NonnullOwnPtr<StringTable> string_table;
     NonnullOwnPtr<IdentifierTable> identifier_table;
     size_t number_of_registers { 0 };
+    mutable Vector<PropertyLookupCache> property_lookup_caches;
 
     String const& get_string(StringTableIndex index) const { return string_table->get(index); }
     FlyString const& get_identifier(IdentifierTableIndex index) const { return identifier_table->get(index); }
 
+    size_t instruction_count() const;
+
     void dump() const;
 };
 
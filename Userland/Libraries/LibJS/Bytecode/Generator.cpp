@@ -41,12 +41,15 @@ CodeGenerationErrorOr<NonnullOwnPtr<Executable>> Generator::generate(ASTNode con
             generator.emit<Bytecode::Op::Yield>(nullptr);
         }
     }
-    return adopt_own(*new Executable {
+    auto executable = adopt_own(*new Executable {
         .name = {},
         .basic_blocks = move(generator.m_root_basic_blocks),
         .string_table = move(generator.m_string_table),
         .identifier_table = move(generator.m_identifier_table),
-        .number_of_registers = generator.m_next_register });
+        .number_of_registers = generator.m_next_register,
+        .property_lookup_caches = {} });
+    executable->property_lookup_caches.resize(generator.m_next_property_lookup_cache);
+    return executable;
 }
 
 void Generator::grow(size_t additional_size)
@@ -145,7 +148,7 @@ CodeGenerationErrorOr<void> Generator::emit_load_from_reference(JS::ASTNode cons
             emit<Bytecode::Op::GetByValue>(object_reg);
         } else if (expression.property().is_identifier()) {
             auto identifier_table_ref = intern_identifier(verify_cast<Identifier>(expression.property()).string());
-            emit<Bytecode::Op::GetById>(identifier_table_ref);
+            emit<Bytecode::Op::GetById>(identifier_table_ref, next_property_lookup_cache());
         } else {
             return CodeGenerationError {
                 &expression,
@@ -184,7 +187,7 @@ CodeGenerationErrorOr<void> Generator::emit_store_to_reference(JS::ASTNode const
         } else if (expression.property().is_identifier()) {
             emit<Bytecode::Op::Load>(value_reg);
             auto identifier_table_ref = intern_identifier(verify_cast<Identifier>(expression.property()).string());
-            emit<Bytecode::Op::PutById>(object_reg, identifier_table_ref);
+            emit<Bytecode::Op::PutById>(object_reg, identifier_table_ref, next_property_lookup_cache());
         } else {
             return CodeGenerationError {
                 &expression,
@@ -108,6 +108,14 @@ public:
     void replace_references(BasicBlock const&, BasicBlock const&);
     static void destroy(Instruction&);
 
+    // Calls the callback with every register operand, apart from the accumulator that most instructions use implicitly.
+    template<typename Callback>
+    void visit_registers(Callback);
+
+    // Instructions without register operands don't have to provide their own.
+    template<typename Callback>
+    void visit_registers_impl(Callback) { }
+
 protected:
     explicit Instruction(Type type)
         : m_type(type)
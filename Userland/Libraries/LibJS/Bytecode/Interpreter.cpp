@@ -19,6 +19,7 @@ namespace JS::Bytecode {
 
 static Interpreter* s_current;
 bool g_dump_bytecode = false;
+Interpreter::OptimizationLevel g_optimization_level = Interpreter::OptimizationLevel::Default;
 
 Interpreter* Interpreter::current()
 {
@@ -222,7 +223,7 @@ Bytecode::PassManager& Interpreter::optimization_pipeline(Interpreter::Optimizat
         return *entry;
 
     auto pm = make<PassManager>();
-    if (level == OptimizationLevel::Default) {
+    if (level == OptimizationLevel::Default || level == OptimizationLevel::Aggressive) {
         pm->add<Passes::GenerateCFG>();
         pm->add<Passes::UnifySameBlocks>();
         pm->add<Passes::GenerateCFG>();
@@ -237,6 +238,17 @@ Bytecode::PassManager& Interpreter::optimization_pipeline(Interpreter::Optimizat
         VERIFY_NOT_REACHED();
     }
 
+    if (level == OptimizationLevel::Aggressive) {
+        pm->add<Passes::FoldConstants>();
+        pm->add<Passes::AnalyzeLiveness>();
+        pm->add<Passes::EliminateRedundantLoadsAndStores>();
+        pm->add<Passes::AnalyzeLiveness>();
+        pm->add<Passes::AllocateRegisters>();
+        // Coalesced registers leave behind Load/Store pairs that don't do anything anymore.
+        pm->add<Passes::AnalyzeLiveness>();
+        pm->add<Passes::EliminateRedundantLoadsAndStores>();
+    }
+
     auto& passes = *pm;
     entry = move(pm);
 
@@ -82,6 +82,7 @@ public:
 
     enum class OptimizationLevel {
         Default,
+        Aggressive,
         __Count,
     };
     static Bytecode::PassManager& optimization_pipeline(OptimizationLevel = OptimizationLevel::Default);
@@ -107,5 +108,6 @@ private:
 };
 
 extern bool g_dump_bytecode;
+extern Interpreter::OptimizationLevel g_optimization_level;
 
 }
@@ -80,6 +80,100 @@ static ThrowCompletionOr<void> put_by_property_key(Object* object, Value value,
     return {};
 }
 
+// Returns the object that holds the property described by the entry, if the entry is still valid for the given object.
+static Object const* find_property_holder_in_cache_entry(PropertyLookupCache::Entry const& entry, Object const& object, PropertyKey const& property_key)
+{
+    Object const* holder = &object;
+    for (size_t i = 0;; ++i) {
+        auto const& shape = holder->shape();
+        if (entry.shapes[i].ptr() != &shape || entry.shape_serial_numbers[i] != shape.serial_number())
+            return nullptr;
+        if (i == entry.prototype_chain_length)
+            break;
+        // The shape didn't change, so neither did the prototype.
+        holder = shape.prototype();
+    }
+
+    // Objects of different classes can share a shape, so this has to be checked every time.
+    // Prototypes were checked when the entry was created, and matching shapes mean they're still the same objects.
+    if (object.has_exotic_behavior_for(property_key))
+        return nullptr;
+    return holder;
+}
+
+static Optional<Value> get_from_property_lookup_cache(PropertyLookupCache const& cache, Object const& object, PropertyKey const& property_key)
+{
+    for (auto const& entry : cache.entries) {
+        auto const* holder = find_property_holder_in_cache_entry(entry, object, property_key);
+        if (!holder)
+            continue;
+        auto value = holder->get_direct(entry.property_offset);
+        // Redefining a data property as an accessor doesn't necessarily change the shape.
+        if (value.is_accessor())
+            return {};
+        return value;
+    }
+    return {};
+}
+
+static bool put_in_property_lookup_cache(PropertyLookupCache const& cache, Object& object, PropertyKey const& property_key, Value value)
+{
+    for (auto const& entry : cache.entries) {
+        if (entry.prototype_chain_length != 0)
+            continue;
+        if (!find_property_holder_in_cache_entry(entry, object, property_key))
+            continue;
+        if (object.get_direct(entry.property_offset).is_accessor())
+            return false;
+        object.put_direct(entry.property_offset, value);
+        return true;
+    }
+    return false;
+}
+
+enum class PropertyLookupCacheAccess {
+    Get,
+    Put,
+};
+
+// Only plain data properties are cached. For puts, the property must also be a writable own property,
+// as anything else may end up calling a setter, throwing, or adding a new property.
+static void fill_property_lookup_cache(PropertyLookupCache& cache, Object const& object, PropertyKey const& property_key, PropertyLookupCacheAccess access)
+{
+    if (!property_key.is_string())
+        return;
+
+    PropertyLookupCache::Entry entry;
+    Object const* holder = &object;
+    for (size_t i = 0; i <= PropertyLookupCache::max_prototype_chain_length; ++i) {
+        if (holder->has_exotic_behavior_for(property_key))
+            return;
+
+        auto const& shape = holder->shape();
+        entry.shapes[i] = shape.make_weak_ptr<Shape>();
+        entry.shape_serial_numbers[i] = shape.serial_number();
+
+        auto metadata = shape.lookup(property_key.to_string_or_symbol());
+        if (metadata.has_value()) {
+            if (holder->get_direct(metadata->offset).is_accessor())
+                return;
+            if (access == PropertyLookupCacheAccess::Put && !metadata->attributes.is_writable())
+                return;
+            entry.prototype_chain_length = i;
+            entry.property_offset = metadata->offset;
+            cache.entries[cache.next_entry_to_replace] = move(entry);
+            cache.next_entry_to_replace = (cache.next_entry_to_replace + 1) % PropertyLookupCache::max_entries;
+            return;
+        }
+
+        if (access == PropertyLookupCacheAccess::Put)
+            return;
+        holder = shape.prototype();
+        if (!holder)
+            return;
+    }
+}
+
 ThrowCompletionOr<void> Load::execute_impl(Bytecode::Interpreter& interpreter) const
 {
     interpreter.accumulator() = interpreter.reg(m_src);
@@ -379,7 +473,14 @@ ThrowCompletionOr<void> SetVariable::execute_impl(Bytecode::Interpreter& interpr
 ThrowCompletionOr<void> GetById::execute_impl(Bytecode::Interpreter& interpreter) const
 {
     auto* object = TRY(interpreter.accumulator().to_object(interpreter.global_object()));
-    interpreter.accumulator() = TRY(object->get(interpreter.current_executable().get_identifier(m_property)));
+    PropertyKey name = interpreter.current_executable().get_identifier(m_property);
+    auto& cache = interpreter.current_executable().property_lookup_caches[m_cache_index];
+    if (auto value = get_from_property_lookup_cache(cache, *object, name); value.has_value()) {
+        interpreter.accumulator() = *value;
+        return {};
+    }
+    interpreter.accumulator() = TRY(object->get(name));
+    fill_property_lookup_cache(cache, *object, name, PropertyLookupCacheAccess::Get);
     return {};
 }
 
@@ -388,7 +489,15 @@ ThrowCompletionOr<void> PutById::execute_impl(Bytecode::Interpreter& interpreter
     auto* object = TRY(interpreter.reg(m_base).to_object(interpreter.global_object()));
     PropertyKey name = interpreter.current_executable().get_identifier(m_property);
     auto value = interpreter.accumulator();
-    return put_by_property_key(object, value, name, interpreter, m_kind);
+    if (m_kind != PropertyKind::KeyValue)
+        return put_by_property_key(object, value, name, interpreter, m_kind);
+
+    auto& cache = interpreter.current_executable().property_lookup_caches[m_cache_index];
+    if (put_in_property_lookup_cache(cache, *object, name, value))
+        return {};
+    TRY(put_by_property_key(object, value, name, interpreter, m_kind));
+    fill_property_lookup_cache(cache, *object, name, PropertyLookupCacheAccess::Put);
+    return {};
 }
 
 ThrowCompletionOr<void> DeleteById::execute_impl(Bytecode::Interpreter& interpreter) const
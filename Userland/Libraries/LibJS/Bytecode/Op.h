@@ -34,6 +34,11 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback) { callback(m_src); }
+
+    Register src() const { return m_src; }
+
 private:
     Register m_src;
 };
@@ -50,6 +55,8 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
 
+    Value value() const { return m_value; }
+
 private:
     Value m_value;
 };
@@ -66,6 +73,11 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback) { callback(m_dst); }
+
+    Register dst() const { return m_dst; }
+
 private:
     Register m_dst;
 };
@@ -107,6 +119,9 @@ private:
         String to_string_impl(Bytecode::Executable const&) const;              \
         void replace_references_impl(BasicBlock const&, BasicBlock const&) { } \
                                                                                \
+        template<typename Callback>                                            \
+        void visit_registers_impl(Callback callback) { callback(m_lhs_reg); }  \
+                                                                               \
     private:                                                                   \
         Register m_lhs_reg;                                                    \
     };
@@ -201,6 +216,14 @@ public:
 
     size_t length_impl() const { return sizeof(*this) + sizeof(Register) * m_excluded_names_count; }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback)
+    {
+        callback(m_from_object);
+        for (size_t i = 0; i < m_excluded_names_count; i++)
+            callback(m_excluded_names[i]);
+    }
+
 private:
     Register m_from_object;
     size_t m_excluded_names_count { 0 };
@@ -249,6 +272,23 @@ public:
         return sizeof(*this) + sizeof(Register) * (m_element_count == 0 ? 0 : 2);
     }
 
+    // NOTE: Only the first and last register of the range are visited, the ones in between must stay where they are.
+    template<typename Callback>
+    void visit_registers_impl(Callback callback)
+    {
+        if (m_element_count == 0)
+            return;
+        callback(m_elements[0]);
+        callback(m_elements[1]);
+    }
+
+    size_t element_count() const { return m_element_count; }
+    AK::Array<Register, 2> elements_range() const
+    {
+        VERIFY(m_element_count != 0);
+        return { m_elements[0], m_elements[1] };
+    }
+
 private:
     size_t m_element_count { 0 };
     Register m_elements[];
@@ -278,6 +318,9 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback) { callback(m_lhs); }
+
 private:
     Register m_lhs;
 };
@@ -396,9 +439,10 @@ private:
 
 class GetById final : public Instruction {
 public:
-    explicit GetById(IdentifierTableIndex property)
+    GetById(IdentifierTableIndex property, u32 cache_index)
         : Instruction(Type::GetById)
         , m_property(property)
+        , m_cache_index(cache_index)
     {
     }
 
@@ -408,6 +452,7 @@ public:
 
 private:
     IdentifierTableIndex m_property;
+    u32 m_cache_index { 0 };
 };
 
 enum class PropertyKind {
@@ -420,11 +465,12 @@ enum class PropertyKind {
 
 class PutById final : public Instruction {
 public:
-    explicit PutById(Register base, IdentifierTableIndex property, PropertyKind kind = PropertyKind::KeyValue)
+    PutById(Register base, IdentifierTableIndex property, u32 cache_index, PropertyKind kind = PropertyKind::KeyValue)
         : Instruction(Type::PutById)
         , m_base(base)
         , m_property(property)
         , m_kind(kind)
+        , m_cache_index(cache_index)
     {
     }
 
@@ -432,10 +478,14 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback) { callback(m_base); }
+
 private:
     Register m_base;
     IdentifierTableIndex m_property;
     PropertyKind m_kind;
+    u32 m_cache_index { 0 };
 };
 
 class DeleteById final : public Instruction {
@@ -466,6 +516,9 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback) { callback(m_base); }
+
 private:
     Register m_base;
 };
@@ -484,6 +537,13 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback)
+    {
+        callback(m_base);
+        callback(m_property);
+    }
+
 private:
     Register m_base;
     Register m_property;
@@ -502,6 +562,9 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback) { callback(m_base); }
+
 private:
     Register m_base;
 };
@@ -603,6 +666,15 @@ public:
         return sizeof(*this) + sizeof(Register) * m_argument_count;
     }
 
+    template<typename Callback>
+    void visit_registers_impl(Callback callback)
+    {
+        callback(m_callee);
+        callback(m_this_value);
+        for (size_t i = 0; i < m_argument_count; ++i)
+            callback(m_arguments[i]);
+    }
+
 private:
     Register m_callee;
     Register m_this_value;
@@ -761,6 +833,8 @@ public:
     String to_string_impl(Bytecode::Executable const&) const;
     void replace_references_impl(BasicBlock const&, BasicBlock const&);
 
+    auto& next_target() const { return m_next_target; }
+
 private:
     Label m_next_target;
 };
@@ -944,6 +1018,22 @@ ALWAYS_INLINE void Instruction::replace_references(BasicBlock const& from, Basic
 #undef __BYTECODE_OP
 }
 
+template<typename Callback>
+ALWAYS_INLINE void Instruction::visit_registers(Callback callback)
+{
+#define __BYTECODE_OP(op)       \
+    case Instruction::Type::op: \
+        return static_cast<Bytecode::Op::op&>(*this).visit_registers_impl(callback);
+
+    switch (type()) {
+        ENUMERATE_BYTECODE_OPS(__BYTECODE_OP)
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+#undef __BYTECODE_OP
+}
+
 ALWAYS_INLINE size_t Instruction::length() const
 {
     if (type() == Type::Call)
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/PassManager.h>
+
+namespace JS::Bytecode::Passes {
+
+void AllocateRegisters::perform(PassPipelineExecutable& executable)
+{
+    started();
+
+    VERIFY(executable.live_registers_at_exit.has_value());
+    VERIFY(executable.pinned_registers.has_value());
+    auto live_registers_at_exit = executable.live_registers_at_exit.release_value();
+    auto pinned_registers = executable.pinned_registers.release_value();
+
+    auto register_count = executable.executable.number_of_registers;
+
+    // Some registers have to stay where they are, relative to each other: the accumulator and the global object,
+    // anything an exception handler might read, and NewArray's element ranges, which must remain contiguous.
+    Vector<bool> is_fixed;
+    is_fixed.resize(register_count);
+    is_fixed[Register::accumulator_index] = true;
+    is_fixed[Register::global_object_index] = true;
+    for (auto index : pinned_registers)
+        is_fixed[index] = true;
+
+    Vector<bool> is_used;
+    is_used.resize(register_count);
+    Vector<u32> registers_in_order_of_appearance;
+    auto note_use = [&](u32 index) {
+        if (is_used[index])
+            return;
+        is_used[index] = true;
+        registers_in_order_of_appearance.append(index);
+    };
+
+    for (auto& block : executable.executable.basic_blocks) {
+        InstructionStreamIterator it { block.instruction_stream() };
+        while (!it.at_end()) {
+            auto& instruction = *it;
+            ++it;
+            if (instruction.type() == Instruction::Type::NewArray) {
+                visit_register_accesses(
+                    instruction, [&](u32 index) { is_fixed[index] = true; }, [](u32) {});
+            }
+            visit_register_accesses(instruction, note_use, note_use);
+        }
+    }
+
+    // Two registers interfere if one of them is written while the other one is live. The exception is a Store
+    // right after a Load, which leaves both registers holding the same value; we'd like those two to coalesce.
+    Vector<HashTable<u32>> interferences;
+    interferences.resize(register_count);
+    HashMap<u32, Vector<u32>> copies;
+
+    for (auto& block : executable.executable.basic_blocks) {
+        Vector<Instruction const*> instructions;
+        InstructionStreamIterator it { block.instruction_stream() };
+        while (!it.at_end()) {
+            instructions.append(&*it);
+            ++it;
+        }
+
+        auto live_registers = live_registers_at_exit.find(&block)->value;
+        for (size_t i = instructions.size(); i > 0; --i) {
+            auto& instruction = *instructions[i - 1];
+
+            Optional<u32> copied_register;
+            if (instruction.type() == Instruction::Type::Store && i > 1 && instructions[i - 2]->type() == Instruction::Type::Load) {
+                auto source = static_cast<Op::Load const&>(*instructions[i - 2]).src().index();
+                auto destination = static_cast<Op::Store const&>(instruction).dst().index();
+                if (source != destination && !is_fixed[source] && !is_fixed[destination]) {
+                    copied_register = source;
+                    copies.ensure(source).append(destination);
+                    copies.ensure(destination).append(source);
+                }
+            }
+
+            visit_register_accesses(
+                instruction, [](u32) {},
+                [&](u32 written) {
+                    if (is_fixed[written])
+                        return;
+                    for (auto live : live_registers) {
+                        if (live == written || is_fixed[live] || (copied_register.has_value() && live == *copied_register))
+                            continue;
+                        interferences[written].set(live);
+                        interferences[live].set(written);
+                    }
+                });
+            visit_register_accesses(
+                instruction, [](u32) {}, [&](u32 index) { live_registers.remove(index); });
+            visit_register_accesses(
+                instruction, [&](u32 index) { live_registers.set(index); }, [](u32) {});
+        }
+    }
+
+    // The fixed registers keep their order, but move down to the bottom of the register window.
+    Vector<u32> new_indices;
+    new_indices.resize(register_count);
+    u32 fixed_register_count = 0;
+    for (u32 index = 0; index < register_count; ++index) {
+        if (is_fixed[index])
+            new_indices[index] = fixed_register_count++;
+    }
+
+    // Everything else goes above them, and gets the lowest index none of its neighbours have, greedily.
+    Vector<Optional<u32>> colors;
+    colors.resize(register_count);
+    u32 color_count = 0;
+    for (auto index : registers_in_order_of_appearance) {
+        if (is_fixed[index])
+            continue;
+
+        HashTable<u32> neighbour_colors;
+        for (auto neighbour : interferences[index]) {
+            if (colors[neighbour].has_value())
+                neighbour_colors.set(*colors[neighbour]);
+        }
+
+        Optional<u32> color;
+        if (auto it = copies.find(index); it != copies.end()) {
+            for (auto partner : it->value) {
+                if (colors[partner].has_value() && !neighbour_colors.contains(*colors[partner])) {
+                    color = colors[partner];
+                    break;
+                }
+            }
+        }
+        if (!color.has_value()) {
+            u32 candidate = 0;
+            while (neighbour_colors.contains(candidate))
+                ++candidate;
+            color = candidate;
+        }
+
+        colors[index] = color;
+        color_count = max(color_count, *color + 1);
+        new_indices[index] = fixed_register_count + *color;
+    }
+
+    for (auto& block : executable.executable.basic_blocks) {
+        InstructionStreamIterator it { block.instruction_stream() };
+        while (!it.at_end()) {
+            auto& instruction = const_cast<Instruction&>(*it);
+            ++it;
+            instruction.visit_registers([&](Register& reg) {
+                reg = Register(new_indices[reg.index()]);
+            });
+        }
+    }
+
+    executable.executable.number_of_registers = fixed_register_count + color_count;
+
+    finished();
+}
+
+}
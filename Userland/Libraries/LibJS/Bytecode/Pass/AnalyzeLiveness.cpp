@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/PassManager.h>
+
+namespace JS::Bytecode::Passes {
+
+struct BlockLiveness {
+    Vector<BasicBlock const*> successors;
+    HashTable<u32> upward_exposed_reads;
+    HashTable<u32> writes;
+    HashTable<u32> live_at_entry;
+    HashTable<u32> live_at_exit;
+};
+
+void AnalyzeLiveness::perform(PassPipelineExecutable& executable)
+{
+    started();
+
+    HashMap<BasicBlock const*, BlockLiveness> blocks;
+    HashTable<BasicBlock const*> unwind_targets;
+
+    for (auto& block : executable.executable.basic_blocks) {
+        BlockLiveness liveness;
+        auto add_successor = [&](Label const& label) {
+            liveness.successors.append(&label.block());
+        };
+
+        InstructionStreamIterator it { block.instruction_stream() };
+        while (!it.at_end()) {
+            auto& instruction = *it;
+            ++it;
+
+            visit_register_accesses(
+                instruction,
+                [&](u32 index) {
+                    if (!liveness.writes.contains(index))
+                        liveness.upward_exposed_reads.set(index);
+                },
+                [&](u32 index) { liveness.writes.set(index); });
+
+            switch (instruction.type()) {
+            case Instruction::Type::Jump:
+            case Instruction::Type::JumpConditional:
+            case Instruction::Type::JumpNullish:
+            case Instruction::Type::JumpUndefined: {
+                auto& jump = static_cast<Op::Jump const&>(instruction);
+                if (jump.true_target().has_value())
+                    add_successor(*jump.true_target());
+                if (jump.false_target().has_value())
+                    add_successor(*jump.false_target());
+                break;
+            }
+            case Instruction::Type::EnterUnwindContext: {
+                auto& enter = static_cast<Op::EnterUnwindContext const&>(instruction);
+                add_successor(enter.entry_point());
+                if (enter.handler_target().has_value()) {
+                    add_successor(*enter.handler_target());
+                    unwind_targets.set(&enter.handler_target()->block());
+                }
+                if (enter.finalizer_target().has_value()) {
+                    add_successor(*enter.finalizer_target());
+                    unwind_targets.set(&enter.finalizer_target()->block());
+                }
+                break;
+            }
+            case Instruction::Type::ContinuePendingUnwind:
+                add_successor(static_cast<Op::ContinuePendingUnwind const&>(instruction).resume_target());
+                break;
+            case Instruction::Type::FinishUnwind:
+                add_successor(static_cast<Op::FinishUnwind const&>(instruction).next_target());
+                break;
+            case Instruction::Type::Yield: {
+                auto& continuation = static_cast<Op::Yield const&>(instruction).continuation();
+                if (continuation.has_value())
+                    add_successor(*continuation);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        liveness.live_at_entry = liveness.upward_exposed_reads;
+        blocks.set(&block, move(liveness));
+    }
+
+    // Iterate backwards to a fixed point, the sets only ever grow.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = executable.executable.basic_blocks.size(); i > 0; --i) {
+            auto& liveness = blocks.find(&executable.executable.basic_blocks[i - 1])->value;
+            for (auto* successor : liveness.successors) {
+                auto successor_liveness = blocks.find(successor);
+                // Blocks that aren't part of this executable can't read its registers.
+                if (successor_liveness == blocks.end())
+                    continue;
+                for (auto index : successor_liveness->value.live_at_entry)
+                    liveness.live_at_exit.set(index);
+            }
+            for (auto index : liveness.live_at_exit) {
+                if (liveness.writes.contains(index))
+                    continue;
+                if (liveness.live_at_entry.set(index) == AK::HashSetResult::InsertedNewEntry)
+                    changed = true;
+            }
+        }
+    }
+
+    HashTable<u32> pinned_registers;
+    for (auto* block : unwind_targets) {
+        auto liveness = blocks.find(block);
+        if (liveness == blocks.end())
+            continue;
+        for (auto index : liveness->value.live_at_entry)
+            pinned_registers.set(index);
+    }
+
+    HashMap<BasicBlock const*, HashTable<u32>> live_registers_at_exit;
+    for (auto& entry : blocks)
+        live_registers_at_exit.set(entry.key, move(entry.value.live_at_exit));
+
+    executable.live_registers_at_exit = move(live_registers_at_exit);
+    executable.pinned_registers = move(pinned_registers);
+
+    finished();
+}
+
+}
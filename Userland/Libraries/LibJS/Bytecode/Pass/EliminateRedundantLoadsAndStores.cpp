@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/PassManager.h>
+
+namespace JS::Bytecode::Passes {
+
+static bool is_load(Instruction const& instruction)
+{
+    return instruction.type() == Instruction::Type::Load || instruction.type() == Instruction::Type::LoadImmediate;
+}
+
+void EliminateRedundantLoadsAndStores::perform(PassPipelineExecutable& executable)
+{
+    started();
+
+    VERIFY(executable.live_registers_at_exit.has_value());
+    VERIFY(executable.pinned_registers.has_value());
+    auto live_registers_at_exit = executable.live_registers_at_exit.release_value();
+    auto pinned_registers = executable.pinned_registers.release_value();
+
+    for (auto& block : executable.executable.basic_blocks) {
+        Vector<Instruction const*> instructions;
+        Vector<size_t> offsets;
+        InstructionStreamIterator it { block.instruction_stream() };
+        while (!it.at_end()) {
+            instructions.append(&*it);
+            offsets.append(it.offset());
+            ++it;
+        }
+
+        Vector<bool> removed;
+        removed.resize(instructions.size());
+
+        // Walk backwards to find stores to registers that nobody is going to read.
+        auto live_registers = live_registers_at_exit.find(&block)->value;
+        for (size_t i = instructions.size(); i > 0; --i) {
+            auto& instruction = *instructions[i - 1];
+            if (instruction.type() == Instruction::Type::Store) {
+                auto index = static_cast<Op::Store const&>(instruction).dst().index();
+                if (index > Register::global_object_index && !pinned_registers.contains(index) && !live_registers.contains(index)) {
+                    removed[i - 1] = true;
+                    continue;
+                }
+            }
+            visit_register_accesses(
+                instruction, [](u32) {}, [&](u32 index) { live_registers.remove(index); });
+            visit_register_accesses(
+                instruction, [&](u32 index) { live_registers.set(index); }, [](u32) {});
+        }
+
+        // Then walk forwards, keeping track of which register the accumulator is a copy of.
+        // Only stores are known to leave the accumulator alone: anything else might end up running JS code,
+        // and a function returning to us puts its return value into our accumulator.
+        Optional<u32> accumulator_register;
+        Optional<size_t> previous_load;
+        for (size_t i = 0; i < instructions.size(); ++i) {
+            if (removed[i])
+                continue;
+            auto& instruction = *instructions[i];
+
+            // Loading a register the accumulator is a copy of, or storing the accumulator back into it, changes nothing.
+            if (accumulator_register.has_value()) {
+                if ((instruction.type() == Instruction::Type::Load && static_cast<Op::Load const&>(instruction).src().index() == *accumulator_register)
+                    || (instruction.type() == Instruction::Type::Store && static_cast<Op::Store const&>(instruction).dst().index() == *accumulator_register)) {
+                    removed[i] = true;
+                    continue;
+                }
+            }
+
+            // A load immediately followed by another load is pointless, neither of them can throw.
+            if (is_load(instruction) && previous_load.has_value())
+                removed[*previous_load] = true;
+            previous_load.clear();
+
+            switch (instruction.type()) {
+            case Instruction::Type::Load:
+                accumulator_register = static_cast<Op::Load const&>(instruction).src().index();
+                previous_load = i;
+                break;
+            case Instruction::Type::LoadImmediate:
+                accumulator_register.clear();
+                previous_load = i;
+                break;
+            case Instruction::Type::Store:
+                accumulator_register = static_cast<Op::Store const&>(instruction).dst().index();
+                break;
+            default:
+                accumulator_register.clear();
+                break;
+            }
+        }
+
+        Vector<size_t> instructions_to_remove;
+        for (size_t i = 0; i < instructions.size(); ++i) {
+            if (removed[i])
+                instructions_to_remove.append(offsets[i]);
+        }
+        if (!instructions_to_remove.is_empty())
+            block.remove_instructions(instructions_to_remove);
+    }
+
+    finished();
+}
+
+}
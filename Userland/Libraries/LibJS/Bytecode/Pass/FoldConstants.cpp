@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/PassManager.h>
+#include <math.h>
+
+namespace JS::Bytecode::Passes {
+
+// We don't have a global object here, so this only handles the cases that can't throw, call into user code or
+// allocate anything: numbers for the most part, and strict equality, which works on any primitive.
+static Optional<Value> fold_binary_operation(Instruction::Type type, Value lhs, Value rhs)
+{
+    if (type == Instruction::Type::StrictlyEquals)
+        return Value(is_strictly_equal(lhs, rhs));
+    if (type == Instruction::Type::StrictlyInequals)
+        return Value(!is_strictly_equal(lhs, rhs));
+
+    if (!lhs.is_number() || !rhs.is_number())
+        return {};
+
+    auto l = lhs.as_double();
+    auto r = rhs.as_double();
+    switch (type) {
+    case Instruction::Type::Add:
+        return Value(l + r);
+    case Instruction::Type::Sub:
+        return Value(l - r);
+    case Instruction::Type::Mul:
+        return Value(l * r);
+    case Instruction::Type::Div:
+        return Value(l / r);
+    case Instruction::Type::Mod:
+        return Value(fmod(l, r));
+    case Instruction::Type::LessThan:
+        return Value(l < r);
+    case Instruction::Type::LessThanEquals:
+        return Value(l <= r);
+    case Instruction::Type::GreaterThan:
+        return Value(l > r);
+    case Instruction::Type::GreaterThanEquals:
+        return Value(l >= r);
+    case Instruction::Type::LooselyEquals:
+        return Value(l == r);
+    case Instruction::Type::LooselyInequals:
+        return Value(l != r);
+    default:
+        break;
+    }
+
+    // ToInt32() is the identity on int32s, so the bitwise operations are easy enough for those.
+    if (!lhs.is_int32() || !rhs.is_int32())
+        return {};
+
+    auto left = lhs.as_i32();
+    auto shift_count = static_cast<u32>(rhs.as_i32()) % 32;
+    switch (type) {
+    case Instruction::Type::BitwiseAnd:
+        return Value(left & rhs.as_i32());
+    case Instruction::Type::BitwiseOr:
+        return Value(left | rhs.as_i32());
+    case Instruction::Type::BitwiseXor:
+        return Value(left ^ rhs.as_i32());
+    case Instruction::Type::LeftShift:
+        return Value(static_cast<i32>(static_cast<u32>(left) << shift_count));
+    case Instruction::Type::RightShift:
+        return Value(left >> shift_count);
+    case Instruction::Type::UnsignedRightShift:
+        return Value(static_cast<u32>(left) >> shift_count);
+    default:
+        return {};
+    }
+}
+
+static Optional<Value> fold_unary_operation(Instruction::Type type, Value value)
+{
+    if (type == Instruction::Type::Not)
+        return Value(!value.to_boolean());
+
+    if (!value.is_number())
+        return {};
+
+    switch (type) {
+    case Instruction::Type::UnaryPlus:
+        return value;
+    case Instruction::Type::UnaryMinus:
+        return Value(-value.as_double());
+    case Instruction::Type::Increment:
+        return Value(value.as_double() + 1);
+    case Instruction::Type::Decrement:
+        return Value(value.as_double() - 1);
+    case Instruction::Type::BitwiseNot:
+        if (value.is_int32())
+            return Value(~value.as_i32());
+        return {};
+    default:
+        return {};
+    }
+}
+
+static bool is_foldable_binary_operation(Instruction::Type type)
+{
+    switch (type) {
+#define __BYTECODE_OP(OpTitleCase, op_snake_case) \
+    case Instruction::Type::OpTitleCase:          \
+        return true;
+        JS_ENUMERATE_COMMON_BINARY_OPS(__BYTECODE_OP)
+#undef __BYTECODE_OP
+    default:
+        return false;
+    }
+}
+
+static bool is_foldable_unary_operation(Instruction::Type type)
+{
+    switch (type) {
+#define __BYTECODE_OP(OpTitleCase, op_snake_case) \
+    case Instruction::Type::OpTitleCase:          \
+        return true;
+        JS_ENUMERATE_COMMON_UNARY_OPS(__BYTECODE_OP)
+#undef __BYTECODE_OP
+    case Instruction::Type::Increment:
+    case Instruction::Type::Decrement:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static Optional<Label> taken_target_for_constant(Op::Jump const& jump, Value value)
+{
+    bool condition = false;
+    switch (jump.type()) {
+    case Instruction::Type::JumpConditional:
+        condition = value.to_boolean();
+        break;
+    case Instruction::Type::JumpNullish:
+        condition = value.is_nullish();
+        break;
+    case Instruction::Type::JumpUndefined:
+        condition = value.is_undefined();
+        break;
+    default:
+        return {};
+    }
+    return condition ? jump.true_target() : jump.false_target();
+}
+
+// Only immediates that aren't cells are worth looking at: those are the ones we can put back into a LoadImmediate.
+static bool is_foldable_constant(Value value)
+{
+    return !value.is_empty() && !value.is_cell();
+}
+
+void FoldConstants::perform(PassPipelineExecutable& executable)
+{
+    started();
+
+    static_assert(sizeof(Op::Jump) == sizeof(Op::JumpConditional));
+    static_assert(sizeof(Op::Jump) == sizeof(Op::JumpNullish));
+    static_assert(sizeof(Op::Jump) == sizeof(Op::JumpUndefined));
+
+    for (auto& block : executable.executable.basic_blocks) {
+        Optional<Value> accumulator;
+        HashMap<u32, Value> registers;
+        // The LoadImmediate that put the current (constant) value into the accumulator, if it's the previous instruction.
+        Op::LoadImmediate* accumulator_load = nullptr;
+        Vector<size_t> instructions_to_remove;
+
+        InstructionStreamIterator it { block.instruction_stream() };
+        while (!it.at_end()) {
+            auto offset = it.offset();
+            auto& instruction = const_cast<Instruction&>(*it);
+            ++it;
+
+            auto type = instruction.type();
+            if (type == Instruction::Type::LoadImmediate) {
+                auto& load = static_cast<Op::LoadImmediate&>(instruction);
+                accumulator = load.value();
+                accumulator_load = &load;
+                continue;
+            }
+
+            if (type == Instruction::Type::Load) {
+                accumulator = registers.get(static_cast<Op::Load const&>(instruction).src().index());
+                accumulator_load = nullptr;
+                continue;
+            }
+
+            if (type == Instruction::Type::Store) {
+                auto index = static_cast<Op::Store const&>(instruction).dst().index();
+                if (accumulator.has_value())
+                    registers.set(index, *accumulator);
+                else
+                    registers.remove(index);
+                accumulator_load = nullptr;
+                continue;
+            }
+
+            if (accumulator_load && is_foldable_constant(*accumulator)) {
+                Optional<Value> result;
+                if (is_foldable_binary_operation(type)) {
+                    // The left-hand side register is the only register operand of these.
+                    Optional<Value> lhs;
+                    instruction.visit_registers([&](Register& reg) { lhs = registers.get(reg.index()); });
+                    if (lhs.has_value() && is_foldable_constant(*lhs))
+                        result = fold_binary_operation(type, *lhs, *accumulator);
+                } else if (is_foldable_unary_operation(type)) {
+                    result = fold_unary_operation(type, *accumulator);
+                }
+
+                if (result.has_value()) {
+                    // Load the result instead of the operand, and drop the operation itself.
+                    Instruction::destroy(*accumulator_load);
+                    new (accumulator_load) Op::LoadImmediate(*result);
+                    accumulator = result;
+                    instructions_to_remove.append(offset);
+                    continue;
+                }
+            }
+
+            if (accumulator.has_value() && is_foldable_constant(*accumulator)) {
+                if (type == Instruction::Type::JumpConditional || type == Instruction::Type::JumpNullish || type == Instruction::Type::JumpUndefined) {
+                    auto target = taken_target_for_constant(static_cast<Op::Jump const&>(instruction), *accumulator);
+                    Instruction::destroy(instruction);
+                    new (&instruction) Op::Jump(move(target));
+                    continue;
+                }
+            }
+
+            // Everything else leaves us not knowing what's in the accumulator, and ConcatString also writes to its register.
+            if (type == Instruction::Type::ConcatString)
+                instruction.visit_registers([&](Register& reg) { registers.remove(reg.index()); });
+            accumulator.clear();
+            accumulator_load = nullptr;
+        }
+
+        if (!instructions_to_remove.is_empty())
+            block.remove_instructions(instructions_to_remove);
+    }
+
+    finished();
+}
+
+}
@@ -18,8 +18,42 @@ struct PassPipelineExecutable {
     Optional<HashMap<BasicBlock const*, HashTable<BasicBlock const*>>> cfg {};
     Optional<HashMap<BasicBlock const*, HashTable<BasicBlock const*>>> inverted_cfg {};
     Optional<HashTable<BasicBlock const*>> exported_blocks {};
+    Optional<HashMap<BasicBlock const*, HashTable<u32>>> live_registers_at_exit {};
+    Optional<HashTable<u32>> pinned_registers {};
 };
 
+// Calls `on_read` with the index of every register the instruction reads, and then `on_write` with every register it writes.
+// The accumulator is not included, as it's used implicitly by almost every instruction.
+template<typename ReadCallback, typename WriteCallback>
+void visit_register_accesses(Instruction const& instruction, ReadCallback on_read, WriteCallback on_write)
+{
+    switch (instruction.type()) {
+    case Instruction::Type::Store:
+        on_write(static_cast<Op::Store const&>(instruction).dst().index());
+        return;
+    case Instruction::Type::ConcatString:
+        const_cast<Instruction&>(instruction).visit_registers([&](Register& reg) {
+            on_read(reg.index());
+            on_write(reg.index());
+        });
+        return;
+    case Instruction::Type::NewArray: {
+        auto& new_array = static_cast<Op::NewArray const&>(instruction);
+        if (new_array.element_count() == 0)
+            return;
+        auto range = new_array.elements_range();
+        for (auto index = range[0].index(); index <= range[1].index(); ++index)
+            on_read(index);
+        return;
+    }
+    default:
+        const_cast<Instruction&>(instruction).visit_registers([&](Register& reg) {
+            on_read(reg.index());
+        });
+        return;
+    }
+}
+
 class Pass {
 public:
     Pass() = default;
@@ -121,6 +155,50 @@ private:
     virtual void perform(PassPipelineExecutable&) override;
 };
 
+// Computes which registers are live at the end of every block, following the jumps that GenerateCFG follows as well as
+// FinishUnwind. Anything live at the start of an exception handler or finalizer ends up in `pinned_registers`: those
+// can be entered from any instruction that throws, so we treat them as live everywhere instead of trying to figure that out.
+class AnalyzeLiveness : public Pass {
+public:
+    AnalyzeLiveness() = default;
+    ~AnalyzeLiveness() override = default;
+
+private:
+    virtual void perform(PassPipelineExecutable&) override;
+};
+
+// Evaluates operations on constants within a block, and turns conditional jumps on a known value into plain jumps.
+class FoldConstants : public Pass {
+public:
+    FoldConstants() = default;
+    ~FoldConstants() override = default;
+
+private:
+    virtual void perform(PassPipelineExecutable&) override;
+};
+
+// Drops stores to dead registers, loads and stores that would not change anything, and loads whose result is
+// immediately overwritten. Needs AnalyzeLiveness to have run.
+class EliminateRedundantLoadsAndStores : public Pass {
+public:
+    EliminateRedundantLoadsAndStores() = default;
+    ~EliminateRedundantLoadsAndStores() override = default;
+
+private:
+    virtual void perform(PassPipelineExecutable&) override;
+};
+
+// Gives registers that are never live at the same time the same index, preferring to put both sides of a
+// Load/Store pair into the same register, and shrinks the register window accordingly. Needs AnalyzeLiveness to have run.
+class AllocateRegisters : public Pass {
+public:
+    AllocateRegisters() = default;
+    ~AllocateRegisters() override = default;
+
+private:
+    virtual void perform(PassPipelineExecutable&) override;
+};
+
 class DumpCFG : public Pass {
 public:
     DumpCFG(FILE* file)
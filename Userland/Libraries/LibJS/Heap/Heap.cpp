@@ -7,6 +7,7 @@
 #include <AK/Badge.h>
 #include <AK/Debug.h>
 #include <AK/HashTable.h>
+#include <AK/QuickSort.h>
 #include <AK/StackInfo.h>
 #include <AK/TemporaryChange.h>
 #include <LibCore/ElapsedTimer.h>
@@ -49,6 +50,8 @@ Heap::Heap(VM& vm)
     m_allocators.append(make<CellAllocator>(512));
     m_allocators.append(make<CellAllocator>(1024));
     m_allocators.append(make<CellAllocator>(3072));
+
+    update_allocation_threshold();
 }
 
 Heap::~Heap()
@@ -69,16 +72,16 @@ ALWAYS_INLINE CellAllocator& Heap::allocator_for_size(size_t cell_size)
 
 Cell* Heap::allocate_cell(size_t size)
 {
+    auto& allocator = allocator_for_size(size);
+
     if (should_collect_on_every_allocation()) {
         collect_garbage();
-    } else if (m_allocations_since_last_gc > m_max_allocations_between_gc) {
-        m_allocations_since_last_gc = 0;
+    } else if (m_allocated_bytes_since_last_gc + allocator.cell_size() > m_allocation_threshold_bytes) {
+        m_allocated_bytes_since_last_gc = 0;
         collect_garbage();
-    } else {
-        ++m_allocations_since_last_gc;
     }
+    m_allocated_bytes_since_last_gc += allocator.cell_size();
 
-    auto& allocator = allocator_for_size(size);
     return allocator.allocate_cell(*this);
 }
 
@@ -103,6 +106,35 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
         mark_live_cells(roots);
     }
     sweep_dead_cells(print_report, collection_measurement_timer);
+    did_collect_garbage(collection_measurement_timer.elapsed_time());
+}
+
+bool Heap::collect_garbage_if_idle_time_is_worth_it()
+{
+    if (m_gc_deferrals)
+        return false;
+    // Don't bother unless the next allocation-triggered collection is getting close.
+    if (m_allocated_bytes_since_last_gc < m_allocation_threshold_bytes / 2)
+        return false;
+    collect_garbage();
+    ++m_statistics.idle_time_collections;
+    return true;
+}
+
+void Heap::did_collect_garbage(Time time_spent)
+{
+    ++m_statistics.collections;
+    m_statistics.total_time += time_spent;
+    m_statistics.longest_pause = max(m_statistics.longest_pause, time_spent);
+
+    m_allocated_bytes_since_last_gc = 0;
+    update_allocation_threshold();
+}
+
+void Heap::update_allocation_threshold()
+{
+    m_allocation_threshold_bytes = max(min_allocation_threshold_bytes, m_statistics.live_cell_bytes * heap_growth_factor);
+    m_statistics.allocation_threshold_bytes = m_allocation_threshold_bytes;
 }
 
 void Heap::gather_roots(HashTable<Cell*>& roots)
@@ -132,40 +164,72 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
     jmp_buf buf;
     setjmp(buf);
 
-    HashTable<FlatPtr> possible_pointers;
+    // Every HeapBlock is block_size aligned, so with the block addresses in sorted order we can throw
+    // out most words with a single range check, and match up the rest against the blocks in one pass.
+    Vector<FlatPtr> block_addresses;
+    for_each_block([&](auto& block) {
+        block_addresses.append(bit_cast<FlatPtr>(&block));
+        return IterationDecision::Continue;
+    });
+    if (block_addresses.is_empty())
+        return;
+    quick_sort(block_addresses);
+
+    auto min_block_address = block_addresses.first();
+    auto max_block_address = block_addresses.last() + HeapBlock::block_size;
+
+    Vector<FlatPtr> possible_pointers;
+    auto add_possible_pointer = [&](FlatPtr data) {
+        if (data >= min_block_address && data < max_block_address)
+            possible_pointers.append(data);
+    };
+    auto add_possible_value = [&](FlatPtr data) {
+        add_possible_pointer(data);
+#if !ARCH(I386)
+        // A NaN-boxed Value keeps its tag in the upper bits of the word, so strip it off to get at the cell.
+        // On i386 the pointer occupies a word of its own and is already picked up above.
+        if (Value::is_boxed_cell(data))
+            add_possible_pointer(Value::extract_pointer_bits(data));
+#endif
+    };
 
     auto* raw_jmp_buf = reinterpret_cast<FlatPtr const*>(buf);
 
-    for (size_t i = 0; i < ((size_t)sizeof(buf)) / sizeof(FlatPtr); i += sizeof(FlatPtr))
-        possible_pointers.set(raw_jmp_buf[i]);
+    for (size_t i = 0; i < ((size_t)sizeof(buf)) / sizeof(FlatPtr); ++i)
+        add_possible_value(raw_jmp_buf[i]);
 
     auto stack_reference = bit_cast<FlatPtr>(&dummy);
     auto& stack_info = m_vm.stack_info();
 
     for (FlatPtr stack_address = stack_reference; stack_address < stack_info.top(); stack_address += sizeof(FlatPtr)) {
         auto data = *reinterpret_cast<FlatPtr*>(stack_address);
-        possible_pointers.set(data);
+        add_possible_value(data);
     }
 
-    HashTable<HeapBlock*> all_live_heap_blocks;
-    for_each_block([&](auto& block) {
-        all_live_heap_blocks.set(&block);
-        return IterationDecision::Continue;
-    });
+    quick_sort(possible_pointers);
 
+    size_t block_index = 0;
+    FlatPtr previous_pointer = 0;
     for (auto possible_pointer : possible_pointers) {
-        if (!possible_pointer)
+        if (possible_pointer == previous_pointer)
             continue;
+        previous_pointer = possible_pointer;
         dbgln_if(HEAP_DEBUG, "  ? {}", (void const*)possible_pointer);
-        auto* possible_heap_block = HeapBlock::from_cell(reinterpret_cast<Cell const*>(possible_pointer));
-        if (all_live_heap_blocks.contains(possible_heap_block)) {
-            if (auto* cell = possible_heap_block->cell_from_possible_pointer(possible_pointer)) {
-                if (cell->state() == Cell::State::Live) {
-                    dbgln_if(HEAP_DEBUG, "  ?-> {}", (void const*)cell);
-                    roots.set(cell);
-                } else {
-                    dbgln_if(HEAP_DEBUG, "  #-> {}", (void const*)cell);
-                }
+
+        while (block_index < block_addresses.size() && block_addresses[block_index] + HeapBlock::block_size <= possible_pointer)
+            ++block_index;
+        if (block_index == block_addresses.size())
+            break;
+        if (possible_pointer < block_addresses[block_index])
+            continue;
+
+        auto* possible_heap_block = reinterpret_cast<HeapBlock*>(block_addresses[block_index]);
+        if (auto* cell = possible_heap_block->cell_from_possible_pointer(possible_pointer)) {
+            if (cell->state() == Cell::State::Live) {
+                dbgln_if(HEAP_DEBUG, "  ?-> {}", (void const*)cell);
+                roots.set(cell);
+            } else {
+                dbgln_if(HEAP_DEBUG, "  #-> {}", (void const*)cell);
             }
         }
     }
@@ -254,6 +318,10 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
         });
     }
 
+    m_statistics.collected_cells += collected_cells;
+    m_statistics.collected_cell_bytes += collected_cell_bytes;
+    m_statistics.live_cell_bytes = live_cell_bytes;
+
     int time_spent = measurement_timer.elapsed();
 
     if (print_report) {
@@ -11,6 +11,7 @@
 #include <AK/IntrusiveList.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/Time.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCore/Forward.h>
@@ -58,6 +59,23 @@ public:
 
     void collect_garbage(CollectionType = CollectionType::CollectGarbage, bool print_report = false);
 
+    // Meant to be called when the embedder has nothing else to do. Collects garbage if we're
+    // getting close to the point where an allocation would have done so anyway, so that the
+    // pause happens now instead of in the middle of running some script.
+    bool collect_garbage_if_idle_time_is_worth_it();
+
+    struct Statistics {
+        size_t collections { 0 };
+        size_t idle_time_collections { 0 };
+        Time total_time;
+        Time longest_pause;
+        size_t collected_cells { 0 };
+        size_t collected_cell_bytes { 0 };
+        size_t live_cell_bytes { 0 };
+        size_t allocation_threshold_bytes { 0 };
+    };
+    Statistics const& statistics() const { return m_statistics; }
+
     VM& vm() { return m_vm; }
 
     bool should_collect_on_every_allocation() const { return m_should_collect_on_every_allocation; }
@@ -86,6 +104,7 @@ private:
     void gather_conservative_roots(HashTable<Cell*>&);
     void mark_live_cells(HashTable<Cell*> const& live_cells);
     void sweep_dead_cells(bool print_report, Core::ElapsedTimer const&);
+    void did_collect_garbage(Time time_spent);
 
     CellAllocator& allocator_for_size(size_t);
 
@@ -98,8 +117,18 @@ private:
         }
     }
 
-    size_t m_max_allocations_between_gc { 100000 };
-    size_t m_allocations_since_last_gc { 0 };
+    // We collect garbage once we've allocated as many bytes since the last collection as
+    // were live after it, so the heap can grow to about twice its live size between collections.
+    // Small heaps still get to allocate min_allocation_threshold_bytes first.
+    static constexpr size_t min_allocation_threshold_bytes = 4 * MiB;
+    static constexpr size_t heap_growth_factor = 1;
+
+    void update_allocation_threshold();
+
+    size_t m_allocation_threshold_bytes { min_allocation_threshold_bytes };
+    size_t m_allocated_bytes_since_last_gc { 0 };
+
+    Statistics m_statistics;
 
     bool m_should_collect_on_every_allocation { false };
 
@@ -29,6 +29,9 @@ public:
     virtual ThrowCompletionOr<bool> internal_set(PropertyKey const&, Value value, Value receiver) override;
     virtual ThrowCompletionOr<bool> internal_delete(PropertyKey const&) override;
 
+    // Only indices can be mapped to parameters.
+    virtual bool has_exotic_behavior_for(PropertyKey const& property_key) const override { return property_key.is_number(); }
+
     // [[ParameterMap]]
     Object& parameter_map() { return *m_parameter_map; }
 
@@ -212,6 +212,12 @@ ThrowCompletionOr<bool> Array::internal_delete(PropertyKey const& property_key)
     return Object::internal_delete(property_key);
 }
 
+bool Array::has_exotic_behavior_for(PropertyKey const& property_key) const
+{
+    // The length property and the indexed properties don't live in the shape.
+    return property_key.is_number() || (property_key.is_string() && property_key.as_string() == vm().names.length.as_string());
+}
+
 // NON-STANDARD: Used to inject the ephemeral length property's key
 ThrowCompletionOr<MarkedVector<Value>> Array::internal_own_property_keys() const
 {
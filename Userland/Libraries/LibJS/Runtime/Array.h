@@ -41,6 +41,7 @@ public:
     virtual ThrowCompletionOr<bool> internal_define_own_property(PropertyKey const&, PropertyDescriptor const&) override;
     virtual ThrowCompletionOr<bool> internal_delete(PropertyKey const&) override;
     virtual ThrowCompletionOr<MarkedVector<Value>> internal_own_property_keys() const override;
+    virtual bool has_exotic_behavior_for(PropertyKey const&) const override;
 
     [[nodiscard]] bool length_is_writable() const { return m_length_writable; };
 
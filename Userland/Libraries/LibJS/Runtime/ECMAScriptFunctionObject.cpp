@@ -783,14 +783,19 @@ Completion ECMAScriptFunctionObject::ordinary_call_evaluate_body()
 
                 auto bytecode_executable = executable_result.release_value();
                 bytecode_executable->name = name;
-                auto& passes = Bytecode::Interpreter::optimization_pipeline();
+                auto instruction_count = Bytecode::g_dump_bytecode ? bytecode_executable->instruction_count() : 0;
+                auto register_count = bytecode_executable->number_of_registers;
+                auto& passes = Bytecode::Interpreter::optimization_pipeline(Bytecode::g_optimization_level);
                 passes.perform(*bytecode_executable);
                 if constexpr (JS_BYTECODE_DEBUG) {
                     dbgln("Optimisation passes took {}us", passes.elapsed());
                     dbgln("Compiled Bytecode::Block for function '{}':", m_name);
                 }
-                if (Bytecode::g_dump_bytecode)
+                if (Bytecode::g_dump_bytecode) {
                     bytecode_executable->dump();
+                    if (Bytecode::g_optimization_level == Bytecode::Interpreter::OptimizationLevel::Aggressive)
+                        dbgln("Optimized from {} instructions and {} registers to {} instructions and {} registers", instruction_count, register_count, bytecode_executable->instruction_count(), bytecode_executable->number_of_registers);
+                }
 
                 return bytecode_executable;
             };
@@ -33,6 +33,8 @@ public:
     virtual ThrowCompletionOr<MarkedVector<Value>> internal_own_property_keys() const override;
     virtual void initialize(GlobalObject& object) override;
 
+    virtual bool has_exotic_behavior_for(PropertyKey const&) const override { return true; }
+
 private:
     // FIXME: UHHH how do we want to store this to avoid cycles but be safe??
     Module* m_module;            // [[Module]]
@@ -46,6 +46,8 @@ public:
     virtual ThrowCompletionOr<Value> internal_call(Value this_argument, MarkedVector<Value> arguments_list) override;
     virtual ThrowCompletionOr<Object*> internal_construct(MarkedVector<Value> arguments_list, FunctionObject& new_target) override;
 
+    virtual bool has_exotic_behavior_for(PropertyKey const&) const override { return true; }
+
 private:
     virtual void visit_edges(Visitor&) override;
 
@@ -198,6 +198,7 @@ void Shape::add_property_to_unique_shape(StringOrSymbol const& property_key, Pro
 
     VERIFY(m_property_count < NumericLimits<u32>::max());
     ++m_property_count;
+    ++m_serial_number;
 }
 
 void Shape::reconfigure_property_in_unique_shape(StringOrSymbol const& property_key, PropertyAttributes attributes)
@@ -208,6 +209,7 @@ void Shape::reconfigure_property_in_unique_shape(StringOrSymbol const& property_
     VERIFY(it != m_property_table->end());
     it->value.attributes = attributes;
     m_property_table->set(property_key, it->value);
+    ++m_serial_number;
 }
 
 void Shape::remove_property_from_unique_shape(StringOrSymbol const& property_key, size_t offset)
@@ -221,6 +223,7 @@ void Shape::remove_property_from_unique_shape(StringOrSymbol const& property_key
         if (it.value.offset > offset)
             --it.value.offset;
     }
+    ++m_serial_number;
 }
 
 void Shape::add_property_without_transition(StringOrSymbol const& property_key, PropertyAttributes attributes)
@@ -231,6 +234,7 @@ void Shape::add_property_without_transition(StringOrSymbol const& property_key,
         VERIFY(m_property_count < NumericLimits<u32>::max());
         ++m_property_count;
     }
+    ++m_serial_number;
 }
 
 FLATTEN void Shape::add_property_without_transition(PropertyKey const& property_key, PropertyAttributes attributes)
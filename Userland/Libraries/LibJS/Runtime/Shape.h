@@ -80,7 +80,15 @@ public:
 
     Vector<Property> property_table_ordered() const;
 
-    void set_prototype_without_transition(Object* new_prototype) { m_prototype = new_prototype; }
+    void set_prototype_without_transition(Object* new_prototype)
+    {
+        m_prototype = new_prototype;
+        ++m_serial_number;
+    }
+
+    // Changes whenever this shape is modified in place, which (after initialization) only happens to unique shapes.
+    // Together with the shape's identity, this lets caches tell whether the shape still has the same layout.
+    u32 serial_number() const { return m_serial_number; }
 
     void remove_property_from_unique_shape(StringOrSymbol const&, size_t offset);
     void add_property_to_unique_shape(StringOrSymbol const&, PropertyAttributes attributes);
@@ -105,6 +113,7 @@ private:
     StringOrSymbol m_property_key;
     Object* m_prototype { nullptr };
     u32 m_property_count { 0 };
+    u32 m_serial_number { 0 };
 
     PropertyAttributes m_attributes { 0 };
     TransitionType m_transition_type : 6 { TransitionType::Invalid };
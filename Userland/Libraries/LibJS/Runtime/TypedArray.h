@@ -297,6 +297,14 @@ public:
         return Object::internal_define_own_property(property_key, property_descriptor);
     }
 
+    virtual bool has_exotic_behavior_for(PropertyKey const& property_key) const override
+    {
+        // Anything that looks like a numeric index is handled by the integer-indexed element accessors.
+        if (property_key.is_number())
+            return true;
+        return property_key.is_string() && !canonical_numeric_index_string(property_key, CanonicalIndexMode::DetectNumericRoundtrip).is_undefined();
+    }
+
     // 10.4.5.4 [[Get]] ( P, Receiver ), 10.4.5.4 [[Get]] ( P, Receiver )
     virtual ThrowCompletionOr<Value> internal_get(PropertyKey const& property_key, Value receiver) const override
     {
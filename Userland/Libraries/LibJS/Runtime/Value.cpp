@@ -210,7 +210,7 @@ ThrowCompletionOr<bool> Value::is_array(GlobalObject& global_object) const
 Array& Value::as_array()
 {
     VERIFY(is_object() && is<Array>(as_object()));
-    return static_cast<Array&>(*m_value.as_object);
+    return static_cast<Array&>(as_object());
 }
 
 // 7.2.3 IsCallable ( argument ), https://tc39.es/ecma262/#sec-iscallable
@@ -263,7 +263,7 @@ ThrowCompletionOr<bool> Value::is_regexp(GlobalObject& global_object) const
 // 13.5.3 The typeof Operator, https://tc39.es/ecma262/#sec-typeof-operator
 String Value::typeof() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Value::Type::Undefined:
         return "undefined";
     case Value::Type::Null:
@@ -293,23 +293,23 @@ String Value::typeof() const
 
 String Value::to_string_without_side_effects() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return "undefined";
     case Type::Null:
         return "null";
     case Type::Boolean:
-        return m_value.as_bool ? "true" : "false";
+        return as_bool() ? "true" : "false";
     case Type::Int32:
-        return String::number(m_value.as_i32);
+        return String::number(as_i32());
     case Type::Double:
-        return double_to_string(m_value.as_double);
+        return double_to_string(as_double());
     case Type::String:
-        return m_value.as_string->string();
+        return as_string().string();
     case Type::Symbol:
-        return m_value.as_symbol->to_string();
+        return as_symbol().to_string();
     case Type::BigInt:
-        return m_value.as_bigint->to_string();
+        return as_bigint().to_string();
     case Type::Object:
         return String::formatted("[object {}]", as_object().class_name());
     case Type::Accessor:
@@ -331,23 +331,23 @@ ThrowCompletionOr<PrimitiveString*> Value::to_primitive_string(GlobalObject& glo
 ThrowCompletionOr<String> Value::to_string(GlobalObject& global_object) const
 {
     auto& vm = global_object.vm();
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return "undefined"sv;
     case Type::Null:
         return "null"sv;
     case Type::Boolean:
-        return m_value.as_bool ? "true"sv : "false"sv;
+        return as_bool() ? "true"sv : "false"sv;
     case Type::Int32:
-        return String::number(m_value.as_i32);
+        return String::number(as_i32());
     case Type::Double:
-        return double_to_string(m_value.as_double);
+        return double_to_string(as_double());
     case Type::String:
-        return m_value.as_string->string();
+        return as_string().string();
     case Type::Symbol:
         return vm.throw_completion<TypeError>(global_object, ErrorType::Convert, "symbol", "string");
     case Type::BigInt:
-        return m_value.as_bigint->big_integer().to_base(10);
+        return as_bigint().big_integer().to_base(10);
     case Type::Object: {
         auto primitive_value = TRY(to_primitive(global_object, PreferredType::String));
         return primitive_value.to_string(global_object);
@@ -359,8 +359,8 @@ ThrowCompletionOr<String> Value::to_string(GlobalObject& global_object) const
 
 ThrowCompletionOr<Utf16String> Value::to_utf16_string(GlobalObject& global_object) const
 {
-    if (m_type == Type::String)
-        return m_value.as_string->utf16_string();
+    if (is_string())
+        return as_string().utf16_string();
 
     auto utf8_string = TRY(to_string(global_object));
     return Utf16String(utf8_string);
@@ -369,27 +369,27 @@ ThrowCompletionOr<Utf16String> Value::to_utf16_string(GlobalObject& global_objec
 // 7.1.2 ToBoolean ( argument ), https://tc39.es/ecma262/#sec-toboolean
 bool Value::to_boolean() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
     case Type::Null:
         return false;
     case Type::Boolean:
-        return m_value.as_bool;
+        return as_bool();
     case Type::Int32:
-        return m_value.as_i32 != 0;
+        return as_i32() != 0;
     case Type::Double:
         if (is_nan())
             return false;
-        return m_value.as_double != 0;
+        return as_double() != 0;
     case Type::String:
-        return !m_value.as_string->string().is_empty();
+        return !as_string().string().is_empty();
     case Type::Symbol:
         return true;
     case Type::BigInt:
-        return m_value.as_bigint->big_integer() != BIGINT_ZERO;
+        return as_bigint().big_integer() != BIGINT_ZERO;
     case Type::Object:
         // B.3.7.1 Changes to ToBoolean, https://tc39.es/ecma262/#sec-IsHTMLDDA-internal-slot-to-boolean
-        if (m_value.as_object->is_htmldda())
+        if (as_object().is_htmldda())
             return false;
         return true;
     default:
@@ -432,21 +432,21 @@ ThrowCompletionOr<Value> Value::to_primitive(GlobalObject& global_object, Prefer
 // 7.1.18 ToObject ( argument ), https://tc39.es/ecma262/#sec-toobject
 ThrowCompletionOr<Object*> Value::to_object(GlobalObject& global_object) const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
     case Type::Null:
         return global_object.vm().throw_completion<TypeError>(global_object, ErrorType::ToObjectNullOrUndefined);
     case Type::Boolean:
-        return BooleanObject::create(global_object, m_value.as_bool);
+        return BooleanObject::create(global_object, as_bool());
     case Type::Int32:
     case Type::Double:
         return NumberObject::create(global_object, as_double());
     case Type::String:
-        return StringObject::create(global_object, *m_value.as_string, *global_object.string_prototype());
+        return StringObject::create(global_object, *pointer<PrimitiveString>(), *global_object.string_prototype());
     case Type::Symbol:
-        return SymbolObject::create(global_object, *m_value.as_symbol);
+        return SymbolObject::create(global_object, *pointer<Symbol>());
     case Type::BigInt:
-        return BigIntObject::create(global_object, *m_value.as_bigint);
+        return BigIntObject::create(global_object, *pointer<BigInt>());
     case Type::Object:
         return &const_cast<Object&>(as_object());
     default:
@@ -466,13 +466,13 @@ FLATTEN ThrowCompletionOr<Value> Value::to_numeric(GlobalObject& global_object)
 // 7.1.4 ToNumber ( argument ), https://tc39.es/ecma262/#sec-tonumber
 ThrowCompletionOr<Value> Value::to_number(GlobalObject& global_object) const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Undefined:
         return js_nan();
     case Type::Null:
         return Value(0);
     case Type::Boolean:
-        return Value(m_value.as_bool ? 1 : 0);
+        return Value(as_bool() ? 1 : 0);
     case Type::Int32:
     case Type::Double:
         return *this;
@@ -632,7 +632,7 @@ ThrowCompletionOr<double> Value::to_double(GlobalObject& global_object) const
 // 7.1.19 ToPropertyKey ( argument ), https://tc39.es/ecma262/#sec-topropertykey
 ThrowCompletionOr<PropertyKey> Value::to_property_key(GlobalObject& global_object) const
 {
-    if (type() == Type::Int32 && as_i32() >= 0)
+    if (is_int32() && as_i32() >= 0)
         return PropertyKey { as_i32() };
     auto key = TRY(to_primitive(global_object, PreferredType::String));
     if (key.is_symbol())
@@ -642,7 +642,7 @@ ThrowCompletionOr<PropertyKey> Value::to_property_key(GlobalObject& global_objec
 
 ThrowCompletionOr<i32> Value::to_i32_slow_case(GlobalObject& global_object) const
 {
-    VERIFY(type() != Type::Int32);
+    VERIFY(!is_int32());
     double value = TRY(to_number(global_object)).as_double();
     if (!isfinite(value) || value == 0)
         return 0;
@@ -659,8 +659,8 @@ ThrowCompletionOr<i32> Value::to_i32_slow_case(GlobalObject& global_object) cons
 
 ThrowCompletionOr<i32> Value::to_i32(GlobalObject& global_object) const
 {
-    if (m_type == Type::Int32)
-        return m_value.as_i32;
+    if (is_int32())
+        return as_i32();
     return to_i32_slow_case(global_object);
 }
 
@@ -844,7 +844,7 @@ ThrowCompletionOr<FunctionObject*> Value::get_method(GlobalObject& global_object
 // 13.10 Relational Operators, https://tc39.es/ecma262/#sec-relational-operators
 ThrowCompletionOr<Value> greater_than(GlobalObject& global_object, Value lhs, Value rhs)
 {
-    if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32)
+    if (lhs.is_int32() && rhs.is_int32())
         return lhs.as_i32() > rhs.as_i32();
 
     TriState relation = TRY(is_less_than(global_object, false, lhs, rhs));
@@ -856,7 +856,7 @@ ThrowCompletionOr<Value> greater_than(GlobalObject& global_object, Value lhs, Va
 // 13.10 Relational Operators, https://tc39.es/ecma262/#sec-relational-operators
 ThrowCompletionOr<Value> greater_than_equals(GlobalObject& global_object, Value lhs, Value rhs)
 {
-    if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32)
+    if (lhs.is_int32() && rhs.is_int32())
         return lhs.as_i32() >= rhs.as_i32();
 
     TriState relation = TRY(is_less_than(global_object, true, lhs, rhs));
@@ -868,7 +868,7 @@ ThrowCompletionOr<Value> greater_than_equals(GlobalObject& global_object, Value
 // 13.10 Relational Operators, https://tc39.es/ecma262/#sec-relational-operators
 ThrowCompletionOr<Value> less_than(GlobalObject& global_object, Value lhs, Value rhs)
 {
-    if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32)
+    if (lhs.is_int32() && rhs.is_int32())
         return lhs.as_i32() < rhs.as_i32();
 
     TriState relation = TRY(is_less_than(global_object, true, lhs, rhs));
@@ -880,7 +880,7 @@ ThrowCompletionOr<Value> less_than(GlobalObject& global_object, Value lhs, Value
 // 13.10 Relational Operators, https://tc39.es/ecma262/#sec-relational-operators
 ThrowCompletionOr<Value> less_than_equals(GlobalObject& global_object, Value lhs, Value rhs)
 {
-    if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32)
+    if (lhs.is_int32() && rhs.is_int32())
         return lhs.as_i32() <= rhs.as_i32();
 
     TriState relation = TRY(is_less_than(global_object, false, lhs, rhs));
@@ -892,6 +892,9 @@ ThrowCompletionOr<Value> less_than_equals(GlobalObject& global_object, Value lhs
 // 13.12 Binary Bitwise Operators, https://tc39.es/ecma262/#sec-binary-bitwise-operators
 ThrowCompletionOr<Value> bitwise_and(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_i32() & rhs.as_i32());
+
     auto& vm = global_object.vm();
     auto lhs_numeric = TRY(lhs.to_numeric(global_object));
     auto rhs_numeric = TRY(rhs.to_numeric(global_object));
@@ -908,6 +911,9 @@ ThrowCompletionOr<Value> bitwise_and(GlobalObject& global_object, Value lhs, Val
 // 13.12 Binary Bitwise Operators, https://tc39.es/ecma262/#sec-binary-bitwise-operators
 ThrowCompletionOr<Value> bitwise_or(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_i32() | rhs.as_i32());
+
     auto& vm = global_object.vm();
     auto lhs_numeric = TRY(lhs.to_numeric(global_object));
     auto rhs_numeric = TRY(rhs.to_numeric(global_object));
@@ -928,6 +934,9 @@ ThrowCompletionOr<Value> bitwise_or(GlobalObject& global_object, Value lhs, Valu
 // 13.12 Binary Bitwise Operators, https://tc39.es/ecma262/#sec-binary-bitwise-operators
 ThrowCompletionOr<Value> bitwise_xor(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_i32() ^ rhs.as_i32());
+
     auto& vm = global_object.vm();
     auto lhs_numeric = TRY(lhs.to_numeric(global_object));
     auto rhs_numeric = TRY(rhs.to_numeric(global_object));
@@ -1102,10 +1111,9 @@ static PrimitiveString* concatenate_strings(GlobalObject& global_object, Primiti
 ThrowCompletionOr<Value> add(GlobalObject& global_object, Value lhs, Value rhs)
 {
     if (both_number(lhs, rhs)) {
-        if (lhs.type() == Value::Type::Int32 && rhs.type() == Value::Type::Int32) {
-            Checked<i32> result;
-            result = MUST(lhs.to_i32(global_object));
-            result += MUST(rhs.to_i32(global_object));
+        if (lhs.is_int32() && rhs.is_int32()) {
+            Checked<i32> result = lhs.as_i32();
+            result += rhs.as_i32();
             if (!result.has_overflow())
                 return Value(result.value());
         }
@@ -1133,6 +1141,13 @@ ThrowCompletionOr<Value> add(GlobalObject& global_object, Value lhs, Value rhs)
 // 13.8.2 The Subtraction Operator ( - ), https://tc39.es/ecma262/#sec-subtraction-operator-minus
 ThrowCompletionOr<Value> sub(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32()) {
+        Checked<i32> result = lhs.as_i32();
+        result -= rhs.as_i32();
+        if (!result.has_overflow())
+            return Value(result.value());
+    }
+
     auto& vm = global_object.vm();
     auto lhs_numeric = TRY(lhs.to_numeric(global_object));
     auto rhs_numeric = TRY(rhs.to_numeric(global_object));
@@ -1146,6 +1161,14 @@ ThrowCompletionOr<Value> sub(GlobalObject& global_object, Value lhs, Value rhs)
 // 13.7 Multiplicative Operators, https://tc39.es/ecma262/#sec-multiplicative-operators
 ThrowCompletionOr<Value> mul(GlobalObject& global_object, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32()) {
+        Checked<i32> result = lhs.as_i32();
+        result *= rhs.as_i32();
+        // A zero result with a negative operand is -0, which isn't an int32.
+        if (!result.has_overflow() && (result.value() != 0 || (lhs.as_i32() >= 0 && rhs.as_i32() >= 0)))
+            return Value(result.value());
+    }
+
     auto& vm = global_object.vm();
     auto lhs_numeric = TRY(lhs.to_numeric(global_object));
     auto rhs_numeric = TRY(rhs.to_numeric(global_object));
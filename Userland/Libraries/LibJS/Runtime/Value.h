@@ -28,6 +28,15 @@ static constexpr u64 NEGATIVE_ZERO_BITS = ((u64)1 << 63);
 
 namespace JS {
 
+// A Value is NaN-boxed into 64 bits: doubles are stored as-is, and every other type
+// lives in the payload of a quiet NaN that no double we store can have, since all
+// NaNs are canonicalized on the way in. The upper 16 bits act as the tag:
+//
+//   0x7FF8             canonical NaN (a double)
+//   0x7FF9..0x7FFF     empty, boolean, int32, undefined, null (payload in the low 32 bits)
+//   0xFFF9..0xFFFD     object, string, symbol, accessor, bigint (pointer in the low 48 bits)
+//
+// Anything else is a double.
 class Value {
 public:
     enum class Type {
@@ -50,237 +59,303 @@ public:
         Number,
     };
 
-    bool is_empty() const { return m_type == Type::Empty; }
-    bool is_undefined() const { return m_type == Type::Undefined; }
-    bool is_null() const { return m_type == Type::Null; }
-    bool is_number() const { return m_type == Type::Int32 || m_type == Type::Double; }
-    bool is_string() const { return m_type == Type::String; }
-    bool is_object() const { return m_type == Type::Object; }
-    bool is_boolean() const { return m_type == Type::Boolean; }
-    bool is_symbol() const { return m_type == Type::Symbol; }
-    bool is_accessor() const { return m_type == Type::Accessor; };
-    bool is_bigint() const { return m_type == Type::BigInt; };
-    bool is_nullish() const { return is_null() || is_undefined(); }
-    bool is_cell() const { return is_string() || is_accessor() || is_object() || is_bigint() || is_symbol(); }
+    static constexpr u64 TAG_SHIFT = 48;
+    static constexpr u64 CANON_NAN_BITS = 0x7FF8000000000000;
+    static constexpr u64 BASE_TAG = 0x7FF8;
+    static constexpr u64 EMPTY_TAG = BASE_TAG | 0b001;
+    static constexpr u64 BOOLEAN_TAG = BASE_TAG | 0b010;
+    static constexpr u64 INT32_TAG = BASE_TAG | 0b011;
+    static constexpr u64 UNDEFINED_TAG = BASE_TAG | 0b110;
+    static constexpr u64 NULL_TAG = BASE_TAG | 0b111;
+    static constexpr u64 CELL_TAG = 0xFFF8;
+    static constexpr u64 OBJECT_TAG = CELL_TAG | 0b001;
+    static constexpr u64 STRING_TAG = CELL_TAG | 0b010;
+    static constexpr u64 SYMBOL_TAG = CELL_TAG | 0b011;
+    static constexpr u64 ACCESSOR_TAG = CELL_TAG | 0b100;
+    static constexpr u64 BIGINT_TAG = CELL_TAG | 0b101;
+
+    static constexpr u64 SHIFTED_BASE_TAG = BASE_TAG << TAG_SHIFT;
+    static constexpr u64 SHIFTED_CELL_TAG = CELL_TAG << TAG_SHIFT;
+    static constexpr u64 SHIFTED_INT32_TAG = INT32_TAG << TAG_SHIFT;
+    static constexpr u64 PAYLOAD_MASK = ((u64)1 << TAG_SHIFT) - 1;
+
+    // Cells are only ever boxed with one of the tags above, so a 64-bit word that matches
+    // SHIFTED_CELL_TAG but isn't 0xFFF8 (a negative NaN, which we never store) is a boxed cell.
+    static constexpr bool is_boxed_cell(u64 encoded)
+    {
+        return (encoded & SHIFTED_CELL_TAG) == SHIFTED_CELL_TAG && (encoded >> TAG_SHIFT) != CELL_TAG;
+    }
+
+    static FlatPtr extract_pointer_bits(u64 encoded)
+    {
+#if ARCH(I386)
+        return static_cast<FlatPtr>(encoded & 0xffffffff);
+#else
+        // Sign-extend bit 47 so that pointers into the upper half of the canonical address space
+        // survive the round trip.
+        return static_cast<FlatPtr>(static_cast<i64>(encoded << 16) >> 16);
+#endif
+    }
+
+    bool is_empty() const { return tag() == EMPTY_TAG; }
+    bool is_undefined() const { return tag() == UNDEFINED_TAG; }
+    bool is_null() const { return tag() == NULL_TAG; }
+    bool is_number() const { return is_double() || is_int32(); }
+    bool is_string() const { return tag() == STRING_TAG; }
+    bool is_object() const { return tag() == OBJECT_TAG; }
+    bool is_boolean() const { return tag() == BOOLEAN_TAG; }
+    bool is_symbol() const { return tag() == SYMBOL_TAG; }
+    bool is_accessor() const { return tag() == ACCESSOR_TAG; };
+    bool is_bigint() const { return tag() == BIGINT_TAG; };
+    bool is_nullish() const { return (tag() & 0xFFFE) == UNDEFINED_TAG; }
+    bool is_cell() const { return is_boxed_cell(m_value); }
     ThrowCompletionOr<bool> is_array(GlobalObject&) const;
     bool is_function() const;
     bool is_constructor() const;
     ThrowCompletionOr<bool> is_regexp(GlobalObject&) const;
 
+    bool is_int32() const { return tag() == INT32_TAG; }
+
+    // This does not include the int32 case, use is_number() for that.
+    bool is_double() const { return (m_value & SHIFTED_BASE_TAG) != SHIFTED_BASE_TAG || m_value == CANON_NAN_BITS; }
+
     bool is_nan() const
     {
-        if (type() == Type::Int32)
-            return false;
-        return is_number() && __builtin_isnan(as_double());
+        return m_value == CANON_NAN_BITS;
     }
 
     bool is_infinity() const
     {
-        if (type() == Type::Int32)
-            return false;
-        return is_number() && __builtin_isinf(as_double());
+        return is_double() && __builtin_isinf(raw_double());
     }
 
     bool is_positive_infinity() const
     {
-        if (type() == Type::Int32)
-            return false;
-        return is_number() && __builtin_isinf_sign(as_double()) > 0;
+        return is_double() && __builtin_isinf_sign(raw_double()) > 0;
     }
 
     bool is_negative_infinity() const
     {
-        if (type() == Type::Int32)
-            return false;
-        return is_number() && __builtin_isinf_sign(as_double()) < 0;
+        return is_double() && __builtin_isinf_sign(raw_double()) < 0;
     }
 
     bool is_positive_zero() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return as_i32() == 0;
-        return is_number() && bit_cast<u64>(as_double()) == 0;
+        return m_value == 0;
     }
 
     bool is_negative_zero() const
     {
-        if (type() == Type::Int32)
-            return false;
-        return is_number() && bit_cast<u64>(as_double()) == NEGATIVE_ZERO_BITS;
+        return m_value == NEGATIVE_ZERO_BITS;
     }
 
     bool is_integral_number() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return true;
         return is_finite_number() && trunc(as_double()) == as_double();
     }
 
     bool is_finite_number() const
     {
-        if (type() == Type::Int32)
+        if (is_int32())
             return true;
-        if (!is_number())
+        if (!is_double())
             return false;
-        auto number = as_double();
+        auto number = raw_double();
         return !__builtin_isnan(number) && !__builtin_isinf(number);
     }
 
     Value()
-        : m_type(Type::Empty)
+        : m_value(EMPTY_TAG << TAG_SHIFT)
     {
     }
 
     template<typename T>
     requires(SameAs<RemoveCVReference<T>, bool>) explicit Value(T value)
-        : m_type(Type::Boolean)
+        : m_value((BOOLEAN_TAG << TAG_SHIFT) | (value ? 1 : 0))
     {
-        m_value.as_bool = value;
     }
 
     explicit Value(double value)
     {
         bool is_negative_zero = bit_cast<u64>(value) == NEGATIVE_ZERO_BITS;
         if (value >= NumericLimits<i32>::min() && value <= NumericLimits<i32>::max() && trunc(value) == value && !is_negative_zero) {
-            m_type = Type::Int32;
-            m_value.as_i32 = static_cast<i32>(value);
+            m_value = encode_i32(static_cast<i32>(value));
+        } else if (__builtin_isnan(value)) {
+            m_value = CANON_NAN_BITS;
         } else {
-            m_type = Type::Double;
-            m_value.as_double = value;
+            m_value = bit_cast<u64>(value);
         }
     }
 
     explicit Value(unsigned long value)
     {
-        if (value > NumericLimits<i32>::max()) {
-            m_value.as_double = static_cast<double>(value);
-            m_type = Type::Double;
-        } else {
-            m_value.as_i32 = static_cast<i32>(value);
-            m_type = Type::Int32;
-        }
+        if (value > NumericLimits<i32>::max())
+            m_value = bit_cast<u64>(static_cast<double>(value));
+        else
+            m_value = encode_i32(static_cast<i32>(value));
     }
 
     explicit Value(unsigned value)
     {
-        if (value > NumericLimits<i32>::max()) {
-            m_value.as_double = static_cast<double>(value);
-            m_type = Type::Double;
-        } else {
-            m_value.as_i32 = static_cast<i32>(value);
-            m_type = Type::Int32;
-        }
+        if (value > NumericLimits<i32>::max())
+            m_value = bit_cast<u64>(static_cast<double>(value));
+        else
+            m_value = encode_i32(static_cast<i32>(value));
     }
 
     explicit Value(i32 value)
-        : m_type(Type::Int32)
+        : m_value(encode_i32(value))
     {
-        m_value.as_i32 = value;
     }
 
     Value(Object const* object)
-        : m_type(object ? Type::Object : Type::Null)
+        : m_value(object ? encode_cell(OBJECT_TAG, object) : NULL_TAG << TAG_SHIFT)
     {
-        m_value.as_object = const_cast<Object*>(object);
     }
 
     Value(PrimitiveString const* string)
-        : m_type(Type::String)
+        : m_value(encode_cell(STRING_TAG, string))
     {
-        m_value.as_string = const_cast<PrimitiveString*>(string);
     }
 
     Value(Symbol const* symbol)
-        : m_type(Type::Symbol)
+        : m_value(encode_cell(SYMBOL_TAG, symbol))
     {
-        m_value.as_symbol = const_cast<Symbol*>(symbol);
     }
 
     Value(Accessor const* accessor)
-        : m_type(Type::Accessor)
+        : m_value(encode_cell(ACCESSOR_TAG, accessor))
     {
-        m_value.as_accessor = const_cast<Accessor*>(accessor);
     }
 
     Value(BigInt const* bigint)
-        : m_type(Type::BigInt)
+        : m_value(encode_cell(BIGINT_TAG, bigint))
     {
-        m_value.as_bigint = const_cast<BigInt*>(bigint);
     }
 
     explicit Value(Type type)
-        : m_type(type)
     {
+        switch (type) {
+        case Type::Empty:
+            m_value = EMPTY_TAG << TAG_SHIFT;
+            break;
+        case Type::Undefined:
+            m_value = UNDEFINED_TAG << TAG_SHIFT;
+            break;
+        case Type::Null:
+            m_value = NULL_TAG << TAG_SHIFT;
+            break;
+        default:
+            VERIFY_NOT_REACHED();
+        }
     }
 
-    Type type() const { return m_type; }
+    Type type() const
+    {
+        if (is_double())
+            return Type::Double;
+        switch (tag()) {
+        case EMPTY_TAG:
+            return Type::Empty;
+        case BOOLEAN_TAG:
+            return Type::Boolean;
+        case INT32_TAG:
+            return Type::Int32;
+        case UNDEFINED_TAG:
+            return Type::Undefined;
+        case NULL_TAG:
+            return Type::Null;
+        case OBJECT_TAG:
+            return Type::Object;
+        case STRING_TAG:
+            return Type::String;
+        case SYMBOL_TAG:
+            return Type::Symbol;
+        case ACCESSOR_TAG:
+            return Type::Accessor;
+        case BIGINT_TAG:
+            return Type::BigInt;
+        default:
+            VERIFY_NOT_REACHED();
+        }
+    }
 
     double as_double() const
     {
         VERIFY(is_number());
-        if (m_type == Type::Int32)
-            return m_value.as_i32;
-        return m_value.as_double;
+        if (is_int32())
+            return as_i32();
+        return raw_double();
     }
 
     bool as_bool() const
     {
-        VERIFY(type() == Type::Boolean);
-        return m_value.as_bool;
+        VERIFY(is_boolean());
+        return m_value & 1;
     }
 
     Object& as_object()
     {
-        VERIFY(type() == Type::Object);
-        return *m_value.as_object;
+        VERIFY(is_object());
+        return *pointer<Object>();
     }
 
     Object const& as_object() const
     {
-        VERIFY(type() == Type::Object);
-        return *m_value.as_object;
+        VERIFY(is_object());
+        return *pointer<Object>();
     }
 
     PrimitiveString& as_string()
     {
         VERIFY(is_string());
-        return *m_value.as_string;
+        return *pointer<PrimitiveString>();
     }
 
     PrimitiveString const& as_string() const
     {
         VERIFY(is_string());
-        return *m_value.as_string;
+        return *pointer<PrimitiveString>();
     }
 
     Symbol& as_symbol()
     {
         VERIFY(is_symbol());
-        return *m_value.as_symbol;
+        return *pointer<Symbol>();
     }
 
     Symbol const& as_symbol() const
     {
         VERIFY(is_symbol());
-        return *m_value.as_symbol;
+        return *pointer<Symbol>();
     }
 
     Cell& as_cell()
     {
         VERIFY(is_cell());
-        return *m_value.as_cell;
+        return *pointer<Cell>();
     }
 
     Accessor& as_accessor()
     {
         VERIFY(is_accessor());
-        return *m_value.as_accessor;
+        return *pointer<Accessor>();
     }
 
     BigInt& as_bigint()
     {
         VERIFY(is_bigint());
-        return *m_value.as_bigint;
+        return *pointer<BigInt>();
+    }
+
+    BigInt const& as_bigint() const
+    {
+        VERIFY(is_bigint());
+        return *pointer<BigInt>();
     }
 
     Array& as_array();
@@ -290,19 +365,19 @@ public:
     // FIXME: These two conversions are wrong for JS, and seem likely to be footguns
     i32 as_i32() const
     {
-        if (m_type == Type::Int32)
-            return m_value.as_i32;
+        if (is_int32())
+            return static_cast<i32>(static_cast<u32>(m_value));
         return static_cast<i32>(as_double());
     }
     u32 as_u32() const
     {
-        if (m_type == Type::Int32 && m_value.as_i32 >= 0)
-            return m_value.as_i32;
+        if (is_int32() && as_i32() >= 0)
+            return as_i32();
         VERIFY(as_double() >= 0);
         return (u32)min(as_double(), (double)NumericLimits<u32>::max());
     }
 
-    u64 encoded() const { return m_value.encoded; }
+    u64 encoded() const { return m_value; }
 
     ThrowCompletionOr<String> to_string(GlobalObject&) const;
     ThrowCompletionOr<Utf16String> to_utf16_string(GlobalObject&) const;
@@ -349,27 +424,35 @@ public:
     [[nodiscard]] ALWAYS_INLINE ThrowCompletionOr<Value> invoke(GlobalObject& global_object, PropertyKey const& property_key, Args... args);
 
 private:
-    Type m_type { Type::Empty };
+    static constexpr u64 encode_i32(i32 value)
+    {
+        return SHIFTED_INT32_TAG | static_cast<u32>(value);
+    }
+
+    template<typename T>
+    static u64 encode_cell(u64 tag, T const* cell)
+    {
+        return (tag << TAG_SHIFT) | (static_cast<u64>(bit_cast<FlatPtr>(cell)) & PAYLOAD_MASK);
+    }
+
+    u64 tag() const { return m_value >> TAG_SHIFT; }
+    double raw_double() const { return bit_cast<double>(m_value); }
+
+    template<typename T>
+    T* pointer() const
+    {
+        return reinterpret_cast<T*>(extract_pointer_bits(m_value));
+    }
 
     [[nodiscard]] ThrowCompletionOr<Value> invoke_internal(GlobalObject& global_object, PropertyKey const&, Optional<MarkedVector<Value>> arguments);
 
     ThrowCompletionOr<i32> to_i32_slow_case(GlobalObject&) const;
 
-    union {
-        bool as_bool;
-        i32 as_i32;
-        double as_double;
-        PrimitiveString* as_string;
-        Symbol* as_symbol;
-        Object* as_object;
-        Cell* as_cell;
-        Accessor* as_accessor;
-        BigInt* as_bigint;
-
-        u64 encoded;
-    } m_value { .encoded = 0 };
+    u64 m_value { EMPTY_TAG << TAG_SHIFT };
 };
 
+static_assert(sizeof(Value) == sizeof(u64));
+
 inline Value js_undefined()
 {
     return Value(Value::Type::Undefined);
@@ -217,6 +217,7 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex)
 int pthread_mutexattr_init(pthread_mutexattr_t* attr)
 {
     attr->type = PTHREAD_MUTEX_NORMAL;
+    attr->protocol = PTHREAD_PRIO_NONE;
     return 0;
 }
 
@@ -243,6 +244,24 @@ int pthread_mutexattr_gettype(pthread_mutexattr_t* attr, int* type)
     return 0;
 }
 
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/pthread_mutexattr_setprotocol.html
+int pthread_mutexattr_setprotocol(pthread_mutexattr_t* attr, int protocol)
+{
+    if (!attr)
+        return EINVAL;
+    if (protocol != PTHREAD_PRIO_NONE && protocol != PTHREAD_PRIO_INHERIT)
+        return ENOTSUP;
+    attr->protocol = protocol;
+    return 0;
+}
+
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/pthread_mutexattr_getprotocol.html
+int pthread_mutexattr_getprotocol(pthread_mutexattr_t const* attr, int* protocol)
+{
+    *protocol = attr->protocol;
+    return 0;
+}
+
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_attr_init.html
 int pthread_attr_init(pthread_attr_t* attributes)
 {
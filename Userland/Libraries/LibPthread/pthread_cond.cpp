@@ -147,12 +147,29 @@ int pthread_cond_broadcast(pthread_cond_t* cond)
     if (!(value & NEED_TO_WAKE_ALL)) [[likely]]
         return 0;
 
-    AK::atomic_fetch_and(&cond->value, ~(NEED_TO_WAKE_ONE | NEED_TO_WAKE_ALL), AK::memory_order_acquire);
+    value = AK::atomic_fetch_and(&cond->value, ~(NEED_TO_WAKE_ONE | NEED_TO_WAKE_ALL), AK::memory_order_acquire);
+    value &= ~(NEED_TO_WAKE_ONE | NEED_TO_WAKE_ALL);
 
     pthread_mutex_t* mutex = AK::atomic_load(&cond->mutex, AK::memory_order_relaxed);
     VERIFY(mutex);
 
-    int rc = futex(&cond->value, FUTEX_REQUEUE, 1, nullptr, &mutex->lock, INT_MAX);
+    // A priority-inheritance mutex keeps its owner's TID in mutex->lock, so
+    // we can't park plain futex waiters on it. Wake everyone instead.
+    if (mutex->protocol == PTHREAD_PRIO_INHERIT) {
+        int rc = futex_wake(&cond->value, INT_MAX);
+        VERIFY(rc >= 0);
+        return 0;
+    }
+
+    // Wake a single waiter, and move everyone else over to the mutex. They then
+    // get woken one at a time as the mutex is unlocked, instead of all of them
+    // stampeding onto it at once. The requeue count is passed in place of the
+    // timeout, like for FUTEX_WAKE_OP.
+    int rc = futex(&cond->value, FUTEX_CMP_REQUEUE, 1, reinterpret_cast<timespec const*>(static_cast<FlatPtr>(INT_MAX)), &mutex->lock, value);
+    if (rc < 0 && errno == EAGAIN) {
+        // Someone changed the value under our feet; fall back to waking everyone.
+        rc = futex_wake(&cond->value, INT_MAX);
+    }
     VERIFY(rc >= 0);
     return 0;
 }
@@ -30,6 +30,7 @@ public:
     virtual JS::ThrowCompletionOr<bool> internal_set(JS::PropertyKey const&, JS::Value value, JS::Value receiver) override;
     virtual JS::ThrowCompletionOr<bool> internal_delete(JS::PropertyKey const&) override;
     virtual JS::ThrowCompletionOr<JS::MarkedVector<JS::Value>> internal_own_property_keys() const override;
+    virtual bool has_exotic_behavior_for(JS::PropertyKey const&) const override { return true; }
 
     WindowObject& window() { return *m_window; }
     WindowObject const& window() const { return *m_window; }
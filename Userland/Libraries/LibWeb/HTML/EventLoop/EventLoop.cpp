@@ -216,6 +216,10 @@ void EventLoop::process()
         //    perform the start an idle period algorithm for win with computeDeadline. [REQUESTIDLECALLBACK]
         for (auto& win : same_loop_windows())
             win.start_an_idle_period();
+
+        // Nothing else is going on, so this is a good time to take the garbage collection pause,
+        // rather than having some allocation trigger it while a script is running.
+        Bindings::main_thread_vm().heap().collect_garbage_if_idle_time_is_worth_it();
     }
 
     // FIXME: 14. If this is a worker event loop, then:
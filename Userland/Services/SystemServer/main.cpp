@@ -285,6 +285,10 @@ static void populate_devtmpfs_devices_based_on_devctl()
                     create_devtmpfs_char_device("/dev/random", 0666, 1, 8);
                     break;
                 }
+                case 10: {
+                    create_devtmpfs_char_device("/dev/perf", 0600, 1, 10);
+                    break;
+                }
                 default:
                     warnln("Unknown character device {}:{}", major_number, minor_number);
                     break;
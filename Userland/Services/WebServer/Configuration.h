@@ -18,15 +18,18 @@ public:
 
     String const& root_path() const { return m_root_path; }
     Optional<HTTP::HttpRequest::BasicAuthenticationCredentials> const& credentials() const { return m_credentials; }
+    bool use_sendfile() const { return m_use_sendfile; }
 
     void set_root_path(String root_path) { m_root_path = move(root_path); }
     void set_credentials(Optional<HTTP::HttpRequest::BasicAuthenticationCredentials> credentials) { m_credentials = move(credentials); }
+    void set_use_sendfile(bool use_sendfile) { m_use_sendfile = use_sendfile; }
 
     static Configuration const& the();
 
 private:
     String m_root_path;
     Optional<HTTP::HttpRequest::BasicAuthenticationCredentials> m_credentials;
+    bool m_use_sendfile { false };
 };
 
 }
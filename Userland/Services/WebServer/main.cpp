@@ -28,12 +28,14 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     int port = default_port;
     String username;
     String password;
+    bool use_sendfile = false;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(listen_address, "IP address to listen on", "listen-address", 'l', "listen_address");
     args_parser.add_option(port, "Port to listen on", "port", 'p', "port");
     args_parser.add_option(username, "HTTP basic authentication username", "user", 'U', "username");
     args_parser.add_option(password, "HTTP basic authentication password", "pass", 'P', "password");
+    args_parser.add_option(use_sendfile, "Send files with sendfile(), without copying them through userspace", "sendfile", 0);
     args_parser.add_positional_argument(root_path, "Path to serve the contents of", "path", Core::ArgsParser::Required::No);
     args_parser.parse(arguments);
 
@@ -66,6 +68,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     if (!username.is_empty() && !password.is_empty())
         configuration.set_credentials(HTTP::HttpRequest::BasicAuthenticationCredentials { username, password });
+    configuration.set_use_sendfile(use_sendfile);
 
     Core::EventLoop loop;
 
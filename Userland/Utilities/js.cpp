@@ -120,6 +120,7 @@ static bool s_as_module = false;
 static bool s_print_last_result = false;
 static bool s_strip_ansi = false;
 static bool s_disable_source_location_hints = false;
+static bool s_print_gc_statistics = false;
 static RefPtr<Line::Editor> s_editor;
 static String s_history_path = String::formatted("{}/.js-history", Core::StandardPaths::home_directory());
 static int s_repl_line_level = 0;
@@ -1040,14 +1041,19 @@ static bool parse_and_run(JS::Interpreter& interpreter, StringView source, Strin
 
             auto executable = executable_result.release_value();
             executable->name = source_name;
+            auto instruction_count = JS::Bytecode::g_dump_bytecode ? executable->instruction_count() : 0;
+            auto register_count = executable->number_of_registers;
             if (s_opt_bytecode) {
-                auto& passes = JS::Bytecode::Interpreter::optimization_pipeline();
+                auto& passes = JS::Bytecode::Interpreter::optimization_pipeline(JS::Bytecode::g_optimization_level);
                 passes.perform(*executable);
                 dbgln("Optimisation passes took {}us", passes.elapsed());
             }
 
-            if (JS::Bytecode::g_dump_bytecode)
+            if (JS::Bytecode::g_dump_bytecode) {
                 executable->dump();
+                if (s_opt_bytecode)
+                    dbgln("Optimized from {} instructions and {} registers to {} instructions and {} registers", instruction_count, register_count, executable->instruction_count(), executable->number_of_registers);
+            }
 
             if (s_run_bytecode) {
                 JS::Bytecode::Interpreter bytecode_interpreter(interpreter.global_object(), interpreter.realm());
@@ -1370,6 +1376,20 @@ private:
     int m_group_stack_depth { 0 };
 };
 
+static void print_gc_statistics(JS::Heap const& heap)
+{
+    auto const& statistics = heap.statistics();
+    warnln("Garbage collection statistics");
+    warnln("=============================================");
+    warnln("           Collections: {} ({} during idle time)", statistics.collections, statistics.idle_time_collections);
+    warnln("            Total time: {:.3} ms", statistics.total_time.to_microseconds() / 1000.0);
+    warnln("         Longest pause: {:.3} ms", statistics.longest_pause.to_microseconds() / 1000.0);
+    warnln("       Collected cells: {} ({} bytes)", statistics.collected_cells, statistics.collected_cell_bytes);
+    warnln("            Live cells: {} bytes after the last collection", statistics.live_cell_bytes);
+    warnln("  Allocation threshold: {} bytes", statistics.allocation_threshold_bytes);
+    warnln("=============================================");
+}
+
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
 #ifdef __serenity__
@@ -1392,11 +1412,15 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(s_strip_ansi, "Disable ANSI colors", "disable-ansi-colors", 'i');
     args_parser.add_option(s_disable_source_location_hints, "Disable source location hints", "disable-source-location-hints", 'h');
     args_parser.add_option(gc_on_every_allocation, "GC on every allocation", "gc-on-every-allocation", 'g');
+    args_parser.add_option(s_print_gc_statistics, "Print garbage collection statistics on exit", "gc-stats", 0);
     args_parser.add_option(disable_syntax_highlight, "Disable live syntax highlighting", "no-syntax-highlight", 's');
     args_parser.add_option(evaluate_script, "Evaluate argument as a script", "evaluate", 'c', "script");
     args_parser.add_positional_argument(script_paths, "Path to script files", "scripts", Core::ArgsParser::Required::No);
     args_parser.parse(arguments);
 
+    if (s_opt_bytecode)
+        JS::Bytecode::g_optimization_level = JS::Bytecode::Interpreter::OptimizationLevel::Aggressive;
+
     bool syntax_highlight = !disable_syntax_highlight;
 
     vm = JS::VM::create();
@@ -1637,6 +1661,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         s_editor->on_tab_complete = move(complete);
         repl(*interpreter);
         s_editor->save_history(s_history_path);
+        if (s_print_gc_statistics)
+            print_gc_statistics(interpreter->heap());
     } else {
         interpreter = JS::Interpreter::create<ScriptObject>(*vm);
         ReplConsoleClient console_client(interpreter->global_object().console());
@@ -1678,7 +1704,10 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
         // We resolve modules as if it is the first file
 
-        if (!parse_and_run(*interpreter, builder.string_view(), source_name))
+        bool success = parse_and_run(*interpreter, builder.string_view(), source_name);
+        if (s_print_gc_statistics)
+            print_gc_statistics(interpreter->heap());
+        if (!success)
             return 1;
     }
 